@@ -77,6 +77,7 @@ COMMON_SRC_FILES += \
 	Renderer/SetupProcessor.cpp \
 	Renderer/Surface.cpp \
 	Renderer/TextureStage.cpp \
+	Renderer/TieredRoutine.cpp \
 	Renderer/Vector.cpp \
 	Renderer/VertexProcessor.cpp \
 
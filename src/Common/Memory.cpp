@@ -16,6 +16,7 @@
 
 #include "Types.hpp"
 #include "Debug.hpp"
+#include "MutexLock.hpp"
 
 #if defined(_WIN32)
 	#ifndef WIN32_LEAN_AND_MEAN
@@ -26,9 +27,15 @@
 #else
 	#include <sys/mman.h>
 	#include <unistd.h>
+
+	#if !defined(MAP_ANONYMOUS)
+		#define MAP_ANONYMOUS MAP_ANON
+	#endif
 #endif
 
 #include <memory.h>
+#include <map>
+#include <vector>
 
 #undef allocate
 #undef deallocate
@@ -103,11 +110,245 @@ void deallocate(void *memory)
 	}
 }
 
-void *allocateExecutable(size_t bytes)
+// Executable memory gets suballocated from large chunks shared by all routines, so code is
+// densely packed into a few address ranges instead of taking a mapping per routine. Allocations
+// are whole pages, since code in use by other threads must remain executable while new code gets
+// written.
+class CodeHeap
+{
+public:
+	CodeHeap();
+
+	void *allocate(size_t bytes);
+	void shrink(void *memory, size_t bytes, size_t newBytes);
+	void deallocate(void *memory, size_t bytes);
+
+	size_t allocated();
+	size_t reserved();
+
+private:
+	struct Chunk
+	{
+		unsigned char *memory;
+		size_t size;
+		size_t used;
+		std::map<size_t, size_t> freeRanges;   // Offset to size of unallocated pages
+	};
+
+	Chunk *findChunk(void *memory);
+	static void addFreeRange(Chunk *chunk, size_t offset, size_t bytes);
+
+	static unsigned char *mapChunk(size_t bytes);
+	static void unmapChunk(unsigned char *memory, size_t bytes);
+
+	std::vector<Chunk*> chunks;
+	size_t allocatedBytes;
+	size_t reservedBytes;
+
+	MutexLock mutex;
+};
+
+static CodeHeap &codeHeap()
+{
+	static CodeHeap *heap = new CodeHeap();   // Never destroyed, since routines may get freed during static destruction
+
+	return *heap;
+}
+
+CodeHeap::CodeHeap()
+{
+	allocatedBytes = 0;
+	reservedBytes = 0;
+}
+
+void *CodeHeap::allocate(size_t bytes)
+{
+	const size_t chunkSize = 1024 * 1024;
+
+	LockGuard lock(mutex);
+
+	for(Chunk *chunk : chunks)
+	{
+		if(chunk->size - chunk->used < bytes)
+		{
+			continue;
+		}
+
+		// First fit, to keep the code near the start of the chunks
+		for(auto range = chunk->freeRanges.begin(); range != chunk->freeRanges.end(); range++)
+		{
+			if(range->second >= bytes)
+			{
+				size_t offset = range->first;
+				size_t remainder = range->second - bytes;
+
+				chunk->freeRanges.erase(range);
+
+				if(remainder > 0)
+				{
+					chunk->freeRanges[offset + bytes] = remainder;
+				}
+
+				chunk->used += bytes;
+				allocatedBytes += bytes;
+
+				return chunk->memory + offset;
+			}
+		}
+	}
+
+	Chunk *chunk = new Chunk;
+	chunk->size = (bytes > chunkSize) ? bytes : chunkSize;
+	chunk->memory = mapChunk(chunk->size);
+	chunk->used = bytes;
+
+	if(!chunk->memory)
+	{
+		delete chunk;
+		return nullptr;
+	}
+
+	if(chunk->size > bytes)
+	{
+		chunk->freeRanges[bytes] = chunk->size - bytes;
+	}
+
+	chunks.push_back(chunk);
+	allocatedBytes += bytes;
+	reservedBytes += chunk->size;
+
+	return chunk->memory;
+}
+
+void CodeHeap::shrink(void *memory, size_t bytes, size_t newBytes)
+{
+	LockGuard lock(mutex);
+
+	Chunk *chunk = findChunk(memory);
+	size_t offset = (unsigned char*)memory - chunk->memory;
+
+	addFreeRange(chunk, offset + newBytes, bytes - newBytes);
+	chunk->used -= bytes - newBytes;
+	allocatedBytes -= bytes - newBytes;
+}
+
+void CodeHeap::deallocate(void *memory, size_t bytes)
+{
+	LockGuard lock(mutex);
+
+	Chunk *chunk = findChunk(memory);
+	size_t offset = (unsigned char*)memory - chunk->memory;
+
+	addFreeRange(chunk, offset, bytes);
+	chunk->used -= bytes;
+	allocatedBytes -= bytes;
+
+	// Keep one chunk around, to not map and unmap memory for each routine when few are in use
+	if(chunk->used == 0 && chunks.size() > 1)
+	{
+		for(size_t i = 0; i < chunks.size(); i++)
+		{
+			if(chunks[i] == chunk)
+			{
+				chunks.erase(chunks.begin() + i);
+				break;
+			}
+		}
+
+		reservedBytes -= chunk->size;
+		unmapChunk(chunk->memory, chunk->size);
+		delete chunk;
+	}
+}
+
+size_t CodeHeap::allocated()
+{
+	LockGuard lock(mutex);
+
+	return allocatedBytes;
+}
+
+size_t CodeHeap::reserved()
+{
+	LockGuard lock(mutex);
+
+	return reservedBytes;
+}
+
+CodeHeap::Chunk *CodeHeap::findChunk(void *memory)
+{
+	for(Chunk *chunk : chunks)
+	{
+		if(memory >= chunk->memory && memory < chunk->memory + chunk->size)
+		{
+			return chunk;
+		}
+	}
+
+	ASSERT(false);
+	return nullptr;
+}
+
+void CodeHeap::addFreeRange(Chunk *chunk, size_t offset, size_t bytes)
+{
+	if(bytes == 0)
+	{
+		return;
+	}
+
+	auto next = chunk->freeRanges.lower_bound(offset);
+
+	if(next != chunk->freeRanges.end() && next->first == offset + bytes)   // Merge with the following range
+	{
+		bytes += next->second;
+		next = chunk->freeRanges.erase(next);
+	}
+
+	if(next != chunk->freeRanges.begin())   // Merge with the preceding range
+	{
+		auto previous = next;
+		previous--;
+
+		if(previous->first + previous->second == offset)
+		{
+			previous->second += bytes;
+			return;
+		}
+	}
+
+	chunk->freeRanges[offset] = bytes;
+}
+
+unsigned char *CodeHeap::mapChunk(size_t bytes)
+{
+	#if defined(_WIN32)
+		return (unsigned char*)VirtualAlloc(NULL, bytes, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+	#else
+		void *memory = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+		return (memory != MAP_FAILED) ? (unsigned char*)memory : nullptr;
+	#endif
+}
+
+void CodeHeap::unmapChunk(unsigned char *memory, size_t bytes)
+{
+	#if defined(_WIN32)
+		VirtualFree(memory, 0, MEM_RELEASE);
+	#else
+		munmap(memory, bytes);
+	#endif
+}
+
+static size_t roundToPages(size_t bytes)
 {
 	size_t pageSize = memoryPageSize();
 
-	return allocate((bytes + pageSize - 1) & ~(pageSize - 1), pageSize);
+	return (bytes + pageSize - 1) & ~(pageSize - 1);
+}
+
+void *allocateExecutable(size_t bytes)
+{
+	return codeHeap().allocate(roundToPages(bytes));
 }
 
 void markExecutable(void *memory, size_t bytes)
@@ -120,8 +361,23 @@ void markExecutable(void *memory, size_t bytes)
 	#endif
 }
 
+size_t shrinkExecutable(void *memory, size_t bytes, size_t newBytes)
+{
+	bytes = roundToPages(bytes);
+	newBytes = roundToPages(newBytes);
+
+	if(newBytes < bytes)
+	{
+		codeHeap().shrink(memory, bytes, newBytes);
+	}
+
+	return newBytes;
+}
+
 void deallocateExecutable(void *memory, size_t bytes)
 {
+	bytes = roundToPages(bytes);
+
 	#if defined(_WIN32)
 		unsigned long oldProtection;
 		VirtualProtect(memory, bytes, PAGE_READWRITE, &oldProtection);
@@ -129,7 +385,17 @@ void deallocateExecutable(void *memory, size_t bytes)
 		mprotect(memory, bytes, PROT_READ | PROT_WRITE);
 	#endif
 
-	deallocate(memory);
+	codeHeap().deallocate(memory, bytes);
+}
+
+size_t executableMemoryAllocated()
+{
+	return codeHeap().allocated();
+}
+
+size_t executableMemoryReserved()
+{
+	return codeHeap().reserved();
 }
 
 void clear(uint16_t *memory, uint16_t element, size_t count)
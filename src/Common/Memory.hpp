@@ -25,10 +25,14 @@ size_t memoryPageSize();
 void *allocate(size_t bytes, size_t alignment = 16);
 void deallocate(void *memory);
 
-void *allocateExecutable(size_t bytes);   // Allocates memory that can be made executable using markExecutable()
+void *allocateExecutable(size_t bytes);   // Allocates pages from the shared code heap, which can be made executable using markExecutable()
 void markExecutable(void *memory, size_t bytes);
+size_t shrinkExecutable(void *memory, size_t bytes, size_t newBytes);   // Returns the pages past newBytes to the code heap, and the new allocation size
 void deallocateExecutable(void *memory, size_t bytes);
 
+size_t executableMemoryAllocated();   // Bytes of code heap memory in use by routines
+size_t executableMemoryReserved();    // Bytes of code heap memory mapped from the system
+
 void clear(uint16_t *memory, uint16_t element, size_t count);
 void clear(uint32_t *memory, uint32_t element, size_t count);
 }
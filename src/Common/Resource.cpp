@@ -16,9 +16,80 @@
 
 #include "Memory.hpp"
 
+#include <string.h>
+#include <vector>
+
 namespace sw
 {
-	Resource::Resource(size_t bytes) : size(bytes)
+	// Memory of destructed recycled resources, for reuse by new resources of the same size
+	class ResourcePool
+	{
+	public:
+		void *acquire(size_t bytes)
+		{
+			void *memory = nullptr;
+
+			mutex.lock();
+
+			for(auto block = blocks.begin(); block != blocks.end(); block++)
+			{
+				if(block->bytes == bytes)
+				{
+					memory = block->memory;
+					pooledBytes -= bytes;
+					blocks.erase(block);
+					break;
+				}
+			}
+
+			mutex.unlock();
+
+			return memory;
+		}
+
+		void release(void *memory, size_t bytes)
+		{
+			mutex.lock();
+
+			if(pooledBytes + bytes <= MAX_POOLED_BYTES && blocks.size() < MAX_POOLED_BLOCKS)
+			{
+				blocks.push_back({memory, bytes});
+				pooledBytes += bytes;
+				memory = nullptr;
+			}
+
+			mutex.unlock();
+
+			deallocate(memory);
+		}
+
+	private:
+		enum
+		{
+			MAX_POOLED_BYTES = 64 * 1024 * 1024,
+			MAX_POOLED_BLOCKS = 64,
+		};
+
+		struct Block
+		{
+			void *memory;
+			size_t bytes;
+		};
+
+		MutexLock mutex;
+		std::vector<Block> blocks;
+		size_t pooledBytes = 0;
+	};
+
+	// Never destroyed, since resources can outlive static destruction when displays are terminated at exit
+	static ResourcePool &resourcePool()
+	{
+		static ResourcePool *pool = new ResourcePool();
+
+		return *pool;
+	}
+
+	Resource::Resource(size_t bytes, bool recycled, bool overwritten) : size(bytes), recycled(recycled)
 	{
 		blocked = 0;
 
@@ -26,12 +97,28 @@ namespace sw
 		count = 0;
 		orphaned = false;
 
-		buffer = allocate(bytes);
+		buffer = recycled ? resourcePool().acquire(bytes) : nullptr;
+
+		if(!buffer)
+		{
+			buffer = allocate(bytes);
+		}
+		else if(!overwritten)
+		{
+			memset(buffer, 0, bytes);   // Don't expose the contents of the previous owner
+		}
 	}
 
 	Resource::~Resource()
 	{
-		deallocate(buffer);
+		if(recycled)
+		{
+			resourcePool().release(buffer, size);
+		}
+		else
+		{
+			deallocate(buffer);
+		}
 	}
 
 	void *Resource::lock(Accessor claimer)
@@ -156,6 +243,24 @@ namespace sw
 		criticalSection.unlock();
 	}
 
+	bool Resource::isBusy()
+	{
+		criticalSection.lock();
+		bool busy = (count > 0 && accessor != PUBLIC);
+		criticalSection.unlock();
+
+		return busy;
+	}
+
+	bool Resource::isBusy(Accessor accessor)
+	{
+		criticalSection.lock();
+		bool busy = (count > 0 && this->accessor == accessor);
+		criticalSection.unlock();
+
+		return busy;
+	}
+
 	void Resource::destruct()
 	{
 		criticalSection.lock();
@@ -30,7 +30,10 @@ namespace sw
 	class Resource
 	{
 	public:
-		Resource(size_t bytes);
+		// Recycled resources take their memory from a pool of previously destructed
+		// recycled resources of the same size. It only skips getting cleared when the
+		// caller overwrites all of it.
+		Resource(size_t bytes, bool recycled = false, bool overwritten = false);
 
 		void destruct();   // Asynchronous destructor
 
@@ -39,6 +42,9 @@ namespace sw
 		void unlock();
 		void unlock(Accessor relinquisher);
 
+		bool isBusy();                    // Locked by the renderer
+		bool isBusy(Accessor accessor);   // Locked by the renderer through the given accessor only
+
 		const void *data() const;
 		const size_t size;
 
@@ -52,6 +58,7 @@ namespace sw
 		volatile Accessor accessor;
 		volatile int count;
 		bool orphaned;
+		const bool recycled;
 
 		void *buffer;
 	};
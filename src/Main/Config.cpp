@@ -32,6 +32,15 @@ namespace sw
 		framesTotal = 0;
 		FPS = 0;
 
+		vertexRoutines = 0;
+		setupRoutines = 0;
+		pixelRoutines = 0;
+
+		bufferRenames = 0;
+		bufferWaits = 0;
+		textureRenames = 0;
+		textureWaits = 0;
+
 		#if PERF_PROFILE
 			for(int i = 0; i < PERF_TIMERS; i++)
 			{
@@ -54,6 +54,18 @@ namespace sw
 		int framesTotal;
 		double FPS;
 
+		// Number of routines generated since the last reset (routine cache misses)
+		int vertexRoutines;
+		int setupRoutines;
+		int pixelRoutines;
+
+		// Number of buffer and texture updates since the last reset which replaced storage
+		// still in use by the renderer, or had to wait for the renderer to release it
+		int bufferRenames;
+		int bufferWaits;
+		int textureRenames;
+		int textureWaits;
+
 		#if PERF_PROFILE
 		double cycles[PERF_TIMERS];
 
@@ -76,6 +88,7 @@ namespace sw
 	enum
 	{
 		OUTLINE_RESOLUTION = 8192,   // Maximum vertical resolution of the render target
+		GUARD_BAND_AREA = 4096 * 1024,   // Maximum screen area of unclipped triangles, keeping edge setup within 32-bit
 		MIPMAP_LEVELS = 14,
 		TEXTURE_IMAGE_UNITS = 16,
 		VERTEX_TEXTURE_IMAGE_UNITS = 16,
@@ -17,6 +17,7 @@
 #include "Config.hpp"
 #include "Common/Configurator.hpp"
 #include "Common/Debug.hpp"
+#include "Common/Memory.hpp"
 #include "Common/Version.h"
 
 #include <sstream>
@@ -438,6 +439,8 @@ namespace sw
 		html += "<option value='3'" + (config.shadowMapping == 3 ? selected : empty) + ">Fetch4 & DST (default)</option>\n";
 		html += "</select></td>\n";
 		html += "<tr><td>Force clearing registers that have no default value:</td><td><input name = 'forceClearRegisters' type='checkbox'" + (config.forceClearRegisters == true ? checked : empty) + " title='Initializes shader register values to 0 even if they have no default.'></td></tr>";
+		html += "<tr><td>Constant specialization:</td><td><input name = 'constantSpecialization' type='checkbox'" + (config.constantSpecialization == true ? checked : empty) + " title='If checked pixel shader branches and loops controlled by rarely changing constants get resolved when generating the routines.'></td></tr>";
+		html += "<tr><td>Tiered compilation:</td><td><input name = 'tieredCompilation' type='checkbox'" + (config.tieredCompilation == true ? checked : empty) + " title='If checked routines are first compiled with minimal optimization, and recompiled with full optimization on a background thread once they are used by many draw calls.'></td></tr>";
 		html += "</table>\n";
 	#ifndef NDEBUG
 		html += "<h2><em>Debugging</em></h2>\n";
@@ -465,6 +468,7 @@ namespace sw
 
 		html += "<p>FPS: " + ftoa(profiler.FPS) + "</p>\n";
 		html += "<p>Frame: " + itoa(profiler.framesTotal) + "</p>\n";
+		html += "<p>JIT code memory (KB): " + itoa((int)(executableMemoryAllocated() / 1024)) + " (allocated), " + itoa((int)(executableMemoryReserved() / 1024)) + " (reserved)</p>\n";
 
 		#if PERF_PROFILE
 			int texTime = (int)(1000 * profiler.cycles[PERF_TEX] / profiler.cycles[PERF_PIXEL] + 0.5);
@@ -547,6 +551,8 @@ namespace sw
 		config.disable10BitMode = false;
 		config.precache = false;
 		config.forceClearRegisters = false;
+		config.constantSpecialization = false;
+		config.tieredCompilation = false;
 
 		while(*post != 0)
 		{
@@ -689,6 +695,14 @@ namespace sw
 			{
 				config.forceClearRegisters = true;
 			}
+			else if(strstr(post, "constantSpecialization=on"))
+			{
+				config.constantSpecialization = true;
+			}
+			else if(strstr(post, "tieredCompilation=on"))
+			{
+				config.tieredCompilation = true;
+			}
 		#ifndef NDEBUG
 			else if(sscanf(post, "minPrimitives=%d", &integer))
 			{
@@ -752,6 +766,8 @@ namespace sw
 		config.precache = ini.getBoolean("Testing", "Precache", false);
 		config.shadowMapping = ini.getInteger("Testing", "ShadowMapping", 3);
 		config.forceClearRegisters = ini.getBoolean("Testing", "ForceClearRegisters", false);
+		config.constantSpecialization = ini.getBoolean("Testing", "ConstantSpecialization", false);
+		config.tieredCompilation = ini.getBoolean("Testing", "TieredCompilation", true);
 
 	#ifndef NDEBUG
 		config.minPrimitives = 1;
@@ -810,6 +826,8 @@ namespace sw
 		ini.addValue("Testing", "Precache", itoa(config.precache));
 		ini.addValue("Testing", "ShadowMapping", itoa(config.shadowMapping));
 		ini.addValue("Testing", "ForceClearRegisters", itoa(config.forceClearRegisters));
+		ini.addValue("Testing", "ConstantSpecialization", itoa(config.constantSpecialization));
+		ini.addValue("Testing", "TieredCompilation", itoa(config.tieredCompilation));
 		ini.addValue("LastModified", "Time", itoa((int)time(0)));
 
 		ini.writeFile("SwiftShader Configuration File\n"
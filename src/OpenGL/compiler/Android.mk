@@ -68,6 +68,7 @@ COMMON_SRC_FILES := \
 	PoolAlloc.cpp \
 	SymbolTable.cpp \
 	TranslatorASM.cpp \
+	TreeOptimizer.cpp \
 	util.cpp \
 	ValidateLimitations.cpp \
 	ValidateSwitch.cpp \
@@ -18,6 +18,7 @@
 #include <map>
 #include <sstream>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "PoolAlloc.h"
@@ -82,4 +83,26 @@ public:
 	TMap(const tAllocator& a) : std::map<K, D, CMP, tAllocator>(std::map<K, D, CMP, tAllocator>::key_compare(), a) {}
 };
 
+template <class K, class D, class H = std::hash<K>, class EQ = std::equal_to<K> >
+class TUnorderedMap : public std::unordered_map<K, D, H, EQ, pool_allocator<std::pair<const K, D> > > {
+public:
+	typedef pool_allocator<std::pair<const K, D> > tAllocator;
+
+	TUnorderedMap() : std::unordered_map<K, D, H, EQ, tAllocator>() {}
+	TUnorderedMap(const tAllocator& a) : std::unordered_map<K, D, H, EQ, tAllocator>(0, H(), EQ(), a) {}
+};
+
+//
+// FNV-1a hash of a pool string, for use as a TUnorderedMap key.
+//
+struct TStringHash {
+	size_t operator()(const TString& s) const
+	{
+		size_t hash = 2166136261u;
+		for (TString::const_iterator c = s.begin(); c != s.end(); ++c)
+			hash = (hash ^ static_cast<unsigned char>(*c)) * 16777619u;
+		return hash;
+	}
+};
+
 #endif // _COMMON_INCLUDED_
@@ -19,6 +19,7 @@
 #include "InitializeParseContext.h"
 #include "InitializeGlobals.h"
 #include "ParseHelper.h"
+#include "TreeOptimizer.h"
 #include "ValidateLimitations.h"
 
 namespace
@@ -146,6 +147,9 @@ bool TCompiler::compile(const char* const shaderStrings[],
 		if (success && (compileOptions & SH_VALIDATE_LOOP_INDEXING))
 			success = validateLimitations(root);
 
+		if (success)
+			optimizeTree(root);
+
 		if (success && (compileOptions & SH_INTERMEDIATE_TREE))
 			intermediate.outputTree(root);
 
@@ -244,6 +248,12 @@ bool TCompiler::validateLimitations(TIntermNode* root) {
 	return validate.numErrors() == 0;
 }
 
+void TCompiler::optimizeTree(TIntermNode *root)
+{
+	TreeOptimizer optimizer;
+	optimizer.optimize(root);
+}
+
 const TExtensionBehavior& TCompiler::getExtensionBehavior() const
 {
 	return extensionBehavior;
@@ -121,6 +121,8 @@ protected:
 	// Returns true if the given shader does not exceed the minimum
 	// functionality mandated in GLSL 1.0 spec Appendix A.
 	bool validateLimitations(TIntermNode *root);
+	// Inlines, unrolls and folds constants ahead of translation.
+	void optimizeTree(TIntermNode *root);
 	// Translate to object code.
 	virtual bool translate(TIntermNode *root) = 0;
 	// Get built-in extensions with default behavior.
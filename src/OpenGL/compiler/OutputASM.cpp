@@ -3218,7 +3218,7 @@ namespace glsl
 						{
 							if(!fragmentOutputs[requestedLocation + i])
 							{
-								fragmentOutputs[requestedLocation + i] = fragmentOutput;
+								fragmentOutputs.set(requestedLocation + i, fragmentOutput);
 							}
 							else
 							{
@@ -3422,12 +3422,11 @@ namespace glsl
 
 	int OutputASM::lookup(VariableArray &list, TIntermTyped *variable)
 	{
-		for(unsigned int i = 0; i < list.size(); i++)
+		int index = list.find(variable);
+
+		if(index != -1)
 		{
-			if(list[i] == variable)
-			{
-				return i;   // Pointer match
-			}
+			return index;   // Pointer match
 		}
 
 		TIntermSymbol *varSymbol = variable->getAsSymbolNode();
@@ -3435,63 +3434,40 @@ namespace glsl
 
 		if(varBlock)
 		{
-			for(unsigned int i = 0; i < list.size(); i++)
-			{
-				if(list[i])
-				{
-					TInterfaceBlock *listBlock = list[i]->getType().getAsInterfaceBlock();
+			index = list.findBlock(varBlock->name());
 
-					if(listBlock)
-					{
-						if(listBlock->name() == varBlock->name())
-						{
-							ASSERT(listBlock->arraySize() == varBlock->arraySize());
-							ASSERT(listBlock->fields() == varBlock->fields());
-							ASSERT(listBlock->blockStorage() == varBlock->blockStorage());
-							ASSERT(listBlock->matrixPacking() == varBlock->matrixPacking());
+			if(index != -1)
+			{
+				TInterfaceBlock *listBlock = list[index]->getType().getAsInterfaceBlock();
 
-							return i;
-						}
-					}
-				}
+				ASSERT(listBlock->arraySize() == varBlock->arraySize());
+				ASSERT(listBlock->fields() == varBlock->fields());
+				ASSERT(listBlock->blockStorage() == varBlock->blockStorage());
+				ASSERT(listBlock->matrixPacking() == varBlock->matrixPacking());
+				(void)listBlock;   // Unused when assertions are disabled
 			}
 		}
 		else if(varSymbol)
 		{
-			for(unsigned int i = 0; i < list.size(); i++)
-			{
-				if(list[i])
-				{
-					TIntermSymbol *listSymbol = list[i]->getAsSymbolNode();
+			index = list.findSymbol(varSymbol->getId());
 
-					if(listSymbol)
-					{
-						if(listSymbol->getId() == varSymbol->getId())
-						{
-							ASSERT(listSymbol->getSymbol() == varSymbol->getSymbol());
-							ASSERT(listSymbol->getType() == varSymbol->getType());
-							ASSERT(listSymbol->getQualifier() == varSymbol->getQualifier());
+			if(index != -1)
+			{
+				TIntermSymbol *listSymbol = list[index]->getAsSymbolNode();
 
-							return i;
-						}
-					}
-				}
+				ASSERT(listSymbol->getSymbol() == varSymbol->getSymbol());
+				ASSERT(listSymbol->getType() == varSymbol->getType());
+				ASSERT(listSymbol->getQualifier() == varSymbol->getQualifier());
+				(void)listSymbol;   // Unused when assertions are disabled
 			}
 		}
 
-		return -1;
+		return index;
 	}
 
 	int OutputASM::lookup(VariableArray &list, TInterfaceBlock *block)
 	{
-		for(unsigned int i = 0; i < list.size(); i++)
-		{
-			if(list[i] && (list[i]->getType().getInterfaceBlock() == block))
-			{
-				return i;   // Pointer match
-			}
-		}
-		return -1;
+		return list.findBlockMember(block);
 	}
 
 	int OutputASM::allocate(VariableArray &list, TIntermTyped *variable, bool samplersOnly)
@@ -3502,29 +3478,16 @@ namespace glsl
 		{
 			unsigned int registerCount = variable->blockRegisterCount(samplersOnly);
 
-			for(unsigned int i = 0; i < list.size(); i++)
+			index = list.findFree(registerCount);
+
+			if(index != -1)
 			{
-				if(list[i] == 0)
+				for(unsigned int i = 0; i < registerCount; i++)
 				{
-					unsigned int j = 1;
-					for( ; j < registerCount && (i + j) < list.size(); j++)
-					{
-						if(list[i + j] != 0)
-						{
-							break;
-						}
-					}
-
-					if(j == registerCount)   // Found free slots
-					{
-						for(unsigned int j = 0; j < registerCount; j++)
-						{
-							list[i + j] = variable;
-						}
-
-						return i;
-					}
+					list.set(index + i, variable);
 				}
+
+				return index;
 			}
 
 			index = list.size();
@@ -3544,7 +3507,171 @@ namespace glsl
 
 		if(index >= 0)
 		{
-			list[index] = 0;
+			list.set(index, nullptr);
+		}
+	}
+
+	void OutputASM::VariableArray::set(int index, TIntermTyped *variable)
+	{
+		Slot &slot = slots[index];
+
+		if(slot.variable)
+		{
+			TIntermTyped *old = slot.variable;
+			erase(variables, old, index, [old](const Slot &s) { return s.variable == old; });
+
+			if(slot.id != -1)
+			{
+				int id = slot.id;
+				erase(symbols, id, index, [id](const Slot &s) { return s.id == id; });
+			}
+
+			if(slot.block)
+			{
+				std::string name = slot.block->name().c_str();
+				erase(blocks, name, index, [&name](const Slot &s) { return s.block && name == s.block->name().c_str(); });
+			}
+
+			if(slot.parent)
+			{
+				TInterfaceBlock *parent = slot.parent;
+				erase(members, parent, index, [parent](const Slot &s) { return s.parent == parent; });
+			}
+		}
+
+		slot.variable = variable;
+		slot.id = -1;
+		slot.block = nullptr;
+		slot.parent = nullptr;
+
+		if(!variable)
+		{
+			freeSlots.insert(index);
+			return;
+		}
+
+		freeSlots.erase(index);
+
+		TIntermSymbol *symbol = variable->getAsSymbolNode();
+		slot.id = symbol ? symbol->getId() : -1;
+		slot.block = variable->getType().getAsInterfaceBlock();
+		slot.parent = variable->getType().getInterfaceBlock();
+
+		insert(variables, variable, index);
+
+		if(slot.id != -1)
+		{
+			insert(symbols, slot.id, index);
+		}
+
+		if(slot.block)
+		{
+			insert(blocks, std::string(slot.block->name().c_str()), index);
+		}
+
+		if(slot.parent)
+		{
+			insert(members, slot.parent, index);
+		}
+	}
+
+	void OutputASM::VariableArray::push_back(TIntermTyped *variable)
+	{
+		Slot slot = {nullptr, -1, nullptr, nullptr};
+		slots.push_back(slot);
+
+		set(static_cast<int>(slots.size() - 1), variable);
+	}
+
+	int OutputASM::VariableArray::find(TIntermTyped *variable) const
+	{
+		return first(variables, variable);
+	}
+
+	int OutputASM::VariableArray::findSymbol(int id) const
+	{
+		return first(symbols, id);
+	}
+
+	int OutputASM::VariableArray::findBlock(const TString &name) const
+	{
+		return first(blocks, std::string(name.c_str()));
+	}
+
+	int OutputASM::VariableArray::findBlockMember(TInterfaceBlock *block) const
+	{
+		return first(members, block);
+	}
+
+	int OutputASM::VariableArray::findFree(unsigned int registerCount) const
+	{
+		for(int index : freeSlots)
+		{
+			if(index + registerCount > slots.size())
+			{
+				break;
+			}
+
+			unsigned int i = 1;
+			while(i < registerCount && !slots[index + i].variable)
+			{
+				i++;
+			}
+
+			if(i == registerCount)
+			{
+				return index;
+			}
+		}
+
+		return -1;
+	}
+
+	template<class Key>
+	int OutputASM::VariableArray::first(const std::unordered_map<Key, Range> &ranges, const Key &key)
+	{
+		auto range = ranges.find(key);
+
+		return (range != ranges.end()) ? range->second.first : -1;
+	}
+
+	template<class Key>
+	void OutputASM::VariableArray::insert(std::unordered_map<Key, Range> &ranges, const Key &key, int index)
+	{
+		auto range = ranges.find(key);
+
+		if(range == ranges.end())
+		{
+			Range newRange = {index, 1};
+			ranges[key] = newRange;
+		}
+		else
+		{
+			range->second.first = std::min(range->second.first, index);
+			range->second.count++;
+		}
+	}
+
+	// Variables occupy consecutive slots, so the next one with the key is normally adjacent
+	template<class Key, class Match>
+	void OutputASM::VariableArray::erase(std::unordered_map<Key, Range> &ranges, const Key &key, int index, Match match)
+	{
+		auto range = ranges.find(key);
+		ASSERT(range != ranges.end());
+
+		if(--range->second.count == 0)
+		{
+			ranges.erase(range);
+		}
+		else if(range->second.first == index)
+		{
+			int next = index + 1;
+			while(!(slots[next].variable && match(slots[next])))
+			{
+				next++;
+			}
+
+			range->second.first = next;
 		}
 	}
 
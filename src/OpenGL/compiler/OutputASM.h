@@ -23,6 +23,7 @@
 #include <list>
 #include <set>
 #include <map>
+#include <unordered_map>
 
 namespace es2
 {
@@ -305,7 +306,56 @@ namespace glsl
 		int samplerRegister(TIntermSymbol *sampler);
 		bool isSamplerRegister(TIntermTyped *operand);
 
-		typedef std::vector<TIntermTyped*> VariableArray;
+		// Register slots assigned to variables. Lookups by node, symbol id and interface
+		// block are hashed, since large shaders allocate thousands of registers.
+		class VariableArray
+		{
+		public:
+			size_t size() const { return slots.size(); }
+			TIntermTyped *operator[](size_t index) const { return slots[index].variable; }
+
+			void set(int index, TIntermTyped *variable);
+			void push_back(TIntermTyped *variable);
+
+			// Lowest slot holding the node, a symbol with the given id, the declaration
+			// of the named interface block, or a variable which is part of the block
+			int find(TIntermTyped *variable) const;
+			int findSymbol(int id) const;
+			int findBlock(const TString &name) const;
+			int findBlockMember(TInterfaceBlock *block) const;
+
+			// Lowest run of consecutive free slots, or -1
+			int findFree(unsigned int registerCount) const;
+
+		private:
+			struct Slot
+			{
+				TIntermTyped *variable;
+				int id;                    // Symbol id, or -1
+				TInterfaceBlock *block;    // Declared interface block
+				TInterfaceBlock *parent;   // Interface block the variable is part of
+			};
+
+			struct Range
+			{
+				int first;   // Lowest slot with the key
+				int count;   // Number of slots with the key
+			};
+
+			template<class Key>
+			static int first(const std::unordered_map<Key, Range> &ranges, const Key &key);
+			template<class Key>
+			static void insert(std::unordered_map<Key, Range> &ranges, const Key &key, int index);
+			template<class Key, class Match>
+			void erase(std::unordered_map<Key, Range> &ranges, const Key &key, int index, Match match);
+
+			std::vector<Slot> slots;
+			std::unordered_map<TIntermTyped*, Range> variables;
+			std::unordered_map<int, Range> symbols;
+			std::unordered_map<std::string, Range> blocks;
+			std::unordered_map<TInterfaceBlock*, Range> members;
+			std::set<int> freeSlots;
+		};
 
 		int lookup(VariableArray &list, TIntermTyped *variable);
 		int lookup(VariableArray &list, TInterfaceBlock *block);
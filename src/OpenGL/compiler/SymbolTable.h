@@ -197,7 +197,7 @@ protected:
 class TSymbolTableLevel
 {
 public:
-	typedef TMap<TString, TSymbol*> tLevel;
+	typedef TUnorderedMap<TString, TSymbol*, TStringHash> tLevel;
 	typedef tLevel::const_iterator const_iterator;
 	typedef const tLevel::value_type tLevelPair;
 	typedef std::pair<tLevel::iterator, bool> tInsertResult;
@@ -0,0 +1,1355 @@
+// Copyright 2017 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "TreeOptimizer.h"
+
+#include "AnalyzeCallDepth.h"
+#include "debug.h"
+#include "localintermediate.h"
+
+#include <math.h>
+
+namespace
+{
+	// Loops are fully unrolled when they iterate at most this many times,
+	// and the unrolled loop consists of no more than this many nodes.
+	const unsigned int MAX_UNROLL_ITERATIONS = 16;
+	const unsigned int MAX_UNROLL_NODES = 1024;
+
+	// Maximum size of a function's return expression for it to be inlined.
+	const unsigned int MAX_INLINE_NODES = 64;
+
+	// Every expression node takes a temporary register, so bound the total growth of the tree.
+	const unsigned int MAX_GROWTH_NODES = 2048;
+
+	bool isTrivial(TIntermTyped *node)
+	{
+		if(node->getAsSymbolNode() || node->getAsConstantUnion())
+		{
+			return true;
+		}
+
+		TIntermBinary *binary = node->getAsBinaryNode();
+
+		if(binary)
+		{
+			switch(binary->getOp())
+			{
+			case EOpIndexDirect:
+			case EOpIndexDirectStruct:
+			case EOpVectorSwizzle:
+				return isTrivial(binary->getLeft());
+			default:
+				break;
+			}
+		}
+
+		return false;
+	}
+
+	bool hasZero(TIntermConstantUnion *node)
+	{
+		ConstantUnion integerZero;
+		integerZero.setIConst(0);
+		ConstantUnion zero;
+		zero.cast(node->getBasicType(), integerZero);
+
+		for(size_t i = 0; i < node->getType().getObjectSize(); i++)
+		{
+			if(node->getUnionArrayPointer()[i] == zero)
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	float component(TIntermConstantUnion *node, size_t i)
+	{
+		return (node->getType().getObjectSize() == 1) ? node->getFConst(0) : node->getFConst(static_cast<int>(i));
+	}
+
+	bool compare(TOperator op, const ConstantUnion &left, const ConstantUnion &right)
+	{
+		switch(op)
+		{
+		case EOpLessThan:         return left < right;
+		case EOpGreaterThan:      return left > right;
+		case EOpLessThanEqual:    return left <= right;
+		case EOpGreaterThanEqual: return left >= right;
+		case EOpEqual:            return left == right;
+		case EOpNotEqual:         return left != right;
+		default:                  UNREACHABLE(op);
+		}
+
+		return false;
+	}
+}
+
+TreeOptimizer::TreeOptimizer() : growthBudget(MAX_GROWTH_NODES), inlined(false)
+{
+}
+
+void TreeOptimizer::optimize(TIntermNode *root)
+{
+	TIntermAggregate *aggregate = root->getAsAggregate();
+
+	if(!aggregate)
+	{
+		return;
+	}
+
+	TVector<TIntermAggregate*> functions;
+
+	if(aggregate->getOp() == EOpFunction)
+	{
+		functions.push_back(aggregate);
+	}
+	else if(aggregate->getOp() == EOpSequence)
+	{
+		for(TIntermNode *node : aggregate->getSequence())
+		{
+			TIntermAggregate *function = node->getAsAggregate();
+
+			if(function && function->getOp() == EOpFunction)
+			{
+				functions.push_back(function);
+			}
+		}
+	}
+
+	for(TIntermAggregate *function : functions)
+	{
+		analyzeFunction(function);
+	}
+
+	for(TIntermAggregate *function : functions)
+	{
+		TIntermSequence &sequence = function->getSequence();
+
+		if(sequence.size() > 1 && sequence[1])
+		{
+			sequence[1] = optimizeNode(sequence[1]);
+		}
+	}
+
+	if(inlined)
+	{
+		// Turns functions which are no longer called into prototypes
+		AnalyzeCallDepth analyzeCallDepth(root);
+		analyzeCallDepth.analyzeCallDepth();
+	}
+}
+
+void TreeOptimizer::analyzeFunction(TIntermAggregate *function)
+{
+	TIntermSequence &sequence = function->getSequence();
+
+	if(sequence.size() != 2 || !sequence[0] || !sequence[1])
+	{
+		return;
+	}
+
+	TIntermAggregate *parameters = sequence[0]->getAsAggregate();
+	TIntermAggregate *body = sequence[1]->getAsAggregate();
+
+	if(parameters)
+	{
+		functionParameters[function->getName()] = &parameters->getSequence();
+	}
+
+	if(!parameters || !body || body->getOp() != EOpSequence || body->getSequence().size() != 1)
+	{
+		return;
+	}
+
+	TIntermBranch *branch = body->getSequence()[0]->getAsBranchNode();
+
+	if(!branch || branch->getFlowOp() != EOpReturn || !branch->getExpression() || function->getName() == "main(")
+	{
+		return;
+	}
+
+	for(TIntermNode *parameter : parameters->getSequence())
+	{
+		TIntermSymbol *symbol = parameter->getAsSymbolNode();
+
+		if(!symbol || (symbol->getQualifier() != EvqIn && symbol->getQualifier() != EvqConstReadOnly))
+		{
+			return;
+		}
+	}
+
+	// Parameters get replaced by the arguments, so they must not be assigned to
+	if(!sideEffectFree(branch->getExpression()))
+	{
+		return;
+	}
+
+	InlineFunction &inlineFunction = inlineFunctions[function->getName()];
+	inlineFunction.parameters = &parameters->getSequence();
+	inlineFunction.branch = branch;
+}
+
+TIntermNode *TreeOptimizer::optimizeNode(TIntermNode *node)
+{
+	if(!node)
+	{
+		return nullptr;
+	}
+
+	TIntermSelection *selection = node->getAsSelectionNode();
+	TIntermTyped *typed = node->getAsTyped();
+	TIntermLoop *loop = node->getAsLoopNode();
+	TIntermBranch *branch = node->getAsBranchNode();
+	TIntermSwitch *switchNode = node->getAsSwitchNode();
+
+	if(selection)
+	{
+		return optimizeSelection(selection);
+	}
+	else if(typed)
+	{
+		return optimizeTyped(typed);
+	}
+	else if(loop)
+	{
+		return optimizeLoop(loop);
+	}
+	else if(branch)
+	{
+		if(branch->getExpression())
+		{
+			branch->setExpression(optimizeTyped(branch->getExpression()));
+		}
+	}
+	else if(switchNode)
+	{
+		switchNode->setInit(optimizeTyped(switchNode->getInit()));
+
+		if(switchNode->getStatementList())
+		{
+			optimizeAggregate(switchNode->getStatementList());
+		}
+	}
+
+	return node;
+}
+
+TIntermTyped *TreeOptimizer::optimizeTyped(TIntermTyped *node)
+{
+	TIntermBinary *binary = node->getAsBinaryNode();
+	TIntermUnary *unary = node->getAsUnaryNode();
+	TIntermAggregate *aggregate = node->getAsAggregate();
+	TIntermSelection *selection = node->getAsSelectionNode();
+
+	if(binary)
+	{
+		return optimizeBinary(binary);
+	}
+	else if(unary)
+	{
+		return optimizeUnary(unary);
+	}
+	else if(aggregate)
+	{
+		return optimizeAggregate(aggregate);
+	}
+	else if(selection)
+	{
+		TIntermTyped *typed = optimizeSelection(selection)->getAsTyped();
+		ASSERT(typed);   // Ternary operator
+		return typed;
+	}
+
+	return node;
+}
+
+TIntermTyped *TreeOptimizer::optimizeBinary(TIntermBinary *node)
+{
+	TOperator op = node->getOp();
+
+	node->setLeft(optimizeTyped(node->getLeft()));
+
+	if(op != EOpVectorSwizzle)   // Right operand is a sequence of component indices
+	{
+		node->setRight(optimizeTyped(node->getRight()));
+	}
+
+	TIntermTyped *left = node->getLeft();
+	TIntermTyped *right = node->getRight();
+
+	switch(op)
+	{
+	case EOpIndexDirect:
+	case EOpIndexIndirect:
+	case EOpIndexDirectStruct:
+	case EOpVectorSwizzle:
+		return foldIndex(node);
+	case EOpLogicalAnd:
+		if(isConstant(left))
+		{
+			return left->getAsConstantUnion()->getBConst(0) ? right : left;
+		}
+		break;
+	case EOpLogicalOr:
+		if(isConstant(left))
+		{
+			return left->getAsConstantUnion()->getBConst(0) ? left : right;
+		}
+		break;
+	case EOpDiv:
+	case EOpIMod:
+		// Leave division by zero to be evaluated at run-time
+		if(isConstant(right) && hasZero(right->getAsConstantUnion()))
+		{
+			return node;
+		}
+		break;
+	default:
+		break;
+	}
+
+	if(node->modifiesState() || op == EOpInitialize || !isConstant(left) || !isConstant(right))
+	{
+		return node;
+	}
+
+	TIntermTyped *folded = left->getAsConstantUnion()->fold(op, right, infoSink);
+
+	if(!folded)
+	{
+		return node;
+	}
+
+	folded->setLine(node->getLine());
+
+	return folded;
+}
+
+TIntermTyped *TreeOptimizer::optimizeUnary(TIntermUnary *node)
+{
+	node->setOperand(optimizeTyped(node->getOperand()));
+
+	TIntermTyped *operand = node->getOperand();
+
+	if(node->modifiesState() || !isConstant(operand))
+	{
+		return node;
+	}
+
+	TIntermTyped *folded = operand->getAsConstantUnion()->fold(node->getOp(), nullptr, infoSink);
+
+	if(!folded)
+	{
+		return node;
+	}
+
+	folded->setLine(node->getLine());
+
+	return folded;
+}
+
+TIntermTyped *TreeOptimizer::optimizeAggregate(TIntermAggregate *node)
+{
+	TIntermSequence &sequence = node->getSequence();
+
+	switch(node->getOp())
+	{
+	case EOpFunction:
+	case EOpParameters:
+	case EOpPrototype:
+		return node;
+	case EOpSequence:
+		{
+			// Statements which got optimized away are removed from the list
+			TIntermSequence statements;
+
+			for(TIntermNode *statement : sequence)
+			{
+				TIntermNode *optimized = optimizeNode(statement);
+
+				if(optimized)
+				{
+					statements.push_back(optimized);
+				}
+			}
+
+			sequence.swap(statements);
+		}
+		return node;
+	default:
+		break;
+	}
+
+	for(size_t i = 0; i < sequence.size(); i++)
+	{
+		if(sequence[i]->getAsTyped())
+		{
+			sequence[i] = optimizeTyped(sequence[i]->getAsTyped());
+		}
+	}
+
+	if(node->getOp() == EOpFunctionCall)
+	{
+		if(node->isUserDefined())
+		{
+			TIntermTyped *expression = inlineCall(node);
+
+			if(expression)
+			{
+				return expression;
+			}
+		}
+
+		return node;
+	}
+	else if(node->isConstructor())
+	{
+		return foldConstructor(node);
+	}
+
+	return foldBuiltIn(node);
+}
+
+TIntermNode *TreeOptimizer::optimizeSelection(TIntermSelection *node)
+{
+	node->setCondition(optimizeTyped(node->getCondition()));
+
+	TIntermTyped *condition = node->getCondition();
+
+	if(isConstant(condition))
+	{
+		bool taken = condition->getAsConstantUnion()->getBConst(0);
+
+		return optimizeNode(taken ? node->getTrueBlock() : node->getFalseBlock());
+	}
+
+	node->setTrueBlock(optimizeNode(node->getTrueBlock()));
+	node->setFalseBlock(optimizeNode(node->getFalseBlock()));
+
+	return node;
+}
+
+TIntermNode *TreeOptimizer::optimizeLoop(TIntermLoop *node)
+{
+	node->setInit(optimizeNode(node->getInit()));
+
+	if(node->getCondition())
+	{
+		node->setCondition(optimizeTyped(node->getCondition()));
+	}
+
+	if(node->getExpression())
+	{
+		node->setExpression(optimizeTyped(node->getExpression()));
+	}
+
+	node->setBody(optimizeNode(node->getBody()));
+
+	TIntermTyped *condition = node->getCondition();
+
+	if(node->getType() != ELoopDoWhile && isConstant(condition) && !condition->getAsConstantUnion()->getBConst(0))
+	{
+		return node->getInit();   // Never iterates
+	}
+
+	LoopIndex index;
+
+	if(!parseLoopIndex(node, index) || !loopUnrollable(node->getBody(), index.symbol->getId(), 0, 0))
+	{
+		return node;
+	}
+
+	unsigned int unrolledNodes = nodeCount(node->getBody()) * static_cast<unsigned int>(index.values.size());
+
+	if(unrolledNodes > MAX_UNROLL_NODES || unrolledNodes > growthBudget)
+	{
+		return node;
+	}
+
+	growthBudget -= unrolledNodes;
+
+	TIntermAggregate *iterations = new TIntermAggregate(EOpSequence);
+	iterations->setLine(node->getLine());
+
+	for(const ConstantUnion &value : index.values)
+	{
+		ConstantUnion *constant = new ConstantUnion[1];
+		constant[0] = value;
+		TIntermConstantUnion *indexValue = new TIntermConstantUnion(constant, index.symbol->getType());
+		indexValue->setLine(index.symbol->getLine());
+
+		substitutions[index.symbol->getId()] = indexValue;
+		TIntermNode *iteration = clone(node->getBody());
+		substitutions.erase(index.symbol->getId());
+
+		iteration = optimizeNode(iteration);
+
+		if(iteration)
+		{
+			iterations->getSequence().push_back(iteration);
+		}
+	}
+
+	return iterations;
+}
+
+TIntermTyped *TreeOptimizer::foldIndex(TIntermBinary *node)
+{
+	TIntermTyped *left = node->getLeft();
+	TIntermConstantUnion *right = node->getRight()->getAsConstantUnion();
+
+	if(node->getOp() == EOpVectorSwizzle)
+	{
+		TIntermAggregate *components = node->getRight()->getAsAggregate();
+
+		if(!isConstant(left) || !components)
+		{
+			return node;
+		}
+
+		TIntermSequence &sequence = components->getSequence();
+		ConstantUnion *constants = new ConstantUnion[sequence.size()];
+
+		for(size_t i = 0; i < sequence.size(); i++)
+		{
+			int offset = sequence[i]->getAsConstantUnion()->getIConst(0);
+			constants[i] = left->getAsConstantUnion()->getUnionArrayPointer()[offset];
+		}
+
+		TIntermConstantUnion *folded = new TIntermConstantUnion(constants, node->getType());
+		folded->setLine(node->getLine());
+
+		return folded;
+	}
+
+	if(!isConstant(right) || !right->isScalar())
+	{
+		return node;
+	}
+
+	int index = (right->getBasicType() == EbtUInt) ? static_cast<int>(right->getUConst(0)) : right->getIConst(0);
+	size_t offset = 0;
+	size_t size = node->getType().getObjectSize();
+
+	if(node->getOp() == EOpIndexDirectStruct)
+	{
+		if(!isConstant(left))
+		{
+			return node;
+		}
+
+		const TFieldList &fields = left->getType().getStruct()->fields();
+
+		if(index < 0 || static_cast<size_t>(index) >= fields.size())
+		{
+			return node;
+		}
+
+		for(int i = 0; i < index; i++)
+		{
+			offset += fields[i]->type()->getObjectSize();
+		}
+	}
+	else
+	{
+		int count = left->isArray() ? left->getArraySize() : left->getNominalSize();
+
+		if(index < 0 || index >= count)
+		{
+			return node;
+		}
+
+		// A constant index allows direct register addressing
+		node->setOp(EOpIndexDirect);
+
+		if(!isConstant(left))
+		{
+			return node;
+		}
+
+		offset = index * size;
+	}
+
+	if(offset + size > left->getType().getObjectSize())
+	{
+		return node;
+	}
+
+	ConstantUnion *constants = new ConstantUnion[size];
+
+	for(size_t i = 0; i < size; i++)
+	{
+		constants[i] = left->getAsConstantUnion()->getUnionArrayPointer()[offset + i];
+	}
+
+	TIntermConstantUnion *folded = new TIntermConstantUnion(constants, node->getType());
+	folded->setLine(node->getLine());
+
+	return folded;
+}
+
+TIntermTyped *TreeOptimizer::foldConstructor(TIntermAggregate *node)
+{
+	if(node->getSequence().empty() || !node->isConstantFoldable())
+	{
+		return node;
+	}
+
+	const TType &type = node->getType();
+	ConstantUnion *constants = new ConstantUnion[type.getObjectSize()];
+	bool singleConstantParam = (node->getSequence().size() == 1);
+
+	TIntermediate intermediate(infoSink);
+
+	if(intermediate.parseConstTree(node->getLine(), node, constants, node->getOp(), type, singleConstantParam))
+	{
+		return node;
+	}
+
+	TIntermConstantUnion *folded = new TIntermConstantUnion(constants, type);
+	folded->setLine(node->getLine());
+
+	return folded;
+}
+
+TIntermTyped *TreeOptimizer::foldBuiltIn(TIntermAggregate *node)
+{
+	TIntermSequence &arguments = node->getSequence();
+
+	if(arguments.empty() || !node->isConstantFoldable())
+	{
+		return node;
+	}
+
+	TOperator op = node->getOp();
+	TIntermConstantUnion *x = arguments[0]->getAsConstantUnion();
+	TIntermConstantUnion *y = (arguments.size() > 1) ? arguments[1]->getAsConstantUnion() : nullptr;
+	TIntermConstantUnion *a = (arguments.size() > 2) ? arguments[2]->getAsConstantUnion() : nullptr;
+
+	if(arguments.size() == 2)
+	{
+		TIntermTyped *folded = x->fold(op, y, infoSink);
+
+		if(folded)
+		{
+			folded->setLine(node->getLine());
+			return folded;
+		}
+	}
+
+	if(node->getBasicType() != EbtFloat)
+	{
+		return node;
+	}
+
+	for(TIntermNode *argument : arguments)
+	{
+		if(argument->getAsTyped()->getBasicType() != EbtFloat)
+		{
+			return node;
+		}
+	}
+
+	size_t size = node->getType().getObjectSize();
+	ConstantUnion *constants = new ConstantUnion[size];
+
+	switch(op)
+	{
+	case EOpDot:
+	case EOpDistance:
+		if(!y || a || size != 1)
+		{
+			return node;
+		}
+		else
+		{
+			float result = 0.0f;
+
+			for(size_t i = 0; i < x->getType().getObjectSize(); i++)
+			{
+				float d = (op == EOpDot) ? x->getFConst(i) * y->getFConst(i) : x->getFConst(i) - y->getFConst(i);
+				result += (op == EOpDot) ? d : d * d;
+			}
+
+			constants[0].setFConst((op == EOpDot) ? result : sqrtf(result));
+		}
+		break;
+	case EOpPow:
+	case EOpMod:
+	case EOpStep:
+	case EOpAtan:
+		if(!y || a)
+		{
+			return node;
+		}
+
+		for(size_t i = 0; i < size; i++)
+		{
+			float s = component(x, i);
+			float t = component(y, i);
+
+			switch(op)
+			{
+			case EOpPow:  constants[i].setFConst(powf(s, t));                   break;
+			case EOpMod:  constants[i].setFConst(s - t * floorf(s / t));        break;
+			case EOpStep: constants[i].setFConst((t < s) ? 0.0f : 1.0f);        break;
+			case EOpAtan: constants[i].setFConst(atan2f(s, t));                 break;
+			default: UNREACHABLE(op);
+			}
+		}
+		break;
+	case EOpClamp:
+	case EOpMix:
+	case EOpSmoothStep:
+		if(!a)
+		{
+			return node;
+		}
+
+		for(size_t i = 0; i < size; i++)
+		{
+			float s = component(x, i);
+			float t = component(y, i);
+			float u = component(a, i);
+
+			switch(op)
+			{
+			case EOpClamp:
+				constants[i].setFConst(fminf(fmaxf(s, t), u));
+				break;
+			case EOpMix:
+				constants[i].setFConst(s * (1.0f - u) + t * u);
+				break;
+			case EOpSmoothStep:
+				{
+					float f = fminf(fmaxf((u - s) / (t - s), 0.0f), 1.0f);
+					constants[i].setFConst(f * f * (3.0f - 2.0f * f));
+				}
+				break;
+			default: UNREACHABLE(op);
+			}
+		}
+		break;
+	default:
+		return node;
+	}
+
+	TIntermConstantUnion *folded = new TIntermConstantUnion(constants, node->getType());
+	folded->setLine(node->getLine());
+
+	return folded;
+}
+
+TIntermTyped *TreeOptimizer::inlineCall(TIntermAggregate *node)
+{
+	TMap<TString, InlineFunction>::iterator function = inlineFunctions.find(node->getName());
+
+	if(function == inlineFunctions.end())
+	{
+		return nullptr;
+	}
+
+	TIntermSequence &parameters = *function->second.parameters;
+	TIntermSequence &arguments = node->getSequence();
+	TIntermTyped *expression = function->second.branch->getExpression();
+
+	if(parameters.size() != arguments.size())
+	{
+		return nullptr;
+	}
+
+	unsigned int size = nodeCount(expression);
+
+	if(size > MAX_INLINE_NODES || size > growthBudget)
+	{
+		return nullptr;
+	}
+
+	for(size_t i = 0; i < arguments.size(); i++)
+	{
+		TIntermTyped *argument = arguments[i]->getAsTyped();
+		int id = parameters[i]->getAsSymbolNode()->getId();
+
+		// Arguments get evaluated as many times as the parameter is referenced
+		if(!sideEffectFree(argument) || (symbolCount(expression, id) > 1 && !isTrivial(argument)))
+		{
+			return nullptr;
+		}
+	}
+
+	growthBudget -= size;
+	inlined = true;
+
+	for(size_t i = 0; i < arguments.size(); i++)
+	{
+		substitutions[parameters[i]->getAsSymbolNode()->getId()] = arguments[i]->getAsTyped();
+	}
+
+	TIntermTyped *inlineExpression = cloneTyped(expression);
+
+	for(size_t i = 0; i < arguments.size(); i++)
+	{
+		substitutions.erase(parameters[i]->getAsSymbolNode()->getId());
+	}
+
+	return optimizeTyped(inlineExpression);
+}
+
+bool TreeOptimizer::parseLoopIndex(TIntermLoop *node, LoopIndex &index)
+{
+	// Parse loops of the form:
+	// for(int index = initial; index [comparator] limit; index += increment)
+	if(node->getType() != ELoopFor || !node->getInit() || !node->getCondition() || !node->getExpression())
+	{
+		return false;
+	}
+
+	TIntermAggregate *init = node->getInit()->getAsAggregate();
+
+	if(!init || init->getOp() != EOpDeclaration || init->getSequence().size() != 1)
+	{
+		return false;
+	}
+
+	TIntermBinary *assign = init->getSequence()[0]->getAsBinaryNode();
+
+	if(!assign || assign->getOp() != EOpInitialize)
+	{
+		return false;
+	}
+
+	TIntermSymbol *symbol = assign->getLeft()->getAsSymbolNode();
+	TIntermTyped *initial = assign->getRight();
+
+	if(!symbol || !symbol->isScalar() || !isConstant(initial) ||
+	   (symbol->getBasicType() != EbtInt && symbol->getBasicType() != EbtFloat))
+	{
+		return false;
+	}
+
+	TIntermBinary *test = node->getCondition()->getAsBinaryNode();
+	TIntermSymbol *left = test ? test->getLeft()->getAsSymbolNode() : nullptr;
+
+	if(!left || left->getId() != symbol->getId() || !isConstant(test->getRight()))
+	{
+		return false;
+	}
+
+	switch(test->getOp())
+	{
+	case EOpLessThan:
+	case EOpGreaterThan:
+	case EOpLessThanEqual:
+	case EOpGreaterThanEqual:
+	case EOpEqual:
+	case EOpNotEqual:
+		break;
+	default:
+		return false;
+	}
+
+	ConstantUnion increment;
+	TOperator step = EOpAdd;
+	TIntermBinary *binaryTerminal = node->getExpression()->getAsBinaryNode();
+	TIntermUnary *unaryTerminal = node->getExpression()->getAsUnaryNode();
+
+	if(binaryTerminal)
+	{
+		TIntermSymbol *terminal = binaryTerminal->getLeft()->getAsSymbolNode();
+
+		if(!terminal || terminal->getId() != symbol->getId() || !isConstant(binaryTerminal->getRight()))
+		{
+			return false;
+		}
+
+		increment = binaryTerminal->getRight()->getAsConstantUnion()->getUnionArrayPointer()[0];
+
+		switch(binaryTerminal->getOp())
+		{
+		case EOpAddAssign: step = EOpAdd; break;
+		case EOpSubAssign: step = EOpSub; break;
+		default: return false;
+		}
+	}
+	else if(unaryTerminal)
+	{
+		TIntermSymbol *terminal = unaryTerminal->getOperand()->getAsSymbolNode();
+
+		if(!terminal || terminal->getId() != symbol->getId())
+		{
+			return false;
+		}
+
+		ConstantUnion one;
+		one.setIConst(1);
+		increment.cast(symbol->getBasicType(), one);
+
+		switch(unaryTerminal->getOp())
+		{
+		case EOpPostIncrement:
+		case EOpPreIncrement:
+			step = EOpAdd;
+			break;
+		case EOpPostDecrement:
+		case EOpPreDecrement:
+			step = EOpSub;
+			break;
+		default:
+			return false;
+		}
+	}
+	else
+	{
+		return false;
+	}
+
+	ConstantUnion value = initial->getAsConstantUnion()->getUnionArrayPointer()[0];
+	const ConstantUnion &limit = test->getRight()->getAsConstantUnion()->getUnionArrayPointer()[0];
+
+	while(compare(test->getOp(), value, limit))
+	{
+		if(index.values.size() == MAX_UNROLL_ITERATIONS)
+		{
+			return false;
+		}
+
+		index.values.push_back(value);
+		value = (step == EOpAdd) ? value + increment : value - increment;
+	}
+
+	index.symbol = symbol;
+
+	return !index.values.empty();
+}
+
+bool TreeOptimizer::loopUnrollable(TIntermNode *node, int index, int loopDepth, int switchDepth)
+{
+	// The loop can be unrolled when the body doesn't break out of it, doesn't skip to the next
+	// iteration, and doesn't write to the index.
+	if(!node)
+	{
+		return true;
+	}
+
+	TIntermBinary *binary = node->getAsBinaryNode();
+	TIntermUnary *unary = node->getAsUnaryNode();
+	TIntermAggregate *aggregate = node->getAsAggregate();
+	TIntermSelection *selection = node->getAsSelectionNode();
+	TIntermLoop *loop = node->getAsLoopNode();
+	TIntermBranch *branch = node->getAsBranchNode();
+	TIntermSwitch *switchNode = node->getAsSwitchNode();
+
+	if(binary)
+	{
+		if(binary->modifiesState() || binary->getOp() == EOpInitialize)
+		{
+			TIntermSymbol *symbol = binary->getLeft()->getAsSymbolNode();
+
+			if(symbol && symbol->getId() == index)
+			{
+				return false;
+			}
+		}
+
+		return loopUnrollable(binary->getLeft(), index, loopDepth, switchDepth) &&
+		       loopUnrollable(binary->getRight(), index, loopDepth, switchDepth);
+	}
+	else if(unary)
+	{
+		TIntermSymbol *symbol = unary->getOperand()->getAsSymbolNode();
+
+		if(unary->modifiesState() && symbol && symbol->getId() == index)
+		{
+			return false;
+		}
+
+		return loopUnrollable(unary->getOperand(), index, loopDepth, switchDepth);
+	}
+	else if(aggregate)
+	{
+		TIntermSequence *parameters = nullptr;
+
+		if(aggregate->getOp() == EOpFunctionCall && aggregate->isUserDefined())
+		{
+			TMap<TString, TIntermSequence*>::iterator function = functionParameters.find(aggregate->getName());
+			parameters = (function != functionParameters.end()) ? function->second : nullptr;
+		}
+
+		TIntermSequence &arguments = aggregate->getSequence();
+
+		for(size_t i = 0; i < arguments.size(); i++)
+		{
+			TIntermSymbol *symbol = arguments[i]->getAsSymbolNode();
+
+			if(symbol && symbol->getId() == index)
+			{
+				// Out parameters could write to the index
+				if(aggregate->getOp() == EOpModf && i == 1)
+				{
+					return false;
+				}
+				else if(aggregate->getOp() == EOpFunctionCall && aggregate->isUserDefined())
+				{
+					TIntermSymbol *parameter = (parameters && i < parameters->size()) ? (*parameters)[i]->getAsSymbolNode() : nullptr;
+
+					if(!parameter || parameter->getQualifier() == EvqOut || parameter->getQualifier() == EvqInOut)
+					{
+						return false;
+					}
+				}
+			}
+
+			if(!loopUnrollable(arguments[i], index, loopDepth, switchDepth))
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+	else if(selection)
+	{
+		return loopUnrollable(selection->getCondition(), index, loopDepth, switchDepth) &&
+		       loopUnrollable(selection->getTrueBlock(), index, loopDepth, switchDepth) &&
+		       loopUnrollable(selection->getFalseBlock(), index, loopDepth, switchDepth);
+	}
+	else if(loop)
+	{
+		return loopUnrollable(loop->getInit(), index, loopDepth + 1, switchDepth) &&
+		       loopUnrollable(loop->getCondition(), index, loopDepth + 1, switchDepth) &&
+		       loopUnrollable(loop->getExpression(), index, loopDepth + 1, switchDepth) &&
+		       loopUnrollable(loop->getBody(), index, loopDepth + 1, switchDepth);
+	}
+	else if(branch)
+	{
+		switch(branch->getFlowOp())
+		{
+		case EOpBreak:
+			return loopDepth > 0 || switchDepth > 0;
+		case EOpContinue:
+			return loopDepth > 0;
+		default:
+			return loopUnrollable(branch->getExpression(), index, loopDepth, switchDepth);
+		}
+	}
+	else if(switchNode)
+	{
+		return loopUnrollable(switchNode->getInit(), index, loopDepth, switchDepth) &&
+		       loopUnrollable(switchNode->getStatementList(), index, loopDepth, switchDepth + 1);
+	}
+
+	return true;
+}
+
+TIntermNode *TreeOptimizer::clone(TIntermNode *node)
+{
+	if(!node)
+	{
+		return nullptr;
+	}
+
+	TIntermTyped *typed = node->getAsTyped();
+	TIntermLoop *loop = node->getAsLoopNode();
+	TIntermBranch *branch = node->getAsBranchNode();
+	TIntermSwitch *switchNode = node->getAsSwitchNode();
+	TIntermCase *caseNode = node->getAsCaseNode();
+	TIntermNode *copy = nullptr;
+
+	if(typed)
+	{
+		return cloneTyped(typed);
+	}
+	else if(loop)
+	{
+		TIntermLoop *loopCopy = new TIntermLoop(loop->getType(), clone(loop->getInit()), cloneTyped(loop->getCondition()),
+		                                        cloneTyped(loop->getExpression()), clone(loop->getBody()));
+		loopCopy->setUnrollFlag(loop->getUnrollFlag());
+		copy = loopCopy;
+	}
+	else if(branch)
+	{
+		copy = new TIntermBranch(branch->getFlowOp(), cloneTyped(branch->getExpression()));
+	}
+	else if(switchNode)
+	{
+		TIntermNode *statementList = clone(switchNode->getStatementList());
+		copy = new TIntermSwitch(cloneTyped(switchNode->getInit()), statementList ? statementList->getAsAggregate() : nullptr);
+	}
+	else if(caseNode)
+	{
+		copy = new TIntermCase(cloneTyped(caseNode->getCondition()));
+	}
+	else UNREACHABLE(0);
+
+	copy->setLine(node->getLine());
+
+	return copy;
+}
+
+TIntermTyped *TreeOptimizer::cloneTyped(TIntermTyped *node)
+{
+	if(!node)
+	{
+		return nullptr;
+	}
+
+	TIntermSymbol *symbol = node->getAsSymbolNode();
+	TIntermConstantUnion *constant = node->getAsConstantUnion();
+	TIntermBinary *binary = node->getAsBinaryNode();
+	TIntermUnary *unary = node->getAsUnaryNode();
+	TIntermAggregate *aggregate = node->getAsAggregate();
+	TIntermSelection *selection = node->getAsSelectionNode();
+	TIntermTyped *copy = nullptr;
+
+	// The original type is preserved as-is, without re-deriving the qualifier from the operands
+	if(symbol)
+	{
+		TMap<int, TIntermTyped*>::iterator substitution = substitutions.find(symbol->getId());
+
+		if(substitution != substitutions.end())
+		{
+			return cloneTyped(substitution->second);
+		}
+
+		copy = new TIntermSymbol(symbol->getId(), symbol->getSymbol(), symbol->getType());
+	}
+	else if(constant)
+	{
+		copy = new TIntermConstantUnion(constant->getUnionArrayPointer(), constant->getType());
+	}
+	else if(binary)
+	{
+		TIntermBinary *binaryCopy = new TIntermBinary(binary->getOp());
+		binaryCopy->setLeft(cloneTyped(binary->getLeft()));
+		binaryCopy->setRight(cloneTyped(binary->getRight()));
+		binaryCopy->TIntermTyped::setType(binary->getType());
+		copy = binaryCopy;
+	}
+	else if(unary)
+	{
+		TType type = unary->getType();
+		TIntermUnary *unaryCopy = new TIntermUnary(unary->getOp(), type);
+		unaryCopy->setOperand(cloneTyped(unary->getOperand()));
+		copy = unaryCopy;
+	}
+	else if(aggregate)
+	{
+		TIntermAggregate *aggregateCopy = new TIntermAggregate(aggregate->getOp());
+
+		for(TIntermNode *child : aggregate->getSequence())
+		{
+			aggregateCopy->getSequence().push_back(clone(child));
+		}
+
+		aggregateCopy->setName(aggregate->getName());
+		aggregateCopy->setOptimize(aggregate->getOptimize());
+		aggregateCopy->setDebug(aggregate->getDebug());
+		aggregateCopy->setEndLine(aggregate->getEndLine());
+		aggregateCopy->TIntermTyped::setType(aggregate->getType());
+
+		if(aggregate->isUserDefined())
+		{
+			aggregateCopy->setUserDefined();
+		}
+
+		copy = aggregateCopy;
+	}
+	else if(selection)
+	{
+		TIntermTyped *condition = cloneTyped(selection->getCondition());
+		TIntermNode *trueBlock = clone(selection->getTrueBlock());
+		TIntermNode *falseBlock = clone(selection->getFalseBlock());
+
+		if(selection->usesTernaryOperator())
+		{
+			copy = new TIntermSelection(condition, trueBlock, falseBlock, selection->getType());
+		}
+		else
+		{
+			copy = new TIntermSelection(condition, trueBlock, falseBlock);
+		}
+	}
+	else UNREACHABLE(0);
+
+	copy->setLine(node->getLine());
+
+	return copy;
+}
+
+unsigned int TreeOptimizer::nodeCount(TIntermNode *node)
+{
+	if(!node)
+	{
+		return 0;
+	}
+
+	TIntermBinary *binary = node->getAsBinaryNode();
+	TIntermUnary *unary = node->getAsUnaryNode();
+	TIntermAggregate *aggregate = node->getAsAggregate();
+	TIntermSelection *selection = node->getAsSelectionNode();
+	TIntermLoop *loop = node->getAsLoopNode();
+	TIntermBranch *branch = node->getAsBranchNode();
+	TIntermSwitch *switchNode = node->getAsSwitchNode();
+
+	unsigned int count = 1;
+
+	if(binary)
+	{
+		count += nodeCount(binary->getLeft()) + nodeCount(binary->getRight());
+	}
+	else if(unary)
+	{
+		count += nodeCount(unary->getOperand());
+	}
+	else if(aggregate)
+	{
+		for(TIntermNode *child : aggregate->getSequence())
+		{
+			count += nodeCount(child);
+		}
+	}
+	else if(selection)
+	{
+		count += nodeCount(selection->getCondition()) + nodeCount(selection->getTrueBlock()) + nodeCount(selection->getFalseBlock());
+	}
+	else if(loop)
+	{
+		count += nodeCount(loop->getInit()) + nodeCount(loop->getCondition()) + nodeCount(loop->getExpression()) + nodeCount(loop->getBody());
+	}
+	else if(branch)
+	{
+		count += nodeCount(branch->getExpression());
+	}
+	else if(switchNode)
+	{
+		count += nodeCount(switchNode->getInit()) + nodeCount(switchNode->getStatementList());
+	}
+
+	return count;
+}
+
+unsigned int TreeOptimizer::symbolCount(TIntermNode *node, int id)
+{
+	if(!node)
+	{
+		return 0;
+	}
+
+	TIntermSymbol *symbol = node->getAsSymbolNode();
+	TIntermBinary *binary = node->getAsBinaryNode();
+	TIntermUnary *unary = node->getAsUnaryNode();
+	TIntermAggregate *aggregate = node->getAsAggregate();
+	TIntermSelection *selection = node->getAsSelectionNode();
+
+	unsigned int count = 0;
+
+	if(symbol)
+	{
+		count = (symbol->getId() == id) ? 1 : 0;
+	}
+	else if(binary)
+	{
+		count = symbolCount(binary->getLeft(), id) + symbolCount(binary->getRight(), id);
+	}
+	else if(unary)
+	{
+		count = symbolCount(unary->getOperand(), id);
+	}
+	else if(aggregate)
+	{
+		for(TIntermNode *child : aggregate->getSequence())
+		{
+			count += symbolCount(child, id);
+		}
+	}
+	else if(selection)
+	{
+		count = symbolCount(selection->getCondition(), id) + symbolCount(selection->getTrueBlock(), id) + symbolCount(selection->getFalseBlock(), id);
+	}
+
+	return count;
+}
+
+bool TreeOptimizer::sideEffectFree(TIntermNode *node)
+{
+	if(!node)
+	{
+		return true;
+	}
+
+	TIntermBinary *binary = node->getAsBinaryNode();
+	TIntermUnary *unary = node->getAsUnaryNode();
+	TIntermAggregate *aggregate = node->getAsAggregate();
+	TIntermSelection *selection = node->getAsSelectionNode();
+
+	if(node->getAsSymbolNode() || node->getAsConstantUnion())
+	{
+		return true;
+	}
+	else if(binary)
+	{
+		return !binary->modifiesState() && binary->getOp() != EOpInitialize &&
+		       sideEffectFree(binary->getLeft()) && sideEffectFree(binary->getRight());
+	}
+	else if(unary)
+	{
+		return !unary->modifiesState() && sideEffectFree(unary->getOperand());
+	}
+	else if(aggregate)
+	{
+		switch(aggregate->getOp())
+		{
+		case EOpFunctionCall:
+			if(aggregate->isUserDefined())
+			{
+				return false;
+			}
+			break;
+		case EOpModf:
+		case EOpSequence:
+		case EOpDeclaration:
+		case EOpInvariantDeclaration:
+			return false;
+		default:
+			break;
+		}
+
+		for(TIntermNode *child : aggregate->getSequence())
+		{
+			if(!sideEffectFree(child))
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+	else if(selection)
+	{
+		return selection->usesTernaryOperator() && sideEffectFree(selection->getCondition()) &&
+		       sideEffectFree(selection->getTrueBlock()) && sideEffectFree(selection->getFalseBlock());
+	}
+
+	return false;
+}
+
+bool TreeOptimizer::isConstant(TIntermNode *node)
+{
+	TIntermConstantUnion *constant = node ? node->getAsConstantUnion() : nullptr;
+
+	return constant && constant->getUnionArrayPointer();
+}
@@ -0,0 +1,79 @@
+// Copyright 2017 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef COMPILER_TREE_OPTIMIZER_H_
+#define COMPILER_TREE_OPTIMIZER_H_
+
+#include "intermediate.h"
+#include "InfoSink.h"
+
+// Simplifies the intermediate tree ahead of code generation. Functions consisting of a single
+// return expression are inlined, for-loops with a small constant trip count are fully unrolled
+// with the index replaced by constants, constant expressions (including built-in function calls
+// and indexing) are folded, and branches with a constant condition are removed.
+class TreeOptimizer
+{
+public:
+	TreeOptimizer();
+
+	void optimize(TIntermNode *root);
+
+private:
+	struct InlineFunction
+	{
+		TIntermSequence *parameters;
+		TIntermBranch *branch;   // Return statement
+	};
+
+	struct LoopIndex
+	{
+		TIntermSymbol *symbol;
+		TVector<ConstantUnion> values;   // Index value at the start of each iteration
+	};
+
+	void analyzeFunction(TIntermAggregate *function);
+
+	TIntermNode *optimizeNode(TIntermNode *node);
+	TIntermTyped *optimizeTyped(TIntermTyped *node);
+	TIntermTyped *optimizeBinary(TIntermBinary *node);
+	TIntermTyped *optimizeUnary(TIntermUnary *node);
+	TIntermTyped *optimizeAggregate(TIntermAggregate *node);
+	TIntermNode *optimizeSelection(TIntermSelection *node);
+	TIntermNode *optimizeLoop(TIntermLoop *node);
+
+	TIntermTyped *foldIndex(TIntermBinary *node);
+	TIntermTyped *foldConstructor(TIntermAggregate *node);
+	TIntermTyped *foldBuiltIn(TIntermAggregate *node);
+	TIntermTyped *inlineCall(TIntermAggregate *node);
+
+	bool parseLoopIndex(TIntermLoop *node, LoopIndex &index);
+	bool loopUnrollable(TIntermNode *node, int index, int loopDepth, int switchDepth);
+
+	TIntermNode *clone(TIntermNode *node);
+	TIntermTyped *cloneTyped(TIntermTyped *node);
+
+	static unsigned int nodeCount(TIntermNode *node);
+	static unsigned int symbolCount(TIntermNode *node, int id);
+	static bool sideEffectFree(TIntermNode *node);
+	static bool isConstant(TIntermNode *node);
+
+	TInfoSink infoSink;   // Diagnostics of failed folding attempts are discarded
+	TMap<TString, TIntermSequence*> functionParameters;
+	TMap<TString, InlineFunction> inlineFunctions;
+	TMap<int, TIntermTyped*> substitutions;   // Symbol id to replacement expression, applied by clone()
+	unsigned int growthBudget;   // Number of nodes which can still be added by unrolling and inlining
+	bool inlined;
+};
+
+#endif   // COMPILER_TREE_OPTIMIZER_H_
@@ -370,6 +370,11 @@ public:
 	TIntermTyped* getExpression() { return expr; }
 	TIntermNode* getBody() { return body; }
 
+	void setInit(TIntermNode* i) { init = i; }
+	void setCondition(TIntermTyped* c) { cond = c; }
+	void setExpression(TIntermTyped* e) { expr = e; }
+	void setBody(TIntermNode* b) { body = b; }
+
 	void setUnrollFlag(bool flag) { unrollFlag = flag; }
 	bool getUnrollFlag() { return unrollFlag; }
 
@@ -397,6 +402,7 @@ public:
 
 	TOperator getFlowOp() { return flowOp; }
 	TIntermTyped* getExpression() { return expression; }
+	void setExpression(TIntermTyped* e) { expression = e; }
 
 protected:
 	TOperator flowOp;
@@ -625,6 +631,10 @@ public:
 	TIntermNode* getFalseBlock() const { return falseBlock; }
 	TIntermSelection* getAsSelectionNode() { return this; }
 
+	void setCondition(TIntermTyped* c) { condition = c; }
+	void setTrueBlock(TIntermNode* t) { trueBlock = t; }
+	void setFalseBlock(TIntermNode* f) { falseBlock = f; }
+
 protected:
 	TIntermTyped* condition;
 	TIntermNode* trueBlock;
@@ -647,6 +657,7 @@ public:
 
 	TIntermTyped *getInit() { return mInit; }
 	TIntermAggregate *getStatementList() { return mStatementList; }
+	void setInit(TIntermTyped *init) { mInit = init; }
 	void setStatementList(TIntermAggregate *statementList) { mStatementList = statementList; }
 
 protected:
@@ -22,6 +22,7 @@
 #include <GLES/gl.h>
 
 namespace gl { class Surface; }
+namespace sw { class DrawProgress; }
 
 namespace egl
 {
@@ -38,6 +39,8 @@ public:
 	virtual EGLint getClientVersion() const = 0;
 	virtual EGLint getConfigID() const = 0;
 	virtual void finish() = 0;
+	virtual int getDrawSequence() const = 0;
+	virtual sw::DrawProgress *getDrawProgress() const = 0;
 	virtual void blit(sw::Surface *source, const sw::SliceRect &sRect, sw::Surface *dest, const sw::SliceRect &dRect) = 0;
 
 	Display *getDisplay() const { return display; }
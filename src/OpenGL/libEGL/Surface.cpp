@@ -259,7 +259,10 @@ void WindowSurface::swap()
 {
 	if(backBuffer && frameBuffer)
 	{
-		frameBuffer->flip(backBuffer);
+		if(!backBuffer->hasUndefinedContents())   // Invalidated contents don't need to be presented
+		{
+			frameBuffer->flip(backBuffer);
+		}
 
 		checkForResize();
 	}
@@ -18,34 +18,43 @@
 #define LIBEGL_SYNC_H_
 
 #include "Context.hpp"
+#include "Renderer/DrawProgress.hpp"
 
 #include <EGL/eglext.h>
 
 namespace egl
 {
 
+// Signaled once the context has finished all draw calls issued before the fence
 class FenceSync
 {
 public:
-	explicit FenceSync(Context *context) : context(context)
+	explicit FenceSync(Context *context) : progress(context->getDrawProgress())
 	{
-		status = EGL_UNSIGNALED_KHR;
-		context->addRef();
+		sequence = context->getDrawSequence();
+		progress->bind();
 	}
 
 	~FenceSync()
 	{
-		context->release();
-		context = nullptr;
+		progress->unbind();
 	}
 
-	void wait() { context->finish(); signal(); }
-	void signal() { status = EGL_SIGNALED_KHR; }
-	bool isSignaled() const { return status == EGL_SIGNALED_KHR; }
+	// Returns EGL_CONDITION_SATISFIED_KHR, or EGL_TIMEOUT_EXPIRED_KHR if the fence
+	// didn't signal within the timeout, in nanoseconds.
+	EGLint wait(EGLTimeKHR timeout)
+	{
+		return progress->wait(sequence, timeout) ? EGL_CONDITION_SATISFIED_KHR : EGL_TIMEOUT_EXPIRED_KHR;
+	}
+
+	bool isSignaled()
+	{
+		return progress->hasRetired(sequence);
+	}
 
 private:
-	EGLint status;
-	Context *context;
+	sw::DrawProgress *const progress;   // Doesn't keep the context alive
+	int sequence;
 };
 
 }
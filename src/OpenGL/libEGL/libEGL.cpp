@@ -978,6 +978,13 @@ EGLBoolean SwapBuffers(EGLDisplay dpy, EGLSurface surface)
 		return error(EGL_BAD_SURFACE, EGL_FALSE);
 	}
 
+	egl::Context *context = egl::getCurrentContext();
+
+	if(context && context->getClientVersion() >= 2 && libGLESv2)
+	{
+		libGLESv2->captureSwapBuffers();
+	}
+
 	eglSurface->swap();
 
 	return success(EGL_TRUE);
@@ -1229,15 +1236,9 @@ EGLint ClientWaitSyncKHR(EGLDisplay dpy, EGLSyncKHR sync, EGLint flags, EGLTimeK
 		return error(EGL_BAD_PARAMETER, EGL_FALSE);
 	}
 
-	(void)flags;
-	(void)timeout;
-
-	if(!eglSync->isSignaled())
-	{
-		eglSync->wait();
-	}
+	(void)flags;   // Commands are submitted as they are issued, so there is nothing to flush
 
-	return success(EGL_CONDITION_SATISFIED_KHR);
+	return success(eglSync->wait(timeout));
 }
 
 EGLBoolean GetSyncAttribKHR(EGLDisplay dpy, EGLSyncKHR sync, EGLint attribute, EGLint *value)
@@ -1263,7 +1264,6 @@ EGLBoolean GetSyncAttribKHR(EGLDisplay dpy, EGLSyncKHR sync, EGLint attribute, E
 		*value = EGL_SYNC_FENCE_KHR;
 		return success(EGL_TRUE);
 	case EGL_SYNC_STATUS_KHR:
-		eglSync->wait();   // TODO: Don't block. Just poll based on sw::Query.
 		*value = eglSync->isSignaled() ? EGL_SIGNALED_KHR : EGL_UNSIGNALED_KHR;
 		return success(EGL_TRUE);
 	case EGL_SYNC_CONDITION_KHR:
@@ -2861,6 +2861,16 @@ void Context::finish()
 	device->finish();
 }
 
+int Context::getDrawSequence() const
+{
+	return device->getDrawSequence();
+}
+
+sw::DrawProgress *Context::getDrawProgress() const
+{
+	return device->getDrawProgress();
+}
+
 void Context::flush()
 {
 	// We don't queue anything without processing it as fast as possible
@@ -300,6 +300,8 @@ public:
 	EGLint getConfigID() const override;
 
 	void finish() override;
+	int getDrawSequence() const override;
+	sw::DrawProgress *getDrawProgress() const override;
 
 	void markAllStateDirty();
 
@@ -27,6 +27,7 @@ endif
 
 COMMON_SRC_FILES := \
 	Buffer.cpp \
+	Capture.cpp \
 	Context.cpp \
 	Device.cpp \
 	Fence.cpp \
@@ -21,6 +21,7 @@
 #include "main.h"
 #include "VertexDataManager.h"
 #include "IndexDataManager.h"
+#include "Main/Config.hpp"
 
 namespace es2
 {
@@ -28,6 +29,7 @@ namespace es2
 Buffer::Buffer(GLuint name) : NamedObject(name)
 {
 	mContents = 0;
+	mRendererWrites = false;
 	mSize = 0;
 	mUsage = GL_STATIC_DRAW;
 	mIsMapped = false;
@@ -54,11 +56,12 @@ void Buffer::bufferData(const void *data, GLsizeiptr size, GLenum usage)
 
 	mSize = size;
 	mUsage = usage;
+	mRendererWrites = false;   // Until the new storage gets bound for renderer output
 
 	if(size > 0)
 	{
 		const int padding = 1024;   // For SIMD processing of vertices
-		mContents = new sw::Resource(size + padding);
+		mContents = new sw::Resource(size + padding, true);
 
 		if(!mContents)
 		{
@@ -77,16 +80,66 @@ void Buffer::bufferSubData(const void *data, GLsizeiptr size, GLintptr offset)
 {
 	if(mContents && data)
 	{
+		renameContents(offset != 0 || (size_t)size != mSize);
+
 		char *buffer = (char*)mContents->lock(sw::PUBLIC);
 		memcpy(buffer + offset, data, size);
 		mContents->unlock();
 	}
 }
 
+// Replaces the storage with a recycled allocation when in-flight draw calls still
+// read from it, instead of waiting for them to finish. The old storage is released
+// when they do. Returns false if the storage is not busy, or the renderer writes to it.
+bool Buffer::renameContents(bool preserve)
+{
+	if(!mContents->isBusy())
+	{
+		return false;
+	}
+
+	if(mRendererWrites)
+	{
+		sw::profiler.bufferWaits++;
+		return false;
+	}
+
+	sw::Resource *contents = new sw::Resource(mContents->size, true);
+
+	if(preserve)
+	{
+		memcpy(const_cast<void*>(contents->data()), mContents->data(), mSize);
+	}
+
+	mContents->destruct();
+	mContents = contents;
+	sw::profiler.bufferRenames++;
+
+	return true;
+}
+
 void* Buffer::mapRange(GLintptr offset, GLsizeiptr length, GLbitfield access)
 {
 	if(mContents)
 	{
+		if(access & GL_MAP_UNSYNCHRONIZED_BIT)
+		{
+			// The application guarantees it doesn't modify data in use by the renderer
+			mIsMapped = true;
+			mOffset = offset;
+			mLength = length;
+			mAccess = access;
+			return (char*)mContents->data() + offset;
+		}
+
+		if(access & GL_MAP_WRITE_BIT)
+		{
+			bool invalidate = (access & GL_MAP_INVALIDATE_BUFFER_BIT) ||
+			                  ((access & GL_MAP_INVALIDATE_RANGE_BIT) && offset == 0 && (size_t)length == mSize);
+
+			renameContents(!invalidate);
+		}
+
 		char* buffer = (char*)mContents->lock(sw::PUBLIC);
 		mIsMapped = true;
 		mOffset = offset;
@@ -99,7 +152,7 @@ void* Buffer::mapRange(GLintptr offset, GLsizeiptr length, GLbitfield access)
 
 bool Buffer::unmap()
 {
-	if(mContents)
+	if(mContents && !(mAccess & GL_MAP_UNSYNCHRONIZED_BIT))
 	{
 		mContents->unlock();
 	}
@@ -53,8 +53,15 @@ public:
 
 	sw::Resource *getResource();
 
+	// Buffers the renderer writes to, as transform feedback, pixel pack or query
+	// buffers, keep their storage so that the application observes the writes
+	void setRendererWrites() { mRendererWrites = true; }
+
 private:
+	bool renameContents(bool preserve);
+
 	sw::Resource *mContents;
+	bool mRendererWrites;
 	size_t mSize;
 	GLenum mUsage;
 	bool mIsMapped;
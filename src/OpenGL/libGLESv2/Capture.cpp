@@ -0,0 +1,449 @@
+// Copyright 2017 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Capture.cpp: Implements the Capture class, which records the OpenGL ES call
+// stream into a binary trace that can be replayed by tests/GLESReplay.
+
+#include "Capture.h"
+
+#include "main.h"
+#include "Buffer.h"
+#include "Context.h"
+#include "VertexArray.h"
+#include "Common/Configurator.hpp"
+
+#include <algorithm>
+#include <string.h>
+
+namespace es2
+{
+
+Capture *Capture::get()
+{
+	static Capture *capture = []() -> Capture*
+	{
+		sw::Configurator ini("SwiftShader.ini");
+		std::string path = ini.getValue("Capture", "File");
+
+		if(path.empty())
+		{
+			return nullptr;
+		}
+
+		FILE *file = fopen(path.c_str(), "wb");
+
+		if(!file)
+		{
+			ERR("Failed to open capture file %s", path.c_str());
+			return nullptr;
+		}
+
+		return new Capture(file);
+	}();
+
+	return capture;
+}
+
+Capture::Capture(FILE *file) : file(file)
+{
+	write((GLuint)CAPTURE_MAGIC);
+	write((GLuint)CAPTURE_VERSION);
+}
+
+void Capture::write(unsigned short value)
+{
+	unsigned char bytes[2] = {(unsigned char)value, (unsigned char)(value >> 8)};
+	fwrite(bytes, 1, sizeof(bytes), file);
+}
+
+void Capture::write(GLuint value)
+{
+	unsigned char bytes[4] = {(unsigned char)value, (unsigned char)(value >> 8), (unsigned char)(value >> 16), (unsigned char)(value >> 24)};
+	fwrite(bytes, 1, sizeof(bytes), file);
+}
+
+void Capture::write(GLfloat value)
+{
+	GLuint bits;
+	memcpy(&bits, &value, sizeof(bits));
+	write(bits);
+}
+
+void Capture::writeData(const void *data, size_t size)
+{
+	write((GLuint)size);
+
+	if(size > 0)
+	{
+		fwrite(data, 1, size, file);
+	}
+}
+
+void Capture::makeCurrent(GLsizei width, GLsizei height, GLint clientVersion)
+{
+	record(CAPTURE_MakeCurrent, width, height, clientVersion);
+}
+
+void Capture::swapBuffers()
+{
+	mutex.lock();
+	write((unsigned short)CAPTURE_SwapBuffers);
+	fflush(file);   // Keep the trace usable when the application is terminated
+	mutex.unlock();
+}
+
+// Calls with a negative size or offset only generate an error, so they're not recorded.
+// This also keeps the payload from being read past the end of the client data.
+void Capture::bufferData(GLenum target, GLsizeiptr size, const void *data, GLenum usage)
+{
+	if(size < 0)
+	{
+		return;
+	}
+
+	mutex.lock();
+	write((unsigned short)CAPTURE_BufferData);
+	write(target);
+	write((GLuint)size);
+	write(usage);
+	writeData(data, data ? size : 0);
+	mutex.unlock();
+}
+
+void Capture::bufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void *data)
+{
+	if(size < 0 || offset < 0)
+	{
+		return;
+	}
+
+	mutex.lock();
+	write((unsigned short)CAPTURE_BufferSubData);
+	write(target);
+	write((GLuint)offset);
+	writeData(data, data ? size : 0);
+	mutex.unlock();
+}
+
+// Image data is stored inline, or as an offset when a pixel unpack buffer is bound
+static size_t imageDataSize(GLsizei width, GLsizei height, GLenum format, GLenum type, const void *pixels, GLuint *offset)
+{
+	Context *context = getContext();
+
+	if(!context || context->getPixelUnpackBuffer())
+	{
+		*offset = (GLuint)(size_t)pixels;
+		return 0;
+	}
+
+	*offset = 0;
+
+	if(!pixels || width <= 0 || height <= 0)
+	{
+		return 0;
+	}
+
+	return context->getRequiredBufferSize(width, height, 1, format, type);
+}
+
+void Capture::texImage2D(GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const void *pixels)
+{
+	GLuint offset;
+	size_t size = imageDataSize(width, height, format, type, pixels, &offset);
+
+	mutex.lock();
+	write((unsigned short)CAPTURE_TexImage2D);
+	writeArguments(target, level, internalformat, width, height, border, format, type, offset);
+	writeData(pixels, size);
+	mutex.unlock();
+}
+
+void Capture::texSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLenum type, const void *pixels)
+{
+	GLuint offset;
+	size_t size = imageDataSize(width, height, format, type, pixels, &offset);
+
+	mutex.lock();
+	write((unsigned short)CAPTURE_TexSubImage2D);
+	writeArguments(target, level, xoffset, yoffset, width, height, format, type, offset);
+	writeData(pixels, size);
+	mutex.unlock();
+}
+
+void Capture::compressedTexImage2D(GLenum target, GLint level, GLenum internalformat, GLsizei width, GLsizei height, GLint border, GLsizei imageSize, const void *data)
+{
+	mutex.lock();
+	write((unsigned short)CAPTURE_CompressedTexImage2D);
+	writeArguments(target, level, internalformat, width, height, border);
+	writeData(data, (data && imageSize > 0) ? imageSize : 0);
+	mutex.unlock();
+}
+
+void Capture::compressedTexSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLsizei imageSize, const void *data)
+{
+	mutex.lock();
+	write((unsigned short)CAPTURE_CompressedTexSubImage2D);
+	writeArguments(target, level, xoffset, yoffset, width, height, format);
+	writeData(data, (data && imageSize > 0) ? imageSize : 0);
+	mutex.unlock();
+}
+
+// Number of values taken by a texture parameter
+static size_t texParameterCount(GLenum pname)
+{
+	switch(pname)
+	{
+	case GL_TEXTURE_BORDER_COLOR_OES: return 4;
+	default:                          return 1;
+	}
+}
+
+void Capture::texParameterv(CaptureCall call, GLenum target, GLenum pname, const void *params)
+{
+	if(!params)
+	{
+		return;
+	}
+
+	mutex.lock();
+	write((unsigned short)call);
+	writeArguments(target, pname);
+	writeData(params, texParameterCount(pname) * 4);
+	mutex.unlock();
+}
+
+void Capture::shaderSource(GLuint shader, GLsizei count, const GLchar *const *string, const GLint *length)
+{
+	std::string source;
+
+	for(GLsizei i = 0; i < count && string; i++)
+	{
+		if(!string[i])
+		{
+			continue;
+		}
+
+		if(length && length[i] >= 0)
+		{
+			source.append(string[i], length[i]);
+		}
+		else
+		{
+			source.append(string[i]);
+		}
+	}
+
+	mutex.lock();
+	write((unsigned short)CAPTURE_ShaderSource);
+	write(shader);
+	writeData(source.c_str(), source.size());
+	mutex.unlock();
+}
+
+void Capture::names(CaptureCall call, GLsizei n, const GLuint *names)
+{
+	if(n <= 0 || !names)
+	{
+		return;
+	}
+
+	mutex.lock();
+	write((unsigned short)call);
+	writeData(names, n * sizeof(GLuint));
+	mutex.unlock();
+}
+
+void Capture::location(CaptureCall call, GLuint program, const GLchar *name, GLint location)
+{
+	if(!name)
+	{
+		return;
+	}
+
+	mutex.lock();
+	write((unsigned short)call);
+	write(program);
+	write(location);
+	writeData(name, strlen(name));
+	mutex.unlock();
+}
+
+void Capture::uniform(CaptureCall call, GLint components, GLint location, GLsizei count, const void *values)
+{
+	if(count <= 0 || !values)
+	{
+		return;
+	}
+
+	mutex.lock();
+	write((unsigned short)call);
+	writeArguments(components, location, count);
+	writeData(values, components * count * 4);
+	mutex.unlock();
+}
+
+void Capture::uniformMatrix(GLint columns, GLint location, GLsizei count, GLboolean transpose, const GLfloat *values)
+{
+	if(count <= 0 || !values)
+	{
+		return;
+	}
+
+	mutex.lock();
+	write((unsigned short)CAPTURE_UniformMatrixfv);
+	writeArguments(columns, location, count, transpose);
+	writeData(values, columns * columns * count * sizeof(GLfloat));
+	mutex.unlock();
+}
+
+void Capture::vertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void *pointer)
+{
+	// Client-side arrays are captured at draw time, when the referenced range is known
+	Context *context = getContext();
+	GLuint buffer = context ? context->getArrayBufferName() : 0;
+
+	mutex.lock();
+	write((unsigned short)CAPTURE_VertexAttribPointer);
+	writeArguments(index, size, type, normalized, stride, buffer, (GLuint)(size_t)pointer);
+	mutex.unlock();
+}
+
+// Records the contents of enabled client-side vertex arrays for vertices [0, first + count)
+void Capture::clientArrays(GLint first, GLsizei count, GLsizei instanceCount)
+{
+	Context *context = getContext();
+
+	if(!context || first < 0 || count <= 0 || instanceCount <= 0)   // Capture runs before validation
+	{
+		return;
+	}
+
+	const VertexAttributeArray &attribs = context->getCurrentVertexAttributes();
+
+	for(int i = 0; i < MAX_VERTEX_ATTRIBS; i++)
+	{
+		const VertexAttribute &attrib = attribs[i];
+
+		if(!attrib.mArrayEnabled || attrib.mBoundBuffer || !attrib.mPointer)
+		{
+			continue;
+		}
+
+		GLsizei elements = first + count;
+
+		if(attrib.mDivisor > 0)
+		{
+			elements = (instanceCount + attrib.mDivisor - 1) / attrib.mDivisor;
+		}
+
+		if(elements <= 0)
+		{
+			continue;
+		}
+
+		size_t size = (elements - 1) * attrib.stride() + attrib.typeSize();
+
+		write((unsigned short)CAPTURE_ClientArray);
+		writeArguments((GLuint)i, attrib.mSize, attrib.mType, (GLboolean)attrib.mNormalized, attrib.mStride);
+		writeData(attrib.mPointer, size);
+	}
+}
+
+void Capture::drawArrays(GLenum mode, GLint first, GLsizei count, GLsizei instanceCount)
+{
+	mutex.lock();
+	clientArrays(first, count, instanceCount);
+
+	if(instanceCount == 1)
+	{
+		write((unsigned short)CAPTURE_DrawArrays);
+		writeArguments(mode, first, count);
+	}
+	else
+	{
+		write((unsigned short)CAPTURE_DrawArraysInstanced);
+		writeArguments(mode, first, count, instanceCount);
+	}
+	mutex.unlock();
+}
+
+template<typename Index>
+static GLint maximumIndex(const void *indices, GLsizei count)
+{
+	const Index *index = static_cast<const Index*>(indices);
+	GLint maximum = 0;
+
+	for(GLsizei i = 0; i < count; i++)
+	{
+		maximum = std::max(maximum, (GLint)index[i]);
+	}
+
+	return maximum;
+}
+
+void Capture::drawElements(GLenum mode, GLsizei count, GLenum type, const void *indices, GLsizei instanceCount)
+{
+	Context *context = getContext();
+	Buffer *elementArrayBuffer = context ? context->getCurrentVertexArray()->getElementArrayBuffer() : nullptr;
+
+	const void *data = indices;
+	size_t indexSize = (type == GL_UNSIGNED_INT) ? 4 : (type == GL_UNSIGNED_SHORT) ? 2 : 1;
+
+	if(elementArrayBuffer)
+	{
+		size_t offset = (size_t)indices;
+		data = (offset + count * indexSize <= elementArrayBuffer->size()) ? (const char*)elementArrayBuffer->data() + offset : nullptr;
+	}
+
+	GLint maxIndex = 0;
+
+	if(data && count > 0)
+	{
+		switch(type)
+		{
+		case GL_UNSIGNED_BYTE:  maxIndex = maximumIndex<GLubyte>(data, count);  break;
+		case GL_UNSIGNED_SHORT: maxIndex = maximumIndex<GLushort>(data, count); break;
+		case GL_UNSIGNED_INT:   maxIndex = maximumIndex<GLuint>(data, count);   break;
+		default: break;
+		}
+	}
+
+	mutex.lock();
+	clientArrays(0, (count > 0) ? maxIndex + 1 : 0, instanceCount);
+
+	if(instanceCount == 1)
+	{
+		write((unsigned short)CAPTURE_DrawElements);
+		writeArguments(mode, count, type);
+	}
+	else
+	{
+		write((unsigned short)CAPTURE_DrawElementsInstanced);
+		writeArguments(mode, count, type, instanceCount);
+	}
+
+	if(elementArrayBuffer)
+	{
+		write((GLuint)(size_t)indices);
+		writeData(nullptr, 0);
+	}
+	else
+	{
+		write((GLuint)0);
+		writeData(indices, indices && count > 0 ? count * indexSize : 0);
+	}
+	mutex.unlock();
+}
+
+}
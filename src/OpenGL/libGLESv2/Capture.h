@@ -0,0 +1,211 @@
+// Copyright 2017 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Capture.h: Defines the Capture class, which records the OpenGL ES call
+// stream into a binary trace that can be replayed by tests/GLESReplay.
+
+#ifndef LIBGLESV2_CAPTURE_H_
+#define LIBGLESV2_CAPTURE_H_
+
+#include "Common/MutexLock.hpp"
+
+#include <GLES2/gl2.h>
+
+#include <stdio.h>
+
+// Records an entry point call when capturing is enabled
+#define CAPTURE(method, ...) do { if(es2::Capture *capture = es2::Capture::get()) { capture->method(__VA_ARGS__); } } while(false)
+
+namespace es2
+{
+
+// Trace layout: a header of CAPTURE_MAGIC and CAPTURE_VERSION, followed by
+// records. Each record is a 16-bit CaptureCall followed by its arguments in
+// declaration order. Scalars are stored as 32-bit little-endian values and
+// payloads (buffer and texture data, shader sources, client arrays) as a
+// 32-bit byte count followed by the bytes. Object names are stored as
+// returned by the capturing implementation; the replayer remaps them. The
+// trace ends at the end of the file, since the application may exit at any
+// point.
+enum
+{
+	CAPTURE_MAGIC = 0x54435753,   // "SWCT"
+	CAPTURE_VERSION = 2,
+};
+
+enum CaptureCall : unsigned short
+{
+	CAPTURE_END = 0,   // Returned by readers at the end of the trace
+
+	// Window system
+	CAPTURE_MakeCurrent,   // width, height, clientVersion
+	CAPTURE_SwapBuffers,
+
+	// Pseudo-calls carrying data the application passes by pointer at draw time
+	CAPTURE_ClientArray,   // index, size, type, normalized, stride, data
+
+	CAPTURE_ActiveTexture,
+	CAPTURE_AttachShader,
+	CAPTURE_BindAttribLocation,
+	CAPTURE_BindBuffer,
+	CAPTURE_BindFramebuffer,
+	CAPTURE_BindRenderbuffer,
+	CAPTURE_BindTexture,
+	CAPTURE_BlendColor,
+	CAPTURE_BlendEquationSeparate,
+	CAPTURE_BlendFuncSeparate,
+	CAPTURE_BufferData,
+	CAPTURE_BufferSubData,
+	CAPTURE_Clear,
+	CAPTURE_ClearColor,
+	CAPTURE_ClearDepthf,
+	CAPTURE_ClearStencil,
+	CAPTURE_ColorMask,
+	CAPTURE_CompileShader,
+	CAPTURE_CompressedTexImage2D,
+	CAPTURE_CompressedTexSubImage2D,
+	CAPTURE_CopyTexImage2D,
+	CAPTURE_CopyTexSubImage2D,
+	CAPTURE_CreateProgram,
+	CAPTURE_CreateShader,
+	CAPTURE_CullFace,
+	CAPTURE_DeleteBuffers,
+	CAPTURE_DeleteFramebuffers,
+	CAPTURE_DeleteProgram,
+	CAPTURE_DeleteRenderbuffers,
+	CAPTURE_DeleteShader,
+	CAPTURE_DeleteTextures,
+	CAPTURE_DepthFunc,
+	CAPTURE_DepthMask,
+	CAPTURE_DepthRangef,
+	CAPTURE_DetachShader,
+	CAPTURE_Disable,
+	CAPTURE_DisableVertexAttribArray,
+	CAPTURE_DrawArrays,
+	CAPTURE_DrawArraysInstanced,
+	CAPTURE_DrawElements,
+	CAPTURE_DrawElementsInstanced,
+	CAPTURE_Enable,
+	CAPTURE_EnableVertexAttribArray,
+	CAPTURE_Finish,
+	CAPTURE_Flush,
+	CAPTURE_FramebufferRenderbuffer,
+	CAPTURE_FramebufferTexture2D,
+	CAPTURE_FrontFace,
+	CAPTURE_GenBuffers,
+	CAPTURE_GenerateMipmap,
+	CAPTURE_GenFramebuffers,
+	CAPTURE_GenRenderbuffers,
+	CAPTURE_GenTextures,
+	CAPTURE_GetAttribLocation,
+	CAPTURE_GetUniformLocation,
+	CAPTURE_Hint,
+	CAPTURE_LineWidth,
+	CAPTURE_LinkProgram,
+	CAPTURE_PixelStorei,
+	CAPTURE_PolygonOffset,
+	CAPTURE_ReadPixels,
+	CAPTURE_RenderbufferStorage,
+	CAPTURE_RenderbufferStorageMultisample,
+	CAPTURE_SampleCoverage,
+	CAPTURE_Scissor,
+	CAPTURE_ShaderSource,
+	CAPTURE_StencilFuncSeparate,
+	CAPTURE_StencilMaskSeparate,
+	CAPTURE_StencilOpSeparate,
+	CAPTURE_TexImage2D,
+	CAPTURE_TexParameterf,
+	CAPTURE_TexParameteri,
+	CAPTURE_TexSubImage2D,
+	CAPTURE_Uniformfv,          // components, location, count, values
+	CAPTURE_Uniformiv,          // components, location, count, values
+	CAPTURE_UniformMatrixfv,    // columns, location, count, transpose, values
+	CAPTURE_UseProgram,
+	CAPTURE_VertexAttrib4f,
+	CAPTURE_VertexAttribDivisor,
+	CAPTURE_VertexAttribPointer,
+	CAPTURE_Viewport,
+
+	// Version 2
+	CAPTURE_TexParameterfv,     // target, pname, values
+	CAPTURE_TexParameteriv,     // target, pname, values
+
+	CAPTURE_CALL_COUNT
+};
+
+class Capture
+{
+public:
+	// Returns the process-wide capture stream, or null when capturing is
+	// disabled. Capturing is enabled by setting File in the [Capture] section
+	// of SwiftShader.ini.
+	static Capture *get();
+
+	template<typename... Args>
+	void record(CaptureCall call, Args... args)
+	{
+		mutex.lock();
+		write((unsigned short)call);
+		writeArguments(args...);
+		mutex.unlock();
+	}
+
+	void makeCurrent(GLsizei width, GLsizei height, GLint clientVersion);
+	void swapBuffers();
+
+	// Calls whose payload size must be derived from the GL state
+	void bufferData(GLenum target, GLsizeiptr size, const void *data, GLenum usage);
+	void bufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void *data);
+	void texImage2D(GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const void *pixels);
+	void texSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLenum type, const void *pixels);
+	void compressedTexImage2D(GLenum target, GLint level, GLenum internalformat, GLsizei width, GLsizei height, GLint border, GLsizei imageSize, const void *data);
+	void compressedTexSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLsizei imageSize, const void *data);
+	void texParameterv(CaptureCall call, GLenum target, GLenum pname, const void *params);
+	void shaderSource(GLuint shader, GLsizei count, const GLchar *const *string, const GLint *length);
+	void names(CaptureCall call, GLsizei n, const GLuint *names);
+	void location(CaptureCall call, GLuint program, const GLchar *name, GLint location);
+	void uniform(CaptureCall call, GLint components, GLint location, GLsizei count, const void *values);
+	void uniformMatrix(GLint columns, GLint location, GLsizei count, GLboolean transpose, const GLfloat *values);
+	void vertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void *pointer);
+	void drawArrays(GLenum mode, GLint first, GLsizei count, GLsizei instanceCount);
+	void drawElements(GLenum mode, GLsizei count, GLenum type, const void *indices, GLsizei instanceCount);
+
+private:
+	Capture(FILE *file);   // Never destroyed, the trace gets flushed at each frame
+
+	void write(unsigned short value);
+	void write(GLuint value);
+	void write(GLint value) { write((GLuint)value); }
+	void write(GLfloat value);
+	void write(GLboolean value) { write((GLuint)value); }
+	void writeData(const void *data, size_t size);
+
+	void writeArguments() {}
+
+	template<typename T, typename... Args>
+	void writeArguments(T value, Args... args)
+	{
+		write(value);
+		writeArguments(args...);
+	}
+
+	void clientArrays(GLint first, GLsizei count, GLsizei instanceCount);
+
+	FILE *file;
+	sw::MutexLock mutex;
+};
+
+}
+
+#endif   // LIBGLESV2_CAPTURE_H_
@@ -22,6 +22,7 @@
 #include "utilities.h"
 #include "ResourceManager.h"
 #include "Buffer.h"
+#include "Capture.h"
 #include "Fence.h"
 #include "Framebuffer.h"
 #include "Program.h"
@@ -233,6 +234,7 @@ Context::~Context()
 	mState.copyWriteBuffer = nullptr;
 	mState.pixelPackBuffer = nullptr;
 	mState.pixelUnpackBuffer = nullptr;
+	mState.queryBuffer = nullptr;
 	mState.genericUniformBuffer = nullptr;
 
 	for(int i = 0; i < MAX_UNIFORM_BUFFER_BINDINGS; i++) {
@@ -282,6 +284,8 @@ void Context::makeCurrent(gl::Surface *surface)
 
 	if(surface)
 	{
+		CAPTURE(makeCurrent, surface->getWidth(), surface->getHeight(), clientVersion);
+
 		// Wrap the existing resources into GL objects and assign them to the '0' names
 		egl::Image *defaultRenderTarget = surface->getRenderTarget();
 		egl::Image *depthStencil = surface->getDepthStencil();
@@ -324,6 +328,11 @@ EGLint Context::getConfigID() const
 void Context::markAllStateDirty()
 {
 	mAppliedProgramSerial = 0;
+	mAppliedVertexShaderID = 0;
+	mAppliedPixelShaderID = 0;
+	mDepthRangeShaderID = 0;
+	mAppliedSamplerMask = 0;
+	mAppliedTextureMask = 0;
 
 	mDepthStateDirty = true;
 	mMaskStateDirty = true;
@@ -333,6 +342,7 @@ void Context::markAllStateDirty()
 	mSampleStateDirty = true;
 	mDitherStateDirty = true;
 	mFrontFaceDirty = true;
+	mCullStateDirty = true;
 }
 
 void Context::setClearColor(float red, float green, float blue, float alpha)
@@ -355,7 +365,11 @@ void Context::setClearStencil(int stencil)
 
 void Context::setCullFaceEnabled(bool enabled)
 {
-	mState.cullFaceEnabled = enabled;
+	if(mState.cullFaceEnabled != enabled)
+	{
+		mState.cullFaceEnabled = enabled;
+		mCullStateDirty = true;
+	}
 }
 
 bool Context::isCullFaceEnabled() const
@@ -365,7 +379,11 @@ bool Context::isCullFaceEnabled() const
 
 void Context::setCullMode(GLenum mode)
 {
-   mState.cullMode = mode;
+	if(mState.cullMode != mode)
+	{
+		mState.cullMode = mode;
+		mCullStateDirty = true;
+	}
 }
 
 void Context::setFrontFace(GLenum front)
@@ -374,6 +392,7 @@ void Context::setFrontFace(GLenum front)
 	{
 		mState.frontFace = front;
 		mFrontFaceDirty = true;
+		mCullStateDirty = true;
 	}
 }
 
@@ -937,7 +956,7 @@ GLuint Context::createVertexArray()
 
 GLsync Context::createFenceSync(GLenum condition, GLbitfield flags)
 {
-	GLuint handle = mResourceManager->createFenceSync(condition, flags);
+	GLuint handle = mResourceManager->createFenceSync(this, condition, flags);
 
 	return reinterpret_cast<GLsync>(static_cast<uintptr_t>(handle));
 }
@@ -1120,6 +1139,13 @@ void Context::bindCopyReadBuffer(GLuint buffer)
 	mState.copyReadBuffer = getBuffer(buffer);
 }
 
+void Context::bindQueryBuffer(GLuint buffer)
+{
+	mResourceManager->checkBufferAllocation(buffer);
+
+	mState.queryBuffer = getBuffer(buffer);
+}
+
 void Context::bindCopyWriteBuffer(GLuint buffer)
 {
 	mResourceManager->checkBufferAllocation(buffer);
@@ -1545,6 +1571,11 @@ Buffer *Context::getCopyReadBuffer() const
 	return mState.copyReadBuffer;
 }
 
+Buffer *Context::getQueryBuffer() const
+{
+	return mState.queryBuffer;
+}
+
 Buffer *Context::getCopyWriteBuffer() const
 {
 	return mState.copyWriteBuffer;
@@ -1609,6 +1640,9 @@ bool Context::getBuffer(GLenum target, es2::Buffer **buffer) const
 			break;
 		}
 		else return false;
+	case GL_QUERY_BUFFER_AMD:
+		*buffer = getQueryBuffer();
+		break;
 	case GL_COPY_WRITE_BUFFER:
 		if(clientVersion >= 3)
 		{
@@ -1935,6 +1969,7 @@ template<typename T> bool Context::getIntegerv(GLenum pname, T *params) const
 	case GL_SHADER_BINARY_FORMATS:      /* no shader binary formats are supported */          return true;
 	case GL_ARRAY_BUFFER_BINDING:             *params = getArrayBufferName();                 return true;
 	case GL_ELEMENT_ARRAY_BUFFER_BINDING:     *params = getElementArrayBufferName();          return true;
+	case GL_QUERY_BUFFER_BINDING_AMD:         *params = mState.queryBuffer.name();            return true;
 //	case GL_FRAMEBUFFER_BINDING:            // now equivalent to GL_DRAW_FRAMEBUFFER_BINDING_ANGLE
 	case GL_DRAW_FRAMEBUFFER_BINDING:         *params = mState.drawFramebuffer;               return true;
 	case GL_READ_FRAMEBUFFER_BINDING:         *params = mState.readFramebuffer;               return true;
@@ -2561,6 +2596,7 @@ bool Context::getQueryParameterInfo(GLenum pname, GLenum *type, unsigned int *nu
 	case GL_TEXTURE_BINDING_3D_OES:
 	case GL_COPY_READ_BUFFER_BINDING:
 	case GL_COPY_WRITE_BUFFER_BINDING:
+	case GL_QUERY_BUFFER_BINDING_AMD:
 	case GL_DRAW_BUFFER0:
 	case GL_DRAW_BUFFER1:
 	case GL_DRAW_BUFFER2:
@@ -2784,8 +2820,14 @@ bool Context::applyRenderTarget()
 
 	Program *program = getCurrentProgram();
 
-	if(program)
+	// The vertex shader's serial identifies both the program and its link
+	if(program && program->getVertexShader() &&
+	   (program->getVertexShader()->getSerialID() != mDepthRangeShaderID || zNear != mAppliedZNear || zFar != mAppliedZFar))
 	{
+		mDepthRangeShaderID = program->getVertexShader()->getSerialID();
+		mAppliedZNear = zNear;
+		mAppliedZFar = zFar;
+
 		GLfloat nearFarDiff[3] = {zNear, zFar, zFar - zNear};
 		program->setUniform1fv(program->getUniformLocation("gl_DepthRange.near"), 1, &nearFarDiff[0]);
 		program->setUniform1fv(program->getUniformLocation("gl_DepthRange.far"), 1, &nearFarDiff[1]);
@@ -2800,13 +2842,18 @@ void Context::applyState(GLenum drawMode)
 {
 	Framebuffer *framebuffer = getDrawFramebuffer();
 
-	if(mState.cullFaceEnabled)
-	{
-		device->setCullMode(es2sw::ConvertCullMode(mState.cullMode, mState.frontFace));
-	}
-	else
+	if(mCullStateDirty)
 	{
-		device->setCullMode(sw::CULL_NONE);
+		if(mState.cullFaceEnabled)
+		{
+			device->setCullMode(es2sw::ConvertCullMode(mState.cullMode, mState.frontFace));
+		}
+		else
+		{
+			device->setCullMode(sw::CULL_NONE);
+		}
+
+		mCullStateDirty = false;
 	}
 
 	if(mDepthStateDirty)
@@ -3066,8 +3113,18 @@ void Context::applyShaders()
 	sw::VertexShader *vertexShader = programObject->getVertexShader();
 	sw::PixelShader *pixelShader = programObject->getPixelShader();
 
-	device->setVertexShader(vertexShader);
-	device->setPixelShader(pixelShader);
+	// Rebinding reloads all constants, so only do it for new shaders
+	if(vertexShader->getSerialID() != mAppliedVertexShaderID)
+	{
+		device->setVertexShader(vertexShader);
+		mAppliedVertexShaderID = vertexShader->getSerialID();
+	}
+
+	if(pixelShader->getSerialID() != mAppliedPixelShaderID)
+	{
+		device->setPixelShader(pixelShader);
+		mAppliedPixelShaderID = pixelShader->getSerialID();
+	}
 
 	if(programObject->getSerial() != mAppliedProgramSerial)
 	{
@@ -3141,22 +3198,27 @@ void Context::applyTextures(sw::SamplerType samplerType)
 				GLenum swizzleB = texture->getSwizzleB();
 				GLenum swizzleA = texture->getSwizzleA();
 
-				device->setAddressingModeU(samplerType, samplerIndex, es2sw::ConvertTextureWrap(wrapS));
-				device->setAddressingModeV(samplerType, samplerIndex, es2sw::ConvertTextureWrap(wrapT));
-				device->setAddressingModeW(samplerType, samplerIndex, es2sw::ConvertTextureWrap(wrapR));
-				device->setCompareFunc(samplerType, samplerIndex, es2sw::ConvertCompareFunc(compFunc, compMode));
-				device->setSwizzleR(samplerType, samplerIndex, es2sw::ConvertSwizzleType(swizzleR));
-				device->setSwizzleG(samplerType, samplerIndex, es2sw::ConvertSwizzleType(swizzleG));
-				device->setSwizzleB(samplerType, samplerIndex, es2sw::ConvertSwizzleType(swizzleB));
-				device->setSwizzleA(samplerType, samplerIndex, es2sw::ConvertSwizzleType(swizzleA));
-				device->setMinLod(samplerType, samplerIndex, minLOD);
-				device->setMaxLod(samplerType, samplerIndex, maxLOD);
-				device->setBaseLevel(samplerType, samplerIndex, baseLevel);
-				device->setMaxLevel(samplerType, samplerIndex, maxLevel);
-				device->setTextureFilter(samplerType, samplerIndex, es2sw::ConvertTextureFilter(minFilter, magFilter, maxAnisotropy));
-				device->setMipmapFilter(samplerType, samplerIndex, es2sw::ConvertMipMapFilter(minFilter));
-				device->setMaxAnisotropy(samplerType, samplerIndex, maxAnisotropy);
-				device->setHighPrecisionFiltering(samplerType, samplerIndex, mState.textureFilteringHint == GL_NICEST);
+				SamplerParameters parameters;
+				memset(&parameters, 0, sizeof(SamplerParameters));   // Padding gets compared too
+
+				parameters.addressingModeU = es2sw::ConvertTextureWrap(wrapS);
+				parameters.addressingModeV = es2sw::ConvertTextureWrap(wrapT);
+				parameters.addressingModeW = es2sw::ConvertTextureWrap(wrapR);
+				parameters.compareFunc = es2sw::ConvertCompareFunc(compFunc, compMode);
+				parameters.swizzle[0] = es2sw::ConvertSwizzleType(swizzleR);
+				parameters.swizzle[1] = es2sw::ConvertSwizzleType(swizzleG);
+				parameters.swizzle[2] = es2sw::ConvertSwizzleType(swizzleB);
+				parameters.swizzle[3] = es2sw::ConvertSwizzleType(swizzleA);
+				parameters.minLod = minLOD;
+				parameters.maxLod = maxLOD;
+				parameters.baseLevel = baseLevel;
+				parameters.maxLevel = maxLevel;
+				parameters.textureFilter = es2sw::ConvertTextureFilter(minFilter, magFilter, maxAnisotropy);
+				parameters.mipmapFilter = es2sw::ConvertMipMapFilter(minFilter);
+				parameters.maxAnisotropy = maxAnisotropy;
+				parameters.highPrecisionFiltering = (mState.textureFilteringHint == GL_NICEST);
+
+				applySamplerParameters(samplerType, samplerIndex, parameters);
 
 				applyTexture(samplerType, samplerIndex, texture);
 			}
@@ -3172,6 +3234,36 @@ void Context::applyTextures(sw::SamplerType samplerType)
 	}
 }
 
+void Context::applySamplerParameters(sw::SamplerType type, int index, const SamplerParameters &parameters)
+{
+	int sampler = (type == sw::SAMPLER_PIXEL) ? index : 16 + index;
+
+	if((mAppliedSamplerMask & (1 << sampler)) && memcmp(&parameters, &mAppliedSampler[sampler], sizeof(SamplerParameters)) == 0)
+	{
+		return;
+	}
+
+	device->setAddressingModeU(type, index, parameters.addressingModeU);
+	device->setAddressingModeV(type, index, parameters.addressingModeV);
+	device->setAddressingModeW(type, index, parameters.addressingModeW);
+	device->setCompareFunc(type, index, parameters.compareFunc);
+	device->setSwizzleR(type, index, parameters.swizzle[0]);
+	device->setSwizzleG(type, index, parameters.swizzle[1]);
+	device->setSwizzleB(type, index, parameters.swizzle[2]);
+	device->setSwizzleA(type, index, parameters.swizzle[3]);
+	device->setMinLod(type, index, parameters.minLod);
+	device->setMaxLod(type, index, parameters.maxLod);
+	device->setBaseLevel(type, index, parameters.baseLevel);
+	device->setMaxLevel(type, index, parameters.maxLevel);
+	device->setTextureFilter(type, index, parameters.textureFilter);
+	device->setMipmapFilter(type, index, parameters.mipmapFilter);
+	device->setMaxAnisotropy(type, index, parameters.maxAnisotropy);
+	device->setHighPrecisionFiltering(type, index, parameters.highPrecisionFiltering);
+
+	memcpy(&mAppliedSampler[sampler], &parameters, sizeof(SamplerParameters));
+	mAppliedSamplerMask |= (1 << sampler);
+}
+
 void Context::applyTexture(sw::SamplerType type, int index, Texture *baseTexture)
 {
 	Program *program = getCurrentProgram();
@@ -3209,6 +3301,7 @@ void Context::applyTexture(sw::SamplerType type, int index, Texture *baseTexture
 		case GL_TEXTURE_RECTANGLE_ARB:
 		{
 			Texture2D *texture = static_cast<Texture2D*>(baseTexture);
+			egl::Image *surfaces[sw::MIPMAP_LEVELS];
 
 			for(int mipmapLevel = 0; mipmapLevel < sw::MIPMAP_LEVELS; mipmapLevel++)
 			{
@@ -3219,14 +3312,16 @@ void Context::applyTexture(sw::SamplerType type, int index, Texture *baseTexture
 					surfaceLevel = maxLevel;
 				}
 
-				egl::Image *surface = texture->getImage(surfaceLevel);
-				device->setTextureLevel(sampler, 0, mipmapLevel, surface, sw::TEXTURE_2D);
+				surfaces[mipmapLevel] = texture->getImage(surfaceLevel);
 			}
+
+			applyTextureLevels(sampler, baseTexture->getTarget(), surfaces, sw::TEXTURE_2D);
 		}
 		break;
 		case GL_TEXTURE_3D:
 		{
 			Texture3D *texture = static_cast<Texture3D*>(baseTexture);
+			egl::Image *surfaces[sw::MIPMAP_LEVELS];
 
 			for(int mipmapLevel = 0; mipmapLevel < sw::MIPMAP_LEVELS; mipmapLevel++)
 			{
@@ -3237,14 +3332,16 @@ void Context::applyTexture(sw::SamplerType type, int index, Texture *baseTexture
 					surfaceLevel = maxLevel;
 				}
 
-				egl::Image *surface = texture->getImage(surfaceLevel);
-				device->setTextureLevel(sampler, 0, mipmapLevel, surface, sw::TEXTURE_3D);
+				surfaces[mipmapLevel] = texture->getImage(surfaceLevel);
 			}
+
+			applyTextureLevels(sampler, baseTexture->getTarget(), surfaces, sw::TEXTURE_3D);
 		}
 		break;
 		case GL_TEXTURE_2D_ARRAY:
 		{
 			Texture2DArray *texture = static_cast<Texture2DArray*>(baseTexture);
+			egl::Image *surfaces[sw::MIPMAP_LEVELS];
 
 			for(int mipmapLevel = 0; mipmapLevel < sw::MIPMAP_LEVELS; mipmapLevel++)
 			{
@@ -3255,9 +3352,10 @@ void Context::applyTexture(sw::SamplerType type, int index, Texture *baseTexture
 					surfaceLevel = maxLevel;
 				}
 
-				egl::Image *surface = texture->getImage(surfaceLevel);
-				device->setTextureLevel(sampler, 0, mipmapLevel, surface, sw::TEXTURE_2D_ARRAY);
+				surfaces[mipmapLevel] = texture->getImage(surfaceLevel);
 			}
+
+			applyTextureLevels(sampler, baseTexture->getTarget(), surfaces, sw::TEXTURE_2D_ARRAY);
 		}
 		break;
 		case GL_TEXTURE_CUBE_MAP:
@@ -3281,16 +3379,59 @@ void Context::applyTexture(sw::SamplerType type, int index, Texture *baseTexture
 					device->setTextureLevel(sampler, face, mipmapLevel, surface, sw::TEXTURE_CUBE);
 				}
 			}
+
+			// Border updates must follow rendering into the faces, so cube maps are always applied
+			mAppliedTextureMask &= ~(1 << sampler);
 		}
 		break;
 		default:
 			UNIMPLEMENTED();
+			mAppliedTextureMask &= ~(1 << sampler);
 			break;
 		}
 	}
-	else
+	else if(!(mAppliedTextureMask & (1 << sampler)) || mAppliedTexture[sampler].target != GL_NONE)
 	{
 		device->setTextureLevel(sampler, 0, 0, 0, sw::TEXTURE_NULL);
+
+		mAppliedTexture[sampler].target = GL_NONE;
+		mAppliedTextureMask |= (1 << sampler);
+	}
+}
+
+// Surface revisions change on every write by the application, so matching ones mean the
+// sampler already holds these exact images and their current storage.
+void Context::applyTextureLevels(int sampler, GLenum target, egl::Image *const surfaces[sw::MIPMAP_LEVELS], sw::TextureType type)
+{
+	TextureLevels levels;
+	levels.target = target;
+
+	for(int mipmapLevel = 0; mipmapLevel < sw::MIPMAP_LEVELS; mipmapLevel++)
+	{
+		levels.revision[mipmapLevel] = surfaces[mipmapLevel] ? surfaces[mipmapLevel]->getRevision() : 0;
+	}
+
+	// External images can be backed by buffers which change without being written through GL
+	bool cacheable = (target != GL_TEXTURE_EXTERNAL_OES);
+
+	if(cacheable && (mAppliedTextureMask & (1 << sampler)) && memcmp(&levels, &mAppliedTexture[sampler], sizeof(TextureLevels)) == 0)
+	{
+		return;
+	}
+
+	for(int mipmapLevel = 0; mipmapLevel < sw::MIPMAP_LEVELS; mipmapLevel++)
+	{
+		device->setTextureLevel(sampler, 0, mipmapLevel, surfaces[mipmapLevel], type);
+	}
+
+	if(cacheable)
+	{
+		mAppliedTexture[sampler] = levels;
+		mAppliedTextureMask |= (1 << sampler);
+	}
+	else
+	{
+		mAppliedTextureMask &= ~(1 << sampler);
 	}
 }
 
@@ -3353,6 +3494,19 @@ void Context::readPixels(GLint x, GLint y, GLsizei width, GLsizei height, GLenum
 	sw::Surface *externalSurface = sw::Surface::create(width, height, 1, egl::ConvertFormatType(format, type), pixels, outputPitch, outputPitch * outputHeight);
 	sw::SliceRectF sliceRect(rect);
 	sw::SliceRect dstSliceRect(dstRect);
+
+	// Reading into a pixel pack buffer completes on the worker threads after the
+	// pending draw calls. Mapping the buffer or waiting on a fence synchronizes.
+	Buffer *pixelPackBuffer = getPixelPackBuffer();
+
+	if(pixelPackBuffer && format != GL_DEPTH_COMPONENT &&
+	   device->blitDeferred(renderTarget, sliceRect, externalSurface, dstSliceRect, pixelPackBuffer->getResource()))
+	{
+		pixelPackBuffer->setRendererWrites();
+		renderTarget->release();
+		return;   // The external surface is deleted by the renderer
+	}
+
 	device->blit(renderTarget, sliceRect, externalSurface, dstSliceRect, false, false, false);
 	delete externalSurface;
 
@@ -3559,23 +3713,7 @@ void Context::drawElements(GLenum mode, GLuint start, GLuint end, GLsizei count,
 		return error(GL_INVALID_OPERATION);
 	}
 
-	GLenum internalMode = mode;
-	if(isPrimitiveRestartFixedIndexEnabled())
-	{
-		switch(mode)
-		{
-		case GL_TRIANGLE_FAN:
-		case GL_TRIANGLE_STRIP:
-			internalMode = GL_TRIANGLES;
-			break;
-		case GL_LINE_LOOP:
-		case GL_LINE_STRIP:
-			internalMode = GL_LINES;
-			break;
-		default:
-			break;
-		}
-	}
+	GLenum internalMode = isPrimitiveRestartFixedIndexEnabled() ? SeparatePrimitiveMode(mode) : mode;
 
 	sw::DrawType primitiveType;
 	int primitiveCount;
@@ -3591,21 +3729,88 @@ void Context::drawElements(GLenum mode, GLuint start, GLuint end, GLsizei count,
 		return;
 	}
 
-	TranslatedIndexData indexInfo(primitiveCount);
+	TranslatedIndexData indexInfo(std::max(primitiveCount, 0));   // Strips of less than one primitive have a negative count
 	GLenum err = applyIndexBuffer(indices, start, end, count, mode, type, &indexInfo);
 	if(err != GL_NO_ERROR)
 	{
 		return error(err);
 	}
 
-	applyState(internalMode);
+	drawIndexed(internalMode, type, indexInfo, instanceCount);
+}
+
+void Context::multiDrawArrays(GLenum mode, const GLint *first, const GLsizei *count, GLsizei drawCount)
+{
+	GLenum internalMode = SeparatePrimitiveMode(mode);
+
+	if(!applyRenderTarget())
+	{
+		return;
+	}
+
+	TranslatedIndexData indexInfo(0);
+	GLenum err = mIndexDataManager->prepareIndexData(mode, first, count, drawCount, &indexInfo);
+	if(err != GL_NO_ERROR)
+	{
+		return error(err);
+	}
+
+	device->setIndexBuffer(indexInfo.indexBuffer);
+
+	drawIndexed(internalMode, GL_UNSIGNED_INT, indexInfo, 1);
+}
+
+void Context::multiDrawElements(GLenum mode, const GLsizei *count, GLenum type, const void *const *indices, GLsizei drawCount)
+{
+	Buffer *elementArrayBuffer = getCurrentVertexArray()->getElementArrayBuffer();
+
+	for(GLsizei i = 0; i < drawCount && !elementArrayBuffer; i++)
+	{
+		if(!indices[i])
+		{
+			return error(GL_INVALID_OPERATION);
+		}
+	}
+
+	GLenum internalMode = SeparatePrimitiveMode(mode);
+
+	if(!applyRenderTarget())
+	{
+		return;
+	}
+
+	TranslatedIndexData indexInfo(0);
+	GLenum err = mIndexDataManager->prepareIndexData(mode, type, count, indices, drawCount, elementArrayBuffer, &indexInfo, isPrimitiveRestartFixedIndexEnabled());
+	if(err != GL_NO_ERROR)
+	{
+		return error(err);
+	}
+
+	device->setIndexBuffer(indexInfo.indexBuffer);
+
+	drawIndexed(internalMode, type, indexInfo, 1);
+}
+
+// Draws the primitives of the translated index data
+void Context::drawIndexed(GLenum mode, GLenum type, const TranslatedIndexData &indexInfo, GLsizei instanceCount)
+{
+	sw::DrawType primitiveType;
+	int primitiveCount;
+	int verticesPerPrimitive;
+
+	if(!es2sw::ConvertPrimitiveType(mode, indexInfo.primitiveCount, type, primitiveType, primitiveCount, verticesPerPrimitive))
+	{
+		return error(GL_INVALID_ENUM);
+	}
+
+	applyState(mode);
 
 	for(int i = 0; i < instanceCount; ++i)
 	{
 		device->setInstanceID(i);
 
 		GLsizei vertexCount = indexInfo.maxIndex - indexInfo.minIndex + 1;
-		err = applyVertexBuffer(-(int)indexInfo.minIndex, indexInfo.minIndex, vertexCount, i);
+		GLenum err = applyVertexBuffer(-(int)indexInfo.minIndex, indexInfo.minIndex, vertexCount, i);
 		if(err != GL_NO_ERROR)
 		{
 			return error(err);
@@ -3624,13 +3829,13 @@ void Context::drawElements(GLenum mode, GLuint start, GLuint end, GLsizei count,
 			return error(GL_INVALID_OPERATION);
 		}
 
-		if(primitiveCount <= 0)
+		if(indexInfo.primitiveCount <= 0)
 		{
 			return;
 		}
 
 		TransformFeedback* transformFeedback = getTransformFeedback();
-		if(!cullSkipsDraw(internalMode) || (transformFeedback->isActive() && !transformFeedback->isPaused()))
+		if(!cullSkipsDraw(mode) || (transformFeedback->isActive() && !transformFeedback->isPaused()))
 		{
 			device->drawIndexedPrimitive(primitiveType, indexInfo.indexOffset, indexInfo.primitiveCount);
 		}
@@ -3657,6 +3862,16 @@ void Context::flush()
 	// We don't queue anything without processing it as fast as possible
 }
 
+int Context::getDrawSequence() const
+{
+	return device->getDrawSequence();
+}
+
+sw::DrawProgress *Context::getDrawProgress() const
+{
+	return device->getDrawProgress();
+}
+
 void Context::recordInvalidEnum()
 {
 	mInvalidEnum = true;
@@ -3757,6 +3972,11 @@ void Context::detachBuffer(GLuint buffer)
 		mState.copyWriteBuffer = nullptr;
 	}
 
+	if(mState.queryBuffer.name() == buffer)
+	{
+		mState.queryBuffer = nullptr;
+	}
+
 	if(mState.pixelPackBuffer.name() == buffer)
 	{
 		mState.pixelPackBuffer = nullptr;
@@ -4412,6 +4632,7 @@ const GLubyte *Context::getExtensions(GLuint index, GLuint *numExt) const
 		"GL_EXT_color_buffer_half_float",
 		"GL_EXT_draw_buffers",
 		"GL_EXT_instanced_arrays",
+		"GL_EXT_multi_draw_arrays",
 		"GL_EXT_occlusion_query_boolean",
 		"GL_EXT_read_format_bgra",
 		"GL_EXT_texture_compression_dxt1",
@@ -4422,6 +4643,7 @@ const GLubyte *Context::getExtensions(GLuint index, GLuint *numExt) const
 		"GL_KHR_texture_compression_astc_hdr",
 		"GL_KHR_texture_compression_astc_ldr",
 #endif
+		"GL_AMD_query_buffer_object",
 		"GL_ARB_texture_rectangle",
 		"GL_ANGLE_framebuffer_blit",
 		"GL_ANGLE_framebuffer_multisample",
@@ -407,6 +407,7 @@ struct State
 	gl::BindingPointer<Buffer> copyWriteBuffer;
 	gl::BindingPointer<Buffer> pixelPackBuffer;
 	gl::BindingPointer<Buffer> pixelUnpackBuffer;
+	gl::BindingPointer<Buffer> queryBuffer;
 	gl::BindingPointer<Buffer> genericUniformBuffer;
 	BufferBinding uniformBuffers[MAX_UNIFORM_BUFFER_BINDINGS];
 
@@ -581,6 +582,7 @@ public:
 	void bindArrayBuffer(GLuint buffer);
 	void bindElementArrayBuffer(GLuint buffer);
 	void bindCopyReadBuffer(GLuint buffer);
+	void bindQueryBuffer(GLuint buffer);
 	void bindCopyWriteBuffer(GLuint buffer);
 	void bindPixelPackBuffer(GLuint buffer);
 	void bindPixelUnpackBuffer(GLuint buffer);
@@ -635,6 +637,7 @@ public:
 	Buffer *getArrayBuffer() const;
 	Buffer *getElementArrayBuffer() const;
 	Buffer *getCopyReadBuffer() const;
+	Buffer *getQueryBuffer() const;
 	Buffer *getCopyWriteBuffer() const;
 	Buffer *getPixelPackBuffer() const;
 	Buffer *getPixelUnpackBuffer() const;
@@ -670,6 +673,8 @@ public:
 
 	void drawArrays(GLenum mode, GLint first, GLsizei count, GLsizei instanceCount = 1);
 	void drawElements(GLenum mode, GLuint start, GLuint end, GLsizei count, GLenum type, const void *indices, GLsizei instanceCount = 1);
+	void multiDrawArrays(GLenum mode, const GLint *first, const GLsizei *count, GLsizei drawCount);
+	void multiDrawElements(GLenum mode, const GLsizei *count, GLenum type, const void *const *indices, GLsizei drawCount);
 	void blit(sw::Surface *source, const sw::SliceRect &sRect, sw::Surface *dest, const sw::SliceRect &dRect) override;
 	void readPixels(GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, GLsizei *bufSize, void* pixels);
 	void clear(GLbitfield mask);
@@ -681,6 +686,9 @@ public:
 	void finish() override;
 	void flush();
 
+	int getDrawSequence() const override;
+	sw::DrawProgress *getDrawProgress() const override;
+
 	void recordInvalidEnum();
 	void recordInvalidValue();
 	void recordInvalidOperation();
@@ -705,6 +713,29 @@ public:
 	const GLubyte *getExtensions(GLuint index, GLuint *numExt = nullptr) const;
 
 private:
+	struct SamplerParameters
+	{
+		sw::AddressingMode addressingModeU;
+		sw::AddressingMode addressingModeV;
+		sw::AddressingMode addressingModeW;
+		sw::CompareFunc compareFunc;
+		sw::SwizzleType swizzle[4];
+		float minLod;
+		float maxLod;
+		int baseLevel;
+		int maxLevel;
+		sw::FilterType textureFilter;
+		sw::MipmapType mipmapFilter;
+		float maxAnisotropy;
+		bool highPrecisionFiltering;
+	};
+
+	struct TextureLevels
+	{
+		GLenum target;   // GL_NONE when the sampler is unused
+		unsigned int revision[sw::MIPMAP_LEVELS];
+	};
+
 	~Context() override;
 
 	void applyScissor(int width, int height);
@@ -715,8 +746,11 @@ private:
 	void applyShaders();
 	void applyTextures();
 	void applyTextures(sw::SamplerType type);
+	void applySamplerParameters(sw::SamplerType type, int index, const SamplerParameters &parameters);
 	void applyTexture(sw::SamplerType type, int sampler, Texture *texture);
+	void applyTextureLevels(int sampler, GLenum target, egl::Image *const surfaces[sw::MIPMAP_LEVELS], sw::TextureType type);
 	void clearColorBuffer(GLint drawbuffer, void *value, sw::Format format);
+	void drawIndexed(GLenum mode, GLenum type, const TranslatedIndexData &indexInfo, GLsizei instanceCount);
 
 	void detachBuffer(GLuint buffer);
 	void detachTexture(GLuint texture);
@@ -761,6 +795,17 @@ private:
 
 	unsigned int mAppliedProgramSerial;
 
+	// Device state last applied for draws, so that only changes get sent
+	int mAppliedVertexShaderID;
+	int mAppliedPixelShaderID;
+	int mDepthRangeShaderID;   // Vertex shader whose program holds the applied gl_DepthRange
+	float mAppliedZNear;
+	float mAppliedZFar;
+	unsigned int mAppliedSamplerMask;
+	unsigned int mAppliedTextureMask;
+	SamplerParameters mAppliedSampler[sw::TOTAL_IMAGE_UNITS];
+	TextureLevels mAppliedTexture[sw::TOTAL_IMAGE_UNITS];
+
 	// state caching flags
 	bool mDepthStateDirty;
 	bool mMaskStateDirty;
@@ -770,6 +815,7 @@ private:
 	bool mSampleStateDirty;
 	bool mFrontFaceDirty;
 	bool mDitherStateDirty;
+	bool mCullStateDirty;
 
 	Device *device;
 	ResourceManager *mResourceManager;
@@ -329,7 +329,16 @@ namespace es2
 		}
 
 		pixelShaderConstantsFDirty = max(startRegister + count, pixelShaderConstantsFDirty);
-		pixelShaderDirty = true;   // Reload DEF constants
+
+		// Without DEF constants to reload, the bound shader's uniforms can be updated in place
+		if(!pixelShaderDirty && pixelShader && !pixelShader->containsDefineInstruction() && startRegister < FRAGMENT_UNIFORM_VECTORS)
+		{
+			Renderer::setPixelShaderConstantF(startRegister, constantData, min(count, FRAGMENT_UNIFORM_VECTORS - startRegister));
+		}
+		else
+		{
+			pixelShaderDirty = true;   // Reload DEF constants
+		}
 	}
 
 	void Device::setScissorEnable(bool enable)
@@ -420,7 +429,15 @@ namespace es2
 		}
 
 		vertexShaderConstantsFDirty = max(startRegister + count, vertexShaderConstantsFDirty);
-		vertexShaderDirty = true;   // Reload DEF constants
+
+		if(!vertexShaderDirty && vertexShader && !vertexShader->containsDefineInstruction() && startRegister < VERTEX_UNIFORM_VECTORS)
+		{
+			Renderer::setVertexShaderConstantF(startRegister, constantData, min(count, VERTEX_UNIFORM_VECTORS - startRegister));
+		}
+		else
+		{
+			vertexShaderDirty = true;   // Reload DEF constants
+		}
 	}
 
 	void Device::setViewport(const Viewport &viewport)
@@ -17,7 +17,7 @@
 #include "Fence.h"
 
 #include "main.h"
-#include "Common/Thread.hpp"
+#include "Context.h"
 
 namespace es2
 {
@@ -27,6 +27,7 @@ Fence::Fence()
 	mQuery = false;
 	mCondition = GL_NONE;
 	mStatus = GL_FALSE;
+	mSequence = 0;
 }
 
 Fence::~Fence()
@@ -51,6 +52,9 @@ void Fence::setFence(GLenum condition)
 	mQuery = true;
 	mCondition = condition;
 	mStatus = GL_FALSE;
+
+	Context *context = getContext();
+	mSequence = context ? context->getDrawSequence() : 0;
 }
 
 GLboolean Fence::testFence()
@@ -60,10 +64,10 @@ GLboolean Fence::testFence()
 		return error(GL_INVALID_OPERATION, GL_TRUE);
 	}
 
-	// The current assumtion is that no matter where the fence is placed, it is
-	// done by the time it is tested, which is similar to Context::flush(), since
-	// we don't queue anything without processing it as fast as possible.
-	mStatus = GL_TRUE;
+	// Fence names are per-context, so the fence was set in the current context
+	Context *context = getContext();
+
+	mStatus = (!context || context->getDrawProgress()->hasRetired(mSequence)) ? GL_TRUE : GL_FALSE;
 
 	return mStatus;
 }
@@ -75,10 +79,14 @@ void Fence::finishFence()
 		return error(GL_INVALID_OPERATION);
 	}
 
-	while(!testFence())
+	Context *context = getContext();
+
+	if(context)
 	{
-		sw::Thread::yield();
+		context->getDrawProgress()->wait(mSequence, sw::DrawProgress::forever);
 	}
+
+	mStatus = GL_TRUE;
 }
 
 void Fence::getFenceiv(GLenum pname, GLint *params)
@@ -115,24 +123,45 @@ void Fence::getFenceiv(GLenum pname, GLint *params)
 	}
 }
 
-FenceSync::FenceSync(GLuint name, GLenum condition, GLbitfield flags) : NamedObject(name), mCondition(condition), mFlags(flags)
+FenceSync::FenceSync(GLuint name, GLenum condition, GLbitfield flags, Context *context) : NamedObject(name), mCondition(condition), mFlags(flags), mProgress(context->getDrawProgress())
 {
+	mSequence = context->getDrawSequence();
+	mProgress->bind();
 }
 
 FenceSync::~FenceSync()
 {
+	mProgress->unbind();
+}
+
+bool FenceSync::isSignaled()
+{
+	return mProgress->hasRetired(mSequence);
 }
 
 GLenum FenceSync::clientWait(GLbitfield flags, GLuint64 timeout)
 {
-	// The current assumtion is that no matter where the fence is placed, it is
-	// done by the time it is tested, which is similar to Context::flush(), since
-	// we don't queue anything without processing it as fast as possible.
-	return GL_ALREADY_SIGNALED;
+	if(isSignaled())
+	{
+		return GL_ALREADY_SIGNALED;
+	}
+
+	// Draw calls are handed to the renderer as soon as they are issued, so
+	// GL_SYNC_FLUSH_COMMANDS_BIT requires no further action.
+	return mProgress->wait(mSequence, timeout) ? GL_CONDITION_SATISFIED : GL_TIMEOUT_EXPIRED;
 }
 
 void FenceSync::serverWait(GLbitfield flags, GLuint64 timeout)
 {
+	// A context's draw calls execute in submission order, so only fences inserted by
+	// another context have to be waited on. The renderer can't make its draw calls
+	// depend on another renderer's progress, so block the issuing thread instead.
+	Context *context = getContext();
+
+	if(!context || context->getDrawProgress() != mProgress)
+	{
+		mProgress->wait(mSequence, sw::DrawProgress::forever);   // The timeout is always GL_TIMEOUT_IGNORED
+	}
 }
 
 void FenceSync::getSynciv(GLenum pname, GLsizei *length, GLint *values)
@@ -146,10 +175,7 @@ void FenceSync::getSynciv(GLenum pname, GLsizei *length, GLint *values)
 		}
 		break;
 	case GL_SYNC_STATUS:
-		// The current assumtion is that no matter where the fence is placed, it is
-		// done by the time it is tested, which is similar to Context::flush(), since
-		// we don't queue anything without processing it as fast as possible.
-		values[0] = GL_SIGNALED;
+		values[0] = isSignaled() ? GL_SIGNALED : GL_UNSIGNALED;
 		if(length) {
 			*length = 1;
 		}
@@ -18,11 +18,14 @@
 #define LIBGLESV2_FENCE_H_
 
 #include "common/Object.hpp"
+#include "Renderer/DrawProgress.hpp"
 #include <GLES2/gl2.h>
 
 namespace es2
 {
 
+class Context;
+
 class Fence
 {
 public:
@@ -39,12 +42,13 @@ private:
 	bool mQuery;
 	GLenum mCondition;
 	GLboolean mStatus;
+	int mSequence;   // Draw sequence number of the current context at SetFenceNV
 };
 
 class FenceSync : public gl::NamedObject
 {
 public:
-	FenceSync(GLuint name, GLenum condition, GLbitfield flags);
+	FenceSync(GLuint name, GLenum condition, GLbitfield flags, Context *context);
 	virtual ~FenceSync();
 
 	GLenum clientWait(GLbitfield flags, GLuint64 timeout);
@@ -55,8 +59,16 @@ public:
 	GLbitfield getFlags() const { return mFlags; }
 
 private:
+	bool isSignaled();
+
 	GLenum mCondition;
 	GLbitfield mFlags;
+
+	// The fence is signaled once the context which inserted it has finished
+	// all draw calls submitted before mSequence. Referencing the progress
+	// rather than the context avoids keeping the context alive.
+	sw::DrawProgress *const mProgress;
+	int mSequence;
 };
 
 }
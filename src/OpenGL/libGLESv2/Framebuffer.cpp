@@ -23,6 +23,7 @@
 #include "utilities.h"
 
 #include <algorithm>
+#include <limits>
 
 namespace es2
 {
@@ -174,6 +175,84 @@ void Framebuffer::detachRenderbuffer(GLuint renderbuffer)
 	}
 }
 
+// Discards the contents of attachments which are invalidated in their entirety.
+// Partially invalidated attachments are left untouched, which is a valid implementation.
+void Framebuffer::invalidate(GLsizei numAttachments, const GLenum *attachments, GLint x, GLint y, GLsizei width, GLsizei height)
+{
+	bool color[MAX_COLOR_ATTACHMENTS] = {};
+	bool depth = false;
+	bool stencil = false;
+
+	for(int i = 0; i < numAttachments; i++)
+	{
+		switch(attachments[i])
+		{
+		case GL_COLOR:                    color[0] = true; break;
+		case GL_DEPTH:                    depth = true;    break;
+		case GL_STENCIL:                  stencil = true;  break;
+		case GL_DEPTH_ATTACHMENT:         depth = true;    break;
+		case GL_STENCIL_ATTACHMENT:       stencil = true;  break;
+		case GL_DEPTH_STENCIL_ATTACHMENT: depth = true; stencil = true; break;
+		default:
+			if(attachments[i] >= GL_COLOR_ATTACHMENT0 && attachments[i] - GL_COLOR_ATTACHMENT0 < MAX_COLOR_ATTACHMENTS)
+			{
+				color[attachments[i] - GL_COLOR_ATTACHMENT0] = true;
+			}
+			break;
+		}
+	}
+
+	auto invalidateImage = [&](egl::Image *image)
+	{
+		sw::Rect rect(0, 0, image->getWidth(), image->getHeight());
+		rect.clip(x, y, static_cast<GLint>(std::min<GLint64>(static_cast<GLint64>(x) + width, std::numeric_limits<GLint>::max())),
+		                static_cast<GLint>(std::min<GLint64>(static_cast<GLint64>(y) + height, std::numeric_limits<GLint>::max())));
+
+		if(image->isEntire(rect))
+		{
+			image->invalidate();
+		}
+	};
+
+	for(GLuint i = 0; i < MAX_COLOR_ATTACHMENTS; i++)
+	{
+		if(color[i])
+		{
+			egl::Image *colorbuffer = getRenderTarget(i);
+
+			if(colorbuffer)
+			{
+				invalidateImage(colorbuffer);
+				colorbuffer->release();
+			}
+		}
+	}
+
+	egl::Image *depthbuffer = depth ? getDepthBuffer() : nullptr;
+	egl::Image *stencilbuffer = stencil ? getStencilBuffer() : nullptr;
+
+	// A combined depth-stencil image can only be discarded when both of its aspects are invalidated
+	if(depthbuffer && (stencil || !depthbuffer->hasStencil()))
+	{
+		invalidateImage(depthbuffer);
+	}
+
+	if(stencilbuffer && stencilbuffer != depthbuffer && (depth || !stencilbuffer->hasDepth()))
+	{
+		invalidateImage(stencilbuffer);
+	}
+
+	if(depthbuffer)
+	{
+		depthbuffer->release();
+	}
+
+	if(stencilbuffer)
+	{
+		stencilbuffer->release();
+	}
+}
+
 // Increments refcount on surface.
 // caller must Release() the returned surface
 egl::Image *Framebuffer::getRenderTarget(GLuint index)
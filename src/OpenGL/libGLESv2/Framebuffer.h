@@ -51,6 +51,8 @@ public:
 	void detachTexture(GLuint texture);
 	void detachRenderbuffer(GLuint renderbuffer);
 
+	void invalidate(GLsizei numAttachments, const GLenum *attachments, GLint x, GLint y, GLsizei width, GLsizei height);
+
 	egl::Image *getRenderTarget(GLuint index);
 	egl::Image *getReadRenderTarget();
 	egl::Image *getDepthBuffer();
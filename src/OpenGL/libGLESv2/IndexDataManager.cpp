@@ -158,16 +158,16 @@ void copyIndices(GLenum mode, GLenum type, const std::vector<GLsizei>& restartIn
 			if(numIndices >= 2)
 			{
 				GLsizei numLines = numIndices;
-				memcpy(outPtr, inPtr + (numIndices - 1) * bytesPerIndex, bytesPerIndex); // Last vertex
-				outPtr += bytesPerIndex;
-				memcpy(outPtr, inPtr, bytesPerIndex); // First vertex
-				outPtr += bytesPerIndex;
 				size_t bytesPerLine = 2 * bytesPerIndex;
 				for(GLsizei tri = 0; tri < (numLines - 1); ++tri)
 				{
 					memcpy(outPtr, inPtr + tri * bytesPerIndex, bytesPerLine);
 					outPtr += bytesPerLine;
 				}
+				memcpy(outPtr, inPtr + (numIndices - 1) * bytesPerIndex, bytesPerIndex); // Last vertex
+				outPtr += bytesPerIndex;
+				memcpy(outPtr, inPtr, bytesPerIndex); // First vertex
+				outPtr += bytesPerIndex;
 			}
 			inPtr += (numIndices + 1) * bytesPerIndex;
 		}
@@ -192,6 +192,75 @@ void copyIndices(GLenum mode, GLenum type, const std::vector<GLsizei>& restartIn
 	}
 }
 
+// Writes the separate primitives formed by consecutive vertices, in the same order as copyIndices()
+GLuint *generateIndices(GLenum mode, GLuint first, GLsizei count, GLuint *output)
+{
+	switch(mode)
+	{
+	case GL_TRIANGLES:
+	case GL_LINES:
+	case GL_POINTS:
+	{
+		GLsizei verticesPerPrimitive = (mode == GL_TRIANGLES) ? 3 : ((mode == GL_LINES) ? 2 : 1);
+		GLsizei numIndices = (count / verticesPerPrimitive) * verticesPerPrimitive;
+		for(GLsizei i = 0; i < numIndices; ++i)
+		{
+			*output++ = first + i;
+		}
+	}
+		break;
+	case GL_TRIANGLE_FAN:
+		for(GLsizei tri = 0; tri < count - 2; ++tri)
+		{
+			*output++ = first;
+			*output++ = first + tri + 1;
+			*output++ = first + tri + 2;
+		}
+		break;
+	case GL_TRIANGLE_STRIP:
+		for(GLsizei tri = 0; tri < count - 2; ++tri)
+		{
+			if(tri & 1) // Reverse odd triangles
+			{
+				*output++ = first + tri + 1;
+				*output++ = first + tri + 0;
+				*output++ = first + tri + 2;
+			}
+			else
+			{
+				*output++ = first + tri + 0;
+				*output++ = first + tri + 1;
+				*output++ = first + tri + 2;
+			}
+		}
+		break;
+	case GL_LINE_LOOP:
+		if(count >= 2)
+		{
+			for(GLsizei line = 0; line < count - 1; ++line)
+			{
+				*output++ = first + line + 0;
+				*output++ = first + line + 1;
+			}
+			*output++ = first + count - 1; // Last vertex
+			*output++ = first;             // First vertex
+		}
+		break;
+	case GL_LINE_STRIP:
+		for(GLsizei line = 0; line < count - 1; ++line)
+		{
+			*output++ = first + line + 0;
+			*output++ = first + line + 1;
+		}
+		break;
+	default:
+		UNREACHABLE(mode);
+		break;
+	}
+
+	return output;
+}
+
 template<class IndexType>
 void computeRange(const IndexType *indices, GLsizei count, GLuint *minIndex, GLuint *maxIndex, std::vector<GLsizei>* restartIndices)
 {
@@ -359,6 +428,150 @@ GLenum IndexDataManager::prepareIndexData(GLenum mode, GLenum type, GLuint start
 	return GL_NO_ERROR;
 }
 
+GLenum IndexDataManager::prepareIndexData(GLenum mode, const GLint *first, const GLsizei *count, GLsizei drawCount, TranslatedIndexData *translated)
+{
+	if(!mStreamingBuffer)
+	{
+		return GL_OUT_OF_MEMORY;
+	}
+
+	const std::vector<GLsizei> noRestarts;
+	int vertexPerPrimitive = 0;
+
+	translated->minIndex = 0;
+	translated->maxIndex = 0;
+	translated->primitiveCount = 0;
+
+	for(GLsizei i = 0; i < drawCount; i++)
+	{
+		unsigned int primitiveCount = 0;
+		vertexPerPrimitive = recomputePrimitiveCount(mode, count[i], noRestarts, &primitiveCount);
+		if(vertexPerPrimitive == -1)
+		{
+			return GL_INVALID_ENUM;
+		}
+
+		if(primitiveCount > 0)
+		{
+			GLuint minIndex = first[i];
+			GLuint maxIndex = first[i] + count[i] - 1;
+
+			bool firstRange = (translated->primitiveCount == 0);
+			translated->minIndex = firstRange ? minIndex : std::min(translated->minIndex, minIndex);
+			translated->maxIndex = firstRange ? maxIndex : std::max(translated->maxIndex, maxIndex);
+			translated->primitiveCount += primitiveCount;
+		}
+	}
+
+	StreamingIndexBuffer *streamingBuffer = mStreamingBuffer;
+
+	size_t streamOffset = 0;
+	int convertCount = translated->primitiveCount * vertexPerPrimitive;
+
+	streamingBuffer->reserveSpace(convertCount * sizeof(GLuint), GL_UNSIGNED_INT);
+	GLuint *output = static_cast<GLuint*>(streamingBuffer->map(sizeof(GLuint) * convertCount, &streamOffset));
+
+	if(output == NULL)
+	{
+		ERR("Failed to map index buffer.");
+		return GL_OUT_OF_MEMORY;
+	}
+
+	for(GLsizei i = 0; i < drawCount; i++)
+	{
+		output = generateIndices(mode, first[i], count[i], output);
+	}
+
+	streamingBuffer->unmap();
+
+	translated->indexBuffer = streamingBuffer->getResource();
+	translated->indexOffset = static_cast<unsigned int>(streamOffset);
+
+	return GL_NO_ERROR;
+}
+
+GLenum IndexDataManager::prepareIndexData(GLenum mode, GLenum type, const GLsizei *count, const void *const *indices, GLsizei drawCount, Buffer *buffer, TranslatedIndexData *translated, bool primitiveRestart)
+{
+	if(!mStreamingBuffer)
+	{
+		return GL_OUT_OF_MEMORY;
+	}
+
+	std::vector<const void*> data(drawCount);
+	std::vector<std::vector<GLsizei>> restartIndices(drawCount);
+	std::vector<unsigned int> primitiveCounts(drawCount);
+	int vertexPerPrimitive = 0;
+
+	translated->minIndex = 0;
+	translated->maxIndex = 0;
+	translated->primitiveCount = 0;
+
+	for(GLsizei i = 0; i < drawCount; i++)
+	{
+		data[i] = indices[i];
+
+		if(buffer != NULL)
+		{
+			intptr_t offset = reinterpret_cast<intptr_t>(indices[i]);
+
+			if(typeSize(type) * count[i] + offset > static_cast<std::size_t>(buffer->size()))
+			{
+				return GL_INVALID_OPERATION;
+			}
+
+			data[i] = static_cast<const GLubyte*>(buffer->data()) + offset;
+		}
+
+		GLuint minIndex = 0;
+		GLuint maxIndex = 0;
+		computeRange(type, data[i], count[i], &minIndex, &maxIndex, primitiveRestart ? &restartIndices[i] : nullptr);
+
+		vertexPerPrimitive = recomputePrimitiveCount(mode, count[i], restartIndices[i], &primitiveCounts[i]);
+		if(vertexPerPrimitive == -1)
+		{
+			return GL_INVALID_ENUM;
+		}
+
+		if(primitiveCounts[i] > 0)
+		{
+			bool firstRange = (translated->primitiveCount == 0);
+			translated->minIndex = firstRange ? minIndex : std::min(translated->minIndex, minIndex);
+			translated->maxIndex = firstRange ? maxIndex : std::max(translated->maxIndex, maxIndex);
+			translated->primitiveCount += primitiveCounts[i];
+		}
+	}
+
+	StreamingIndexBuffer *streamingBuffer = mStreamingBuffer;
+
+	size_t streamOffset = 0;
+	int convertCount = translated->primitiveCount * vertexPerPrimitive;
+
+	streamingBuffer->reserveSpace(convertCount * typeSize(type), type);
+	unsigned char *output = static_cast<unsigned char*>(streamingBuffer->map(typeSize(type) * convertCount, &streamOffset));
+
+	if(output == NULL)
+	{
+		ERR("Failed to map index buffer.");
+		return GL_OUT_OF_MEMORY;
+	}
+
+	for(GLsizei i = 0; i < drawCount; i++)
+	{
+		if(primitiveCounts[i] > 0)
+		{
+			copyIndices(mode, type, restartIndices[i], data[i], count[i], output);
+			output += primitiveCounts[i] * vertexPerPrimitive * typeSize(type);
+		}
+	}
+
+	streamingBuffer->unmap();
+
+	translated->indexBuffer = streamingBuffer->getResource();
+	translated->indexOffset = static_cast<unsigned int>(streamOffset);
+
+	return GL_NO_ERROR;
+}
+
 std::size_t IndexDataManager::typeSize(GLenum type)
 {
 	switch(type)
@@ -63,6 +63,10 @@ public:
 
 	GLenum prepareIndexData(GLenum mode, GLenum type, GLuint start, GLuint end, GLsizei count, Buffer *arrayElementBuffer, const void *indices, TranslatedIndexData *translated, bool primitiveRestart);
 
+	// Concatenate multiple draws into a single list of separate primitives
+	GLenum prepareIndexData(GLenum mode, const GLint *first, const GLsizei *count, GLsizei drawCount, TranslatedIndexData *translated);
+	GLenum prepareIndexData(GLenum mode, GLenum type, const GLsizei *count, const void *const *indices, GLsizei drawCount, Buffer *arrayElementBuffer, TranslatedIndexData *translated, bool primitiveRestart);
+
 	static std::size_t typeSize(GLenum type);
 
 private:
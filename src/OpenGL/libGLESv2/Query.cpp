@@ -17,6 +17,7 @@
 #include "Query.h"
 
 #include "main.h"
+#include "Buffer.h"
 #include "Common/Thread.hpp"
 
 namespace es2
@@ -32,11 +33,22 @@ Query::Query(GLuint name, GLenum type) : NamedObject(name)
 
 Query::~Query()
 {
-	delete mQuery;
+	if(mQuery)
+	{
+		mQuery->destroy();
+	}
 }
 
 void Query::begin()
 {
+	// Draw calls from the previous use may still be in flight. Leave them a
+	// query of their own instead of waiting for them to retire.
+	if(mQuery && !mQuery->isIdle())
+	{
+		mQuery->destroy();
+		mQuery = nullptr;
+	}
+
 	if(!mQuery)
 	{
 		sw::Query::Type type;
@@ -131,6 +143,40 @@ GLboolean Query::isResultAvailable()
 	return mStatus;
 }
 
+void Query::writeResult(GLenum pname, Buffer *buffer, GLintptr offset)
+{
+	GLuint value;
+
+	switch(pname)
+	{
+	case GL_QUERY_RESULT_EXT:
+		if(mQuery && !testQuery())
+		{
+			bool boolean = (mType != GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN);
+			buffer->setRendererWrites();
+			mQuery->writeResult(buffer->getResource(), offset, boolean);
+			return;
+		}
+		value = (GLuint)mResult;
+		break;
+	case GL_QUERY_RESULT_AVAILABLE_EXT:
+		value = isResultAvailable();
+		break;
+	case GL_QUERY_RESULT_NO_WAIT_AMD:
+		if(!isResultAvailable())
+		{
+			return;   // Leave the buffer contents untouched
+		}
+		value = (GLuint)mResult;
+		break;
+	default:
+		UNREACHABLE(pname);
+		return;
+	}
+
+	buffer->bufferSubData(&value, sizeof(value), offset);
+}
+
 GLenum Query::getType() const
 {
 	return mType;
@@ -140,7 +186,10 @@ GLboolean Query::testQuery()
 {
 	if(mQuery != nullptr && mStatus != GL_TRUE)
 	{
-		if(!mQuery->building && mQuery->reference == 0)
+		bool anySamples = (mType != GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN);
+
+		// Once a sample has passed, the boolean result can't change anymore
+		if(!mQuery->building && (mQuery->reference == 0 || (anySamples && mQuery->data > 0)))
 		{
 			unsigned int resultSum = mQuery->data;
 			mStatus = GL_TRUE;
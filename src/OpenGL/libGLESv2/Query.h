@@ -22,9 +22,22 @@
 
 #include <GLES2/gl2.h>
 
+// GL_AMD_query_buffer_object
+#ifndef GL_QUERY_BUFFER_AMD
+#define GL_QUERY_BUFFER_AMD 0x9192
+#endif
+#ifndef GL_QUERY_BUFFER_BINDING_AMD
+#define GL_QUERY_BUFFER_BINDING_AMD 0x9193
+#endif
+#ifndef GL_QUERY_RESULT_NO_WAIT_AMD
+#define GL_QUERY_RESULT_NO_WAIT_AMD 0x9194
+#endif
+
 namespace es2
 {
 
+class Buffer;
+
 class Query : public gl::NamedObject
 {
 public:
@@ -36,6 +49,9 @@ public:
 	GLuint getResult();
 	GLboolean isResultAvailable();
 
+	// Writes the result to the query buffer once it becomes available, without blocking
+	void writeResult(GLenum pname, Buffer *buffer, GLintptr offset);
+
 	GLenum getType() const;
 
 private:
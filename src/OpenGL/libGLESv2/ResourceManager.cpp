@@ -136,11 +136,11 @@ GLuint ResourceManager::createSampler()
 }
 
 // Returns the next unused fence name, and allocates the fence
-GLuint ResourceManager::createFenceSync(GLenum condition, GLbitfield flags)
+GLuint ResourceManager::createFenceSync(Context *context, GLenum condition, GLbitfield flags)
 {
 	GLuint name = mFenceSyncNameSpace.allocate();
 
-	FenceSync *fenceSync = new FenceSync(name, condition, flags);
+	FenceSync *fenceSync = new FenceSync(name, condition, flags, context);
 	fenceSync->addRef();
 
 	mFenceSyncNameSpace.insert(name, fenceSync);
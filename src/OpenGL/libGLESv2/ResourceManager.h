@@ -33,6 +33,7 @@ class Texture;
 class Renderbuffer;
 class Sampler;
 class FenceSync;
+class Context;
 
 enum TextureType
 {
@@ -62,7 +63,7 @@ public:
 	GLuint createTexture();
 	GLuint createRenderbuffer();
 	GLuint createSampler();
-	GLuint createFenceSync(GLenum condition, GLbitfield flags);
+	GLuint createFenceSync(Context *context, GLenum condition, GLbitfield flags);
 
 	void deleteBuffer(GLuint buffer);
 	void deleteShader(GLuint shader);
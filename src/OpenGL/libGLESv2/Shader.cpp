@@ -194,6 +194,8 @@ void Shader::clear()
 
 	varyings.clear();
 	activeUniforms.clear();
+	activeUniformStructs.clear();
+	activeUniformBlocks.clear();
 	activeAttributes.clear();
 }
 
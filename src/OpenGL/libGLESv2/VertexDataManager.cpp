@@ -22,6 +22,8 @@
 #include "IndexDataManager.h"
 #include "common/debug.h"
 
+#include <algorithm>
+
 namespace
 {
 	enum {INITIAL_STREAM_BUFFER_SIZE = 1024 * 1024};
@@ -44,6 +46,10 @@ VertexDataManager::VertexDataManager(Context *context) : mContext(context)
 	{
 		ERR("Failed to allocate the streaming vertex buffer.");
 	}
+
+	mSnapshotValid = false;
+	mSnapshotStart = 0;
+	mSnapshotCount = 0;
 }
 
 VertexDataManager::~VertexDataManager()
@@ -109,33 +115,153 @@ unsigned int VertexDataManager::writeAttributeData(StreamingVertexBuffer *vertex
 	return streamOffset;
 }
 
-GLenum VertexDataManager::prepareVertexData(GLint start, GLsizei count, TranslatedAttribute *translated, GLsizei instanceId)
+GLenum VertexDataManager::writeClientArrays(ClientArray *clientArrays, int clientArrayCount, GLint start, GLsizei count, TranslatedAttribute *translated, GLsizei instanceId)
 {
-	if(!mStreamingBuffer)
+	const VertexAttributeArray &attribs = mContext->getVertexArrayAttributes();
+
+	// Interleaved arrays span overlapping memory, which gets copied once as a whole
+	std::sort(clientArrays, clientArrays + clientArrayCount, [](const ClientArray &a, const ClientArray &b) { return a.begin < b.begin; });
+
+	struct Span
 	{
-		return GL_OUT_OF_MEMORY;
+		int first;   // Range of client arrays within the span
+		int last;
+		const char *begin;
+		const char *end;
+		unsigned int packedSize;
+		bool contiguous;   // Copied as-is rather than per attribute
+	};
+
+	Span spans[MAX_VERTEX_ATTRIBS];
+	int spanCount = 0;
+
+	for(int i = 0; i < clientArrayCount; i++)
+	{
+		if(spanCount > 0 && clientArrays[i].begin <= spans[spanCount - 1].end)
+		{
+			Span &span = spans[spanCount - 1];
+			span.last = i;
+			span.end = std::max(span.end, clientArrays[i].end);
+			span.packedSize += clientArrays[i].packedSize;
+		}
+		else
+		{
+			Span &span = spans[spanCount++];
+			span.first = i;
+			span.last = i;
+			span.begin = clientArrays[i].begin;
+			span.end = clientArrays[i].end;
+			span.packedSize = clientArrays[i].packedSize;
+		}
 	}
 
-	const VertexAttributeArray &attribs = mContext->getVertexArrayAttributes();
-	const VertexAttributeArray &currentAttribs = mContext->getCurrentVertexAttributes();
-	Program *program = mContext->getCurrentProgram();
+	for(int i = 0; i < spanCount; i++)
+	{
+		// Sparse spans, like a single attribute of a large vertex structure, are cheaper to pack
+		spans[i].contiguous = (unsigned int)(spans[i].end - spans[i].begin) <= 2 * spans[i].packedSize;
+		mStreamingBuffer->addRequiredSpace(spans[i].contiguous ? (unsigned int)(spans[i].end - spans[i].begin) : spans[i].packedSize);
+	}
 
-	// Determine the required storage size per used buffer
-	for(int i = 0; i < MAX_VERTEX_ATTRIBS; i++)
+	if(mStreamingBuffer->reserveRequiredSpace())
 	{
-		const VertexAttribute &attrib = attribs[i].mArrayEnabled ? attribs[i] : currentAttribs[i];
+		mSnapshotValid = false;
+	}
+
+	bool reuseSnapshot = (instanceId > 0) && mSnapshotValid && (start == mSnapshotStart) && (count == mSnapshotCount);
+
+	for(int i = 0; i < spanCount; i++)
+	{
+		const Span &span = spans[i];
+
+		bool instanced = false;
 
-		if(program->getAttributeStream(i) != -1 && attrib.mArrayEnabled)
+		for(int j = span.first; j <= span.last; j++)
 		{
-			if(!attrib.mBoundBuffer)
+			instanced = instanced || (attribs[clientArrays[j].index].mDivisor > 0);
+		}
+
+		if(reuseSnapshot && !instanced)
+		{
+			for(int j = span.first; j <= span.last; j++)
 			{
+				translated[clientArrays[j].index].offset = mSnapshotOffset[clientArrays[j].index];
+				translated[clientArrays[j].index].stride = mSnapshotStride[clientArrays[j].index];
+			}
+		}
+		else if(span.contiguous)
+		{
+			unsigned int streamOffset = 0;
+			char *output = (char*)mStreamingBuffer->map(attribs[clientArrays[span.first].index], (unsigned int)(span.end - span.begin), &streamOffset);
+
+			if(!output)
+			{
+				ERR("Failed to map vertex buffer.");
+				return GL_OUT_OF_MEMORY;
+			}
+
+			memcpy(output, span.begin, span.end - span.begin);
+			mStreamingBuffer->unmap();
+
+			for(int j = span.first; j <= span.last; j++)
+			{
+				translated[clientArrays[j].index].offset = streamOffset + (unsigned int)(clientArrays[j].begin - span.begin);
+			}
+		}
+		else
+		{
+			for(int j = span.first; j <= span.last; j++)
+			{
+				const VertexAttribute &attrib = attribs[clientArrays[j].index];
 				const bool isInstanced = attrib.mDivisor > 0;
-				mStreamingBuffer->addRequiredSpace(attrib.typeSize() * (isInstanced ? 1 : count));
+				GLint firstVertexIndex = isInstanced ? instanceId / attrib.mDivisor : start;
+
+				unsigned int streamOffset = writeAttributeData(mStreamingBuffer, firstVertexIndex, isInstanced ? 1 : count, attrib);
+
+				if(streamOffset == ~0u)
+				{
+					return GL_OUT_OF_MEMORY;
+				}
+
+				translated[clientArrays[j].index].offset = streamOffset;
+				translated[clientArrays[j].index].stride = isInstanced ? 0 : attrib.typeSize();
+			}
+		}
+
+		for(int j = span.first; j <= span.last; j++)
+		{
+			translated[clientArrays[j].index].vertexBuffer = mStreamingBuffer->getResource();
+
+			if(instanceId == 0)
+			{
+				mSnapshotOffset[clientArrays[j].index] = translated[clientArrays[j].index].offset;
+				mSnapshotStride[clientArrays[j].index] = translated[clientArrays[j].index].stride;
 			}
 		}
 	}
 
-	mStreamingBuffer->reserveRequiredSpace();
+	if(instanceId == 0)
+	{
+		mSnapshotValid = true;
+		mSnapshotStart = start;
+		mSnapshotCount = count;
+	}
+
+	return GL_NO_ERROR;
+}
+
+GLenum VertexDataManager::prepareVertexData(GLint start, GLsizei count, TranslatedAttribute *translated, GLsizei instanceId)
+{
+	if(!mStreamingBuffer)
+	{
+		return GL_OUT_OF_MEMORY;
+	}
+
+	const VertexAttributeArray &attribs = mContext->getVertexArrayAttributes();
+	const VertexAttributeArray &currentAttribs = mContext->getCurrentVertexAttributes();
+	Program *program = mContext->getCurrentProgram();
+
+	ClientArray clientArrays[MAX_VERTEX_ATTRIBS];
+	int clientArrayCount = 0;
 
 	// Perform the vertex data translations
 	for(int i = 0; i < MAX_VERTEX_ATTRIBS; i++)
@@ -168,18 +294,18 @@ GLenum VertexDataManager::prepareVertexData(GLint start, GLsizei count, Translat
 					translated[i].offset = firstVertexIndex * attrib.stride() + static_cast<int>(attrib.mOffset);
 					translated[i].stride = isInstanced ? 0 : attrib.stride();
 				}
-				else
+				else   // Client arrays get snapshotted by writeClientArrays()
 				{
-					unsigned int streamOffset = writeAttributeData(mStreamingBuffer, firstVertexIndex, isInstanced ? 1 : count, attrib);
+					GLsizei elements = isInstanced ? 1 : count;
+					const char *input = static_cast<const char*>(attrib.mPointer) + attrib.stride() * firstVertexIndex;
 
-					if(streamOffset == ~0u)
-					{
-						return GL_OUT_OF_MEMORY;
-					}
+					ClientArray &clientArray = clientArrays[clientArrayCount++];
+					clientArray.index = i;
+					clientArray.begin = input;
+					clientArray.end = (elements > 0) ? input + attrib.stride() * (elements - 1) + attrib.typeSize() : input;
+					clientArray.packedSize = attrib.typeSize() * elements;
 
-					translated[i].vertexBuffer = mStreamingBuffer->getResource();
-					translated[i].offset = streamOffset;
-					translated[i].stride = isInstanced ? 0 : attrib.typeSize();
+					translated[i].stride = isInstanced ? 0 : attrib.stride();
 				}
 
 				switch(attrib.mType)
@@ -233,6 +359,11 @@ GLenum VertexDataManager::prepareVertexData(GLint start, GLsizei count, Translat
 		}
 	}
 
+	if(clientArrayCount > 0)
+	{
+		return writeClientArrays(clientArrays, clientArrayCount, start, count, translated, instanceId);
+	}
+
 	return GL_NO_ERROR;
 }
 
@@ -321,8 +452,10 @@ void *StreamingVertexBuffer::map(const VertexAttribute &attribute, unsigned int
 	return mapPtr;
 }
 
-void StreamingVertexBuffer::reserveRequiredSpace()
+bool StreamingVertexBuffer::reserveRequiredSpace()
 {
+	bool discarded = (mRequiredSpace > mBufferSize) || (mWritePosition + mRequiredSpace > mBufferSize);
+
 	if(mRequiredSpace > mBufferSize)
 	{
 		if(mVertexBuffer)
@@ -354,6 +487,8 @@ void StreamingVertexBuffer::reserveRequiredSpace()
 	}
 
 	mRequiredSpace = 0;
+
+	return discarded;
 }
 
 }
@@ -66,7 +66,7 @@ public:
 	~StreamingVertexBuffer();
 
 	void *map(const VertexAttribute &attribute, unsigned int requiredSpace, unsigned int *streamOffset);
-	void reserveRequiredSpace();
+	bool reserveRequiredSpace();   // Returns true when previously written data was discarded
 	void addRequiredSpace(unsigned int requiredSpace);
 
 protected:
@@ -86,12 +86,28 @@ public:
 	GLenum prepareVertexData(GLint start, GLsizei count, TranslatedAttribute *outAttribs, GLsizei instanceId);
 
 private:
+	struct ClientArray
+	{
+		int index;
+		const char *begin;
+		const char *end;
+		unsigned int packedSize;
+	};
+
 	unsigned int writeAttributeData(StreamingVertexBuffer *vertexBuffer, GLint start, GLsizei count, const VertexAttribute &attribute);
+	GLenum writeClientArrays(ClientArray *clientArrays, int clientArrayCount, GLint start, GLsizei count, TranslatedAttribute *translated, GLsizei instanceId);
 
 	Context *const mContext;
 
 	StreamingVertexBuffer *mStreamingBuffer;
 
+	// Non-instanced client arrays written for the first instance, reused by the other instances
+	bool mSnapshotValid;
+	GLint mSnapshotStart;
+	GLsizei mSnapshotCount;
+	unsigned int mSnapshotOffset[MAX_VERTEX_ATTRIBS];
+	unsigned int mSnapshotStride[MAX_VERTEX_ATTRIBS];
+
 	bool mDirtyCurrentValue[MAX_VERTEX_ATTRIBS];
 	ConstantVertexBuffer *mCurrentValueBuffer[MAX_VERTEX_ATTRIBS];
 };
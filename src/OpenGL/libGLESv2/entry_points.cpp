@@ -15,6 +15,9 @@
 // entry_points.cpp: GL entry points exports and definition
 
 #include "main.h"
+#include "Capture.h"
+#include "Main/Config.hpp"
+#include "Common/Memory.hpp"
 
 #include "libEGL/main.h"
 
@@ -72,6 +75,8 @@ void DrawElementsInstancedEXT(GLenum mode, GLsizei count, GLenum type, const voi
 void VertexAttribDivisorEXT(GLuint index, GLuint divisor);
 void DrawArraysInstancedANGLE(GLenum mode, GLint first, GLsizei count, GLsizei instanceCount);
 void DrawElementsInstancedANGLE(GLenum mode, GLsizei count, GLenum type, const void *indices, GLsizei instanceCount);
+void MultiDrawArraysEXT(GLenum mode, const GLint *first, const GLsizei *count, GLsizei primcount);
+void MultiDrawElementsEXT(GLenum mode, const GLsizei *count, GLenum type, const void *const *indices, GLsizei primcount);
 void VertexAttribDivisorANGLE(GLuint index, GLuint divisor);
 void Enable(GLenum cap);
 void EnableVertexAttribArray(GLuint index);
@@ -227,11 +232,15 @@ extern "C"
 {
 GL_APICALL void GL_APIENTRY glActiveTexture(GLenum texture)
 {
+	CAPTURE(record, es2::CAPTURE_ActiveTexture, texture);
+
 	return es2::ActiveTexture(texture);
 }
 
 GL_APICALL void GL_APIENTRY glAttachShader(GLuint program, GLuint shader)
 {
+	CAPTURE(record, es2::CAPTURE_AttachShader, program, shader);
+
 	return es2::AttachShader(program, shader);
 }
 
@@ -242,71 +251,99 @@ GL_APICALL void GL_APIENTRY glBeginQueryEXT(GLenum target, GLuint name)
 
 GL_APICALL void GL_APIENTRY glBindAttribLocation(GLuint program, GLuint index, const GLchar* name)
 {
+	CAPTURE(location, es2::CAPTURE_BindAttribLocation, program, name, (GLint)index);
+
 	return es2::BindAttribLocation(program, index, name);
 }
 
 GL_APICALL void GL_APIENTRY glBindBuffer(GLenum target, GLuint buffer)
 {
+	CAPTURE(record, es2::CAPTURE_BindBuffer, target, buffer);
+
 	return es2::BindBuffer(target, buffer);
 }
 
 GL_APICALL void GL_APIENTRY glBindFramebuffer(GLenum target, GLuint framebuffer)
 {
+	CAPTURE(record, es2::CAPTURE_BindFramebuffer, target, framebuffer);
+
 	return es2::BindFramebuffer(target, framebuffer);
 }
 
 GL_APICALL void GL_APIENTRY glBindFramebufferOES(GLenum target, GLuint framebuffer)
 {
+	CAPTURE(record, es2::CAPTURE_BindFramebuffer, target, framebuffer);
+
 	return es2::BindFramebuffer(target, framebuffer);
 }
 
 GL_APICALL void GL_APIENTRY glBindRenderbuffer(GLenum target, GLuint renderbuffer)
 {
+	CAPTURE(record, es2::CAPTURE_BindRenderbuffer, target, renderbuffer);
+
 	return es2::BindRenderbuffer(target, renderbuffer);
 }
 
 GL_APICALL void GL_APIENTRY glBindRenderbufferOES(GLenum target, GLuint renderbuffer)
 {
+	CAPTURE(record, es2::CAPTURE_BindRenderbuffer, target, renderbuffer);
+
 	return es2::BindRenderbuffer(target, renderbuffer);
 }
 
 GL_APICALL void GL_APIENTRY glBindTexture(GLenum target, GLuint texture)
 {
+	CAPTURE(record, es2::CAPTURE_BindTexture, target, texture);
+
 	return es2::BindTexture(target, texture);
 }
 
 GL_APICALL void GL_APIENTRY glBlendColor(GLclampf red, GLclampf green, GLclampf blue, GLclampf alpha)
 {
+	CAPTURE(record, es2::CAPTURE_BlendColor, red, green, blue, alpha);
+
 	return es2::BlendColor(red, green, blue, alpha);
 }
 
 GL_APICALL void GL_APIENTRY glBlendEquation(GLenum mode)
 {
+	CAPTURE(record, es2::CAPTURE_BlendEquationSeparate, mode, mode);
+
 	return es2::BlendEquation(mode);
 }
 
 GL_APICALL void GL_APIENTRY glBlendEquationSeparate(GLenum modeRGB, GLenum modeAlpha)
 {
+	CAPTURE(record, es2::CAPTURE_BlendEquationSeparate, modeRGB, modeAlpha);
+
 	return es2::BlendEquationSeparate(modeRGB, modeAlpha);
 }
 
 GL_APICALL void GL_APIENTRY glBlendFunc(GLenum sfactor, GLenum dfactor)
 {
+	CAPTURE(record, es2::CAPTURE_BlendFuncSeparate, sfactor, dfactor, sfactor, dfactor);
+
 	return es2::BlendFunc(sfactor, dfactor);
 }
 
 GL_APICALL void GL_APIENTRY glBlendFuncSeparate(GLenum srcRGB, GLenum dstRGB, GLenum srcAlpha, GLenum dstAlpha)
 {
+	CAPTURE(record, es2::CAPTURE_BlendFuncSeparate, srcRGB, dstRGB, srcAlpha, dstAlpha);
+
 	return es2::BlendFuncSeparate(srcRGB, dstRGB, srcAlpha, dstAlpha);
 }
 
 GL_APICALL void GL_APIENTRY glBufferData(GLenum target, GLsizeiptr size, const GLvoid* data, GLenum usage)
 {
+	CAPTURE(bufferData, target, size, data, usage);
+
 	return es2::BufferData(target, size, data, usage);
 }
 
 GL_APICALL void GL_APIENTRY glBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const GLvoid* data)
 {
+	CAPTURE(bufferSubData, target, offset, size, data);
+
 	return es2::BufferSubData(target, offset, size, data);
 }
 
@@ -322,73 +359,103 @@ GL_APICALL GLenum GL_APIENTRY glCheckFramebufferStatusOES(GLenum target)
 
 GL_APICALL void GL_APIENTRY glClear(GLbitfield mask)
 {
+	CAPTURE(record, es2::CAPTURE_Clear, mask);
+
 	return es2::Clear(mask);
 }
 
 GL_APICALL void GL_APIENTRY glClearColor(GLclampf red, GLclampf green, GLclampf blue, GLclampf alpha)
 {
+	CAPTURE(record, es2::CAPTURE_ClearColor, red, green, blue, alpha);
+
 	return es2::ClearColor(red, green, blue, alpha);
 }
 
 GL_APICALL void GL_APIENTRY glClearDepthf(GLclampf depth)
 {
+	CAPTURE(record, es2::CAPTURE_ClearDepthf, depth);
+
 	return es2::ClearDepthf(depth);
 }
 
 GL_APICALL void GL_APIENTRY glClearStencil(GLint s)
 {
+	CAPTURE(record, es2::CAPTURE_ClearStencil, s);
+
 	return es2::ClearStencil(s);
 }
 
 GL_APICALL void GL_APIENTRY glColorMask(GLboolean red, GLboolean green, GLboolean blue, GLboolean alpha)
 {
+	CAPTURE(record, es2::CAPTURE_ColorMask, red, green, blue, alpha);
+
 	return es2::ColorMask(red, green, blue, alpha);
 }
 
 GL_APICALL void GL_APIENTRY glCompileShader(GLuint shader)
 {
+	CAPTURE(record, es2::CAPTURE_CompileShader, shader);
+
 	return es2::CompileShader(shader);
 }
 
 GL_APICALL void GL_APIENTRY glCompressedTexImage2D(GLenum target, GLint level, GLenum internalformat, GLsizei width, GLsizei height,
                                                    GLint border, GLsizei imageSize, const GLvoid* data)
 {
+	CAPTURE(compressedTexImage2D, target, level, internalformat, width, height, border, imageSize, data);
+
 	return es2::CompressedTexImage2D(target, level, internalformat, width, height, border, imageSize, data);
 }
 
 GL_APICALL void GL_APIENTRY glCompressedTexSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height,
                                                       GLenum format, GLsizei imageSize, const GLvoid* data)
 {
+	CAPTURE(compressedTexSubImage2D, target, level, xoffset, yoffset, width, height, format, imageSize, data);
+
 	return es2::CompressedTexSubImage2D(target, level, xoffset, yoffset, width, height, format, imageSize, data);
 }
 
 GL_APICALL void GL_APIENTRY glCopyTexImage2D(GLenum target, GLint level, GLenum internalformat, GLint x, GLint y, GLsizei width, GLsizei height, GLint border)
 {
+	CAPTURE(record, es2::CAPTURE_CopyTexImage2D, target, level, internalformat, x, y, width, height, border);
+
 	return es2::CopyTexImage2D(target, level, internalformat, x, y, width, height, border);
 }
 
 GL_APICALL void GL_APIENTRY glCopyTexSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLint x, GLint y, GLsizei width, GLsizei height)
 {
+	CAPTURE(record, es2::CAPTURE_CopyTexSubImage2D, target, level, xoffset, yoffset, x, y, width, height);
+
 	return es2::CopyTexSubImage2D(target, level, xoffset, yoffset, x, y, width, height);
 }
 
 GL_APICALL GLuint GL_APIENTRY glCreateProgram(void)
 {
-	return es2::CreateProgram();
+	GLuint name = es2::CreateProgram();
+	CAPTURE(record, es2::CAPTURE_CreateProgram, name);
+
+	return name;
 }
 
 GL_APICALL GLuint GL_APIENTRY glCreateShader(GLenum type)
 {
-	return es2::CreateShader(type);
+	GLuint name = es2::CreateShader(type);
+	CAPTURE(record, es2::CAPTURE_CreateShader, type, name);
+
+	return name;
 }
 
 GL_APICALL void GL_APIENTRY glCullFace(GLenum mode)
 {
+	CAPTURE(record, es2::CAPTURE_CullFace, mode);
+
 	return es2::CullFace(mode);
 }
 
 GL_APICALL void GL_APIENTRY glDeleteBuffers(GLsizei n, const GLuint* buffers)
 {
+	CAPTURE(names, es2::CAPTURE_DeleteBuffers, n, buffers);
+
 	return es2::DeleteBuffers(n, buffers);
 }
 
@@ -399,16 +466,22 @@ GL_APICALL void GL_APIENTRY glDeleteFencesNV(GLsizei n, const GLuint* fences)
 
 GL_APICALL void GL_APIENTRY glDeleteFramebuffers(GLsizei n, const GLuint* framebuffers)
 {
+	CAPTURE(names, es2::CAPTURE_DeleteFramebuffers, n, framebuffers);
+
 	return es2::DeleteFramebuffers(n, framebuffers);
 }
 
 GL_APICALL void GL_APIENTRY glDeleteFramebuffersOES(GLsizei n, const GLuint* framebuffers)
 {
+	CAPTURE(names, es2::CAPTURE_DeleteFramebuffers, n, framebuffers);
+
 	return es2::DeleteFramebuffers(n, framebuffers);
 }
 
 GL_APICALL void GL_APIENTRY glDeleteProgram(GLuint program)
 {
+	CAPTURE(record, es2::CAPTURE_DeleteProgram, program);
+
 	return es2::DeleteProgram(program);
 }
 
@@ -419,101 +492,161 @@ GL_APICALL void GL_APIENTRY glDeleteQueriesEXT(GLsizei n, const GLuint *ids)
 
 GL_APICALL void GL_APIENTRY glDeleteRenderbuffers(GLsizei n, const GLuint* renderbuffers)
 {
+	CAPTURE(names, es2::CAPTURE_DeleteRenderbuffers, n, renderbuffers);
+
 	return es2::DeleteRenderbuffers(n, renderbuffers);
 }
 
 GL_APICALL void GL_APIENTRY glDeleteRenderbuffersOES(GLsizei n, const GLuint* renderbuffers)
 {
+	CAPTURE(names, es2::CAPTURE_DeleteRenderbuffers, n, renderbuffers);
+
 	return es2::DeleteRenderbuffers(n, renderbuffers);
 }
 
 GL_APICALL void GL_APIENTRY glDeleteShader(GLuint shader)
 {
+	CAPTURE(record, es2::CAPTURE_DeleteShader, shader);
+
 	return es2::DeleteShader(shader);
 }
 
 GL_APICALL void GL_APIENTRY glDeleteTextures(GLsizei n, const GLuint* textures)
 {
+	CAPTURE(names, es2::CAPTURE_DeleteTextures, n, textures);
+
 	return es2::DeleteTextures(n, textures);
 }
 
 GL_APICALL void GL_APIENTRY glDepthFunc(GLenum func)
 {
+	CAPTURE(record, es2::CAPTURE_DepthFunc, func);
+
 	return es2::DepthFunc(func);
 }
 
 GL_APICALL void GL_APIENTRY glDepthMask(GLboolean flag)
 {
+	CAPTURE(record, es2::CAPTURE_DepthMask, flag);
+
 	return es2::DepthMask(flag);
 }
 
 GL_APICALL void GL_APIENTRY glDepthRangef(GLclampf zNear, GLclampf zFar)
 {
+	CAPTURE(record, es2::CAPTURE_DepthRangef, zNear, zFar);
+
 	return es2::DepthRangef(zNear, zFar);
 }
 
 GL_APICALL void GL_APIENTRY glDetachShader(GLuint program, GLuint shader)
 {
+	CAPTURE(record, es2::CAPTURE_DetachShader, program, shader);
+
 	return es2::DetachShader(program, shader);
 }
 
 GL_APICALL void GL_APIENTRY glDisable(GLenum cap)
 {
+	CAPTURE(record, es2::CAPTURE_Disable, cap);
+
 	return es2::Disable(cap);
 }
 
 GL_APICALL void GL_APIENTRY glDisableVertexAttribArray(GLuint index)
 {
+	CAPTURE(record, es2::CAPTURE_DisableVertexAttribArray, index);
+
 	return es2::DisableVertexAttribArray(index);
 }
 
 GL_APICALL void GL_APIENTRY glDrawArrays(GLenum mode, GLint first, GLsizei count)
 {
+	CAPTURE(drawArrays, mode, first, count, 1);
+
 	return es2::DrawArrays(mode, first, count);
 }
 
 GL_APICALL void GL_APIENTRY glDrawElements(GLenum mode, GLsizei count, GLenum type, const GLvoid* indices)
 {
+	CAPTURE(drawElements, mode, count, type, indices, 1);
+
 	return es2::DrawElements(mode, count, type, indices);
 }
 
 GL_APICALL void GL_APIENTRY glDrawArraysInstancedEXT(GLenum mode, GLint first, GLsizei count, GLsizei instanceCount)
 {
+	CAPTURE(drawArrays, mode, first, count, instanceCount);
+
 	return es2::DrawArraysInstancedEXT(mode, first, count, instanceCount);
 }
 
 GL_APICALL void GL_APIENTRY glDrawElementsInstancedEXT(GLenum mode, GLsizei count, GLenum type, const void *indices, GLsizei instanceCount)
 {
+	CAPTURE(drawElements, mode, count, type, indices, instanceCount);
+
 	return es2::DrawElementsInstancedEXT(mode, count, type, indices, instanceCount);
 }
 
 GL_APICALL void GL_APIENTRY glVertexAttribDivisorEXT(GLuint index, GLuint divisor)
 {
+	CAPTURE(record, es2::CAPTURE_VertexAttribDivisor, index, divisor);
+
 	return es2::VertexAttribDivisorEXT(index, divisor);
 }
 
 GL_APICALL void GL_APIENTRY glDrawArraysInstancedANGLE(GLenum mode, GLint first, GLsizei count, GLsizei instanceCount)
 {
+	CAPTURE(drawArrays, mode, first, count, instanceCount);
+
 	return es2::DrawArraysInstancedANGLE(mode, first, count, instanceCount);
 }
 
 GL_APICALL void GL_APIENTRY glDrawElementsInstancedANGLE(GLenum mode, GLsizei count, GLenum type, const void *indices, GLsizei instanceCount)
 {
+	CAPTURE(drawElements, mode, count, type, indices, instanceCount);
+
 	return es2::DrawElementsInstancedANGLE(mode, count, type, indices, instanceCount);
 }
 
+GL_APICALL void GL_APIENTRY glMultiDrawArraysEXT(GLenum mode, const GLint *first, const GLsizei *count, GLsizei primcount)
+{
+	for(GLsizei i = 0; i < primcount; i++)
+	{
+		CAPTURE(drawArrays, mode, first[i], count[i], 1);
+	}
+
+	return es2::MultiDrawArraysEXT(mode, first, count, primcount);
+}
+
+GL_APICALL void GL_APIENTRY glMultiDrawElementsEXT(GLenum mode, const GLsizei *count, GLenum type, const void *const *indices, GLsizei primcount)
+{
+	for(GLsizei i = 0; i < primcount; i++)
+	{
+		CAPTURE(drawElements, mode, count[i], type, indices[i], 1);
+	}
+
+	return es2::MultiDrawElementsEXT(mode, count, type, indices, primcount);
+}
+
 GL_APICALL void GL_APIENTRY glVertexAttribDivisorANGLE(GLuint index, GLuint divisor)
 {
+	CAPTURE(record, es2::CAPTURE_VertexAttribDivisor, index, divisor);
+
 	return es2::VertexAttribDivisorANGLE(index, divisor);
 }
 
 GL_APICALL void GL_APIENTRY glEnable(GLenum cap)
 {
+	CAPTURE(record, es2::CAPTURE_Enable, cap);
+
 	return es2::Enable(cap);
 }
 
 GL_APICALL void GL_APIENTRY glEnableVertexAttribArray(GLuint index)
 {
+	CAPTURE(record, es2::CAPTURE_EnableVertexAttribArray, index);
+
 	return es2::EnableVertexAttribArray(index);
 }
 
@@ -529,51 +662,70 @@ GL_APICALL void GL_APIENTRY glFinishFenceNV(GLuint fence)
 
 GL_APICALL void GL_APIENTRY glFinish(void)
 {
+	CAPTURE(record, es2::CAPTURE_Finish);
+
 	return es2::Finish();
 }
 
 GL_APICALL void GL_APIENTRY glFlush(void)
 {
+	CAPTURE(record, es2::CAPTURE_Flush);
+
 	return es2::Flush();
 }
 
 GL_APICALL void GL_APIENTRY glFramebufferRenderbuffer(GLenum target, GLenum attachment, GLenum renderbuffertarget, GLuint renderbuffer)
 {
+	CAPTURE(record, es2::CAPTURE_FramebufferRenderbuffer, target, attachment, renderbuffertarget, renderbuffer);
+
 	return es2::FramebufferRenderbuffer(target, attachment, renderbuffertarget, renderbuffer);
 }
 
 GL_APICALL void GL_APIENTRY glFramebufferRenderbufferOES(GLenum target, GLenum attachment, GLenum renderbuffertarget, GLuint renderbuffer)
 {
+	CAPTURE(record, es2::CAPTURE_FramebufferRenderbuffer, target, attachment, renderbuffertarget, renderbuffer);
+
 	return es2::FramebufferRenderbuffer(target, attachment, renderbuffertarget, renderbuffer);
 }
 
 GL_APICALL void GL_APIENTRY glFramebufferTexture2D(GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level)
 {
+	CAPTURE(record, es2::CAPTURE_FramebufferTexture2D, target, attachment, textarget, texture, level);
+
 	return es2::FramebufferTexture2D(target, attachment, textarget, texture, level);
 }
 
 GL_APICALL void GL_APIENTRY glFramebufferTexture2DOES(GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level)
 {
+	CAPTURE(record, es2::CAPTURE_FramebufferTexture2D, target, attachment, textarget, texture, level);
+
 	return es2::FramebufferTexture2D(target, attachment, textarget, texture, level);
 }
 
 GL_APICALL void GL_APIENTRY glFrontFace(GLenum mode)
 {
+	CAPTURE(record, es2::CAPTURE_FrontFace, mode);
+
 	return es2::FrontFace(mode);
 }
 
 GL_APICALL void GL_APIENTRY glGenBuffers(GLsizei n, GLuint* buffers)
 {
-	return es2::GenBuffers(n, buffers);
+	es2::GenBuffers(n, buffers);
+	CAPTURE(names, es2::CAPTURE_GenBuffers, n, buffers);
 }
 
 GL_APICALL void GL_APIENTRY glGenerateMipmap(GLenum target)
 {
+	CAPTURE(record, es2::CAPTURE_GenerateMipmap, target);
+
 	return es2::GenerateMipmap(target);
 }
 
 GL_APICALL void GL_APIENTRY glGenerateMipmapOES(GLenum target)
 {
+	CAPTURE(record, es2::CAPTURE_GenerateMipmap, target);
+
 	return es2::GenerateMipmap(target);
 }
 
@@ -584,12 +736,14 @@ GL_APICALL void GL_APIENTRY glGenFencesNV(GLsizei n, GLuint* fences)
 
 GL_APICALL void GL_APIENTRY glGenFramebuffers(GLsizei n, GLuint* framebuffers)
 {
-	return es2::GenFramebuffers(n, framebuffers);
+	es2::GenFramebuffers(n, framebuffers);
+	CAPTURE(names, es2::CAPTURE_GenFramebuffers, n, framebuffers);
 }
 
 GL_APICALL void GL_APIENTRY glGenFramebuffersOES(GLsizei n, GLuint* framebuffers)
 {
-	return es2::GenFramebuffers(n, framebuffers);
+	es2::GenFramebuffers(n, framebuffers);
+	CAPTURE(names, es2::CAPTURE_GenFramebuffers, n, framebuffers);
 }
 
 GL_APICALL void GL_APIENTRY glGenQueriesEXT(GLsizei n, GLuint* ids)
@@ -599,17 +753,20 @@ GL_APICALL void GL_APIENTRY glGenQueriesEXT(GLsizei n, GLuint* ids)
 
 GL_APICALL void GL_APIENTRY glGenRenderbuffers(GLsizei n, GLuint* renderbuffers)
 {
-	return es2::GenRenderbuffers(n, renderbuffers);
+	es2::GenRenderbuffers(n, renderbuffers);
+	CAPTURE(names, es2::CAPTURE_GenRenderbuffers, n, renderbuffers);
 }
 
 GL_APICALL void GL_APIENTRY glGenRenderbuffersOES(GLsizei n, GLuint* renderbuffers)
 {
-	return es2::GenRenderbuffers(n, renderbuffers);
+	es2::GenRenderbuffers(n, renderbuffers);
+	CAPTURE(names, es2::CAPTURE_GenRenderbuffers, n, renderbuffers);
 }
 
 GL_APICALL void GL_APIENTRY glGenTextures(GLsizei n, GLuint* textures)
 {
-	return es2::GenTextures(n, textures);
+	es2::GenTextures(n, textures);
+	CAPTURE(names, es2::CAPTURE_GenTextures, n, textures);
 }
 
 GL_APICALL void GL_APIENTRY glGetActiveAttrib(GLuint program, GLuint index, GLsizei bufsize, GLsizei *length, GLint *size, GLenum *type, GLchar *name)
@@ -629,7 +786,10 @@ GL_APICALL void GL_APIENTRY glGetAttachedShaders(GLuint program, GLsizei maxcoun
 
 GL_APICALL int GL_APIENTRY glGetAttribLocation(GLuint program, const GLchar* name)
 {
-	return es2::GetAttribLocation(program, name);
+	int location = es2::GetAttribLocation(program, name);
+	CAPTURE(location, es2::CAPTURE_GetAttribLocation, program, name, location);
+
+	return location;
 }
 
 GL_APICALL void GL_APIENTRY glGetBooleanv(GLenum pname, GLboolean* params)
@@ -764,7 +924,10 @@ GL_APICALL void GL_APIENTRY glGetUniformiv(GLuint program, GLint location, GLint
 
 GL_APICALL int GL_APIENTRY glGetUniformLocation(GLuint program, const GLchar* name)
 {
-	return es2::GetUniformLocation(program, name);
+	int location = es2::GetUniformLocation(program, name);
+	CAPTURE(location, es2::CAPTURE_GetUniformLocation, program, name, location);
+
+	return location;
 }
 
 GL_APICALL void GL_APIENTRY glGetVertexAttribfv(GLuint index, GLenum pname, GLfloat* params)
@@ -784,6 +947,8 @@ GL_APICALL void GL_APIENTRY glGetVertexAttribPointerv(GLuint index, GLenum pname
 
 GL_APICALL void GL_APIENTRY glHint(GLenum target, GLenum mode)
 {
+	CAPTURE(record, es2::CAPTURE_Hint, target, mode);
+
 	return es2::Hint(target, mode);
 }
 
@@ -844,21 +1009,29 @@ GL_APICALL GLboolean GL_APIENTRY glIsTexture(GLuint texture)
 
 GL_APICALL void GL_APIENTRY glLineWidth(GLfloat width)
 {
+	CAPTURE(record, es2::CAPTURE_LineWidth, width);
+
 	return es2::LineWidth(width);
 }
 
 GL_APICALL void GL_APIENTRY glLinkProgram(GLuint program)
 {
+	CAPTURE(record, es2::CAPTURE_LinkProgram, program);
+
 	return es2::LinkProgram(program);
 }
 
 GL_APICALL void GL_APIENTRY glPixelStorei(GLenum pname, GLint param)
 {
+	CAPTURE(record, es2::CAPTURE_PixelStorei, pname, param);
+
 	return es2::PixelStorei(pname, param);
 }
 
 GL_APICALL void GL_APIENTRY glPolygonOffset(GLfloat factor, GLfloat units)
 {
+	CAPTURE(record, es2::CAPTURE_PolygonOffset, factor, units);
+
 	return es2::PolygonOffset(factor, units);
 }
 
@@ -870,6 +1043,8 @@ GL_APICALL void GL_APIENTRY glReadnPixelsEXT(GLint x, GLint y, GLsizei width, GL
 
 GL_APICALL void GL_APIENTRY glReadPixels(GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, GLvoid* pixels)
 {
+	CAPTURE(record, es2::CAPTURE_ReadPixels, x, y, width, height, format, type);
+
 	return es2::ReadPixels(x, y, width, height, format, type, pixels);
 }
 
@@ -880,26 +1055,36 @@ GL_APICALL void GL_APIENTRY glReleaseShaderCompiler(void)
 
 GL_APICALL void GL_APIENTRY glRenderbufferStorageMultisample(GLenum target, GLsizei samples, GLenum internalformat, GLsizei width, GLsizei height)
 {
+	CAPTURE(record, es2::CAPTURE_RenderbufferStorageMultisample, target, samples, internalformat, width, height);
+
 	return es2::RenderbufferStorageMultisample(target, samples, internalformat, width, height);
 }
 
 GL_APICALL void GL_APIENTRY glRenderbufferStorageMultisampleANGLE(GLenum target, GLsizei samples, GLenum internalformat, GLsizei width, GLsizei height)
 {
+	CAPTURE(record, es2::CAPTURE_RenderbufferStorageMultisample, target, samples, internalformat, width, height);
+
 	return es2::RenderbufferStorageMultisampleANGLE(target, samples, internalformat, width, height);
 }
 
 GL_APICALL void GL_APIENTRY glRenderbufferStorage(GLenum target, GLenum internalformat, GLsizei width, GLsizei height)
 {
+	CAPTURE(record, es2::CAPTURE_RenderbufferStorage, target, internalformat, width, height);
+
 	return es2::RenderbufferStorage(target, internalformat, width, height);
 }
 
 GL_APICALL void GL_APIENTRY glRenderbufferStorageOES(GLenum target, GLenum internalformat, GLsizei width, GLsizei height)
 {
+	CAPTURE(record, es2::CAPTURE_RenderbufferStorage, target, internalformat, width, height);
+
 	return es2::RenderbufferStorage(target, internalformat, width, height);
 }
 
 GL_APICALL void GL_APIENTRY glSampleCoverage(GLclampf value, GLboolean invert)
 {
+	CAPTURE(record, es2::CAPTURE_SampleCoverage, value, invert);
+
 	return es2::SampleCoverage(value, invert);
 }
 
@@ -910,6 +1095,8 @@ GL_APICALL void GL_APIENTRY glSetFenceNV(GLuint fence, GLenum condition)
 
 GL_APICALL void GL_APIENTRY glScissor(GLint x, GLint y, GLsizei width, GLsizei height)
 {
+	CAPTURE(record, es2::CAPTURE_Scissor, x, y, width, height);
+
 	return es2::Scissor(x, y, width, height);
 }
 
@@ -920,36 +1107,50 @@ GL_APICALL void GL_APIENTRY glShaderBinary(GLsizei n, const GLuint* shaders, GLe
 
 GL_APICALL void GL_APIENTRY glShaderSource(GLuint shader, GLsizei count, const GLchar *const *string, const GLint *length)
 {
+	CAPTURE(shaderSource, shader, count, string, length);
+
 	return es2::ShaderSource(shader, count, string, length);
 }
 
 GL_APICALL void GL_APIENTRY glStencilFunc(GLenum func, GLint ref, GLuint mask)
 {
+	CAPTURE(record, es2::CAPTURE_StencilFuncSeparate, (GLenum)GL_FRONT_AND_BACK, func, ref, mask);
+
 	return es2::StencilFunc(func, ref, mask);
 }
 
 GL_APICALL void GL_APIENTRY glStencilFuncSeparate(GLenum face, GLenum func, GLint ref, GLuint mask)
 {
+	CAPTURE(record, es2::CAPTURE_StencilFuncSeparate, face, func, ref, mask);
+
 	return es2::StencilFuncSeparate(face, func, ref, mask);
 }
 
 GL_APICALL void GL_APIENTRY glStencilMask(GLuint mask)
 {
+	CAPTURE(record, es2::CAPTURE_StencilMaskSeparate, (GLenum)GL_FRONT_AND_BACK, mask);
+
 	return es2::StencilMask(mask);
 }
 
 GL_APICALL void GL_APIENTRY glStencilMaskSeparate(GLenum face, GLuint mask)
 {
+	CAPTURE(record, es2::CAPTURE_StencilMaskSeparate, face, mask);
+
 	return es2::StencilMaskSeparate(face, mask);
 }
 
 GL_APICALL void GL_APIENTRY glStencilOp(GLenum fail, GLenum zfail, GLenum zpass)
 {
+	CAPTURE(record, es2::CAPTURE_StencilOpSeparate, (GLenum)GL_FRONT_AND_BACK, fail, zfail, zpass);
+
 	return es2::StencilOp(fail, zfail, zpass);
 }
 
 GL_APICALL void GL_APIENTRY glStencilOpSeparate(GLenum face, GLenum fail, GLenum zfail, GLenum zpass)
 {
+	CAPTURE(record, es2::CAPTURE_StencilOpSeparate, face, fail, zfail, zpass);
+
 	return es2::StencilOpSeparate(face, fail, zfail, zpass);
 }
 
@@ -961,132 +1162,192 @@ GLboolean GL_APIENTRY glTestFenceNV(GLuint fence)
 GL_APICALL void GL_APIENTRY glTexImage2D(GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height,
                                          GLint border, GLenum format, GLenum type, const GLvoid* pixels)
 {
+	CAPTURE(texImage2D, target, level, internalformat, width, height, border, format, type, pixels);
+
 	return es2::TexImage2D(target, level, internalformat, width, height, border, format, type, pixels);
 }
 
 GL_APICALL void GL_APIENTRY glTexParameterf(GLenum target, GLenum pname, GLfloat param)
 {
+	CAPTURE(record, es2::CAPTURE_TexParameterf, target, pname, param);
+
 	return es2::TexParameterf(target, pname, param);
 }
 
 GL_APICALL void GL_APIENTRY glTexParameterfv(GLenum target, GLenum pname, const GLfloat* params)
 {
+	CAPTURE(texParameterv, es2::CAPTURE_TexParameterfv, target, pname, params);
+
 	return es2::TexParameterfv(target, pname, params);
 }
 
 GL_APICALL void GL_APIENTRY glTexParameteri(GLenum target, GLenum pname, GLint param)
 {
+	CAPTURE(record, es2::CAPTURE_TexParameteri, target, pname, param);
+
 	return es2::TexParameteri(target, pname, param);
 }
 
 GL_APICALL void GL_APIENTRY glTexParameteriv(GLenum target, GLenum pname, const GLint* params)
 {
+	CAPTURE(texParameterv, es2::CAPTURE_TexParameteriv, target, pname, params);
+
 	return es2::TexParameteriv(target, pname, params);
 }
 
 GL_APICALL void GL_APIENTRY glTexSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height,
                                             GLenum format, GLenum type, const GLvoid* pixels)
 {
+	CAPTURE(texSubImage2D, target, level, xoffset, yoffset, width, height, format, type, pixels);
+
 	return es2::TexSubImage2D(target, level, xoffset, yoffset, width, height, format, type, pixels);
 }
 
 GL_APICALL void GL_APIENTRY glUniform1f(GLint location, GLfloat x)
 {
+	const GLfloat v[] = {x};
+	CAPTURE(uniform, es2::CAPTURE_Uniformfv, 1, location, 1, v);
+
 	return es2::Uniform1f(location, x);
 }
 
 GL_APICALL void GL_APIENTRY glUniform1fv(GLint location, GLsizei count, const GLfloat* v)
 {
+	CAPTURE(uniform, es2::CAPTURE_Uniformfv, 1, location, count, v);
+
 	return es2::Uniform1fv(location, count, v);
 }
 
 GL_APICALL void GL_APIENTRY glUniform1i(GLint location, GLint x)
 {
+	const GLint v[] = {x};
+	CAPTURE(uniform, es2::CAPTURE_Uniformiv, 1, location, 1, v);
+
 	return es2::Uniform1i(location, x);
 }
 
 GL_APICALL void GL_APIENTRY glUniform1iv(GLint location, GLsizei count, const GLint* v)
 {
+	CAPTURE(uniform, es2::CAPTURE_Uniformiv, 1, location, count, v);
+
 	return es2::Uniform1iv(location, count, v);
 }
 
 GL_APICALL void GL_APIENTRY glUniform2f(GLint location, GLfloat x, GLfloat y)
 {
+	const GLfloat v[] = {x, y};
+	CAPTURE(uniform, es2::CAPTURE_Uniformfv, 2, location, 1, v);
+
 	return es2::Uniform2f(location, x, y);
 }
 
 GL_APICALL void GL_APIENTRY glUniform2fv(GLint location, GLsizei count, const GLfloat* v)
 {
+	CAPTURE(uniform, es2::CAPTURE_Uniformfv, 2, location, count, v);
+
 	return es2::Uniform2fv(location, count, v);
 }
 
 GL_APICALL void GL_APIENTRY glUniform2i(GLint location, GLint x, GLint y)
 {
+	const GLint v[] = {x, y};
+	CAPTURE(uniform, es2::CAPTURE_Uniformiv, 2, location, 1, v);
+
 	return es2::Uniform2i(location, x, y);
 }
 
 GL_APICALL void GL_APIENTRY glUniform2iv(GLint location, GLsizei count, const GLint* v)
 {
+	CAPTURE(uniform, es2::CAPTURE_Uniformiv, 2, location, count, v);
+
 	return es2::Uniform2iv(location, count, v);
 }
 
 GL_APICALL void GL_APIENTRY glUniform3f(GLint location, GLfloat x, GLfloat y, GLfloat z)
 {
+	const GLfloat v[] = {x, y, z};
+	CAPTURE(uniform, es2::CAPTURE_Uniformfv, 3, location, 1, v);
+
 	return es2::Uniform3f(location, x, y, z);
 }
 
 GL_APICALL void GL_APIENTRY glUniform3fv(GLint location, GLsizei count, const GLfloat* v)
 {
+	CAPTURE(uniform, es2::CAPTURE_Uniformfv, 3, location, count, v);
+
 	return es2::Uniform3fv(location, count, v);
 }
 
 GL_APICALL void GL_APIENTRY glUniform3i(GLint location, GLint x, GLint y, GLint z)
 {
+	const GLint v[] = {x, y, z};
+	CAPTURE(uniform, es2::CAPTURE_Uniformiv, 3, location, 1, v);
+
 	return es2::Uniform3i(location, x, y, z);
 }
 
 GL_APICALL void GL_APIENTRY glUniform3iv(GLint location, GLsizei count, const GLint* v)
 {
+	CAPTURE(uniform, es2::CAPTURE_Uniformiv, 3, location, count, v);
+
 	return es2::Uniform3iv(location, count, v);
 }
 
 GL_APICALL void GL_APIENTRY glUniform4f(GLint location, GLfloat x, GLfloat y, GLfloat z, GLfloat w)
 {
+	const GLfloat v[] = {x, y, z, w};
+	CAPTURE(uniform, es2::CAPTURE_Uniformfv, 4, location, 1, v);
+
 	return es2::Uniform4f(location, x, y, z, w);
 }
 
 GL_APICALL void GL_APIENTRY glUniform4fv(GLint location, GLsizei count, const GLfloat* v)
 {
+	CAPTURE(uniform, es2::CAPTURE_Uniformfv, 4, location, count, v);
+
 	return es2::Uniform4fv(location, count, v);
 }
 
 GL_APICALL void GL_APIENTRY glUniform4i(GLint location, GLint x, GLint y, GLint z, GLint w)
 {
+	const GLint v[] = {x, y, z, w};
+	CAPTURE(uniform, es2::CAPTURE_Uniformiv, 4, location, 1, v);
+
 	return es2::Uniform4i(location, x, y, z, w);
 }
 
 GL_APICALL void GL_APIENTRY glUniform4iv(GLint location, GLsizei count, const GLint* v)
 {
+	CAPTURE(uniform, es2::CAPTURE_Uniformiv, 4, location, count, v);
+
 	return es2::Uniform4iv(location, count, v);
 }
 
 GL_APICALL void GL_APIENTRY glUniformMatrix2fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value)
 {
+	CAPTURE(uniformMatrix, 2, location, count, transpose, value);
+
 	return es2::UniformMatrix2fv(location, count, transpose, value);
 }
 
 GL_APICALL void GL_APIENTRY glUniformMatrix3fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value)
 {
+	CAPTURE(uniformMatrix, 3, location, count, transpose, value);
+
 	return es2::UniformMatrix3fv(location, count, transpose, value);
 }
 
 GL_APICALL void GL_APIENTRY glUniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value)
 {
+	CAPTURE(uniformMatrix, 4, location, count, transpose, value);
+
 	return es2::UniformMatrix4fv(location, count, transpose, value);
 }
 
 GL_APICALL void GL_APIENTRY glUseProgram(GLuint program)
 {
+	CAPTURE(record, es2::CAPTURE_UseProgram, program);
+
 	return es2::UseProgram(program);
 }
 
@@ -1097,51 +1358,83 @@ GL_APICALL void GL_APIENTRY glValidateProgram(GLuint program)
 
 GL_APICALL void GL_APIENTRY glVertexAttrib1f(GLuint index, GLfloat x)
 {
+	CAPTURE(record, es2::CAPTURE_VertexAttrib4f, index, x, 0.0f, 0.0f, 1.0f);
+
 	return es2::VertexAttrib1f(index, x);
 }
 
 GL_APICALL void GL_APIENTRY glVertexAttrib1fv(GLuint index, const GLfloat* values)
 {
+	if(values)
+	{
+		CAPTURE(record, es2::CAPTURE_VertexAttrib4f, index, values[0], 0.0f, 0.0f, 1.0f);
+	}
+
 	return es2::VertexAttrib1fv(index, values);
 }
 
 GL_APICALL void GL_APIENTRY glVertexAttrib2f(GLuint index, GLfloat x, GLfloat y)
 {
+	CAPTURE(record, es2::CAPTURE_VertexAttrib4f, index, x, y, 0.0f, 1.0f);
+
 	return es2::VertexAttrib2f(index, x, y);
 }
 
 GL_APICALL void GL_APIENTRY glVertexAttrib2fv(GLuint index, const GLfloat* values)
 {
+	if(values)
+	{
+		CAPTURE(record, es2::CAPTURE_VertexAttrib4f, index, values[0], values[1], 0.0f, 1.0f);
+	}
+
 	return es2::VertexAttrib2fv(index, values);
 }
 
 GL_APICALL void GL_APIENTRY glVertexAttrib3f(GLuint index, GLfloat x, GLfloat y, GLfloat z)
 {
+	CAPTURE(record, es2::CAPTURE_VertexAttrib4f, index, x, y, z, 1.0f);
+
 	return es2::VertexAttrib3f(index, x, y, z);
 }
 
 GL_APICALL void GL_APIENTRY glVertexAttrib3fv(GLuint index, const GLfloat* values)
 {
+	if(values)
+	{
+		CAPTURE(record, es2::CAPTURE_VertexAttrib4f, index, values[0], values[1], values[2], 1.0f);
+	}
+
 	return es2::VertexAttrib3fv(index, values);
 }
 
 GL_APICALL void GL_APIENTRY glVertexAttrib4f(GLuint index, GLfloat x, GLfloat y, GLfloat z, GLfloat w)
 {
+	CAPTURE(record, es2::CAPTURE_VertexAttrib4f, index, x, y, z, w);
+
 	return es2::VertexAttrib4f(index, x, y, z, w);
 }
 
 GL_APICALL void GL_APIENTRY glVertexAttrib4fv(GLuint index, const GLfloat* values)
 {
+	if(values)
+	{
+		CAPTURE(record, es2::CAPTURE_VertexAttrib4f, index, values[0], values[1], values[2], values[3]);
+	}
+
 	return es2::VertexAttrib4fv(index, values);
 }
 
 GL_APICALL void GL_APIENTRY glVertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const GLvoid* ptr)
 {
+	CAPTURE(vertexAttribPointer, index, size, type, normalized, stride, ptr);
+
 	return es2::VertexAttribPointer(index, size, type, normalized, stride, ptr);
 }
 
 GL_APICALL void GL_APIENTRY glViewport(GLint x, GLint y, GLsizei width, GLsizei height)
 {
+	CAPTURE(record, es2::CAPTURE_Viewport, x, y, width, height);
+
 	return es2::Viewport(x, y, width, height);
 }
 
@@ -1214,6 +1507,33 @@ egl::Image *createBackBuffer(int width, int height, sw::Format format, int multi
 egl::Image *createDepthStencil(int width, int height, sw::Format format, int multiSampleDepth);
 sw::FrameBuffer *createFrameBuffer(void *nativeDisplay, EGLNativeWindowType window, int width, int height);
 
+// Marks a frame boundary in the capture stream
+static void captureSwapBuffers()
+{
+	CAPTURE(swapBuffers);
+}
+
+static void getRoutineCounts(int *vertexRoutines, int *setupRoutines, int *pixelRoutines)
+{
+	*vertexRoutines = sw::profiler.vertexRoutines;
+	*setupRoutines = sw::profiler.setupRoutines;
+	*pixelRoutines = sw::profiler.pixelRoutines;
+}
+
+static void getRenameCounts(int *bufferRenames, int *bufferWaits, int *textureRenames, int *textureWaits)
+{
+	*bufferRenames = sw::profiler.bufferRenames;
+	*bufferWaits = sw::profiler.bufferWaits;
+	*textureRenames = sw::profiler.textureRenames;
+	*textureWaits = sw::profiler.textureWaits;
+}
+
+static void getCodeMemoryUsage(size_t *allocatedBytes, size_t *reservedBytes)
+{
+	*allocatedBytes = sw::executableMemoryAllocated();
+	*reservedBytes = sw::executableMemoryReserved();
+}
+
 LibGLESv2exports::LibGLESv2exports()
 {
 	this->glActiveTexture = es2::ActiveTexture;
@@ -1266,6 +1586,8 @@ LibGLESv2exports::LibGLESv2exports()
 	this->glVertexAttribDivisorEXT = es2::VertexAttribDivisorEXT;
 	this->glDrawArraysInstancedANGLE = es2::DrawArraysInstancedANGLE;
 	this->glDrawElementsInstancedANGLE = es2::DrawElementsInstancedANGLE;
+	this->glMultiDrawArraysEXT = es2::MultiDrawArraysEXT;
+	this->glMultiDrawElementsEXT = es2::MultiDrawElementsEXT;
 	this->glVertexAttribDivisorANGLE = es2::VertexAttribDivisorANGLE;
 	this->glEnable = es2::Enable;
 	this->glEnableVertexAttribArray = es2::EnableVertexAttribArray;
@@ -1416,6 +1738,10 @@ LibGLESv2exports::LibGLESv2exports()
 	this->createBackBuffer = ::createBackBuffer;
 	this->createDepthStencil = ::createDepthStencil;
 	this->createFrameBuffer = ::createFrameBuffer;
+	this->captureSwapBuffers = ::captureSwapBuffers;
+	this->getRoutineCounts = ::getRoutineCounts;
+	this->getRenameCounts = ::getRenameCounts;
+	this->getCodeMemoryUsage = ::getCodeMemoryUsage;
 }
 
 extern "C" GL_APICALL LibGLESv2exports *libGLESv2_swiftshader()
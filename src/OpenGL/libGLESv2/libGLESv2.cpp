@@ -44,6 +44,24 @@
 namespace es2
 {
 
+// Implementations which other entry points forward to. Calling these instead of the
+// exported functions keeps the forwarded call from getting captured a second time.
+void BlendEquationSeparate(GLenum modeRGB, GLenum modeAlpha);
+void BlendFuncSeparate(GLenum srcRGB, GLenum dstRGB, GLenum srcAlpha, GLenum dstAlpha);
+void StencilFuncSeparate(GLenum face, GLenum func, GLint ref, GLuint mask);
+void StencilMaskSeparate(GLenum face, GLuint mask);
+void StencilOpSeparate(GLenum face, GLenum fail, GLenum zfail, GLenum zpass);
+void TexParameterf(GLenum target, GLenum pname, GLfloat param);
+void TexParameteri(GLenum target, GLenum pname, GLint param);
+void Uniform1fv(GLint location, GLsizei count, const GLfloat* v);
+void Uniform1iv(GLint location, GLsizei count, const GLint* v);
+void Uniform2fv(GLint location, GLsizei count, const GLfloat* v);
+void Uniform2iv(GLint location, GLsizei count, const GLint* v);
+void Uniform3fv(GLint location, GLsizei count, const GLfloat* v);
+void Uniform3iv(GLint location, GLsizei count, const GLint* v);
+void Uniform4fv(GLint location, GLsizei count, const GLfloat* v);
+void Uniform4iv(GLint location, GLsizei count, const GLint* v);
+
 static bool validImageSize(GLint level, GLsizei width, GLsizei height)
 {
 	if(level < 0 || level >= es2::IMPLEMENTATION_MAX_TEXTURE_LEVELS || width < 0 || height < 0)
@@ -200,6 +218,9 @@ void BindBuffer(GLenum target, GLuint buffer)
 				return;
 			}
 			else return error(GL_INVALID_ENUM);
+		case GL_QUERY_BUFFER_AMD:
+			context->bindQueryBuffer(buffer);
+			return;
 		case GL_COPY_WRITE_BUFFER:
 			if(clientVersion >= 3)
 			{
@@ -349,7 +370,7 @@ void BlendColor(GLclampf red, GLclampf green, GLclampf blue, GLclampf alpha)
 
 void BlendEquation(GLenum mode)
 {
-	glBlendEquationSeparate(mode, mode);
+	BlendEquationSeparate(mode, mode);
 }
 
 void BlendEquationSeparate(GLenum modeRGB, GLenum modeAlpha)
@@ -390,7 +411,7 @@ void BlendEquationSeparate(GLenum modeRGB, GLenum modeAlpha)
 
 void BlendFunc(GLenum sfactor, GLenum dfactor)
 {
-	glBlendFuncSeparate(sfactor, dfactor, sfactor, dfactor);
+	BlendFuncSeparate(sfactor, dfactor, sfactor, dfactor);
 }
 
 void BlendFuncSeparate(GLenum srcRGB, GLenum dstRGB, GLenum srcAlpha, GLenum dstAlpha)
@@ -1753,6 +1774,108 @@ void DrawElementsInstancedANGLE(GLenum mode, GLsizei count, GLenum type, const v
 	}
 }
 
+void MultiDrawArraysEXT(GLenum mode, const GLint *first, const GLsizei *count, GLsizei primcount)
+{
+	TRACE("(GLenum mode = 0x%X, const GLint *first = %p, const GLsizei *count = %p, GLsizei primcount = %d)",
+		mode, first, count, primcount);
+
+	switch(mode)
+	{
+	case GL_POINTS:
+	case GL_LINES:
+	case GL_LINE_LOOP:
+	case GL_LINE_STRIP:
+	case GL_TRIANGLES:
+	case GL_TRIANGLE_FAN:
+	case GL_TRIANGLE_STRIP:
+		break;
+	default:
+		return error(GL_INVALID_ENUM);
+	}
+
+	if(primcount < 0)
+	{
+		return error(GL_INVALID_VALUE);
+	}
+
+	for(GLsizei i = 0; i < primcount; i++)
+	{
+		if(count[i] < 0 || first[i] < 0)
+		{
+			return error(GL_INVALID_VALUE);
+		}
+	}
+
+	es2::Context *context = es2::getContext();
+
+	if(context)
+	{
+		es2::TransformFeedback* transformFeedback = context->getTransformFeedback();
+		if(transformFeedback && transformFeedback->isActive() && (mode != transformFeedback->primitiveMode()))
+		{
+			return error(GL_INVALID_OPERATION);
+		}
+
+		context->multiDrawArrays(mode, first, count, primcount);
+	}
+}
+
+void MultiDrawElementsEXT(GLenum mode, const GLsizei *count, GLenum type, const void *const *indices, GLsizei primcount)
+{
+	TRACE("(GLenum mode = 0x%X, const GLsizei *count = %p, GLenum type = 0x%X, const void *const *indices = %p, GLsizei primcount = %d)",
+		mode, count, type, indices, primcount);
+
+	switch(mode)
+	{
+	case GL_POINTS:
+	case GL_LINES:
+	case GL_LINE_LOOP:
+	case GL_LINE_STRIP:
+	case GL_TRIANGLES:
+	case GL_TRIANGLE_FAN:
+	case GL_TRIANGLE_STRIP:
+		break;
+	default:
+		return error(GL_INVALID_ENUM);
+	}
+
+	switch(type)
+	{
+	case GL_UNSIGNED_BYTE:
+	case GL_UNSIGNED_SHORT:
+	case GL_UNSIGNED_INT:
+		break;
+	default:
+		return error(GL_INVALID_ENUM);
+	}
+
+	if(primcount < 0)
+	{
+		return error(GL_INVALID_VALUE);
+	}
+
+	for(GLsizei i = 0; i < primcount; i++)
+	{
+		if(count[i] < 0)
+		{
+			return error(GL_INVALID_VALUE);
+		}
+	}
+
+	es2::Context *context = es2::getContext();
+
+	if(context)
+	{
+		es2::TransformFeedback* transformFeedback = context->getTransformFeedback();
+		if(transformFeedback && transformFeedback->isActive() && !transformFeedback->isPaused())
+		{
+			return error(GL_INVALID_OPERATION);
+		}
+
+		context->multiDrawElements(mode, count, type, indices, primcount);
+	}
+}
+
 void VertexAttribDivisorANGLE(GLuint index, GLuint divisor)
 {
 	TRACE("(GLuint index = %d, GLuint divisor = %d)", index, divisor);
@@ -3228,6 +3351,7 @@ void GetQueryObjectuivEXT(GLuint name, GLenum pname, GLuint *params)
 	{
 	case GL_QUERY_RESULT_EXT:
 	case GL_QUERY_RESULT_AVAILABLE_EXT:
+	case GL_QUERY_RESULT_NO_WAIT_AMD:
 		break;
 	default:
 		return error(GL_INVALID_ENUM);
@@ -3249,6 +3373,21 @@ void GetQueryObjectuivEXT(GLuint name, GLenum pname, GLuint *params)
 			return error(GL_INVALID_OPERATION);
 		}
 
+		es2::Buffer *queryBuffer = context->getQueryBuffer();
+
+		if(queryBuffer)
+		{
+			// GL_AMD_query_buffer_object: params is an offset into the query buffer
+			GLintptr offset = reinterpret_cast<GLintptr>(params);
+
+			if((offset % sizeof(GLuint)) != 0 || (size_t)offset + sizeof(GLuint) > queryBuffer->size() || queryBuffer->isMapped())
+			{
+				return error(GL_INVALID_OPERATION);
+			}
+
+			return queryObject->writeResult(pname, queryBuffer, offset);
+		}
+
 		switch(pname)
 		{
 		case GL_QUERY_RESULT_EXT:
@@ -3257,6 +3396,12 @@ void GetQueryObjectuivEXT(GLuint name, GLenum pname, GLuint *params)
 		case GL_QUERY_RESULT_AVAILABLE_EXT:
 			params[0] = queryObject->isResultAvailable();
 			break;
+		case GL_QUERY_RESULT_NO_WAIT_AMD:
+			if(queryObject->isResultAvailable())
+			{
+				params[0] = queryObject->getResult();
+			}
+			break;
 		default:
 			ASSERT(false);
 		}
@@ -4752,7 +4897,7 @@ void ShaderSource(GLuint shader, GLsizei count, const GLchar *const *string, con
 
 void StencilFunc(GLenum func, GLint ref, GLuint mask)
 {
-	glStencilFuncSeparate(GL_FRONT_AND_BACK, func, ref, mask);
+	StencilFuncSeparate(GL_FRONT_AND_BACK, func, ref, mask);
 }
 
 void StencilFuncSeparate(GLenum face, GLenum func, GLint ref, GLuint mask)
@@ -4802,7 +4947,7 @@ void StencilFuncSeparate(GLenum face, GLenum func, GLint ref, GLuint mask)
 
 void StencilMask(GLuint mask)
 {
-	glStencilMaskSeparate(GL_FRONT_AND_BACK, mask);
+	StencilMaskSeparate(GL_FRONT_AND_BACK, mask);
 }
 
 void StencilMaskSeparate(GLenum face, GLuint mask)
@@ -4837,7 +4982,7 @@ void StencilMaskSeparate(GLenum face, GLuint mask)
 
 void StencilOp(GLenum fail, GLenum zfail, GLenum zpass)
 {
-	glStencilOpSeparate(GL_FRONT_AND_BACK, fail, zfail, zpass);
+	StencilOpSeparate(GL_FRONT_AND_BACK, fail, zfail, zpass);
 }
 
 void StencilOpSeparate(GLenum face, GLenum fail, GLenum zfail, GLenum zpass)
@@ -5186,7 +5331,7 @@ void TexParameterf(GLenum target, GLenum pname, GLfloat param)
 
 void TexParameterfv(GLenum target, GLenum pname, const GLfloat* params)
 {
-	glTexParameterf(target, pname, *params);
+	TexParameterf(target, pname, *params);
 }
 
 void TexParameteri(GLenum target, GLenum pname, GLint param)
@@ -5338,7 +5483,7 @@ void TexParameteri(GLenum target, GLenum pname, GLint param)
 
 void TexParameteriv(GLenum target, GLenum pname, const GLint* params)
 {
-	glTexParameteri(target, pname, *params);
+	TexParameteri(target, pname, *params);
 }
 
 void TexSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height,
@@ -5415,7 +5560,7 @@ void TexSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLs
 
 void Uniform1f(GLint location, GLfloat x)
 {
-	glUniform1fv(location, 1, &x);
+	Uniform1fv(location, 1, &x);
 }
 
 void Uniform1fv(GLint location, GLsizei count, const GLfloat* v)
@@ -5452,7 +5597,7 @@ void Uniform1fv(GLint location, GLsizei count, const GLfloat* v)
 
 void Uniform1i(GLint location, GLint x)
 {
-	glUniform1iv(location, 1, &x);
+	Uniform1iv(location, 1, &x);
 }
 
 void Uniform1iv(GLint location, GLsizei count, const GLint* v)
@@ -5491,7 +5636,7 @@ void Uniform2f(GLint location, GLfloat x, GLfloat y)
 {
 	GLfloat xy[2] = {x, y};
 
-	glUniform2fv(location, 1, (GLfloat*)&xy);
+	Uniform2fv(location, 1, (GLfloat*)&xy);
 }
 
 void Uniform2fv(GLint location, GLsizei count, const GLfloat* v)
@@ -5530,7 +5675,7 @@ void Uniform2i(GLint location, GLint x, GLint y)
 {
 	GLint xy[4] = {x, y};
 
-	glUniform2iv(location, 1, (GLint*)&xy);
+	Uniform2iv(location, 1, (GLint*)&xy);
 }
 
 void Uniform2iv(GLint location, GLsizei count, const GLint* v)
@@ -5569,7 +5714,7 @@ void Uniform3f(GLint location, GLfloat x, GLfloat y, GLfloat z)
 {
 	GLfloat xyz[3] = {x, y, z};
 
-	glUniform3fv(location, 1, (GLfloat*)&xyz);
+	Uniform3fv(location, 1, (GLfloat*)&xyz);
 }
 
 void Uniform3fv(GLint location, GLsizei count, const GLfloat* v)
@@ -5608,7 +5753,7 @@ void Uniform3i(GLint location, GLint x, GLint y, GLint z)
 {
 	GLint xyz[3] = {x, y, z};
 
-	glUniform3iv(location, 1, (GLint*)&xyz);
+	Uniform3iv(location, 1, (GLint*)&xyz);
 }
 
 void Uniform3iv(GLint location, GLsizei count, const GLint* v)
@@ -5647,7 +5792,7 @@ void Uniform4f(GLint location, GLfloat x, GLfloat y, GLfloat z, GLfloat w)
 {
 	GLfloat xyzw[4] = {x, y, z, w};
 
-	glUniform4fv(location, 1, (GLfloat*)&xyzw);
+	Uniform4fv(location, 1, (GLfloat*)&xyzw);
 }
 
 void Uniform4fv(GLint location, GLsizei count, const GLfloat* v)
@@ -5686,7 +5831,7 @@ void Uniform4i(GLint location, GLint x, GLint y, GLint z, GLint w)
 {
 	GLint xyzw[4] = {x, y, z, w};
 
-	glUniform4iv(location, 1, (GLint*)&xyzw);
+	Uniform4iv(location, 1, (GLint*)&xyzw);
 }
 
 void Uniform4iv(GLint location, GLsizei count, const GLint* v)
@@ -7003,6 +7148,8 @@ extern "C" NO_SANITIZE_FUNCTION __eglMustCastToProperFunctionPointerType es2GetP
 		FUNCTION(glLineWidth),
 		FUNCTION(glLinkProgram),
 		FUNCTION(glMapBufferRange),
+		FUNCTION(glMultiDrawArraysEXT),
+		FUNCTION(glMultiDrawElementsEXT),
 		FUNCTION(glPauseTransformFeedback),
 		FUNCTION(glPixelStorei),
 		FUNCTION(glPolygonOffset),
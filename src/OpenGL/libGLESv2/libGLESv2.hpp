@@ -92,6 +92,8 @@ public:
 	void (*glVertexAttribDivisorEXT)(GLuint index, GLuint divisor);
 	void (*glDrawArraysInstancedANGLE)(GLenum mode, GLint first, GLsizei count, GLsizei instanceCount);
 	void (*glDrawElementsInstancedANGLE)(GLenum mode, GLsizei count, GLenum type, const void *indices, GLsizei instanceCount);
+	void (*glMultiDrawArraysEXT)(GLenum mode, const GLint *first, const GLsizei *count, GLsizei primcount);
+	void (*glMultiDrawElementsEXT)(GLenum mode, const GLsizei *count, GLenum type, const void *const *indices, GLsizei primcount);
 	void (*glVertexAttribDivisorANGLE)(GLuint index, GLuint divisor);
 	void (*glEnable)(GLenum cap);
 	void (*glEnableVertexAttribArray)(GLuint index);
@@ -247,6 +249,10 @@ public:
 	egl::Image *(*createBackBuffer)(int width, int height, sw::Format format, int multiSampleDepth);
 	egl::Image *(*createDepthStencil)(int width, int height, sw::Format format, int multiSampleDepth);
 	sw::FrameBuffer *(*createFrameBuffer)(void *nativeDisplay, EGLNativeWindowType window, int width, int height);
+	void (*captureSwapBuffers)();
+	void (*getRoutineCounts)(int *vertexRoutines, int *setupRoutines, int *pixelRoutines);
+	void (*getRenameCounts)(int *bufferRenames, int *bufferWaits, int *textureRenames, int *textureWaits);
+	void (*getCodeMemoryUsage)(size_t *allocatedBytes, size_t *reservedBytes);
 };
 
 class LibGLESv2
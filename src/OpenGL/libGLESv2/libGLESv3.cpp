@@ -1037,6 +1037,7 @@ GL_APICALL void GL_APIENTRY glGetQueryObjectuiv(GLuint id, GLenum pname, GLuint
 	{
 	case GL_QUERY_RESULT:
 	case GL_QUERY_RESULT_AVAILABLE:
+	case GL_QUERY_RESULT_NO_WAIT_AMD:
 		break;
 	default:
 		return error(GL_INVALID_ENUM);
@@ -1058,6 +1059,21 @@ GL_APICALL void GL_APIENTRY glGetQueryObjectuiv(GLuint id, GLenum pname, GLuint
 			return error(GL_INVALID_OPERATION);
 		}
 
+		es2::Buffer *queryBuffer = context->getQueryBuffer();
+
+		if(queryBuffer)
+		{
+			// GL_AMD_query_buffer_object: params is an offset into the query buffer
+			GLintptr offset = reinterpret_cast<GLintptr>(params);
+
+			if((offset % sizeof(GLuint)) != 0 || (size_t)offset + sizeof(GLuint) > queryBuffer->size() || queryBuffer->isMapped())
+			{
+				return error(GL_INVALID_OPERATION);
+			}
+
+			return queryObject->writeResult(pname, queryBuffer, offset);
+		}
+
 		switch(pname)
 		{
 		case GL_QUERY_RESULT:
@@ -1066,6 +1082,12 @@ GL_APICALL void GL_APIENTRY glGetQueryObjectuiv(GLuint id, GLenum pname, GLuint
 		case GL_QUERY_RESULT_AVAILABLE:
 			params[0] = queryObject->isResultAvailable();
 			break;
+		case GL_QUERY_RESULT_NO_WAIT_AMD:
+			if(queryObject->isResultAvailable())
+			{
+				params[0] = queryObject->getResult();
+			}
+			break;
 		default:
 			ASSERT(false);
 		}
@@ -3833,9 +3855,9 @@ GL_APICALL void GL_APIENTRY glInvalidateSubFramebuffer(GLenum target, GLsizei nu
 					break;
 				}
 			}
-		}
 
-		// UNIMPLEMENTED();   // It is valid for this function to be treated as a no-op
+			framebuffer->invalidate(numAttachments, attachments, x, y, width, height);
+		}
 	}
 }
 
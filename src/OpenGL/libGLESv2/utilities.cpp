@@ -1352,6 +1352,22 @@ namespace es2
 		return GL_NONE;
 	}
 
+	// Primitive mode of the separate primitives that strips, fans and loops get split into
+	GLenum SeparatePrimitiveMode(GLenum mode)
+	{
+		switch(mode)
+		{
+		case GL_TRIANGLE_FAN:
+		case GL_TRIANGLE_STRIP:
+			return GL_TRIANGLES;
+		case GL_LINE_LOOP:
+		case GL_LINE_STRIP:
+			return GL_LINES;
+		default:
+			return mode;
+		}
+	}
+
 	bool IsColorRenderable(GLint internalformat, GLint clientVersion)
 	{
 		if(IsCompressed(internalformat, clientVersion))
@@ -58,6 +58,7 @@ namespace es2
 	GLenum ValidateTextureFormatType(GLenum format, GLenum type, GLint internalformat, GLint clientVersion);
 	GLsizei GetTypeSize(GLenum type);
 	GLenum GetBaseInternalFormat(GLint internalformat);
+	GLenum SeparatePrimitiveMode(GLenum mode);
 
 	bool IsColorRenderable(GLint internalformat, GLint clientVersion);
 	bool IsDepthRenderable(GLint internalformat, GLint clientVersion);
@@ -65,6 +65,7 @@ namespace llvm
 namespace
 {
 	sw::LLVMRoutineManager *routineManager = nullptr;
+	llvm::TargetMachine *targetMachine = nullptr;
 	llvm::ExecutionEngine *executionEngine = nullptr;
 	llvm::IRBuilder<> *builder = nullptr;
 	llvm::LLVMContext *context = nullptr;
@@ -210,8 +211,7 @@ namespace sw
 		MAttrs.push_back(CPUID::supportsSSE4_1() ? "+sse41" : "-sse41");
 
 		std::string error;
-		llvm::TargetMachine *targetMachine = llvm::EngineBuilder::selectTarget(::module, architecture, "", MAttrs, llvm::Reloc::Default, llvm::CodeModel::JITDefault, &error);
-		::executionEngine = llvm::JIT::createJIT(::module, 0, ::routineManager, llvm::CodeGenOpt::Aggressive, true, targetMachine);
+		::targetMachine = llvm::EngineBuilder::selectTarget(::module, architecture, "", MAttrs, llvm::Reloc::Default, llvm::CodeModel::JITDefault, &error);
 
 		if(!::builder)
 		{
@@ -233,9 +233,19 @@ namespace sw
 
 	Nucleus::~Nucleus()
 	{
-		delete ::executionEngine;
-		::executionEngine = nullptr;
+		if(::executionEngine)
+		{
+			delete ::executionEngine;   // Owns the module, routine manager and target machine
+			::executionEngine = nullptr;
+		}
+		else
+		{
+			delete ::targetMachine;
+			delete ::routineManager;
+			delete ::module;
+		}
 
+		::targetMachine = nullptr;
 		::routineManager = nullptr;
 		::function = nullptr;
 		::module = nullptr;
@@ -243,7 +253,7 @@ namespace sw
 		::codegenMutex.unlock();
 	}
 
-	Routine *Nucleus::acquireRoutine(const wchar_t *name, bool runOptimizations)
+	Routine *Nucleus::acquireRoutine(const wchar_t *name, OptimizationLevel level)
 	{
 		if(::builder->GetInsertBlock()->empty() || !::builder->GetInsertBlock()->back().isTerminator())
 		{
@@ -266,10 +276,13 @@ namespace sw
 			::module->print(file, 0);
 		}
 
-		if(runOptimizations)
-		{
-			optimize();
-		}
+		// The code generator's optimization level is fixed when creating the JIT. The IR passes
+		// run regardless, since without promoting variables to registers the code is an order of
+		// magnitude slower to both generate and execute.
+		llvm::CodeGenOpt::Level codeGenLevel = (level == QuickCompilation) ? llvm::CodeGenOpt::None : llvm::CodeGenOpt::Aggressive;
+		::executionEngine = llvm::JIT::createJIT(::module, 0, ::routineManager, codeGenLevel, true, ::targetMachine);
+
+		optimize();
 
 		if(false)
 		{
@@ -5943,6 +5956,11 @@ namespace sw
 		return lhs = lhs - offset;
 	}
 
+	void NoAlias(const Pointer<Byte> &pointer)
+	{
+		// LLVM's own alias analysis decides what can be moved
+	}
+
 	void Return()
 	{
 		Nucleus::createRetVoid();
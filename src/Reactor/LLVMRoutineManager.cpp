@@ -77,6 +77,9 @@ namespace sw
 	void LLVMRoutineManager::endFunctionBody(const llvm::Function *function, uint8_t *functionStart, uint8_t *functionEnd)
 	{
 		routine->functionSize = static_cast<int>(static_cast<ptrdiff_t>(functionEnd - functionStart));
+
+		// The size estimate only ever grows, so give the excess back to the code heap
+		routine->bufferSize = static_cast<int>(shrinkExecutable(routine->buffer, routine->bufferSize, routine->functionSize));
 	}
 
 	uint8_t *LLVMRoutineManager::startExceptionTable(const llvm::Function* F, uintptr_t &ActualSize)
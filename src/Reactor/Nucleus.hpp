@@ -46,6 +46,12 @@ namespace sw
 
 	extern Optimization optimization[10];
 
+	enum OptimizationLevel
+	{
+		QuickCompilation,   // Least code generation effort, for routines which are needed right away
+		FullOptimization,
+	};
+
 	class Nucleus
 	{
 	public:
@@ -53,7 +59,7 @@ namespace sw
 
 		virtual ~Nucleus();
 
-		Routine *acquireRoutine(const wchar_t *name, bool runOptimizations = true);
+		Routine *acquireRoutine(const wchar_t *name, OptimizationLevel level = FullOptimization);
 
 		static Value *allocateStackVariable(Type *type, int arraySize = 0);
 		static BasicBlock *createBasicBlock();
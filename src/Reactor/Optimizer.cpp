@@ -17,7 +17,9 @@
 #include "src/IceCfg.h"
 #include "src/IceCfgNode.h"
 
+#include <algorithm>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 namespace
@@ -25,14 +27,19 @@ namespace
 	class Optimizer
 	{
 	public:
-		void run(Ice::Cfg *function);
+		void run(Ice::Cfg *function, const std::vector<Ice::Operand*> &noAliasPointers);
 
 	private:
+		void analyzeControlFlow();
 		void analyzeUses(Ice::Cfg *function);
+		void analyzeNoAliasPointers(const std::vector<Ice::Operand*> &noAliasPointers);
+		void analyzeMemoryAccesses();
 		void eliminateDeadCode();
 		void eliminateUnitializedLoads();
 		void eliminateLoadsFollowingSingleStore();
 		void optimizeStoresInSingleBasicBlock();
+		void eliminateRedundantInstructions();
+		void hoistLoopInvariants();
 
 		void replace(Ice::Inst *instruction, Ice::Operand *newValue);
 		void deleteInstruction(Ice::Inst *instruction);
@@ -48,6 +55,65 @@ namespace
 		static std::size_t storeSize(const Ice::Inst *instruction);
 		static bool loadTypeMatchesStore(const Ice::Inst *load, const Ice::Inst *store);
 
+		struct Expression
+		{
+			bool operator==(const Expression &other) const;
+
+			Ice::Inst::InstKind kind;
+			int operation;   // Arithmetic, cast or comparison operator, or intrinsic ID
+			Ice::Type type;
+			std::vector<Ice::Operand*> operands;
+		};
+
+		struct ExpressionHash
+		{
+			std::size_t operator()(const Expression &expression) const;
+		};
+
+		struct MemoryLocation
+		{
+			bool operator==(const MemoryLocation &other) const;
+
+			Ice::Operand *address;
+			Ice::Type type;
+			std::size_t size;
+		};
+
+		struct MemoryLocationHash
+		{
+			std::size_t operator()(const MemoryLocation &location) const;
+		};
+
+		struct MemoryValue
+		{
+			Ice::Operand *value;
+			Ice::Variable *stackVariable;   // Alloca which the location belongs to, or null for other memory
+		};
+
+		typedef std::unordered_map<MemoryLocation, MemoryValue, MemoryLocationHash> Memory;
+
+		struct Clobbers
+		{
+			bool memory = false;   // Memory other than non-escaping stack variables
+			bool calls = false;    // Memory written by instructions other than stores
+			std::unordered_set<Ice::Variable*> stackVariables;
+			std::unordered_set<Ice::Operand*> noAliasPointers;   // Unaliased pointers which stores are derived from
+		};
+
+		static bool getExpression(const Ice::Inst *instruction, Expression &expression);
+		static MemoryLocation loadLocation(const Ice::Inst *instruction);
+		static MemoryLocation storeLocation(const Ice::Inst *instruction);
+		static bool clobbersMemory(const Ice::Inst &instruction);
+		static void invalidate(Memory &memory, const Clobbers &clobbers);
+
+		void numberValues(Ice::CfgNode *basicBlock, Memory &memory);
+		bool dominates(Ice::CfgNode *dominator, Ice::CfgNode *basicBlock) const;
+		Clobbers pathClobbers(Ice::CfgNode *dominator, Ice::CfgNode *basicBlock) const;
+		Ice::Variable *stackVariable(Ice::Operand *address) const;
+		Ice::Operand *baseAddress(Ice::Operand *address);
+		void findNoAliasPointers(Ice::Operand *address, std::unordered_set<Ice::Operand*> &pointers, std::unordered_set<Ice::Operand*> &visited);
+		bool isAvailable(Ice::Operand *value);
+
 		Ice::Cfg *function;
 		Ice::GlobalContext *context;
 
@@ -64,20 +130,42 @@ namespace
 		std::unordered_map<Ice::Operand*, Uses> uses;
 		std::unordered_map<Ice::Inst*, Ice::CfgNode*> node;
 		std::unordered_map<Ice::Variable*, Ice::Inst*> definition;
+
+		// Dominator tree, indexed by basic block number
+		std::vector<Ice::CfgNode*> immediateDominator;
+		std::vector<std::vector<Ice::CfgNode*>> dominated;
+		std::vector<Ice::CfgNode*> dominatorTreeOrder;   // Pre-order
+		std::vector<std::size_t> dominatorTreeEntry;   // Index in dominatorTreeOrder
+		std::vector<std::size_t> dominatorTreeExit;    // Largest pre-order index of the dominated subtree
+
+		std::unordered_map<Ice::Operand*, Ice::Variable*> stackAddresses;   // Addresses within allocas which don't escape
+		std::unordered_map<Ice::Variable*, std::vector<Ice::Inst*>> stackStores;
+		std::unordered_set<Ice::Operand*> noAlias;   // Values declared unaliased, see NoAlias()
+		std::vector<Clobbers> clobbers;   // Memory written by each basic block
+
+		std::unordered_map<Expression, Ice::Variable*, ExpressionHash> values;
+		std::vector<Expression> scope;   // Expressions of the dominating basic blocks, in order of appearance
 	};
 
-	void Optimizer::run(Ice::Cfg *function)
+	void Optimizer::run(Ice::Cfg *function, const std::vector<Ice::Operand*> &noAliasPointers)
 	{
 		this->function = function;
 		this->context = function->getContext();
 
+		analyzeControlFlow();
 		analyzeUses(function);
+		analyzeNoAliasPointers(noAliasPointers);
 
 		eliminateDeadCode();
 		eliminateUnitializedLoads();
 		eliminateLoadsFollowingSingleStore();
 		optimizeStoresInSingleBasicBlock();
 		eliminateDeadCode();
+
+		analyzeMemoryAccesses();
+		eliminateRedundantInstructions();
+		hoistLoopInvariants();
+		eliminateDeadCode();
 	}
 
 	void Optimizer::eliminateDeadCode()
@@ -357,6 +445,458 @@ namespace
 		}
 	}
 
+	// Global value numbering, walking the dominator tree. Loads are numbered by their address
+	// and type, and also take the value of preceding stores to the same location, until
+	// memory which might alias gets written.
+	void Optimizer::eliminateRedundantInstructions()
+	{
+		struct Scope
+		{
+			Ice::CfgNode *basicBlock;
+			std::size_t child;
+			std::size_t expressions;
+			Memory memory;
+		};
+
+		std::vector<Scope> scopes;
+
+		values.clear();
+		scope.clear();
+
+		Ice::CfgNode *entryBlock = function->getEntryNode();
+		Memory memory;
+		numberValues(entryBlock, memory);
+		scopes.push_back({entryBlock, 0, 0, std::move(memory)});
+
+		while(!scopes.empty())
+		{
+			Scope &parent = scopes.back();
+			const auto &children = dominated[parent.basicBlock->getIndex()];
+
+			if(parent.child < children.size())
+			{
+				Ice::CfgNode *basicBlock = children[parent.child++];
+				std::size_t expressions = scope.size();
+
+				// Paths from the dominator which don't go through it again may write memory
+				Memory memory = parent.memory;
+				if(basicBlock->getInEdges().size() != 1 && !memory.empty())
+				{
+					invalidate(memory, pathClobbers(parent.basicBlock, basicBlock));
+				}
+
+				numberValues(basicBlock, memory);
+				scopes.push_back({basicBlock, 0, expressions, std::move(memory)});
+			}
+			else
+			{
+				while(scope.size() > parent.expressions)
+				{
+					values.erase(scope.back());
+					scope.pop_back();
+				}
+
+				scopes.pop_back();
+			}
+		}
+
+		values.clear();
+	}
+
+	void Optimizer::numberValues(Ice::CfgNode *basicBlock, Memory &memory)
+	{
+		Expression expression;
+
+		for(Ice::Inst &inst : basicBlock->getInsts())
+		{
+			if(inst.isDeleted())
+			{
+				continue;
+			}
+
+			if(isLoad(inst))
+			{
+				MemoryLocation location = loadLocation(&inst);
+				auto entry = memory.find(location);
+
+				if(entry != memory.end() && isAvailable(entry->second.value))
+				{
+					replace(&inst, entry->second.value);
+				}
+				else
+				{
+					memory[location] = {inst.getDest(), stackVariable(location.address)};
+				}
+			}
+			else if(isStore(inst))
+			{
+				MemoryLocation location = storeLocation(&inst);
+				Clobbers clobbers;
+
+				if(Ice::Variable *variable = stackVariable(location.address))
+				{
+					clobbers.stackVariables.insert(variable);
+					invalidate(memory, clobbers);
+					memory[location] = {storeData(&inst), variable};
+				}
+				else
+				{
+					clobbers.memory = true;
+					invalidate(memory, clobbers);
+					memory[location] = {storeData(&inst), nullptr};
+				}
+			}
+			else if(clobbersMemory(inst))
+			{
+				Clobbers clobbers;
+				clobbers.memory = true;
+				invalidate(memory, clobbers);
+			}
+			else if(getExpression(&inst, expression))
+			{
+				auto entry = values.find(expression);
+
+				if(entry != values.end() && isAvailable(entry->second))
+				{
+					replace(&inst, entry->second);
+				}
+				else
+				{
+					values[expression] = inst.getDest();
+					scope.push_back(expression);
+				}
+			}
+		}
+	}
+
+	// Moves loop invariant computations into the loop's preheader. Loads are hoisted when the
+	// loop doesn't write memory they might alias, and when they can't fault. That is the case
+	// for stack variables, and for constant offsets from routine arguments which get
+	// dereferenced unconditionally, like the pointer to DrawData. Constant offsets from pointers
+	// declared unaliased only have to be kept from moving past stores derived from them.
+	void Optimizer::hoistLoopInvariants()
+	{
+		const Ice::NodeList &basicBlocks = function->getNodes();
+
+		std::unordered_set<Ice::Operand*> dereferencedArguments;
+
+		for(Ice::Inst &inst : function->getEntryNode()->getInsts())
+		{
+			if(!inst.isDeleted() && (isLoad(inst) || isStore(inst)))
+			{
+				Ice::Operand *base = baseAddress(isLoad(inst) ? loadAddress(&inst) : storeAddress(&inst));
+
+				for(Ice::Variable *argument : function->getArgs())
+				{
+					if(base == argument)
+					{
+						dereferencedArguments.insert(argument);
+					}
+				}
+			}
+		}
+
+		// Inner loops come after outer ones in the dominator tree. Visiting them first allows
+		// their invariants to get hoisted further out.
+		for(auto header = dominatorTreeOrder.rbegin(); header != dominatorTreeOrder.rend(); ++header)
+		{
+			std::vector<Ice::CfgNode*> worklist;
+
+			for(Ice::CfgNode *predecessor : (*header)->getInEdges())
+			{
+				if(dominates(*header, predecessor))   // Back edge
+				{
+					worklist.push_back(predecessor);
+				}
+			}
+
+			if(worklist.empty())
+			{
+				continue;
+			}
+
+			std::vector<bool> loop(basicBlocks.size(), false);
+			loop[(*header)->getIndex()] = true;
+
+			while(!worklist.empty())
+			{
+				Ice::CfgNode *basicBlock = worklist.back();
+				worklist.pop_back();
+
+				if(!loop[basicBlock->getIndex()])
+				{
+					loop[basicBlock->getIndex()] = true;
+
+					for(Ice::CfgNode *predecessor : basicBlock->getInEdges())
+					{
+						worklist.push_back(predecessor);
+					}
+				}
+			}
+
+			Ice::CfgNode *preheader = nullptr;
+			int entries = 0;
+
+			for(Ice::CfgNode *predecessor : (*header)->getInEdges())
+			{
+				if(!loop[predecessor->getIndex()])
+				{
+					preheader = predecessor;
+					entries++;
+				}
+			}
+
+			if(entries != 1 || preheader->getOutEdges().size() != 1)
+			{
+				continue;   // No single edge into the loop to hoist onto
+			}
+
+			Clobbers loopClobbers;
+
+			for(Ice::CfgNode *basicBlock : basicBlocks)
+			{
+				if(loop[basicBlock->getIndex()])
+				{
+					const Clobbers &blockClobbers = clobbers[basicBlock->getIndex()];
+
+					loopClobbers.memory |= blockClobbers.memory;
+					loopClobbers.calls |= blockClobbers.calls;
+					loopClobbers.stackVariables.insert(blockClobbers.stackVariables.begin(), blockClobbers.stackVariables.end());
+					loopClobbers.noAliasPointers.insert(blockClobbers.noAliasPointers.begin(), blockClobbers.noAliasPointers.end());
+				}
+			}
+
+			Ice::Inst *terminator = &preheader->getInsts().back();
+			std::vector<Ice::Inst*> invariants;
+			Expression expression;
+
+			do
+			{
+				invariants.clear();
+
+				for(Ice::CfgNode *basicBlock : basicBlocks)
+				{
+					if(!loop[basicBlock->getIndex()])
+					{
+						continue;
+					}
+
+					for(Ice::Inst &inst : basicBlock->getInsts())
+					{
+						if(inst.isDeleted())
+						{
+							continue;
+						}
+
+						if(isLoad(inst))
+						{
+							Ice::Operand *address = loadAddress(&inst);
+							Ice::Operand *base = baseAddress(address);
+
+							if(Ice::Variable *variable = stackVariable(address))
+							{
+								if(loopClobbers.stackVariables.count(variable) != 0)
+								{
+									continue;
+								}
+							}
+							else if(noAlias.count(base) != 0)
+							{
+								if(loopClobbers.calls || loopClobbers.noAliasPointers.count(base) != 0)
+								{
+									continue;
+								}
+							}
+							else if(loopClobbers.memory || dereferencedArguments.count(base) == 0)
+							{
+								continue;
+							}
+						}
+						else if(!getExpression(&inst, expression))
+						{
+							continue;
+						}
+						else if(auto *arithmetic = llvm::dyn_cast<Ice::InstArithmetic>(&inst))
+						{
+							switch(arithmetic->getOp())
+							{
+							case Ice::InstArithmetic::Udiv:
+							case Ice::InstArithmetic::Sdiv:
+							case Ice::InstArithmetic::Urem:
+							case Ice::InstArithmetic::Srem:
+								continue;   // Could trap on iterations where it's not executed
+							default:
+								break;
+							}
+						}
+
+						bool invariant = true;
+
+						for(Ice::SizeT i = 0; i < inst.getSrcSize(); i++)
+						{
+							if(auto *variable = llvm::dyn_cast<Ice::Variable>(inst.getSrc(i)))
+							{
+								Ice::Inst *def = definition[variable];
+
+								if(def && loop[node[def]->getIndex()])
+								{
+									invariant = false;
+								}
+							}
+						}
+
+						if(invariant)
+						{
+							invariants.push_back(&inst);
+						}
+					}
+				}
+
+				for(Ice::Inst *inst : invariants)
+				{
+					node[inst]->getInsts().remove(inst);
+					preheader->getInsts().insert(terminator->getIterator(), inst);
+					node[inst] = preheader;
+				}
+			}
+			while(!invariants.empty());
+		}
+	}
+
+	void Optimizer::analyzeControlFlow()
+	{
+		function->computeInOutEdges();   // Also removes unreachable basic blocks
+
+		const Ice::NodeList &basicBlocks = function->getNodes();
+		Ice::CfgNode *entryBlock = function->getEntryNode();
+
+		std::vector<Ice::CfgNode*> postOrder;
+		std::vector<std::size_t> postOrderIndex(basicBlocks.size());
+		std::vector<bool> visited(basicBlocks.size(), false);
+		std::vector<std::pair<Ice::CfgNode*, std::size_t>> stack;
+
+		visited[entryBlock->getIndex()] = true;
+		stack.push_back({entryBlock, 0});
+
+		while(!stack.empty())
+		{
+			Ice::CfgNode *basicBlock = stack.back().first;
+			std::size_t successor = stack.back().second++;
+
+			if(successor < basicBlock->getOutEdges().size())
+			{
+				Ice::CfgNode *next = basicBlock->getOutEdges()[successor];
+
+				if(!visited[next->getIndex()])
+				{
+					visited[next->getIndex()] = true;
+					stack.push_back({next, 0});
+				}
+			}
+			else
+			{
+				postOrderIndex[basicBlock->getIndex()] = postOrder.size();
+				postOrder.push_back(basicBlock);
+				stack.pop_back();
+			}
+		}
+
+		// "A Simple, Fast Dominance Algorithm" by Cooper, Harvey and Kennedy
+		immediateDominator.assign(basicBlocks.size(), nullptr);
+		immediateDominator[entryBlock->getIndex()] = entryBlock;
+
+		bool modified;
+		do
+		{
+			modified = false;
+
+			for(auto basicBlock = postOrder.rbegin(); basicBlock != postOrder.rend(); ++basicBlock)
+			{
+				if(*basicBlock == entryBlock)
+				{
+					continue;
+				}
+
+				Ice::CfgNode *dominator = nullptr;
+
+				for(Ice::CfgNode *predecessor : (*basicBlock)->getInEdges())
+				{
+					if(!immediateDominator[predecessor->getIndex()])
+					{
+						continue;
+					}
+
+					if(!dominator)
+					{
+						dominator = predecessor;
+						continue;
+					}
+
+					Ice::CfgNode *other = predecessor;
+
+					while(dominator != other)
+					{
+						while(postOrderIndex[dominator->getIndex()] < postOrderIndex[other->getIndex()])
+						{
+							dominator = immediateDominator[dominator->getIndex()];
+						}
+
+						while(postOrderIndex[other->getIndex()] < postOrderIndex[dominator->getIndex()])
+						{
+							other = immediateDominator[other->getIndex()];
+						}
+					}
+				}
+
+				if(immediateDominator[(*basicBlock)->getIndex()] != dominator)
+				{
+					immediateDominator[(*basicBlock)->getIndex()] = dominator;
+					modified = true;
+				}
+			}
+		}
+		while(modified);
+
+		dominated.assign(basicBlocks.size(), std::vector<Ice::CfgNode*>());
+
+		for(Ice::CfgNode *basicBlock : basicBlocks)
+		{
+			if(basicBlock != entryBlock)
+			{
+				dominated[immediateDominator[basicBlock->getIndex()]->getIndex()].push_back(basicBlock);
+			}
+		}
+
+		// Number the dominator tree in pre-order, so that dominance checks are range checks
+		dominatorTreeOrder.clear();
+		dominatorTreeEntry.assign(basicBlocks.size(), 0);
+		dominatorTreeExit.assign(basicBlocks.size(), 0);
+
+		stack.push_back({entryBlock, 0});
+		dominatorTreeEntry[entryBlock->getIndex()] = 0;
+		dominatorTreeOrder.push_back(entryBlock);
+
+		while(!stack.empty())
+		{
+			Ice::CfgNode *basicBlock = stack.back().first;
+			std::size_t child = stack.back().second++;
+
+			if(child < dominated[basicBlock->getIndex()].size())
+			{
+				Ice::CfgNode *next = dominated[basicBlock->getIndex()][child];
+
+				dominatorTreeEntry[next->getIndex()] = dominatorTreeOrder.size();
+				dominatorTreeOrder.push_back(next);
+				stack.push_back({next, 0});
+			}
+			else
+			{
+				dominatorTreeExit[basicBlock->getIndex()] = dominatorTreeOrder.size() - 1;
+				stack.pop_back();
+			}
+		}
+	}
+
 	void Optimizer::analyzeUses(Ice::Cfg *function)
 	{
 		uses.clear();
@@ -396,6 +936,164 @@ namespace
 		}
 	}
 
+	// Marks the values stored to the variables passed to NoAlias(). The loads which identified
+	// them are dead and get eliminated along with the rest.
+	void Optimizer::analyzeNoAliasPointers(const std::vector<Ice::Operand*> &noAliasPointers)
+	{
+		noAlias.clear();
+
+		for(Ice::Operand *pointer : noAliasPointers)
+		{
+			Ice::Inst *load = definition[llvm::cast<Ice::Variable>(pointer)];
+
+			if(!load || !isLoad(*load))
+			{
+				continue;
+			}
+
+			const Uses &variableUses = uses[loadAddress(load)];
+
+			for(Ice::Inst *store : variableUses.stores)
+			{
+				if(llvm::isa<Ice::Variable>(storeData(store)))   // Constants are shared
+				{
+					noAlias.insert(storeData(store));
+				}
+			}
+
+			for(Ice::Inst *variableLoad : variableUses.loads)
+			{
+				noAlias.insert(variableLoad->getDest());
+			}
+		}
+	}
+
+	// Determines which addresses point into allocas whose address is only used for loading and
+	// storing, and which memory each basic block writes to.
+	void Optimizer::analyzeMemoryAccesses()
+	{
+		std::unordered_map<Ice::Operand*, Ice::Variable*> candidates;
+		std::unordered_set<Ice::Variable*> escaping;
+
+		for(Ice::Inst &alloca : function->getEntryNode()->getInsts())
+		{
+			if(alloca.isDeleted())
+			{
+				continue;
+			}
+
+			if(!llvm::isa<Ice::InstAlloca>(alloca))
+			{
+				break;   // Allocas are all at the top
+			}
+
+			Ice::Variable *variable = alloca.getDest();
+			std::vector<Ice::Variable*> addresses(1, variable);
+
+			for(std::size_t i = 0; i < addresses.size(); i++)
+			{
+				Ice::Variable *address = addresses[i];
+
+				if(candidates.count(address) != 0 && candidates[address] != variable)   // Derived from more than one alloca
+				{
+					escaping.insert(variable);
+					escaping.insert(candidates[address]);
+				}
+
+				candidates[address] = variable;
+
+				for(Ice::Inst *use : uses[address])
+				{
+					if(isLoad(*use) && loadAddress(use) == address)
+					{
+						continue;
+					}
+
+					if(isStore(*use) && storeAddress(use) == address && storeData(use) != address)
+					{
+						continue;
+					}
+
+					if(auto *arithmetic = llvm::dyn_cast<Ice::InstArithmetic>(use))
+					{
+						if(arithmetic->getOp() == Ice::InstArithmetic::Add || (arithmetic->getOp() == Ice::InstArithmetic::Sub && arithmetic->getSrc(0) == address))
+						{
+							addresses.push_back(arithmetic->getDest());
+							continue;
+						}
+					}
+
+					escaping.insert(variable);
+				}
+			}
+		}
+
+		stackAddresses.clear();
+
+		for(const auto &candidate : candidates)
+		{
+			if(escaping.count(candidate.second) == 0)
+			{
+				stackAddresses.insert(candidate);
+			}
+		}
+
+		const Ice::NodeList &basicBlocks = function->getNodes();
+		stackStores.clear();
+
+		for(Ice::CfgNode *basicBlock : basicBlocks)
+		{
+			for(Ice::Inst &inst : basicBlock->getInsts())
+			{
+				if(!inst.isDeleted() && isStore(inst))
+				{
+					if(Ice::Variable *variable = stackVariable(storeAddress(&inst)))
+					{
+						stackStores[variable].push_back(&inst);
+					}
+				}
+			}
+		}
+
+		clobbers.assign(basicBlocks.size(), Clobbers());
+
+		for(Ice::CfgNode *basicBlock : basicBlocks)
+		{
+			Clobbers &blockClobbers = clobbers[basicBlock->getIndex()];
+
+			for(Ice::Inst &inst : basicBlock->getInsts())
+			{
+				if(inst.isDeleted())
+				{
+					continue;
+				}
+
+				if(isStore(inst))
+				{
+					if(Ice::Variable *variable = stackVariable(storeAddress(&inst)))
+					{
+						blockClobbers.stackVariables.insert(variable);
+					}
+					else
+					{
+						blockClobbers.memory = true;
+
+						if(!noAlias.empty())
+						{
+							std::unordered_set<Ice::Operand*> visited;
+							findNoAliasPointers(storeAddress(&inst), blockClobbers.noAliasPointers, visited);
+						}
+					}
+				}
+				else if(clobbersMemory(inst))
+				{
+					blockClobbers.memory = true;
+					blockClobbers.calls = true;
+				}
+			}
+		}
+	}
+
 	void Optimizer::replace(Ice::Inst *instruction, Ice::Operand *newValue)
 	{
 		Ice::Variable *oldValue = instruction->getDest();
@@ -422,6 +1120,11 @@ namespace
 
 		uses.erase(oldValue);
 
+		if(noAlias.count(oldValue) != 0)
+		{
+			noAlias.insert(newValue);
+		}
+
 		deleteInstruction(instruction);
 	}
 
@@ -629,6 +1332,231 @@ namespace
 		return false;
 	}
 
+	bool Optimizer::dominates(Ice::CfgNode *dominator, Ice::CfgNode *basicBlock) const
+	{
+		std::size_t entry = dominatorTreeEntry[basicBlock->getIndex()];
+
+		return dominatorTreeEntry[dominator->getIndex()] <= entry && entry <= dominatorTreeExit[dominator->getIndex()];
+	}
+
+	// Memory written on paths from the end of the dominator to the start of the basic block
+	Optimizer::Clobbers Optimizer::pathClobbers(Ice::CfgNode *dominator, Ice::CfgNode *basicBlock) const
+	{
+		Clobbers pathClobbers;
+		std::vector<bool> visited(function->getNodes().size(), false);
+		std::vector<Ice::CfgNode*> worklist(basicBlock->getInEdges().begin(), basicBlock->getInEdges().end());
+
+		while(!worklist.empty())
+		{
+			Ice::CfgNode *predecessor = worklist.back();
+			worklist.pop_back();
+
+			if(predecessor == dominator || visited[predecessor->getIndex()])
+			{
+				continue;
+			}
+
+			visited[predecessor->getIndex()] = true;
+
+			const Clobbers &blockClobbers = clobbers[predecessor->getIndex()];
+			pathClobbers.memory |= blockClobbers.memory;
+			pathClobbers.calls |= blockClobbers.calls;
+			pathClobbers.stackVariables.insert(blockClobbers.stackVariables.begin(), blockClobbers.stackVariables.end());
+			pathClobbers.noAliasPointers.insert(blockClobbers.noAliasPointers.begin(), blockClobbers.noAliasPointers.end());
+
+			worklist.insert(worklist.end(), predecessor->getInEdges().begin(), predecessor->getInEdges().end());
+		}
+
+		return pathClobbers;
+	}
+
+	void Optimizer::invalidate(Memory &memory, const Clobbers &clobbers)
+	{
+		for(auto entry = memory.begin(); entry != memory.end();)
+		{
+			Ice::Variable *variable = entry->second.stackVariable;
+
+			if(variable ? clobbers.stackVariables.count(variable) != 0 : clobbers.memory)
+			{
+				entry = memory.erase(entry);
+			}
+			else
+			{
+				++entry;
+			}
+		}
+	}
+
+	Ice::Variable *Optimizer::stackVariable(Ice::Operand *address) const
+	{
+		auto entry = stackAddresses.find(address);
+
+		return (entry != stackAddresses.end()) ? entry->second : nullptr;
+	}
+
+	Ice::Operand *Optimizer::baseAddress(Ice::Operand *address)
+	{
+		while(auto *variable = llvm::dyn_cast<Ice::Variable>(address))
+		{
+			auto *offset = llvm::dyn_cast_or_null<Ice::InstArithmetic>(definition[variable]);
+
+			if(!offset || offset->getOp() != Ice::InstArithmetic::Add || !llvm::isa<Ice::Constant>(offset->getSrc(1)))
+			{
+				break;
+			}
+
+			address = offset->getSrc(0);
+		}
+
+		return address;
+	}
+
+	// Collects the unaliased pointers which an address is computed from, also through pointers
+	// kept in stack variables
+	void Optimizer::findNoAliasPointers(Ice::Operand *address, std::unordered_set<Ice::Operand*> &pointers, std::unordered_set<Ice::Operand*> &visited)
+	{
+		if(!visited.insert(address).second)
+		{
+			return;
+		}
+
+		if(noAlias.count(address) != 0)
+		{
+			pointers.insert(address);
+		}
+
+		auto *variable = llvm::dyn_cast<Ice::Variable>(address);
+		Ice::Inst *def = variable ? definition[variable] : nullptr;
+
+		if(!def || def->isDeleted())
+		{
+			return;
+		}
+
+		if(llvm::isa<Ice::InstArithmetic>(def) || llvm::isa<Ice::InstCast>(def) || llvm::isa<Ice::InstSelect>(def))
+		{
+			for(Ice::SizeT i = 0; i < def->getSrcSize(); i++)
+			{
+				findNoAliasPointers(def->getSrc(i), pointers, visited);
+			}
+		}
+		else if(isLoad(*def))
+		{
+			if(Ice::Variable *stack = stackVariable(loadAddress(def)))
+			{
+				for(Ice::Inst *store : stackStores[stack])
+				{
+					findNoAliasPointers(storeData(store), pointers, visited);
+				}
+			}
+		}
+	}
+
+	bool Optimizer::isAvailable(Ice::Operand *value)
+	{
+		if(auto *variable = llvm::dyn_cast<Ice::Variable>(value))
+		{
+			Ice::Inst *def = definition[variable];
+
+			return !def || !def->isDeleted();   // Arguments don't have a defining instruction
+		}
+
+		return true;
+	}
+
+	bool Optimizer::clobbersMemory(const Ice::Inst &instruction)
+	{
+		if(auto *intrinsic = llvm::dyn_cast<Ice::InstIntrinsicCall>(&instruction))
+		{
+			return intrinsic->getIntrinsicInfo().HasSideEffects && !asLoadSubVector(&instruction);
+		}
+
+		return llvm::isa<Ice::InstCall>(&instruction);
+	}
+
+	bool Optimizer::getExpression(const Ice::Inst *instruction, Expression &expression)
+	{
+		switch(instruction->getKind())
+		{
+		case Ice::Inst::Arithmetic:
+			expression.operation = llvm::cast<Ice::InstArithmetic>(instruction)->getOp();
+			break;
+		case Ice::Inst::Cast:
+			expression.operation = llvm::cast<Ice::InstCast>(instruction)->getCastKind();
+			break;
+		case Ice::Inst::Icmp:
+			expression.operation = llvm::cast<Ice::InstIcmp>(instruction)->getCondition();
+			break;
+		case Ice::Inst::Fcmp:
+			expression.operation = llvm::cast<Ice::InstFcmp>(instruction)->getCondition();
+			break;
+		case Ice::Inst::IntrinsicCall:
+			{
+				Ice::Intrinsics::IntrinsicInfo info = llvm::cast<Ice::InstIntrinsicCall>(instruction)->getIntrinsicInfo();
+
+				if(info.HasSideEffects || info.ID == Ice::Intrinsics::LoadSubVector)
+				{
+					return false;
+				}
+
+				expression.operation = info.ID;
+			}
+			break;
+		case Ice::Inst::Select:
+		case Ice::Inst::ExtractElement:
+		case Ice::Inst::InsertElement:
+		case Ice::Inst::ShuffleVector:
+			expression.operation = 0;
+			break;
+		default:
+			return false;
+		}
+
+		expression.kind = instruction->getKind();
+		expression.type = instruction->getDest()->getType();
+		expression.operands.clear();
+
+		for(Ice::SizeT i = 0; i < instruction->getSrcSize(); i++)
+		{
+			expression.operands.push_back(instruction->getSrc(i));
+		}
+
+		if(auto *shuffle = llvm::dyn_cast<Ice::InstShuffleVector>(instruction))
+		{
+			for(Ice::SizeT i = 0; i < shuffle->getNumIndexes(); i++)
+			{
+				expression.operands.push_back(shuffle->getIndex(i));
+			}
+		}
+
+		if(auto *arithmetic = llvm::dyn_cast<Ice::InstArithmetic>(instruction))
+		{
+			if(arithmetic->isCommutative() && std::less<Ice::Operand*>()(expression.operands[1], expression.operands[0]))
+			{
+				std::swap(expression.operands[0], expression.operands[1]);
+			}
+		}
+
+		return true;
+	}
+
+	Optimizer::MemoryLocation Optimizer::loadLocation(const Ice::Inst *instruction)
+	{
+		Ice::Type type = instruction->getDest()->getType();
+
+		if(auto *loadSubVector = asLoadSubVector(instruction))
+		{
+			return {loadAddress(instruction), type, (std::size_t)llvm::cast<Ice::ConstantInteger32>(loadSubVector->getSrc(2))->getValue()};
+		}
+
+		return {loadAddress(instruction), type, Ice::typeWidthInBytes(type)};
+	}
+
+	Optimizer::MemoryLocation Optimizer::storeLocation(const Ice::Inst *instruction)
+	{
+		return {storeAddress(instruction), storeData(instruction)->getType(), storeSize(instruction)};
+	}
+
 	bool Optimizer::Uses::areOnlyLoadStore() const
 	{
 		return size() == (loads.size() + stores.size());
@@ -689,14 +1617,41 @@ namespace
 			}
 		}
 	}
+
+	bool Optimizer::Expression::operator==(const Expression &other) const
+	{
+		return kind == other.kind && operation == other.operation && type == other.type && operands == other.operands;
+	}
+
+	std::size_t Optimizer::ExpressionHash::operator()(const Expression &expression) const
+	{
+		std::size_t hash = (expression.kind << 16) ^ (expression.operation << 8) ^ expression.type;
+
+		for(Ice::Operand *operand : expression.operands)
+		{
+			hash = hash * 31 + std::hash<Ice::Operand*>()(operand);
+		}
+
+		return hash;
+	}
+
+	bool Optimizer::MemoryLocation::operator==(const MemoryLocation &other) const
+	{
+		return address == other.address && type == other.type && size == other.size;
+	}
+
+	std::size_t Optimizer::MemoryLocationHash::operator()(const MemoryLocation &location) const
+	{
+		return std::hash<Ice::Operand*>()(location.address) ^ (location.type << 8) ^ location.size;
+	}
 }
 
 namespace sw
 {
-	void optimize(Ice::Cfg *function)
+	void optimize(Ice::Cfg *function, const std::vector<Ice::Operand*> &noAliasPointers)
 	{
 		Optimizer optimizer;
 
-		optimizer.run(function);
+		optimizer.run(function, noAliasPointers);
 	}
 }
\ No newline at end of file
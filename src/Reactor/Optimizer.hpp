@@ -17,9 +17,12 @@
 
 #include "src/IceCfg.h"
 
+#include <vector>
+
 namespace sw
 {
-	void optimize(Ice::Cfg *function);
+	// Pointers which aren't aliased by unrelated ones can have loads moved past other stores
+	void optimize(Ice::Cfg *function, const std::vector<Ice::Operand*> &noAliasPointers);
 }
 
 #endif   // sw_Optimizer_hpp
@@ -2174,6 +2174,11 @@ namespace sw
 	RValue<Pointer<Byte>> operator-=(Pointer<Byte> &lhs, RValue<Int> offset);
 	RValue<Pointer<Byte>> operator-=(Pointer<Byte> &lhs, RValue<UInt> offset);
 
+	// Declares that the memory accessed through the pointers this variable holds is only accessed
+	// through pointers derived from them while the routine runs, and stays valid throughout. Loads
+	// from it can then be moved past stores through other pointers.
+	void NoAlias(const Pointer<Byte> &pointer);
+
 	template<class T, int S = 1>
 	class Array : public LValue<T>
 	{
@@ -2238,8 +2243,11 @@ namespace sw
 		}
 
 		Routine *operator()(const wchar_t *name, ...);
+		Routine *operator()(OptimizationLevel level, const wchar_t *name, ...);
 
 	protected:
+		Routine *acquire(OptimizationLevel level, const wchar_t *name, va_list vararg);
+
 		Nucleus *core;
 		std::vector<Type*> arguments;
 	};
@@ -2739,14 +2747,32 @@ namespace sw
 	template<typename Return, typename... Arguments>
 	Routine *Function<Return(Arguments...)>::operator()(const wchar_t *name, ...)
 	{
-		wchar_t fullName[1024 + 1];
+		va_list vararg;
+		va_start(vararg, name);
+		Routine *routine = acquire(FullOptimization, name, vararg);
+		va_end(vararg);
+
+		return routine;
+	}
 
+	template<typename Return, typename... Arguments>
+	Routine *Function<Return(Arguments...)>::operator()(OptimizationLevel level, const wchar_t *name, ...)
+	{
 		va_list vararg;
 		va_start(vararg, name);
-		vswprintf(fullName, 1024, name, vararg);
+		Routine *routine = acquire(level, name, vararg);
 		va_end(vararg);
 
-		return core->acquireRoutine(fullName, true);
+		return routine;
+	}
+
+	template<typename Return, typename... Arguments>
+	Routine *Function<Return(Arguments...)>::acquire(OptimizationLevel level, const wchar_t *name, va_list vararg)
+	{
+		wchar_t fullName[1024 + 1];
+		vswprintf(fullName, 1024, name, vararg);
+
+		return core->acquireRoutine(fullName, level);
 	}
 
 	template<class T, class S>
@@ -15,6 +15,7 @@
 #include "Reactor.hpp"
 
 #include "Optimizer.hpp"
+#include "../Common/Memory.hpp"
 
 #include "src/IceTypes.h"
 #include "src/IceCfg.h"
@@ -35,11 +36,6 @@
 #define NOMINMAX
 #endif // !NOMINMAX
 #include <Windows.h>
-#else
-#include <sys/mman.h>
-#if !defined(MAP_ANONYMOUS)
-#define MAP_ANONYMOUS MAP_ANON
-#endif
 #endif
 
 //#include <mutex>
@@ -54,6 +50,7 @@ namespace
 	Ice::CfgNode *basicBlock = nullptr;
 	Ice::CfgLocalAllocatorScope *allocator = nullptr;
 	sw::Routine *routine = nullptr;
+	std::vector<Ice::Operand*> noAliasPointers;   // See NoAlias()
 
 	std::mutex codegenMutex;
 
@@ -407,41 +404,13 @@ namespace sw
 		return entry;
 	}
 
-	template<typename T>
-	struct ExecutableAllocator
-	{
-		ExecutableAllocator() {};
-		template<class U> ExecutableAllocator(const ExecutableAllocator<U> &other) {};
-
-		using value_type = T;
-		using size_type = std::size_t;
-
-		T *allocate(size_type n)
-		{
-			#if defined(_WIN32)
-				return (T*)VirtualAlloc(NULL, sizeof(T) * n, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
-			#else
-				return (T*)mmap(nullptr, sizeof(T) * n, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
-			#endif
-		}
-
-		void deallocate(T *p, size_type n)
-		{
-			#if defined(_WIN32)
-				VirtualFree(p, 0, MEM_RELEASE);
-			#else
-				munmap(p, sizeof(T) * n);
-			#endif
-		}
-	};
-
 	class ELFMemoryStreamer : public Ice::ELFStreamer, public Routine
 	{
 		ELFMemoryStreamer(const ELFMemoryStreamer &) = delete;
 		ELFMemoryStreamer &operator=(const ELFMemoryStreamer &) = delete;
 
 	public:
-		ELFMemoryStreamer() : Routine(), entry(nullptr)
+		ELFMemoryStreamer() : Routine(), entry(nullptr), image(nullptr), imageSize(0)
 		{
 			position = 0;
 			buffer.reserve(0x1000);
@@ -449,13 +418,10 @@ namespace sw
 
 		~ELFMemoryStreamer() override
 		{
-			#if defined(_WIN32)
-				if(buffer.size() != 0)
-				{
-					DWORD exeProtection;
-					VirtualProtect(&buffer[0], buffer.size(), oldProtection, &exeProtection);
-				}
-			#endif
+			if(image)
+			{
+				deallocateExecutable(image, imageSize);
+			}
 		}
 
 		void write8(uint8_t Value) override
@@ -491,14 +457,27 @@ namespace sw
 			{
 				position = std::numeric_limits<std::size_t>::max();   // Can't stream more data after this
 
+				// The image is streamed into ordinary memory, and only copied into the code heap
+				// once complete, so it takes exactly the pages it needs
+				imageSize = buffer.size();
+				image = (uint8_t*)allocateExecutable(imageSize);
+
+				if(!image)   // Out of address space for code
+				{
+					return nullptr;
+				}
+
+				memcpy(image, &buffer[0], imageSize);
+				std::vector<uint8_t>().swap(buffer);
+
 				size_t codeSize = 0;
-				entry = loadImage(&buffer[0], codeSize);
+				entry = loadImage(image, codeSize);
+
+				markExecutable(image, imageSize);
 
 				#if defined(_WIN32)
-					VirtualProtect(&buffer[0], buffer.size(), PAGE_EXECUTE_READ, &oldProtection);
 					FlushInstructionCache(GetCurrentProcess(), NULL, 0);
 				#else
-					mprotect(&buffer[0], buffer.size(), PROT_READ | PROT_EXEC);
 					__builtin___clear_cache((char*)entry, (char*)entry + codeSize);
 				#endif
 			}
@@ -508,12 +487,10 @@ namespace sw
 
 	private:
 		void *entry;
-		std::vector<uint8_t, ExecutableAllocator<uint8_t>> buffer;
+		uint8_t *image;   // Relocated copy of the ELF image in executable memory
+		std::size_t imageSize;
+		std::vector<uint8_t> buffer;
 		std::size_t position;
-
-		#if defined(_WIN32)
-		DWORD oldProtection;
-		#endif
 	};
 
 	Nucleus::Nucleus()
@@ -568,7 +545,7 @@ namespace sw
 		::codegenMutex.unlock();
 	}
 
-	Routine *Nucleus::acquireRoutine(const wchar_t *name, bool runOptimizations)
+	Routine *Nucleus::acquireRoutine(const wchar_t *name, OptimizationLevel level)
 	{
 		if(basicBlock->getInsts().empty() || basicBlock->getInsts().back().getKind() != Ice::Inst::Ret)
 		{
@@ -579,7 +556,12 @@ namespace sw
 		std::string asciiName(wideName.begin(), wideName.end());
 		::function->setFunctionName(Ice::GlobalString::createWithString(::context, asciiName));
 
-		optimize();
+		// Subzero's Om1 lowering doesn't support all of Reactor's vector operations, so quick
+		// compilation only skips the IR optimizations.
+		if(level == FullOptimization)
+		{
+			optimize();
+		}
 
 		::function->translate();
 		assert(!::function->hasError());
@@ -611,7 +593,7 @@ namespace sw
 
 	void Nucleus::optimize()
 	{
-		sw::optimize(::function);
+		sw::optimize(::function, ::noAliasPointers);
 	}
 
 	Value *Nucleus::allocateStackVariable(Type *t, int arraySize)
@@ -649,6 +631,7 @@ namespace sw
 		uint32_t sequenceNumber = 0;
 		::function = Ice::Cfg::create(::context, sequenceNumber).release();
 		::allocator = new Ice::CfgLocalAllocatorScope(::function);
+		::noAliasPointers.clear();
 
 		for(Type *type : Params)
 		{
@@ -7147,6 +7130,12 @@ namespace sw
 		return lhs = lhs - offset;
 	}
 
+	void NoAlias(const Pointer<Byte> &pointer)
+	{
+		// Loading the variable identifies it to the optimizer, which also marks the values stored to it
+		::noAliasPointers.push_back(pointer.loadValue());
+	}
+
 	void Return()
 	{
 		Nucleus::createRetVoid();
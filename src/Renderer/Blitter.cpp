@@ -1384,6 +1384,26 @@ namespace sw
 		return function(L"BlitRoutine");
 	}
 
+	Routine *Blitter::getRoutine(const State &state)
+	{
+		criticalSection.lock();
+		Routine *blitRoutine = blitCache->query(state);
+
+		if(!blitRoutine)
+		{
+			blitRoutine = generate(state);
+
+			if(blitRoutine)
+			{
+				blitCache->add(state, blitRoutine);
+			}
+		}
+
+		criticalSection.unlock();
+
+		return blitRoutine;
+	}
+
 	bool Blitter::blitReactor(Surface *source, const SliceRectF &sourceRect, Surface *dest, const SliceRect &destRect, const Blitter::Options &options)
 	{
 		ASSERT(!options.clearOperation || ((source->getWidth() == 1) && (source->getHeight() == 1) && (source->getDepth() == 1)));
@@ -1415,24 +1435,13 @@ namespace sw
 		state.destFormat = isStencil ? dest->getStencilFormat() : dest->getFormat(useDestInternal);
 		state.destSamples = dest->getSamples();
 
-		criticalSection.lock();
-		Routine *blitRoutine = blitCache->query(state);
+		Routine *blitRoutine = getRoutine(state);
 
 		if(!blitRoutine)
 		{
-			blitRoutine = generate(state);
-
-			if(!blitRoutine)
-			{
-				criticalSection.unlock();
-				return false;
-			}
-
-			blitCache->add(state, blitRoutine);
+			return false;
 		}
 
-		criticalSection.unlock();
-
 		void (*blitFunction)(const BlitData *data) = (void(*)(const BlitData*))blitRoutine->getEntry();
 
 		BlitData data;
@@ -1476,4 +1485,73 @@ namespace sw
 
 		return true;
 	}
+
+	bool Blitter::prepare(Deferred &blit, Surface *source, const SliceRectF &sRect, const void *sourceBuffer, Surface *dest, const SliceRect &dRect, void *destBuffer, const Options &options)
+	{
+		// Each destination row must read a single source row, so filtering isn't supported
+		if(dRect.x0 > dRect.x1 || dRect.y0 > dRect.y1 || options.filter || options.useStencil || options.clearOperation)
+		{
+			return false;
+		}
+
+		State state(options);
+		state.clampToEdge = (sRect.x0 < 0.0f) ||
+		                    (sRect.y0 < 0.0f) ||
+		                    (sRect.x1 > (float)source->getWidth()) ||
+		                    (sRect.y1 > (float)source->getHeight());
+		state.sourceFormat = source->getInternalFormat();
+		state.destFormat = dest->getExternalFormat();
+		state.destSamples = dest->getSamples();
+
+		Routine *blitRoutine = getRoutine(state);
+
+		if(!blitRoutine)
+		{
+			return false;
+		}
+
+		blit.function = (void(*)(const BlitData*))blitRoutine->getEntry();
+		blit.clampToEdge = state.clampToEdge;
+
+		BlitData &data = blit.data;
+
+		data.source = const_cast<void*>(sourceBuffer);
+		data.dest = destBuffer;
+		data.sPitchB = source->getInternalPitchB();
+		data.dPitchB = dest->getExternalPitchB();
+		data.dSliceB = dest->getExternalSliceB();
+
+		data.w = sRect.width() / dRect.width();
+		data.h = sRect.height() / dRect.height();
+		data.x0 = sRect.x0 + 0.5f * data.w;
+		data.y0 = sRect.y0 + 0.5f * data.h;
+
+		data.x0d = dRect.x0;
+		data.x1d = dRect.x1;
+		data.y0d = dRect.y0;
+		data.y1d = dRect.y1;
+
+		data.sWidth = source->getWidth();
+		data.sHeight = source->getHeight();
+
+		return true;
+	}
+
+	int Blitter::Deferred::getSourceRow(int row) const
+	{
+		int y = (int)(data.y0 + (row - data.y0d) * data.h);
+
+		return clampToEdge ? clamp(y, 0, data.sHeight - 1) : y;
+	}
+
+	void Blitter::Deferred::execute(int row0, int row1) const
+	{
+		BlitData rows = data;
+
+		rows.y0 = data.y0 + (row0 - data.y0d) * data.h;
+		rows.y0d = row0;
+		rows.y1d = row1;
+
+		function(&rows);
+	}
 }
@@ -91,12 +91,31 @@ namespace sw
 		};
 
 	public:
+		// Blit between buffers locked by the caller, executed in ranges of destination
+		// rows. The source's internal buffer is read and the destination's external
+		// buffer is written.
+		class Deferred
+		{
+			friend class Blitter;
+
+		public:
+			int getRowCount() const { return data.y1d - data.y0d; }
+			int getSourceRow(int row) const;   // Source row sampled for the given destination row
+			void execute(int row0, int row1) const;
+
+		private:
+			void (*function)(const BlitData *data);
+			BlitData data;
+			bool clampToEdge;
+		};
+
 		Blitter();
 		virtual ~Blitter();
 
 		void clear(void *pixel, sw::Format format, Surface *dest, const SliceRect &dRect, unsigned int rgbaMask);
 		void blit(Surface *source, const SliceRectF &sRect, Surface *dest, const SliceRect &dRect, const Options &options);
 		void blit3D(Surface *source, Surface *dest);
+		bool prepare(Deferred &blit, Surface *source, const SliceRectF &sRect, const void *sourceBuffer, Surface *dest, const SliceRect &dRect, void *destBuffer, const Options &options);
 
 	private:
 		bool fastClear(void *pixel, sw::Format format, Surface *dest, const SliceRect &dRect, unsigned int rgbaMask);
@@ -112,6 +131,7 @@ namespace sw
 		static Float4 sRGBtoLinear(Float4 &color);
 		bool blitReactor(Surface *source, const SliceRectF &sRect, Surface *dest, const SliceRect &dRect, const Options &options);
 		Routine *generate(const State &state);
+		Routine *getRoutine(const State &state);
 
 		RoutineCache<State> *blitCache;
 		MutexLock criticalSection;
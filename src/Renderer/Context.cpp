@@ -317,6 +317,9 @@ namespace sw
 
 		colorLogicOpEnabled = false;
 		logicalOperation = LOGICALOP_COPY;
+
+		dirtyState = DIRTY_ALL;
+		dirtySamplers = ~0u;   // All image units
 	}
 
 	const float &Context::exp2Bias()
@@ -336,17 +339,17 @@ namespace sw
 
 	void Context::setLightingEnable(bool lightingEnable)
 	{
-		this->lightingEnable = lightingEnable;
+		setRenderState(Context::lightingEnable, lightingEnable);
 	}
 
 	void Context::setSpecularEnable(bool specularEnable)
 	{
-		Context::specularEnable = specularEnable;
+		setRenderState(Context::specularEnable, specularEnable);
 	}
 
 	void Context::setLightEnable(int light, bool lightEnable)
 	{
-		Context::lightEnable[light] = lightEnable;
+		setRenderState(Context::lightEnable[light], lightEnable);
 	}
 
 	void Context::setLightPosition(int light, Point worldLightPosition)
@@ -356,128 +359,102 @@ namespace sw
 
 	void Context::setAmbientMaterialSource(MaterialSource ambientMaterialSource)
 	{
-		Context::ambientMaterialSource = ambientMaterialSource;
+		setRenderState(Context::ambientMaterialSource, ambientMaterialSource);
 	}
 
 	void Context::setDiffuseMaterialSource(MaterialSource diffuseMaterialSource)
 	{
-		Context::diffuseMaterialSource = diffuseMaterialSource;
+		setRenderState(Context::diffuseMaterialSource, diffuseMaterialSource);
 	}
 
 	void Context::setSpecularMaterialSource(MaterialSource specularMaterialSource)
 	{
-		Context::specularMaterialSource = specularMaterialSource;
+		setRenderState(Context::specularMaterialSource, specularMaterialSource);
 	}
 
 	void Context::setEmissiveMaterialSource(MaterialSource emissiveMaterialSource)
 	{
-		Context::emissiveMaterialSource = emissiveMaterialSource;
+		setRenderState(Context::emissiveMaterialSource, emissiveMaterialSource);
 	}
 
 	void Context::setPointSpriteEnable(bool pointSpriteEnable)
 	{
-		Context::pointSpriteEnable = pointSpriteEnable;
+		setRenderState(Context::pointSpriteEnable, pointSpriteEnable);
 	}
 
 	void Context::setPointScaleEnable(bool pointScaleEnable)
 	{
-		Context::pointScaleEnable = pointScaleEnable;
+		setRenderState(Context::pointScaleEnable, pointScaleEnable);
 	}
 
 	bool Context::setDepthBufferEnable(bool depthBufferEnable)
 	{
-		bool modified = (Context::depthBufferEnable != depthBufferEnable);
-		Context::depthBufferEnable = depthBufferEnable;
-		return modified;
+		return setRenderState(Context::depthBufferEnable, depthBufferEnable);
 	}
 
 	bool Context::setAlphaBlendEnable(bool alphaBlendEnable)
 	{
-		bool modified = (Context::alphaBlendEnable != alphaBlendEnable);
-		Context::alphaBlendEnable = alphaBlendEnable;
-		return modified;
+		return setRenderState(Context::alphaBlendEnable, alphaBlendEnable);
 	}
 
 	bool Context::setSourceBlendFactor(BlendFactor sourceBlendFactor)
 	{
-		bool modified = (Context::sourceBlendFactorState != sourceBlendFactor);
-		Context::sourceBlendFactorState = sourceBlendFactor;
-		return modified;
+		return setRenderState(Context::sourceBlendFactorState, sourceBlendFactor);
 	}
 
 	bool Context::setDestBlendFactor(BlendFactor destBlendFactor)
 	{
-		bool modified = (Context::destBlendFactorState != destBlendFactor);
-		Context::destBlendFactorState = destBlendFactor;
-		return modified;
+		return setRenderState(Context::destBlendFactorState, destBlendFactor);
 	}
 
 	bool Context::setBlendOperation(BlendOperation blendOperation)
 	{
-		bool modified = (Context::blendOperationState != blendOperation);
-		Context::blendOperationState = blendOperation;
-		return modified;
+		return setRenderState(Context::blendOperationState, blendOperation);
 	}
 
 	bool Context::setSeparateAlphaBlendEnable(bool separateAlphaBlendEnable)
 	{
-		bool modified = (Context::separateAlphaBlendEnable != separateAlphaBlendEnable);
-		Context::separateAlphaBlendEnable = separateAlphaBlendEnable;
-		return modified;
+		return setRenderState(Context::separateAlphaBlendEnable, separateAlphaBlendEnable);
 	}
 
 	bool Context::setSourceBlendFactorAlpha(BlendFactor sourceBlendFactorAlpha)
 	{
-		bool modified = (Context::sourceBlendFactorStateAlpha != sourceBlendFactorAlpha);
-		Context::sourceBlendFactorStateAlpha = sourceBlendFactorAlpha;
-		return modified;
+		return setRenderState(Context::sourceBlendFactorStateAlpha, sourceBlendFactorAlpha);
 	}
 
 	bool Context::setDestBlendFactorAlpha(BlendFactor destBlendFactorAlpha)
 	{
-		bool modified = (Context::destBlendFactorStateAlpha != destBlendFactorAlpha);
-		Context::destBlendFactorStateAlpha = destBlendFactorAlpha;
-		return modified;
+		return setRenderState(Context::destBlendFactorStateAlpha, destBlendFactorAlpha);
 	}
 
 	bool Context::setBlendOperationAlpha(BlendOperation blendOperationAlpha)
 	{
-		bool modified = (Context::blendOperationStateAlpha != blendOperationAlpha);
-		Context::blendOperationStateAlpha = blendOperationAlpha;
-		return modified;
+		return setRenderState(Context::blendOperationStateAlpha, blendOperationAlpha);
 	}
 
 	bool Context::setColorWriteMask(int index, int colorWriteMask)
 	{
-		bool modified = (Context::colorWriteMask[index] != colorWriteMask);
-		Context::colorWriteMask[index] = colorWriteMask;
-		return modified;
+		return setRenderState(Context::colorWriteMask[index], colorWriteMask);
 	}
 
 	bool Context::setWriteSRGB(bool sRGB)
 	{
-		bool modified = (Context::writeSRGB != sRGB);
-		Context::writeSRGB = sRGB;
-		return modified;
+		return setRenderState(Context::writeSRGB, sRGB);
 	}
 
 	bool Context::setColorLogicOpEnabled(bool enabled)
 	{
-		bool modified = (Context::colorLogicOpEnabled != enabled);
-		Context::colorLogicOpEnabled = enabled;
-		return modified;
+		return setRenderState(Context::colorLogicOpEnabled, enabled);
 	}
 
 	bool Context::setLogicalOperation(LogicalOperation logicalOperation)
 	{
-		bool modified = (Context::logicalOperation != logicalOperation);
-		Context::logicalOperation = logicalOperation;
-		return modified;
+		return setRenderState(Context::logicalOperation, logicalOperation);
 	}
 
 	void Context::setColorVertexEnable(bool colorVertexEnable)
 	{
-		Context::colorVertexEnable = colorVertexEnable;
+		setRenderState(Context::colorVertexEnable, colorVertexEnable);
 	}
 
 	bool Context::fogActive()
@@ -280,6 +280,18 @@ namespace sw
 	class Context
 	{
 	public:
+		// Groups of states modified since the previous draw, so the processors only re-derive what changed
+		enum DirtyState
+		{
+			DIRTY_RENDER_STATE   = 0x00000001,
+			DIRTY_INPUTS         = 0x00000002,   // Vertex input stream formats
+			DIRTY_SHADERS        = 0x00000004,
+			DIRTY_DRAW_TYPE      = 0x00000008,
+			DIRTY_RENDER_TARGETS = 0x00000010,   // Formats and sample counts of the attachments
+
+			DIRTY_ALL            = 0xFFFFFFFF
+		};
+
 		Context();
 
 		~Context();
@@ -299,6 +311,21 @@ namespace sw
 
 		void setGlobalMipmapBias(float bias);
 
+		// Returns true when modified
+		template<class T>
+		bool setRenderState(T &state, const T &value)
+		{
+			if(state == value)
+			{
+				return false;
+			}
+
+			state = value;
+			dirtyState |= DIRTY_RENDER_STATE;
+
+			return true;
+		}
+
 		// Set fixed-function vertex pipeline states
 		void setLightingEnable(bool lightingEnable);
 		void setSpecularEnable(bool specularEnable);
@@ -535,6 +562,9 @@ namespace sw
 
 		bool colorLogicOpEnabled;
 		LogicalOperation logicalOperation;
+
+		unsigned int dirtyState;
+		unsigned int dirtySamplers;   // One bit per image unit
 	};
 }
 
@@ -0,0 +1,112 @@
+// Copyright 2017 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef sw_DrawProgress_hpp
+#define sw_DrawProgress_hpp
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <stdint.h>
+
+namespace sw
+{
+	// Tracks which of a renderer's draw calls have finished. Fences reference this instead of
+	// the context which inserted them, so they don't keep it alive, and can outlive it.
+	class DrawProgress
+	{
+	public:
+		static const uint64_t forever = ~0ull;   // Timeout in nanoseconds
+
+		DrawProgress() : retiredSequence(0), bindCount(0)
+		{
+		}
+
+		// Reference counting
+		void bind()
+		{
+			++bindCount;
+		}
+
+		void unbind()
+		{
+			if(--bindCount == 0)
+			{
+				delete this;
+			}
+		}
+
+		// Returns whether all draw calls submitted before the sequence number have finished
+		bool hasRetired(int sequence)
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+
+			return isRetired(sequence);
+		}
+
+		// Blocks until hasRetired(sequence). Returns false if the timeout expired first.
+		bool wait(int sequence, uint64_t timeout)
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+
+			bool indefinite = (timeout >= (1ull << 62));   // Over a century, can't be represented as a time point
+			auto deadline = std::chrono::steady_clock::now() + std::chrono::nanoseconds(indefinite ? 0 : timeout);
+
+			while(!isRetired(sequence))
+			{
+				if(indefinite)
+				{
+					retired.wait(lock);
+				}
+				else if(retired.wait_until(lock, deadline) == std::cv_status::timeout)
+				{
+					return isRetired(sequence);
+				}
+			}
+
+			return true;
+		}
+
+		// Called by the renderer when all draw calls before the sequence number have finished
+		void retire(int sequence)
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+
+			if(!isRetired(sequence))
+			{
+				retiredSequence = sequence;
+				retired.notify_all();
+			}
+		}
+
+	private:
+		~DrawProgress()
+		{
+		}
+
+		bool isRetired(int sequence) const
+		{
+			return (int)((unsigned int)sequence - (unsigned int)retiredSequence) <= 0;   // Sequence numbers wrap around
+		}
+
+		std::mutex mutex;
+		std::condition_variable retired;
+		int retiredSequence;
+
+		std::atomic<int> bindCount;
+	};
+}
+
+#endif   // sw_DrawProgress_hpp
@@ -21,6 +21,7 @@
 #include "Shader/PixelShader.hpp"
 #include "Shader/Constants.hpp"
 #include "Common/Debug.hpp"
+#include "Main/Config.hpp"
 
 #include <string.h>
 
@@ -31,6 +32,10 @@ namespace sw
 	extern bool perspectiveCorrection;
 
 	bool precachePixel = false;
+	bool constantSpecialization = false;
+
+	// Number of draw calls for which the constants must remain unchanged before they get folded into the routines
+	static const unsigned int stableConstantsAge = 256;
 
 	unsigned int PixelProcessor::States::computeHash()
 	{
@@ -72,12 +77,21 @@ namespace sw
 		                             // Round to nearest LOD [0.7, 1.4]:  0.0
 		                             // Round to lowest LOD  [1.0, 2.0]:  0.5
 
+		floatConstants = new Resource(sizeof(float4) * FRAGMENT_UNIFORM_VECTORS);
+		floatConstantsShared = false;
+		c = static_cast<float4*>(const_cast<void*>(floatConstants->data()));
+		constantsAge = 0;
+		drawCount = 0;
+		memset(floatConstantChange, 0, sizeof(floatConstantChange));
+
 		routineCache = 0;
 		setRoutineCacheSize(1024);
 	}
 
 	PixelProcessor::~PixelProcessor()
 	{
+		floatConstants->destruct();
+
 		delete routineCache;
 		routineCache = 0;
 	}
@@ -86,6 +100,16 @@ namespace sw
 	{
 		if(index < FRAGMENT_UNIFORM_VECTORS)
 		{
+			if(floatConstantsShared)
+			{
+				renameFloatConstants();
+			}
+
+			if(c[index][0] != value[0] || c[index][1] != value[1] || c[index][2] != value[2] || c[index][3] != value[3])
+			{
+				floatConstantChange[index] = drawCount;
+			}
+
 			c[index][0] = value[0];
 			c[index][1] = value[1];
 			c[index][2] = value[2];
@@ -123,10 +147,42 @@ namespace sw
 		}
 	}
 
+	// Draw calls read the float constants in place, so writes which follow one that
+	// hasn't finished yet go to a new version of the storage, copied from the old one.
+	void PixelProcessor::renameFloatConstants()
+	{
+		floatConstantsShared = false;
+
+		if(!floatConstants->isBusy())
+		{
+			return;
+		}
+
+		Resource *constants = new Resource(floatConstants->size, true, true);
+		memcpy(const_cast<void*>(constants->data()), c, floatConstants->size);
+
+		floatConstants->destruct();   // Deleted by the last draw call which reads it
+		floatConstants = constants;
+		c = static_cast<float4*>(const_cast<void*>(constants->data()));
+	}
+
+	float4 *PixelProcessor::lockFloatConstants(sw::Resource **constants)
+	{
+		floatConstantsShared = true;
+		*constants = floatConstants;
+
+		return static_cast<float4*>(floatConstants->lock(PUBLIC, PRIVATE));
+	}
+
 	void PixelProcessor::setIntegerConstant(unsigned int index, const int value[4])
 	{
 		if(index < 16)
 		{
+			if(i[index][0] != value[0] || i[index][1] != value[1] || i[index][2] != value[2] || i[index][3] != value[3])
+			{
+				constantsAge = 0;
+			}
+
 			i[index][0] = value[0];
 			i[index][1] = value[1];
 			i[index][2] = value[2];
@@ -139,11 +195,82 @@ namespace sw
 	{
 		if(index < 16)
 		{
+			if(b[index] != (boolean != 0))
+			{
+				constantsAge = 0;
+			}
+
 			b[index] = boolean != 0;
 		}
 		else ASSERT(false);
 	}
 
+	void PixelProcessor::ageConstants()
+	{
+		if(constantsAge < stableConstantsAge)
+		{
+			constantsAge++;
+		}
+
+		drawCount++;
+	}
+
+	// Folds the constants which control the shader's branches and loops into the state, once they have
+	// remained unchanged for a while. The routine generated for a state without them reads them at run time.
+	void PixelProcessor::specializeConstants(State &state) const
+	{
+		memset(&state.specialization, 0, sizeof(state.specialization));
+
+		if(!constantSpecialization || !context->pixelShader)
+		{
+			return;
+		}
+
+		const PixelShader *shader = context->pixelShader;
+
+		for(int k = 0; k < shader->controlConstantsFCount; k++)
+		{
+			unsigned int index = shader->controlConstantsF[k];
+
+			if(index < FRAGMENT_UNIFORM_VECTORS && drawCount - floatConstantChange[index] >= stableConstantsAge)
+			{
+				int n = state.specialization.floatCount++;
+
+				state.specialization.floatIndex[n] = index;
+				state.specialization.floatValue[n][0] = c[index][0];
+				state.specialization.floatValue[n][1] = c[index][1];
+				state.specialization.floatValue[n][2] = c[index][2];
+				state.specialization.floatValue[n][3] = c[index][3];
+			}
+		}
+
+		if(constantsAge < stableConstantsAge)
+		{
+			return;
+		}
+
+		for(int index = 0; index < 16; index++)
+		{
+			if(shader->controlConstantsI & (1 << index))
+			{
+				state.specialization.integerMask |= 1 << index;
+				state.specialization.integer[index][0] = i[index][0];
+				state.specialization.integer[index][1] = i[index][1];
+				state.specialization.integer[index][2] = i[index][2];
+			}
+
+			if(shader->controlConstantsB & (1 << index))
+			{
+				state.specialization.booleanMask |= 1 << index;
+
+				if(b[index])
+				{
+					state.specialization.boolean |= 1 << index;
+				}
+			}
+		}
+	}
+
 	void PixelProcessor::setUniformBuffer(int index, sw::Resource* buffer, int offset)
 	{
 		uniformBufferInfo[index].buffer = buffer;
@@ -362,6 +489,7 @@ namespace sw
 		if(sampler < TEXTURE_IMAGE_UNITS)
 		{
 			context->sampler[sampler].setTextureFilter(textureFilter);
+			context->dirtySamplers |= 1u << sampler;
 		}
 		else ASSERT(false);
 	}
@@ -371,6 +499,7 @@ namespace sw
 		if(sampler < TEXTURE_IMAGE_UNITS)
 		{
 			context->sampler[sampler].setMipmapFilter(mipmapFilter);
+			context->dirtySamplers |= 1u << sampler;
 		}
 		else ASSERT(false);
 	}
@@ -380,6 +509,7 @@ namespace sw
 		if(sampler < TEXTURE_IMAGE_UNITS)
 		{
 			context->sampler[sampler].setGatherEnable(enable);
+			context->dirtySamplers |= 1u << sampler;
 		}
 		else ASSERT(false);
 	}
@@ -389,6 +519,7 @@ namespace sw
 		if(sampler < TEXTURE_IMAGE_UNITS)
 		{
 			context->sampler[sampler].setAddressingModeU(addressMode);
+			context->dirtySamplers |= 1u << sampler;
 		}
 		else ASSERT(false);
 	}
@@ -398,6 +529,7 @@ namespace sw
 		if(sampler < TEXTURE_IMAGE_UNITS)
 		{
 			context->sampler[sampler].setAddressingModeV(addressMode);
+			context->dirtySamplers |= 1u << sampler;
 		}
 		else ASSERT(false);
 	}
@@ -407,6 +539,7 @@ namespace sw
 		if(sampler < TEXTURE_IMAGE_UNITS)
 		{
 			context->sampler[sampler].setAddressingModeW(addressMode);
+			context->dirtySamplers |= 1u << sampler;
 		}
 		else ASSERT(false);
 	}
@@ -416,6 +549,7 @@ namespace sw
 		if(sampler < TEXTURE_IMAGE_UNITS)
 		{
 			context->sampler[sampler].setReadSRGB(sRGB);
+			context->dirtySamplers |= 1u << sampler;
 		}
 		else ASSERT(false);
 	}
@@ -425,6 +559,7 @@ namespace sw
 		if(sampler < TEXTURE_IMAGE_UNITS)
 		{
 			context->sampler[sampler].setMipmapLOD(bias);
+			context->dirtySamplers |= 1u << sampler;
 		}
 		else ASSERT(false);
 	}
@@ -434,6 +569,7 @@ namespace sw
 		if(sampler < TEXTURE_IMAGE_UNITS)
 		{
 			context->sampler[sampler].setBorderColor(borderColor);
+			context->dirtySamplers |= 1u << sampler;
 		}
 		else ASSERT(false);
 	}
@@ -443,6 +579,7 @@ namespace sw
 		if(sampler < TEXTURE_IMAGE_UNITS)
 		{
 			context->sampler[sampler].setMaxAnisotropy(maxAnisotropy);
+			context->dirtySamplers |= 1u << sampler;
 		}
 		else ASSERT(false);
 	}
@@ -452,6 +589,7 @@ namespace sw
 		if(sampler < TEXTURE_IMAGE_UNITS)
 		{
 			context->sampler[sampler].setHighPrecisionFiltering(highPrecisionFiltering);
+			context->dirtySamplers |= 1u << sampler;
 		}
 		else ASSERT(false);
 	}
@@ -461,6 +599,7 @@ namespace sw
 		if(sampler < TEXTURE_IMAGE_UNITS)
 		{
 			context->sampler[sampler].setSwizzleR(swizzleR);
+			context->dirtySamplers |= 1u << sampler;
 		}
 		else ASSERT(false);
 	}
@@ -470,6 +609,7 @@ namespace sw
 		if(sampler < TEXTURE_IMAGE_UNITS)
 		{
 			context->sampler[sampler].setSwizzleG(swizzleG);
+			context->dirtySamplers |= 1u << sampler;
 		}
 		else ASSERT(false);
 	}
@@ -479,6 +619,7 @@ namespace sw
 		if(sampler < TEXTURE_IMAGE_UNITS)
 		{
 			context->sampler[sampler].setSwizzleB(swizzleB);
+			context->dirtySamplers |= 1u << sampler;
 		}
 		else ASSERT(false);
 	}
@@ -488,6 +629,7 @@ namespace sw
 		if(sampler < TEXTURE_IMAGE_UNITS)
 		{
 			context->sampler[sampler].setSwizzleA(swizzleA);
+			context->dirtySamplers |= 1u << sampler;
 		}
 		else ASSERT(false);
 	}
@@ -497,6 +639,7 @@ namespace sw
 		if(sampler < TEXTURE_IMAGE_UNITS)
 		{
 			context->sampler[sampler].setCompareFunc(compFunc);
+			context->dirtySamplers |= 1u << sampler;
 		}
 		else ASSERT(false);
 	}
@@ -506,6 +649,7 @@ namespace sw
 		if(sampler < TEXTURE_IMAGE_UNITS)
 		{
 			context->sampler[sampler].setBaseLevel(baseLevel);
+			context->dirtySamplers |= 1u << sampler;
 		}
 		else ASSERT(false);
 	}
@@ -515,6 +659,7 @@ namespace sw
 		if(sampler < TEXTURE_IMAGE_UNITS)
 		{
 			context->sampler[sampler].setMaxLevel(maxLevel);
+			context->dirtySamplers |= 1u << sampler;
 		}
 		else ASSERT(false);
 	}
@@ -524,6 +669,7 @@ namespace sw
 		if(sampler < TEXTURE_IMAGE_UNITS)
 		{
 			context->sampler[sampler].setMinLod(minLod);
+			context->dirtySamplers |= 1u << sampler;
 		}
 		else ASSERT(false);
 	}
@@ -533,6 +679,7 @@ namespace sw
 		if(sampler < TEXTURE_IMAGE_UNITS)
 		{
 			context->sampler[sampler].setMaxLod(maxLod);
+			context->dirtySamplers |= 1u << sampler;
 		}
 		else ASSERT(false);
 	}
@@ -559,27 +706,27 @@ namespace sw
 
 	void PixelProcessor::setDepthCompare(DepthCompareMode depthCompareMode)
 	{
-		context->depthCompareMode = depthCompareMode;
+		context->setRenderState(context->depthCompareMode, depthCompareMode);
 	}
 
 	void PixelProcessor::setAlphaCompare(AlphaCompareMode alphaCompareMode)
 	{
-		context->alphaCompareMode = alphaCompareMode;
+		context->setRenderState(context->alphaCompareMode, alphaCompareMode);
 	}
 
 	void PixelProcessor::setDepthWriteEnable(bool depthWriteEnable)
 	{
-		context->depthWriteEnable = depthWriteEnable;
+		context->setRenderState(context->depthWriteEnable, depthWriteEnable);
 	}
 
 	void PixelProcessor::setAlphaTestEnable(bool alphaTestEnable)
 	{
-		context->alphaTestEnable = alphaTestEnable;
+		context->setRenderState(context->alphaTestEnable, alphaTestEnable);
 	}
 
 	void PixelProcessor::setCullMode(CullMode cullMode)
 	{
-		context->cullMode = cullMode;
+		context->setRenderState(context->cullMode, cullMode);
 	}
 
 	void PixelProcessor::setColorWriteMask(int index, int rgbaMask)
@@ -589,12 +736,12 @@ namespace sw
 
 	void PixelProcessor::setStencilEnable(bool stencilEnable)
 	{
-		context->stencilEnable = stencilEnable;
+		context->setRenderState(context->stencilEnable, stencilEnable);
 	}
 
 	void PixelProcessor::setStencilCompare(StencilCompareMode stencilCompareMode)
 	{
-		context->stencilCompareMode = stencilCompareMode;
+		context->setRenderState(context->stencilCompareMode, stencilCompareMode);
 	}
 
 	void PixelProcessor::setStencilReference(int stencilReference)
@@ -611,66 +758,66 @@ namespace sw
 
 	void PixelProcessor::setStencilMask(int stencilMask)
 	{
-		context->stencilMask = stencilMask;
+		context->setRenderState(context->stencilMask, stencilMask);
 		stencil.set(context->stencilReference, stencilMask, context->stencilWriteMask);
 	}
 
 	void PixelProcessor::setStencilMaskCCW(int stencilMaskCCW)
 	{
-		context->stencilMaskCCW = stencilMaskCCW;
+		context->setRenderState(context->stencilMaskCCW, stencilMaskCCW);
 		stencilCCW.set(context->stencilReferenceCCW, stencilMaskCCW, context->stencilWriteMaskCCW);
 	}
 
 	void PixelProcessor::setStencilFailOperation(StencilOperation stencilFailOperation)
 	{
-		context->stencilFailOperation = stencilFailOperation;
+		context->setRenderState(context->stencilFailOperation, stencilFailOperation);
 	}
 
 	void PixelProcessor::setStencilPassOperation(StencilOperation stencilPassOperation)
 	{
-		context->stencilPassOperation = stencilPassOperation;
+		context->setRenderState(context->stencilPassOperation, stencilPassOperation);
 	}
 
 	void PixelProcessor::setStencilZFailOperation(StencilOperation stencilZFailOperation)
 	{
-		context->stencilZFailOperation = stencilZFailOperation;
+		context->setRenderState(context->stencilZFailOperation, stencilZFailOperation);
 	}
 
 	void PixelProcessor::setStencilWriteMask(int stencilWriteMask)
 	{
-		context->stencilWriteMask = stencilWriteMask;
+		context->setRenderState(context->stencilWriteMask, stencilWriteMask);
 		stencil.set(context->stencilReference, context->stencilMask, stencilWriteMask);
 	}
 
 	void PixelProcessor::setStencilWriteMaskCCW(int stencilWriteMaskCCW)
 	{
-		context->stencilWriteMaskCCW = stencilWriteMaskCCW;
+		context->setRenderState(context->stencilWriteMaskCCW, stencilWriteMaskCCW);
 		stencilCCW.set(context->stencilReferenceCCW, context->stencilMaskCCW, stencilWriteMaskCCW);
 	}
 
 	void PixelProcessor::setTwoSidedStencil(bool enable)
 	{
-		context->twoSidedStencil = enable;
+		context->setRenderState(context->twoSidedStencil, enable);
 	}
 
 	void PixelProcessor::setStencilCompareCCW(StencilCompareMode stencilCompareMode)
 	{
-		context->stencilCompareModeCCW = stencilCompareMode;
+		context->setRenderState(context->stencilCompareModeCCW, stencilCompareMode);
 	}
 
 	void PixelProcessor::setStencilFailOperationCCW(StencilOperation stencilFailOperation)
 	{
-		context->stencilFailOperationCCW = stencilFailOperation;
+		context->setRenderState(context->stencilFailOperationCCW, stencilFailOperation);
 	}
 
 	void PixelProcessor::setStencilPassOperationCCW(StencilOperation stencilPassOperation)
 	{
-		context->stencilPassOperationCCW = stencilPassOperation;
+		context->setRenderState(context->stencilPassOperationCCW, stencilPassOperation);
 	}
 
 	void PixelProcessor::setStencilZFailOperationCCW(StencilOperation stencilZFailOperation)
 	{
-		context->stencilZFailOperationCCW = stencilZFailOperation;
+		context->setRenderState(context->stencilZFailOperationCCW, stencilZFailOperation);
 	}
 
 	void PixelProcessor::setTextureFactor(const Color<float> &textureFactor)
@@ -799,12 +946,12 @@ namespace sw
 
 	void PixelProcessor::setFillMode(FillMode fillMode)
 	{
-		context->fillMode = fillMode;
+		context->setRenderState(context->fillMode, fillMode);
 	}
 
 	void PixelProcessor::setShadingMode(ShadingMode shadingMode)
 	{
-		context->shadingMode = shadingMode;
+		context->setRenderState(context->shadingMode, shadingMode);
 	}
 
 	void PixelProcessor::setAlphaBlendEnable(bool alphaBlendEnable)
@@ -849,7 +996,7 @@ namespace sw
 
 	void PixelProcessor::setAlphaReference(float alphaReference)
 	{
-		context->alphaReference = alphaReference;
+		context->setRenderState(context->alphaReference, alphaReference);
 
 		factor.alphaReference4[0] = (word)iround(alphaReference * 0x1000 / 0xFF);
 		factor.alphaReference4[1] = (word)iround(alphaReference * 0x1000 / 0xFF);
@@ -907,23 +1054,27 @@ namespace sw
 
 	void PixelProcessor::setPixelFogMode(FogMode fogMode)
 	{
-		context->pixelFogMode = fogMode;
+		context->setRenderState(context->pixelFogMode, fogMode);
 	}
 
 	void PixelProcessor::setPerspectiveCorrection(bool perspectiveEnable)
 	{
-		perspectiveCorrection = perspectiveEnable;
+		if(perspectiveCorrection != perspectiveEnable)
+		{
+			perspectiveCorrection = perspectiveEnable;
+			context->dirtyState |= Context::DIRTY_RENDER_STATE;
+		}
 	}
 
 	void PixelProcessor::setOcclusionEnabled(bool enable)
 	{
-		context->occlusionEnabled = enable;
+		context->setRenderState(context->occlusionEnabled, enable);
 	}
 
 	void PixelProcessor::setRoutineCacheSize(int cacheSize)
 	{
 		delete routineCache;
-		routineCache = new RoutineCache<State>(clamp(cacheSize, 1, 65536), precachePixel ? "sw-pixel" : 0);
+		routineCache = new RoutineCache<State, TieredRoutine>(clamp(cacheSize, 1, 65536), precachePixel ? "sw-pixel" : 0);
 	}
 
 	void PixelProcessor::setFogRanges(float start, float end)
@@ -1165,36 +1316,116 @@ namespace sw
 			}
 		}
 
+		specializeConstants(state);
+
 		state.hash = state.computeHash();
 
 		return state;
 	}
 
-	Routine *PixelProcessor::routine(const State &state)
+	// Updates a state derived for the current shaders and render states with the multisample mask and modified samplers
+	bool PixelProcessor::update(State &state, unsigned int dirtySamplers) const
 	{
-		Routine *routine = routineCache->query(state);
+		ASSERT(context->pixelShader);
 
-		if(!routine)
+		bool modified = (state.multiSampleMask != context->multiSampleMask);
+		state.multiSampleMask = context->multiSampleMask;
+
+		for(unsigned int i = 0; i < TEXTURE_IMAGE_UNITS; i++)
+		{
+			if((dirtySamplers & (1u << i)) && context->pixelShader->usesSampler(i))
+			{
+				const Sampler::State sampler = context->sampler[i].samplerState();
+
+				if(memcmp(&state.sampler[i], &sampler, sizeof(Sampler::State)) != 0)
+				{
+					state.sampler[i] = sampler;
+					modified = true;
+				}
+			}
+		}
+
+		State::Specialization specialization = state.specialization;
+		specializeConstants(state);
+
+		if(memcmp(&specialization, &state.specialization, sizeof(specialization)) != 0)
+		{
+			modified = true;
+		}
+
+		if(modified)
+		{
+			state.hash = state.computeHash();
+		}
+
+		return modified;
+	}
+
+	// Keeps its own copy of the shader, since the application may delete it before the routine gets regenerated
+	class PixelRoutineGenerator : public RoutineGenerator
+	{
+	public:
+		PixelRoutineGenerator(const PixelProcessor::State &state, const PixelShader *shader, bool integerPipeline)
+			: state(state), shader(shader ? new PixelShader(shader) : nullptr), integerPipeline(integerPipeline)
+		{
+		}
+
+		~PixelRoutineGenerator() override
+		{
+			delete shader;
+		}
+
+		Routine *generate(OptimizationLevel level) override
+		{
+			return generate(state, shader, integerPipeline, level);
+		}
+
+		static Routine *generate(const PixelProcessor::State &state, const PixelShader *shader, bool integerPipeline, OptimizationLevel level)
 		{
-			const bool integerPipeline = (context->pixelShaderModel() <= 0x0104);
 			QuadRasterizer *generator = nullptr;
 
 			if(integerPipeline)
 			{
-				generator = new PixelPipeline(state, context->pixelShader);
+				generator = new PixelPipeline(state, shader);
 			}
 			else
 			{
-				generator = new PixelProgram(state, context->pixelShader);
+				generator = new PixelProgram(state, shader);
 			}
 
 			generator->generate();
-			routine = (*generator)(L"PixelRoutine_%0.8X", state.shaderID);
+			Routine *routine = (*generator)(level, L"PixelRoutine_%0.8X", state.shaderID);
 			delete generator;
 
+			return routine;
+		}
+
+	private:
+		const PixelProcessor::State state;
+		const PixelShader *const shader;
+		const bool integerPipeline;
+	};
+
+	TieredRoutine *PixelProcessor::routine(const State &state)
+	{
+		TieredRoutine *routine = routineCache->query(state);
+
+		if(!routine)
+		{
+			const bool integerPipeline = (context->pixelShaderModel() <= 0x0104);
+			OptimizationLevel level = tieredCompilation ? QuickCompilation : FullOptimization;
+
+			routine = new TieredRoutine(PixelRoutineGenerator::generate(state, context->pixelShader, integerPipeline, level), level);
+
 			routineCache->add(state, routine);
+			profiler.pixelRoutines++;
 		}
 
 		return routine;
 	}
+
+	RoutineGenerator *PixelProcessor::generator(const State &state) const
+	{
+		return new PixelRoutineGenerator(state, context->pixelShader, context->pixelShaderModel() <= 0x0104);
+	}
 }
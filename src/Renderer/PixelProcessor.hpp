@@ -17,6 +17,7 @@
 
 #include "Context.hpp"
 #include "RoutineCache.hpp"
+#include "TieredRoutine.hpp"
 
 namespace sw
 {
@@ -89,6 +90,19 @@ namespace sw
 			Sampler::State sampler[TEXTURE_IMAGE_UNITS];
 			TextureStage::State textureStage[8];
 
+			struct Specialization   // Constants folded into the routine
+			{
+				unsigned short integerMask;   // Folded integer registers, bit flags
+				unsigned short booleanMask;   // Folded boolean registers, bit flags
+				unsigned short boolean;       // Values of the folded boolean registers, bit flags
+				int integer[16][3];           // Count, initial value and step of the folded integer registers
+				int floatCount;               // Number of folded float registers
+				unsigned short floatIndex[8];
+				float floatValue[8][4];
+			};
+
+			Specialization specialization;
+
 			struct Interpolant
 			{
 				unsigned char component : 4;
@@ -193,6 +207,7 @@ namespace sw
 		void setFloatConstant(unsigned int index, const float value[4]);
 		void setIntegerConstant(unsigned int index, const int value[4]);
 		void setBooleanConstant(unsigned int index, int boolean);
+		float4 *lockFloatConstants(sw::Resource **constants);
 
 		void setUniformBuffer(int index, sw::Resource* buffer, int offset);
 		void lockUniformBuffers(byte** u, sw::Resource* uniformBuffers[]);
@@ -304,12 +319,15 @@ namespace sw
 
 	protected:
 		const State update() const;
-		Routine *routine(const State &state);
+		bool update(State &state, unsigned int dirtySamplers) const;   // Returns true when modified
+		void ageConstants();
+		TieredRoutine *routine(const State &state);
+		RoutineGenerator *generator(const State &state) const;   // Regenerates the routine after the shader is gone
 		void setRoutineCacheSize(int routineCacheSize);
 
 		// Shader constants
 		word4 cW[8][4];
-		float4 c[FRAGMENT_UNIFORM_VECTORS];
+		float4 *c;
 		int4 i[16];
 		bool b[16];
 
@@ -320,6 +338,15 @@ namespace sw
 		Factor factor;
 
 	private:
+		void renameFloatConstants();
+		void specializeConstants(State &state) const;
+
+		Resource *floatConstants;   // Current version of the storage c points into
+		bool floatConstantsShared;   // Referenced by a draw call since it was last renamed
+		unsigned int constantsAge;   // Draw calls since an integer or boolean constant last changed
+		unsigned int drawCount;   // Wraps around
+		unsigned int floatConstantChange[FRAGMENT_UNIFORM_VECTORS];   // Draw count when each float constant last changed
+
 		struct UniformBufferInfo
 		{
 			UniformBufferInfo();
@@ -333,7 +360,7 @@ namespace sw
 
 		Context *const context;
 
-		RoutineCache<State> *routineCache;
+		RoutineCache<State, TieredRoutine> *routineCache;
 	};
 }
 
@@ -48,6 +48,8 @@ namespace sw
 		#endif
 
 		constants = *Pointer<Pointer<Byte>>(data + OFFSET(DrawData,constants));
+		NoAlias(data);
+		NoAlias(constants);
 		occlusion = 0;
 		int clusterCount = Renderer::getClusterCount();
 
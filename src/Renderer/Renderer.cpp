@@ -56,6 +56,7 @@ namespace sw
 	extern bool exactColorRounding;
 	extern TransparencyAntialiasing transparencyAntialiasing;
 	extern bool forceClearRegisters;
+	extern bool constantSpecialization;
 
 	extern bool precacheVertex;
 	extern bool precacheSetup;
@@ -78,19 +79,91 @@ namespace sw
 		int threadIndex;
 	};
 
+	bool Query::isIdle()
+	{
+		mutex.lock();
+		bool idle = (reference == 0);
+		mutex.unlock();
+
+		return idle;
+	}
+
+	void Query::destroy()
+	{
+		mutex.lock();
+		bool idle = (reference == 0);
+		destroyed = true;
+		mutex.unlock();
+
+		if(idle)
+		{
+			delete this;
+		}
+	}
+
+	void Query::retire()
+	{
+		mutex.lock();
+		bool retired = (reference-- == 0);   // Post-decrement returns the new value
+
+		if(retired && !building)
+		{
+			flush();
+		}
+
+		bool remove = retired && destroyed;
+		mutex.unlock();
+
+		if(remove)
+		{
+			delete this;
+		}
+	}
+
+	void Query::writeResult(Resource *resource, size_t offset, bool boolean)
+	{
+		// Taking the resource private makes the application wait for the result on access
+		byte *buffer = (byte*)resource->lock(PUBLIC, PRIVATE);
+		PendingWrite write = {resource, buffer + offset, boolean};
+
+		mutex.lock();
+		pending.push_back(write);
+
+		if(reference == 0 && !building)
+		{
+			flush();
+		}
+		mutex.unlock();
+	}
+
+	void Query::flush()
+	{
+		for(auto &write : pending)
+		{
+			unsigned int result = write.boolean ? (data > 0) : (int)data;
+			memcpy(write.address, &result, sizeof(result));
+			write.resource->unlock();
+		}
+
+		pending.clear();
+	}
+
 	DrawCall::DrawCall()
 	{
 		queries = 0;
+		blit = nullptr;
+		vsConstF = nullptr;
+		psConstF = nullptr;
 
-		vsDirtyConstF = VERTEX_UNIFORM_VECTORS + 1;
 		vsDirtyConstI = 16;
 		vsDirtyConstB = 16;
 
-		psDirtyConstF = FRAGMENT_UNIFORM_VECTORS;
+		psDirtyConstF = 8;
 		psDirtyConstI = 16;
 		psDirtyConstB = 16;
 
 		references = -1;
+		sequence = 0;
 
 		data = (DrawData*)allocate(sizeof(DrawData));
 		data->constants = &constants;
@@ -117,6 +190,12 @@ namespace sw
 		setRenderTarget(0, 0);
 		clipper = new Clipper(symmetricNormalizedDepth);
 		blitter = new Blitter;
+		routineOptimizer = new RoutineOptimizer;
+
+		drawProgress = new DrawProgress;
+		drawProgress->bind();
+
+		resolvePool = Surface::createResolvePool();
 
 		updateViewMatrix = true;
 		updateBaseMatrix = true;
@@ -169,6 +248,21 @@ namespace sw
 
 		clipFlags = 0;
 
+		vertexShaderID = 0;
+		pixelShaderID = 0;
+		previousDrawType = DRAW_POINTLIST;
+
+		for(int i = 0; i < RENDERTARGETS; i++)
+		{
+			renderTargetFormat[i] = FORMAT_NULL;
+		}
+
+		renderTargetExternalFormat = FORMAT_NULL;
+		multiSampleCount = 1;
+		superSampleCount = 1;
+		depthBufferFormat = FORMAT_NULL;
+		stencilBufferAttached = false;
+
 		swiftConfig = new SwiftConfig(disableServer);
 		updateConfiguration(true);
 
@@ -185,9 +279,18 @@ namespace sw
 		delete blitter;
 		blitter = nullptr;
 
+		delete routineOptimizer;
+		routineOptimizer = nullptr;
+
 		terminateThreads();
 		delete resumeApp;
 
+		Surface::destroyResolvePool(resolvePool);
+		resolvePool = nullptr;
+
+		drawProgress->retire(nextDraw);   // Fences can outlive the renderer
+		drawProgress->unbind();
+
 		for(int draw = 0; draw < DRAW_COUNT; draw++)
 		{
 			delete drawCall[draw];
@@ -220,7 +323,9 @@ namespace sw
 		context->drawType = drawType;
 
 		updateConfiguration();
+		updateDirtyState();
 		updateClipper();
+		PixelProcessor::ageConstants();
 
 		int ss = context->getSuperSampleCount();
 		int ms = context->getMultiSampleCount();
@@ -239,13 +344,39 @@ namespace sw
 
 			if(update || oldMultiSampleMask != context->multiSampleMask)
 			{
-				vertexState = VertexProcessor::update(drawType);
-				setupState = SetupProcessor::update();
-				pixelState = PixelProcessor::update();
+				// Fixed-function states depend on too many derived values to be updated incrementally
+				bool programmable = context->vertexShader && context->pixelShader && context->pixelShaderModel() >= 0x0300;
+				unsigned int dirtyState = programmable ? context->dirtyState : Context::DIRTY_ALL;
+
+				if(dirtyState || !vertexRoutine)
+				{
+					vertexState = VertexProcessor::update(drawType);
+					vertexRoutine = VertexProcessor::routine(vertexState);
+				}
+				else if(VertexProcessor::update(vertexState, context->dirtySamplers))
+				{
+					vertexRoutine = VertexProcessor::routine(vertexState);
+				}
+
+				// Only the vertex routine depends on the input stream formats
+				if((dirtyState & ~Context::DIRTY_INPUTS) || !setupRoutine)
+				{
+					setupState = SetupProcessor::update();
+					setupRoutine = SetupProcessor::routine(setupState);
+				}
 
-				vertexRoutine = VertexProcessor::routine(vertexState);
-				setupRoutine = SetupProcessor::routine(setupState);
-				pixelRoutine = PixelProcessor::routine(pixelState);
+				if((dirtyState & ~Context::DIRTY_INPUTS) || !pixelRoutine)
+				{
+					pixelState = PixelProcessor::update();
+					pixelRoutine = PixelProcessor::routine(pixelState);
+				}
+				else if(PixelProcessor::update(pixelState, context->dirtySamplers))
+				{
+					pixelRoutine = PixelProcessor::routine(pixelState);
+				}
+
+				context->dirtyState = 0;
+				context->dirtySamplers = 0;
 			}
 
 			int batch = batchSize / ms;
@@ -281,28 +412,7 @@ namespace sw
 				setupPrimitives = &Renderer::setupPoints;
 			}
 
-			DrawCall *draw = nullptr;
-
-			do
-			{
-				for(int i = 0; i < DRAW_COUNT; i++)
-				{
-					if(drawCall[i]->references == -1)
-					{
-						draw = drawCall[i];
-						drawList[nextDraw & DRAW_COUNT_BITS] = draw;
-
-						break;
-					}
-				}
-
-				if(!draw)
-				{
-					resumeApp->wait();
-				}
-			}
-			while(!draw);
-
+			DrawCall *draw = allocateDrawCall();
 			DrawData *data = draw->data;
 
 			if(queries.size() != 0)
@@ -322,6 +432,21 @@ namespace sw
 			draw->drawType = drawType;
 			draw->batchSize = batch;
 
+			if(vertexRoutine->invoke())
+			{
+				routineOptimizer->schedule(vertexRoutine, VertexProcessor::generator(vertexState));
+			}
+
+			if(setupRoutine->invoke())
+			{
+				routineOptimizer->schedule(setupRoutine, SetupProcessor::generator(setupState));
+			}
+
+			if(pixelRoutine->invoke())
+			{
+				routineOptimizer->schedule(pixelRoutine, PixelProcessor::generator(pixelState));
+			}
+
 			vertexRoutine->bind();
 			setupRoutine->bind();
 			pixelRoutine->bind();
@@ -372,10 +497,11 @@ namespace sw
 
 			if(context->pixelShader)
 			{
+				data->ps.c = PixelProcessor::lockFloatConstants(&draw->psConstF);
+
 				if(draw->psDirtyConstF)
 				{
-					memcpy(&data->ps.cW, PixelProcessor::cW, sizeof(word4) * 4 * (draw->psDirtyConstF < 8 ? draw->psDirtyConstF : 8));
-					memcpy(&data->ps.c, PixelProcessor::c, sizeof(float4) * draw->psDirtyConstF);
+					memcpy(&data->ps.cW, PixelProcessor::cW, sizeof(word4) * 4 * draw->psDirtyConstF);
 					draw->psDirtyConstF = 0;
 				}
 
@@ -395,6 +521,8 @@ namespace sw
 			}
 			else
 			{
+				draw->psConstF = nullptr;
+
 				for(int i = 0; i < MAX_UNIFORM_BUFFER_BINDINGS; i++)
 				{
 					draw->pUniformBuffers[i] = nullptr;
@@ -429,11 +557,7 @@ namespace sw
 					}
 				}
 
-				if(draw->vsDirtyConstF)
-				{
-					memcpy(&data->vs.c, VertexProcessor::c, sizeof(float4) * draw->vsDirtyConstF);
-					draw->vsDirtyConstF = 0;
-				}
+				data->vs.c = VertexProcessor::lockFloatConstants(&draw->vsConstF);
 
 				if(draw->vsDirtyConstI)
 				{
@@ -459,7 +583,7 @@ namespace sw
 			{
 				data->ff = ff;
 
-				draw->vsDirtyConstF = VERTEX_UNIFORM_VECTORS + 1;
+				draw->vsConstF = nullptr;
 				draw->vsDirtyConstI = 16;
 				draw->vsDirtyConstB = 16;
 
@@ -532,6 +656,21 @@ namespace sw
 				}
 			#endif
 
+			// Triangles extending past an integer viewport are rasterized without X and Y clipping, as long as
+			// they lie within a guard band. The scissor rectangle is restricted to the viewport to discard the excess.
+			float guardBand = 1.0f;
+
+			{
+				float area = abs(viewport.width * viewport.height);
+				bool integer = viewport.x0 == floor(viewport.x0) && viewport.y0 == floor(viewport.y0) &&
+				               viewport.width == floor(viewport.width) && viewport.height == floor(viewport.height);
+
+				if(integer && area > 0.0f && area < GUARD_BAND_AREA)
+				{
+					guardBand = sqrt(GUARD_BAND_AREA / area);
+				}
+			}
+
 			// Viewport
 			{
 				float W = 0.5f * viewport.width;
@@ -581,6 +720,7 @@ namespace sw
 				data->YYYY = replicate(Y[s][q] / H);
 				data->halfPixelX = replicate(0.5f / W);
 				data->halfPixelY = replicate(0.5f / H);
+				data->guardBand = replicate(guardBand);
 				data->viewportHeight = abs(viewport.height);
 				data->slopeDepthBias = context->slopeDepthBias;
 				data->depthRange = Z;
@@ -642,37 +782,84 @@ namespace sw
 				data->scissorX1 = scissor.x1;
 				data->scissorY0 = scissor.y0;
 				data->scissorY1 = scissor.y1;
+
+				if(guardBand > 1.0f)
+				{
+					int x0 = (int)min(viewport.x0, viewport.x0 + viewport.width);
+					int x1 = (int)max(viewport.x0, viewport.x0 + viewport.width);
+					int y0 = (int)min(viewport.y0, viewport.y0 + viewport.height);
+					int y1 = (int)max(viewport.y0, viewport.y0 + viewport.height);
+
+					data->scissorX0 = max(data->scissorX0, x0);
+					data->scissorX1 = min(data->scissorX1, x1);
+					data->scissorY0 = max(data->scissorY0, y0);
+					data->scissorY1 = min(data->scissorY1, y1);
+				}
 			}
 
 			draw->primitive = 0;
 			draw->count = count;
 
-			draw->references = (count + batch - 1) / batch;
+			submitDrawCall(draw, (count + batch - 1) / batch);
+		}
+	}
 
-			schedulerMutex.lock();
-			++nextDraw; // Atomic
-			schedulerMutex.unlock();
+	DrawCall *Renderer::allocateDrawCall()
+	{
+		DrawCall *draw = nullptr;
 
-			#ifndef NDEBUG
-			if(threadCount == 1)   // Use main thread for draw execution
+		do
+		{
+			for(int i = 0; i < DRAW_COUNT; i++)
 			{
-				threadsAwake = 1;
-				task[0].type = Task::RESUME;
+				if(drawCall[i]->references == -1)
+				{
+					draw = drawCall[i];
+					drawList[nextDraw & DRAW_COUNT_BITS] = draw;
 
-				taskLoop(0);
+					break;
+				}
 			}
-			else
-			#endif
+
+			if(!draw)
 			{
-				if(!threadsAwake)
-				{
-					suspend[0]->wait();
+				resumeApp->wait();
+			}
+		}
+		while(!draw);
 
-					threadsAwake = 1;
-					task[0].type = Task::RESUME;
+		return draw;
+	}
 
-					resume[0]->signal();
-				}
+	void Renderer::submitDrawCall(DrawCall *draw, int references)
+	{
+		draw->sequence = nextDraw;
+
+		draw->references = references;
+
+		schedulerMutex.lock();
+		++nextDraw; // Atomic
+		schedulerMutex.unlock();
+
+		#ifndef NDEBUG
+		if(threadCount == 1)   // Use main thread for draw execution
+		{
+			threadsAwake = 1;
+			task[0].type = Task::RESUME;
+
+			taskLoop(0);
+		}
+		else
+		#endif
+		{
+			if(!threadsAwake)
+			{
+				suspend[0]->wait();
+
+				threadsAwake = 1;
+				task[0].type = Task::RESUME;
+
+				resume[0]->signal();
 			}
 		}
 	}
@@ -687,6 +874,104 @@ namespace sw
 		blitter->blit(source, sRect, dest, dRect, {filter, isStencil, sRGBconversion});
 	}
 
+	bool Renderer::blitDeferred(Surface *source, const SliceRectF &sRect, Surface *dest, const SliceRect &dRect, Resource *resource)
+	{
+		// Rows are assigned to clusters the same way as for rendering, so the source
+		// must hold resolved, up-to-date contents in its internal buffer
+		if(source->getSamples() > 1 || source->isExternalDirty())
+		{
+			return false;
+		}
+
+		DeferredBlit *deferred = new DeferredBlit;
+		const void *sourceBuffer = source->lockInternal(0, 0, sRect.slice, LOCK_READONLY, MANAGED);
+		void *destBuffer = dest->lockExternal(0, 0, dRect.slice, LOCK_WRITEONLY, PRIVATE);
+
+		if(!blitter->prepare(deferred->blit, source, sRect, sourceBuffer, dest, dRect, destBuffer, {false, false, false}))
+		{
+			source->unlockInternal();
+			dest->unlockExternal();
+			delete deferred;
+
+			return false;
+		}
+
+		deferred->source = source;
+		deferred->dest = dest;
+		deferred->resource = resource;
+		resource->lock(PUBLIC, PRIVATE);
+
+		sync->lock(sw::PRIVATE);
+
+		DrawCall *draw = allocateDrawCall();
+
+		for(int i = 0; i < RENDERTARGETS; i++)
+		{
+			draw->renderTarget[i] = nullptr;
+		}
+
+		draw->depthBuffer = nullptr;
+		draw->stencilBuffer = nullptr;
+
+		for(int i = 0; i < TOTAL_IMAGE_UNITS; i++)
+		{
+			draw->texture[i] = nullptr;
+		}
+
+		for(int i = 0; i < MAX_VERTEX_INPUTS; i++)
+		{
+			draw->vertexStream[i] = nullptr;
+		}
+
+		draw->indexBuffer = nullptr;
+
+		draw->vsConstF = nullptr;
+		draw->psConstF = nullptr;
+
+		for(int i = 0; i < MAX_UNIFORM_BUFFER_BINDINGS; i++)
+		{
+			draw->pUniformBuffers[i] = nullptr;
+			draw->vUniformBuffers[i] = nullptr;
+		}
+
+		for(int i = 0; i < MAX_TRANSFORM_FEEDBACK_INTERLEAVED_COMPONENTS; i++)
+		{
+			draw->transformFeedbackBuffers[i] = nullptr;
+		}
+
+		draw->blit = deferred;
+		draw->batchSize = 1;
+		draw->primitive = 0;
+		draw->count = 1;
+
+		submitDrawCall(draw, 1);
+
+		return true;
+	}
+
+	void Renderer::executeBlit(const DeferredBlit &deferred, int cluster)
+	{
+		const Blitter::Deferred &blit = deferred.blit;
+		int rows = blit.getRowCount();
+		int first = -1;
+
+		// Copy the rows whose source row pairs this cluster renders
+		for(int row = 0; row <= rows; row++)
+		{
+			bool owned = (row < rows) && (((blit.getSourceRow(row) >> 1) & (clusterCount - 1)) == cluster);
+
+			if(owned && first < 0)
+			{
+				first = row;
+			}
+			else if(!owned && first >= 0)
+			{
+				blit.execute(first, row);
+				first = -1;
+			}
+		}
+	}
+
 	void Renderer::blit3D(Surface *source, Surface *dest)
 	{
 		blitter->blit3D(source, dest);
@@ -871,19 +1156,26 @@ namespace sw
 				DrawCall *draw = drawList[primitiveProgress[unit].drawCall & DRAW_COUNT_BITS];
 				int (Renderer::*setupPrimitives)(int batch, int count) = draw->setupPrimitives;
 
-				processPrimitiveVertices(unit, input, count, draw->count, threadIndex);
-
-				#if PERF_HUD
-					int64_t time = Timer::ticks();
-					vertexTime[threadIndex] += time - startTick;
-					startTick = time;
-				#endif
-
 				int visible = 0;
 
-				if(!draw->setupState.rasterizerDiscard)
+				if(draw->blit)
+				{
+					visible = 1;   // Rows are copied by the pixel tasks
+				}
+				else
 				{
-					visible = (this->*setupPrimitives)(unit, count);
+					processPrimitiveVertices(unit, input, count, draw->count, threadIndex);
+
+					#if PERF_HUD
+						int64_t time = Timer::ticks();
+						vertexTime[threadIndex] += time - startTick;
+						startTick = time;
+					#endif
+
+					if(!draw->setupState.rasterizerDiscard)
+					{
+						visible = (this->*setupPrimitives)(unit, count);
+					}
 				}
 
 				primitiveProgress[unit].visible = visible;
@@ -907,7 +1199,14 @@ namespace sw
 					DrawData *data = draw->data;
 					PixelProcessor::RoutinePointer pixelRoutine = draw->pixelPointer;
 
-					pixelRoutine(primitive, visible, cluster, data);
+					if(draw->blit)
+					{
+						executeBlit(*draw->blit, cluster);
+					}
+					else
+					{
+						pixelRoutine(primitive, visible, cluster, data);
+					}
 				}
 
 				finishRendering(task[threadIndex]);
@@ -932,6 +1231,34 @@ namespace sw
 		sync->unlock();
 	}
 
+	int Renderer::getDrawSequence() const
+	{
+		return nextDraw;
+	}
+
+	DrawProgress *Renderer::getDrawProgress() const
+	{
+		return drawProgress;
+	}
+
+	void Renderer::retireDrawCalls()
+	{
+		int retired = nextDraw;   // Draw calls get their reference count before the sequence advances
+
+		// Draw calls can finish out of order, so the oldest one still in flight holds back the rest
+		for(int i = 0; i < DRAW_COUNT; i++)
+		{
+			const DrawCall *draw = drawCall[i];
+
+			if(draw->references != -1 && (int)((unsigned int)draw->sequence - (unsigned int)retired) < 0)
+			{
+				retired = draw->sequence;
+			}
+		}
+
+		drawProgress->retire(retired);
+	}
+
 	void Renderer::finishRendering(Task &pixelTask)
 	{
 		int unit = pixelTask.primitiveUnit;
@@ -988,7 +1315,7 @@ namespace sw
 							break;
 						}
 
-						--query->reference; // Atomic
+						query->retire();
 					}
 
 					delete draw.queries;
@@ -1034,6 +1361,16 @@ namespace sw
 					draw.indexBuffer->unlock();
 				}
 
+				if(draw.vsConstF)
+				{
+					draw.vsConstF->unlock();
+				}
+
+				if(draw.psConstF)
+				{
+					draw.psConstF->unlock();
+				}
+
 				for(int i = 0; i < MAX_UNIFORM_BUFFER_BINDINGS; i++)
 				{
 					if(draw.pUniformBuffers[i])
@@ -1054,13 +1391,27 @@ namespace sw
 					}
 				}
 
-				draw.vertexRoutine->unbind();
-				draw.setupRoutine->unbind();
-				draw.pixelRoutine->unbind();
+				if(draw.blit)
+				{
+					draw.blit->source->unlockInternal();
+					draw.blit->dest->unlockExternal();
+					draw.blit->resource->unlock();
+
+					delete draw.blit->dest;
+					delete draw.blit;
+					draw.blit = nullptr;
+				}
+				else
+				{
+					draw.vertexRoutine->unbind();
+					draw.setupRoutine->unbind();
+					draw.pixelRoutine->unbind();
+				}
 
 				sync->unlock();
 
 				draw.references = -1;
+				retireDrawCalls();
 				resumeApp->signal();
 			}
 		}
@@ -1529,27 +1880,42 @@ namespace sw
 		const DrawData *data = draw.data;
 		int visible = 0;
 
+		// Runs of triangles which need no clipping are set up four at a time
+		Polygon unclipped(&triangle->v0.v[pos], &triangle->v1.v[pos], &triangle->v2.v[pos]);
+		int run = 0;
+
 		for(int i = 0; i < count; i++, triangle++)
 		{
 			Vertex &v0 = triangle->v0;
 			Vertex &v1 = triangle->v1;
 			Vertex &v2 = triangle->v2;
 
+			int clipFlagsOr = v0.clipFlags | v1.clipFlags | v2.clipFlags | draw.clipFlags;
+
+			if(clipFlagsOr == Clipper::CLIP_FINITE)
+			{
+				run++;
+				continue;
+			}
+
+			if(run > 0)
+			{
+				int n = setupRoutine(primitive, triangle - run, &unclipped, data, run);
+				primitive += n * ms;
+				visible += n;
+				run = 0;
+			}
+
 			if((v0.clipFlags & v1.clipFlags & v2.clipFlags) == Clipper::CLIP_FINITE)
 			{
 				Polygon polygon(&v0.v[pos], &v1.v[pos], &v2.v[pos]);
 
-				int clipFlagsOr = v0.clipFlags | v1.clipFlags | v2.clipFlags | draw.clipFlags;
-
-				if(clipFlagsOr != Clipper::CLIP_FINITE)
+				if(!clipper->clip(polygon, clipFlagsOr, draw))
 				{
-					if(!clipper->clip(polygon, clipFlagsOr, draw))
-					{
-						continue;
-					}
+					continue;
 				}
 
-				if(setupRoutine(primitive, triangle, &polygon, data))
+				if(setupRoutine(primitive, triangle, &polygon, data, 1))
 				{
 					primitive += ms;
 					visible++;
@@ -1557,6 +1923,11 @@ namespace sw
 			}
 		}
 
+		if(run > 0)
+		{
+			visible += setupRoutine(primitive, triangle - run, &unclipped, data, run);
+		}
+
 		return visible;
 	}
 
@@ -1798,7 +2169,7 @@ namespace sw
 					}
 				}
 
-				return setupRoutine(&primitive, &triangle, &polygon, &data);
+				return setupRoutine(&primitive, &triangle, &polygon, &data, 1) != 0;
 			}
 		}
 		else   // Diamond test convention
@@ -1904,7 +2275,7 @@ namespace sw
 					}
 				}
 
-				return setupRoutine(&primitive, &triangle, &polygon, &data);
+				return setupRoutine(&primitive, &triangle, &polygon, &data, 1) != 0;
 			}
 		}
 
@@ -1983,7 +2354,7 @@ namespace sw
 				}
 			}
 
-			return setupRoutine(&primitive, &triangle, &polygon, &data);
+			return setupRoutine(&primitive, &triangle, &polygon, &data, 1) != 0;
 		}
 
 		return false;
@@ -2159,7 +2530,11 @@ namespace sw
 
 	void Renderer::setTransparencyAntialiasing(TransparencyAntialiasing transparencyAntialiasing)
 	{
-		sw::transparencyAntialiasing = transparencyAntialiasing;
+		if(sw::transparencyAntialiasing != transparencyAntialiasing)
+		{
+			sw::transparencyAntialiasing = transparencyAntialiasing;
+			context->dirtyState |= Context::DIRTY_RENDER_STATE;
+		}
 	}
 
 	bool Renderer::isReadWriteTexture(int sampler)
@@ -2180,6 +2555,50 @@ namespace sw
 		return false;
 	}
 
+	// Stores the current value, and returns true when it differs from the previous one
+	template<class T>
+	static bool track(T &previous, const T &current)
+	{
+		bool modified = (previous != current);
+		previous = current;
+
+		return modified;
+	}
+
+	void Renderer::updateDirtyState()
+	{
+		bool shadersModified = track(vertexShaderID, context->vertexShader ? context->vertexShader->getSerialID() : 0);
+		shadersModified |= track(pixelShaderID, context->pixelShader ? context->pixelShader->getSerialID() : 0);
+
+		if(shadersModified)
+		{
+			context->dirtyState |= Context::DIRTY_SHADERS;
+		}
+
+		if(track(previousDrawType, context->drawType))
+		{
+			context->dirtyState |= Context::DIRTY_DRAW_TYPE;
+		}
+
+		bool targetsModified = false;
+
+		for(int i = 0; i < RENDERTARGETS; i++)
+		{
+			targetsModified |= track(renderTargetFormat[i], context->renderTargetInternalFormat(i));
+		}
+
+		targetsModified |= track(renderTargetExternalFormat, context->renderTarget[0] ? context->renderTarget[0]->getExternalFormat() : FORMAT_NULL);
+		targetsModified |= track(multiSampleCount, context->getMultiSampleCount());
+		targetsModified |= track(superSampleCount, context->getSuperSampleCount());
+		targetsModified |= track(depthBufferFormat, context->depthBuffer ? context->depthBuffer->getInternalFormat() : FORMAT_NULL);
+		targetsModified |= track(stencilBufferAttached, context->stencilBuffer != nullptr);
+
+		if(targetsModified)
+		{
+			context->dirtyState |= Context::DIRTY_RENDER_TARGETS;
+		}
+	}
+
 	void Renderer::updateClipper()
 	{
 		if(updateClipPlanes)
@@ -2221,6 +2640,7 @@ namespace sw
 		ASSERT(sampler < TOTAL_IMAGE_UNITS && face < 6 && level < MIPMAP_LEVELS);
 
 		context->sampler[sampler].setTextureLevel(face, level, surface, type);
+		context->dirtySamplers |= 1u << sampler;
 	}
 
 	void Renderer::setTextureFilter(SamplerType type, int sampler, FilterType textureFilter)
@@ -2480,17 +2900,17 @@ namespace sw
 
 	void Renderer::setDepthBias(float bias)
 	{
-		context->depthBias = bias;
+		context->setRenderState(context->depthBias, bias);
 	}
 
 	void Renderer::setSlopeDepthBias(float slopeBias)
 	{
-		context->slopeDepthBias = slopeBias;
+		context->setRenderState(context->slopeDepthBias, slopeBias);
 	}
 
 	void Renderer::setRasterizerDiscard(bool rasterizerDiscard)
 	{
-		context->rasterizerDiscard = rasterizerDiscard;
+		context->setRenderState(context->rasterizerDiscard, rasterizerDiscard);
 	}
 
 	void Renderer::setPixelShader(const PixelShader *shader)
@@ -2509,11 +2929,13 @@ namespace sw
 
 	void Renderer::setPixelShaderConstantF(unsigned int index, const float value[4], unsigned int count)
 	{
-		for(unsigned int i = 0; i < DRAW_COUNT; i++)
+		unsigned int dirty = (index + count < 8) ? index + count : 8;   // ps_1_x constants are copied into each draw call
+
+		for(unsigned int i = 0; i < DRAW_COUNT && index < 8; i++)
 		{
-			if(drawCall[i]->psDirtyConstF < index + count)
+			if(drawCall[i]->psDirtyConstF < dirty)
 			{
-				drawCall[i]->psDirtyConstF = index + count;
+				drawCall[i]->psDirtyConstF = dirty;
 			}
 		}
 
@@ -2560,14 +2982,6 @@ namespace sw
 
 	void Renderer::setVertexShaderConstantF(unsigned int index, const float value[4], unsigned int count)
 	{
-		for(unsigned int i = 0; i < DRAW_COUNT; i++)
-		{
-			if(drawCall[i]->vsDirtyConstF < index + count)
-			{
-				drawCall[i]->vsDirtyConstF = index + count;
-			}
-		}
-
 		for(unsigned int i = 0; i < count; i++)
 		{
 			VertexProcessor::setFloatConstant(index + i, value);
@@ -2719,6 +3133,12 @@ namespace sw
 			PixelProcessor::setRoutineCacheSize(configuration.pixelRoutineCacheSize);
 			SetupProcessor::setRoutineCacheSize(configuration.setupRoutineCacheSize);
 
+			// The routines were released with the caches, and the derived states depend on the configuration
+			vertexRoutine = nullptr;
+			setupRoutine = nullptr;
+			pixelRoutine = nullptr;
+			context->dirtyState = Context::DIRTY_ALL;
+
 			switch(configuration.textureSampleQuality)
 			{
 			case 0:  Sampler::setFilterQuality(FILTER_POINT);       break;
@@ -2806,6 +3226,8 @@ namespace sw
 			postBlendSRGB = configuration.postBlendSRGB;
 			exactColorRounding = configuration.exactColorRounding;
 			forceClearRegisters = configuration.forceClearRegisters;
+			constantSpecialization = configuration.constantSpecialization;
+			tieredCompilation = configuration.tieredCompilation;
 
 		#ifndef NDEBUG
 			minPrimitives = configuration.minPrimitives;
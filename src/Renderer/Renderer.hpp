@@ -20,11 +20,13 @@
 #include "SetupProcessor.hpp"
 #include "Plane.hpp"
 #include "Blitter.hpp"
+#include "DrawProgress.hpp"
 #include "Common/MutexLock.hpp"
 #include "Common/Thread.hpp"
 #include "Main/Config.hpp"
 
 #include <list>
+#include <vector>
 
 namespace sw
 {
@@ -89,7 +91,7 @@ namespace sw
 	{
 		enum Type { FRAGMENTS_PASSED, TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN };
 
-		Query(Type type) : building(false), reference(0), data(0), type(type)
+		Query(Type type) : building(false), reference(0), data(0), type(type), destroyed(false)
 		{
 		}
 
@@ -104,11 +106,38 @@ namespace sw
 			building = false;
 		}
 
+		// True when no draw call in flight still contributes to the result
+		bool isIdle();
+
+		// Deletes the query once the draw calls referencing it have retired
+		void destroy();
+
+		// Called by the renderer when a draw call referencing the query retires
+		void retire();
+
+		// Stores the result into the resource at the given offset as soon as it is
+		// available, without blocking the caller. Boolean results are written as 0 or 1.
+		void writeResult(Resource *resource, size_t offset, bool boolean);
+
 		bool building;
 		AtomicInt reference;
 		AtomicInt data;
 
 		const Type type;
+
+	private:
+		struct PendingWrite
+		{
+			Resource *resource;
+			void *address;
+			bool boolean;
+		};
+
+		void flush();   // Assumes the mutex is held
+
+		MutexLock mutex;
+		std::vector<PendingWrite> pending;
+		bool destroyed;
 	};
 
 	struct DrawData
@@ -122,7 +151,7 @@ namespace sw
 
 		struct VS
 		{
-			float4 c[VERTEX_UNIFORM_VECTORS + 1];   // One extra for indices out of range, c[VERTEX_UNIFORM_VECTORS] = {0, 0, 0, 0}
+			float4 *c;   // Version of VertexProcessor::c this draw was issued with
 			byte* u[MAX_UNIFORM_BUFFER_BINDINGS];
 			byte* t[MAX_TRANSFORM_FEEDBACK_INTERLEAVED_COMPONENTS];
 			unsigned int reg[MAX_TRANSFORM_FEEDBACK_INTERLEAVED_COMPONENTS]; // Offset used when reading from registers, in components
@@ -136,7 +165,7 @@ namespace sw
 		struct PS
 		{
 			word4 cW[8][4];
-			float4 c[FRAGMENT_UNIFORM_VECTORS];
+			float4 *c;   // Version of PixelProcessor::c this draw was issued with
 			byte* u[MAX_UNIFORM_BUFFER_BINDINGS];
 			int4 i[16];
 			bool b[16];
@@ -175,6 +204,7 @@ namespace sw
 		float4 YYYY;
 		float4 halfPixelX;
 		float4 halfPixelY;
+		float4 guardBand;   // Scale of the clip volume within which X and Y clipping is skipped
 		float viewportHeight;
 		float slopeDepthBias;
 		float depthRange;
@@ -202,6 +232,14 @@ namespace sw
 		float4 a2c3;
 	};
 
+	struct DeferredBlit
+	{
+		Blitter::Deferred blit;
+		Surface *source;
+		Surface *dest;        // Deleted when the blit completes
+		Resource *resource;   // Memory the destination surface points into
+	};
+
 	struct DrawCall
 	{
 		DrawCall();
@@ -231,22 +269,25 @@ namespace sw
 		Resource* pUniformBuffers[MAX_UNIFORM_BUFFER_BINDINGS];
 		Resource* vUniformBuffers[MAX_UNIFORM_BUFFER_BINDINGS];
 		Resource* transformFeedbackBuffers[MAX_TRANSFORM_FEEDBACK_INTERLEAVED_COMPONENTS];
+		Resource *vsConstF;
+		Resource *psConstF;
 
-		unsigned int vsDirtyConstF;
 		unsigned int vsDirtyConstI;
 		unsigned int vsDirtyConstB;
 
-		unsigned int psDirtyConstF;
+		unsigned int psDirtyConstF;   // ps_1_x constants
 		unsigned int psDirtyConstI;
 		unsigned int psDirtyConstB;
 
 		std::list<Query*> *queries;
+		DeferredBlit *blit;   // Copies rows instead of rendering primitives when non-null
 
 		AtomicInt clipFlags;
 
 		AtomicInt primitive;    // Current primitive to enter pipeline
 		AtomicInt count;        // Number of primitives to render
 		AtomicInt references;   // Remaining references to this draw call, 0 when done drawing, -1 when resources unlocked and slot is free
+		int sequence;           // Submission order, for fences
 
 		DrawData *data;
 	};
@@ -324,6 +365,7 @@ namespace sw
 		void clear(void *value, Format format, Surface *dest, const Rect &rect, unsigned int rgbaMask);
 		void blit(Surface *source, const SliceRectF &sRect, Surface *dest, const SliceRect &dRect, bool filter, bool isStencil = false, bool sRGBconversion = true);
 		void blit3D(Surface *source, Surface *dest);
+		bool blitDeferred(Surface *source, const SliceRectF &sRect, Surface *dest, const SliceRect &dRect, Resource *resource);
 
 		void setIndexBuffer(Resource *indexBuffer);
 
@@ -392,6 +434,11 @@ namespace sw
 
 		void synchronize();
 
+		// Fences: returns the sequence number of the next draw call, and the object
+		// which tracks which sequence numbers have finished.
+		int getDrawSequence() const;
+		DrawProgress *getDrawProgress() const;
+
 		#if PERF_HUD
 			// Performance timers
 			int getThreadCount();
@@ -411,6 +458,10 @@ namespace sw
 		void scheduleTask(int threadIndex);
 		void executeTask(int threadIndex);
 		void finishRendering(Task &pixelTask);
+		void retireDrawCalls();
+		DrawCall *allocateDrawCall();
+		void submitDrawCall(DrawCall *draw, int references);
+		void executeBlit(const DeferredBlit &deferred, int cluster);
 
 		void processPrimitiveVertices(int unit, unsigned int start, unsigned int count, unsigned int loop, int thread);
 
@@ -424,6 +475,7 @@ namespace sw
 		bool setupPoint(Primitive &primitive, Triangle &triangle, const DrawCall &draw);
 
 		bool isReadWriteTexture(int sampler);
+		void updateDirtyState();
 		void updateClipper();
 		void updateConfiguration(bool initialUpdate = false);
 		void initializeThreads();
@@ -435,6 +487,8 @@ namespace sw
 		Context *context;
 		Clipper *clipper;
 		Blitter *blitter;
+		RoutineOptimizer *routineOptimizer;
+		Surface::ResolvePool *resolvePool;   // Threads for resolving multisampled surfaces
 		Viewport viewport;
 		Rect scissor;
 		int clipFlags;
@@ -467,6 +521,7 @@ namespace sw
 
 		AtomicInt currentDraw;
 		AtomicInt nextDraw;
+		DrawProgress *drawProgress;
 
 		enum {
 			TASK_COUNT = 32,   // Size of the task queue (must be power of 2)
@@ -498,9 +553,20 @@ namespace sw
 		SetupProcessor::State setupState;
 		PixelProcessor::State pixelState;
 
-		Routine *vertexRoutine;
-		Routine *setupRoutine;
-		Routine *pixelRoutine;
+		TieredRoutine *vertexRoutine;
+		TieredRoutine *setupRoutine;
+		TieredRoutine *pixelRoutine;
+
+		// Properties of the previous draw's shaders and attachments, which can be recreated at the same address
+		int vertexShaderID;
+		int pixelShaderID;
+		DrawType previousDrawType;
+		Format renderTargetFormat[RENDERTARGETS];
+		Format renderTargetExternalFormat;
+		int multiSampleCount;
+		int superSampleCount;
+		Format depthBufferFormat;
+		bool stencilBufferAttached;
 	};
 }
 
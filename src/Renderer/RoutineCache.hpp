@@ -21,8 +21,8 @@
 
 namespace sw
 {
-	template<class State>
-	class RoutineCache : public LRUCache<State, Routine>
+	template<class State, class Data = Routine>
+	class RoutineCache : public LRUCache<State, Data>
 	{
 	public:
 		RoutineCache(int n, const char *precache = 0);
@@ -35,13 +35,13 @@ namespace sw
 		#endif
 	};
 
-	template<class State>
-	RoutineCache<State>::RoutineCache(int n, const char *precache) : LRUCache<State, Routine>(n), precache(precache)
+	template<class State, class Data>
+	RoutineCache<State, Data>::RoutineCache(int n, const char *precache) : LRUCache<State, Data>(n), precache(precache)
 	{
 	}
 
-	template<class State>
-	RoutineCache<State>::~RoutineCache()
+	template<class State, class Data>
+	RoutineCache<State, Data>::~RoutineCache()
 	{
 	}
 }
@@ -21,6 +21,7 @@
 #include "Shader/SetupRoutine.hpp"
 #include "Shader/Constants.hpp"
 #include "Common/Debug.hpp"
+#include "Main/Config.hpp"
 
 namespace sw
 {
@@ -223,26 +224,57 @@ namespace sw
 		return state;
 	}
 
-	Routine *SetupProcessor::routine(const State &state)
+	class SetupRoutineGenerator : public RoutineGenerator
 	{
-		Routine *routine = routineCache->query(state);
+	public:
+		SetupRoutineGenerator(const SetupProcessor::State &state) : state(state)
+		{
+		}
 
-		if(!routine)
+		Routine *generate(OptimizationLevel level) override
+		{
+			return generate(state, level);
+		}
+
+		static Routine *generate(const SetupProcessor::State &state, OptimizationLevel level)
 		{
 			SetupRoutine *generator = new SetupRoutine(state);
-			generator->generate();
-			routine = generator->getRoutine();
+			generator->generate(level);
+			Routine *routine = generator->getRoutine();
 			delete generator;
 
+			return routine;
+		}
+
+	private:
+		const SetupProcessor::State state;
+	};
+
+	TieredRoutine *SetupProcessor::routine(const State &state)
+	{
+		TieredRoutine *routine = routineCache->query(state);
+
+		if(!routine)
+		{
+			OptimizationLevel level = tieredCompilation ? QuickCompilation : FullOptimization;
+
+			routine = new TieredRoutine(SetupRoutineGenerator::generate(state, level), level);
+
 			routineCache->add(state, routine);
+			profiler.setupRoutines++;
 		}
 
 		return routine;
 	}
 
+	RoutineGenerator *SetupProcessor::generator(const State &state) const
+	{
+		return new SetupRoutineGenerator(state);
+	}
+
 	void SetupProcessor::setRoutineCacheSize(int cacheSize)
 	{
 		delete routineCache;
-		routineCache = new RoutineCache<State>(clamp(cacheSize, 1, 65536), precacheSetup ? "sw-setup" : 0);
+		routineCache = new RoutineCache<State, TieredRoutine>(clamp(cacheSize, 1, 65536), precacheSetup ? "sw-setup" : 0);
 	}
 }
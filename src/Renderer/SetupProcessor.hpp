@@ -17,6 +17,7 @@
 
 #include "Context.hpp"
 #include "RoutineCache.hpp"
+#include "TieredRoutine.hpp"
 #include "Shader/VertexShader.hpp"
 #include "Shader/PixelShader.hpp"
 #include "Common/Types.hpp"
@@ -83,7 +84,7 @@ namespace sw
 			unsigned int hash;
 		};
 
-		typedef bool (*RoutinePointer)(Primitive *primitive, const Triangle *triangle, const Polygon *polygon, const DrawData *draw);
+		typedef int (*RoutinePointer)(Primitive *primitive, const Triangle *triangle, const Polygon *polygon, const DrawData *draw, int count);
 
 		SetupProcessor(Context *context);
 
@@ -91,14 +92,15 @@ namespace sw
 
 	protected:
 		State update() const;
-		Routine *routine(const State &state);
+		TieredRoutine *routine(const State &state);
+		RoutineGenerator *generator(const State &state) const;
 
 		void setRoutineCacheSize(int cacheSize);
 
 	private:
 		Context *const context;
 
-		RoutineCache<State> *routineCache;
+		RoutineCache<State, TieredRoutine> *routineCache;
 	};
 }
 
@@ -23,8 +23,12 @@
 #include "Common/CPUID.hpp"
 #include "Common/Resource.hpp"
 #include "Common/Debug.hpp"
+#include "Main/Config.hpp"
 #include "Reactor/Reactor.hpp"
 
+#include <algorithm>
+#include <vector>
+
 #if defined(__i386__) || defined(__x86_64__)
 	#include <xmmintrin.h>
 	#include <emmintrin.h>
@@ -38,9 +42,11 @@ namespace sw
 	extern bool quadLayoutEnabled;
 	extern bool complementaryDepthBuffer;
 	extern TranscendentalPrecision logPrecision;
+	extern AtomicInt threadCount;
 
 	unsigned int *Surface::palette = 0;
 	unsigned int Surface::paletteID = 0;
+	AtomicInt Surface::revisionCounter;
 
 	void Surface::Buffer::write(int x, int y, int z, const Color<float> &color)
 	{
@@ -1291,7 +1297,12 @@ namespace sw
 		stencil.dirty = false;
 
 		dirtyContents = true;
+		undefinedContents = false;
 		paletteUsed = 0;
+		revision = revisionCounter++;
+
+		retiredCount = 0;
+		renamedLock = false;
 	}
 
 	Surface::Surface(Resource *texture, int width, int height, int depth, int border, int samples, Format format, bool lockable, bool renderTarget, int pitchPprovided) : lockable(lockable), renderTarget(renderTarget)
@@ -1348,7 +1359,12 @@ namespace sw
 		stencil.dirty = false;
 
 		dirtyContents = true;
+		undefinedContents = false;
 		paletteUsed = 0;
+		revision = revisionCounter++;
+
+		retiredCount = 0;
+		renamedLock = false;
 	}
 
 	Surface::~Surface()
@@ -1374,6 +1390,11 @@ namespace sw
 
 		deallocate(stencil.buffer);
 
+		for(int i = 0; i < retiredCount; i++)
+		{
+			deallocate(retired[i]);
+		}
+
 		external.buffer = 0;
 		internal.buffer = 0;
 		stencil.buffer = 0;
@@ -1381,7 +1402,23 @@ namespace sw
 
 	void *Surface::lockExternal(int x, int y, int z, Lock lock, Accessor client)
 	{
-		resource->lock(client);
+		bool rename = canRename(lock, client);
+
+		if(rename)
+		{
+			renamedLock = true;
+			profiler.textureRenames++;
+		}
+		else
+		{
+			if(hasParent && client == PUBLIC && resource->isBusy())
+			{
+				profiler.textureWaits++;
+			}
+
+			resource->lock(client);
+			releaseRetired();
+		}
 
 		if(!external.buffer)
 		{
@@ -1405,6 +1442,11 @@ namespace sw
 			internal.dirty = false;
 		}
 
+		if(rename)
+		{
+			renameStorage(lock);
+		}
+
 		switch(lock)
 		{
 		case LOCK_READONLY:
@@ -1413,6 +1455,8 @@ namespace sw
 		case LOCK_READWRITE:
 		case LOCK_DISCARD:
 			dirtyContents = true;
+			undefinedContents = false;
+			revision = revisionCounter++;
 			break;
 		default:
 			ASSERT(false);
@@ -1425,7 +1469,14 @@ namespace sw
 	{
 		external.unlockRect();
 
-		resource->unlock();
+		if(renamedLock)
+		{
+			renamedLock = false;
+		}
+		else
+		{
+			resource->unlock();
+		}
 	}
 
 	void *Surface::lockInternal(int x, int y, int z, Lock lock, Accessor client)
@@ -1435,6 +1486,8 @@ namespace sw
 			resource->lock(client);
 		}
 
+		releaseRetired();
+
 		if(!internal.buffer)
 		{
 			if(external.buffer && identicalFormats())
@@ -1492,6 +1545,7 @@ namespace sw
 		case LOCK_READWRITE:
 		case LOCK_DISCARD:
 			dirtyContents = true;
+			undefinedContents = false;
 			break;
 		default:
 			ASSERT(false);
@@ -3253,6 +3307,11 @@ namespace sw
 	}
 
 	void *Surface::allocateBuffer(int width, int height, int depth, int border, int samples, Format format)
+	{
+		return allocate(bufferSize(width, height, depth, border, samples, format));
+	}
+
+	size_t Surface::bufferSize(int width, int height, int depth, int border, int samples, Format format)
 	{
 		// Render targets require 2x2 quads
 		int width2 = (width + 1) & ~1;
@@ -3261,7 +3320,7 @@ namespace sw
 		// FIXME: Unpacking byte4 to short4 in the sampler currently involves reading 8 bytes,
 		// and stencil operations also read 8 bytes per four 8-bit stencil values,
 		// so we have to allocate 4 extra bytes to avoid buffer overruns.
-		return allocate(size(width2, height2, depth, border, samples, format) + 4);
+		return size(width2, height2, depth, border, samples, format) + 4;
 	}
 
 	void Surface::memfill4(void *buffer, int pattern, int bytes)
@@ -3332,6 +3391,61 @@ namespace sw
 		}
 	}
 
+	// Texture images which in-flight draw calls only sample from get new storage when
+	// written by the application, instead of waiting for those draw calls to finish.
+	bool Surface::canRename(Lock lock, Accessor client)
+	{
+		if(client != PUBLIC || lock == LOCK_READONLY || !hasParent || !ownExternal)
+		{
+			return false;
+		}
+
+		if(!internal.buffer || internal.samples > 1 || hasStencil() || retiredCount == MAX_RETIRED_BUFFERS)
+		{
+			return false;
+		}
+
+		return resource->isBusy(PRIVATE);
+	}
+
+	void Surface::renameStorage(Lock lock)
+	{
+		void *buffer = nullptr;
+
+		if(internal.buffer == external.buffer)
+		{
+			size_t bytes = bufferSize(internal.width, internal.height, internal.depth, internal.border, internal.samples, internal.format);
+			buffer = allocate(bytes);
+
+			if(lock != LOCK_DISCARD)
+			{
+				memcpy(buffer, internal.buffer, bytes);
+			}
+
+			external.buffer = buffer;
+		}
+
+		// Without a shared buffer, the renderer only reads the internal one. It gets
+		// reallocated and updated from the external buffer when next locked.
+		retired[retiredCount++] = internal.buffer;
+		internal.buffer = buffer;
+	}
+
+	void Surface::releaseRetired()
+	{
+		if(retiredCount == 0 || resource->isBusy())
+		{
+			return;
+		}
+
+		for(int i = 0; i < retiredCount; i++)
+		{
+			deallocate(retired[i]);
+		}
+
+		retiredCount = 0;
+	}
+
 	void Surface::sync()
 	{
 		resource->lock(EXCLUSIVE);
@@ -3742,6 +3856,20 @@ namespace sw
 		dirtyContents = false;
 	}
 
+	void Surface::invalidate()
+	{
+		// Contents are undefined, so neither sibling buffer needs to be brought up to date,
+		// which also leaves nothing for a multisample resolve to do
+		internal.dirty = false;
+		external.dirty = false;
+		undefinedContents = true;
+	}
+
+	unsigned int Surface::getRevision() const
+	{
+		return revision;
+	}
+
 	Resource *Surface::getResource()
 	{
 		return resource;
@@ -4016,6 +4144,154 @@ namespace sw
 		Surface::paletteID++;
 	}
 
+	// Helper threads which resolve bands of large multisampled surfaces alongside the calling
+	// thread. They're created on first use and kept for the following resolves.
+	class Surface::ResolvePool
+	{
+	public:
+		ResolvePool();
+
+		~ResolvePool();
+
+		static ResolvePool *acquire();   // Returns a locked pool which isn't resolving another surface, if any
+
+		void resolve(Surface *surface, int bands, int rows);
+
+		MutexLock mutex;   // One surface at a time
+
+	private:
+		struct Helper
+		{
+			ResolvePool *pool;
+			int band;
+			Thread *thread;
+			Event start;
+			Event done;
+		};
+
+		static void threadFunction(void *parameters);
+
+		Helper helper[MAX_RESOLVE_BANDS];   // The calling thread takes band 0
+		Surface *surface;
+		int rows;
+		volatile bool terminate;
+
+		static MutexLock poolsMutex;
+		static std::vector<ResolvePool*> pools;   // One per renderer
+	};
+
+	MutexLock Surface::ResolvePool::poolsMutex;
+	std::vector<Surface::ResolvePool*> Surface::ResolvePool::pools;
+
+	Surface::ResolvePool::ResolvePool()
+	{
+		for(int i = 0; i < MAX_RESOLVE_BANDS; i++)
+		{
+			helper[i].pool = this;
+			helper[i].band = i;
+			helper[i].thread = nullptr;
+		}
+
+		surface = nullptr;
+		rows = 0;
+		terminate = false;
+
+		poolsMutex.lock();
+		pools.push_back(this);
+		poolsMutex.unlock();
+	}
+
+	Surface::ResolvePool::~ResolvePool()
+	{
+		poolsMutex.lock();
+		pools.erase(std::find(pools.begin(), pools.end(), this));
+		poolsMutex.unlock();
+
+		mutex.lock();   // Wait for a resolve in progress
+		terminate = true;
+
+		for(int i = 1; i < MAX_RESOLVE_BANDS; i++)
+		{
+			if(helper[i].thread)
+			{
+				helper[i].start.signal();
+				helper[i].thread->join();
+				delete helper[i].thread;
+			}
+		}
+
+		mutex.unlock();
+	}
+
+	Surface::ResolvePool *Surface::ResolvePool::acquire()
+	{
+		ResolvePool *available = nullptr;
+
+		poolsMutex.lock();
+
+		for(ResolvePool *pool : pools)
+		{
+			if(pool->mutex.attemptLock())
+			{
+				available = pool;
+				break;
+			}
+		}
+
+		poolsMutex.unlock();
+
+		return available;
+	}
+
+	void Surface::ResolvePool::resolve(Surface *surface, int bands, int rows)
+	{
+		this->surface = surface;
+		this->rows = rows;
+
+		int height = surface->internal.height;
+		int started = 1;
+
+		for(; started < bands && started * rows < height; started++)
+		{
+			if(!helper[started].thread)
+			{
+				helper[started].thread = new Thread(threadFunction, &helper[started]);
+			}
+
+			helper[started].start.signal();
+		}
+
+		surface->resolveRows(0, std::min(rows, height));
+
+		for(int i = 1; i < started; i++)
+		{
+			helper[i].done.wait();
+		}
+	}
+
+	void Surface::ResolvePool::threadFunction(void *parameters)
+	{
+		Helper *helper = static_cast<Helper*>(parameters);
+		ResolvePool *pool = helper->pool;
+
+		while(true)
+		{
+			helper->start.wait();
+
+			if(pool->terminate)
+			{
+				return;
+			}
+
+			int y0 = helper->band * pool->rows;
+			int y1 = std::min(y0 + pool->rows, pool->surface->internal.height);
+
+			pool->surface->resolveRows(y0, y1);
+
+			helper->done.signal();
+		}
+	}
+
 	void Surface::resolve()
 	{
 		if(internal.samples <= 1 || !internal.dirty || !renderTarget || internal.format == FORMAT_NULL)
@@ -4025,14 +4301,63 @@ namespace sw
 
 		ASSERT(internal.depth == 1);  // Unimplemented
 
-		void *source = internal.lockRect(0, 0, 0, LOCK_READWRITE);
+		internal.lockRect(0, 0, 0, LOCK_READWRITE);
 
-		int width = internal.width;
 		int height = internal.height;
+
+		// Large targets are split into bands of row pairs, one per renderer thread
+		int bands = std::min(std::min((int)threadCount, (int)MAX_RESOLVE_BANDS), internal.width * height / RESOLVE_BAND_PIXELS);
+
+		ResolvePool *pool = (bands > 1) ? ResolvePool::acquire() : nullptr;
+
+		if(!pool)   // Small, or all helpers are busy with other surfaces
+		{
+			resolveRows(0, height);
+
+			return;
+		}
+
+		int rows = ((height + bands - 1) / bands + 1) & ~1;
+
+		pool->resolve(this, bands, rows);
+
+		pool->mutex.unlock();
+	}
+
+	Surface::ResolvePool *Surface::createResolvePool()
+	{
+		return new ResolvePool;
+	}
+
+	void Surface::destroyResolvePool(ResolvePool *pool)
+	{
+		delete pool;
+	}
+
+	void Surface::resolveRows(int y0, int y1)
+	{
+		// Vector paths average up to 8 pixels at a time, remaining columns take the scalar path
+		int vectorWidth = internal.width & ~7;
+
+		if(vectorWidth > 0)
+		{
+			resolve(0, y0, vectorWidth, y1);
+		}
+
+		if(vectorWidth < internal.width)
+		{
+			resolve(vectorWidth, y0, internal.width, y1);
+		}
+	}
+
+	void Surface::resolve(int x0, int y0, int x1, int y1)
+	{
+		int width = x1 - x0;
+		int height = y1 - y0;
 		int pitch = internal.pitchB;
 		int slice = internal.sliceB;
 
-		unsigned char *source0 = (unsigned char*)source;
+		unsigned char *source0 = (unsigned char*)internal.buffer + y0 * pitch + x0 * internal.bytes;
 		unsigned char *source1 = source0 + slice;
 		unsigned char *source2 = source1 + slice;
 		unsigned char *source3 = source2 + slice;
@@ -4062,12 +4387,12 @@ namespace sw
 						{
 							for(int x = 0; x < width; x += 4)
 							{
-								__m128i c0 = _mm_load_si128((__m128i*)(source0 + 4 * x));
-								__m128i c1 = _mm_load_si128((__m128i*)(source1 + 4 * x));
+								__m128i c0 = _mm_loadu_si128((__m128i*)(source0 + 4 * x));
+								__m128i c1 = _mm_loadu_si128((__m128i*)(source1 + 4 * x));
 
 								c0 = _mm_avg_epu8(c0, c1);
 
-								_mm_store_si128((__m128i*)(source0 + 4 * x), c0);
+								_mm_storeu_si128((__m128i*)(source0 + 4 * x), c0);
 							}
 
 							source0 += pitch;
@@ -4080,16 +4405,16 @@ namespace sw
 						{
 							for(int x = 0; x < width; x += 4)
 							{
-								__m128i c0 = _mm_load_si128((__m128i*)(source0 + 4 * x));
-								__m128i c1 = _mm_load_si128((__m128i*)(source1 + 4 * x));
-								__m128i c2 = _mm_load_si128((__m128i*)(source2 + 4 * x));
-								__m128i c3 = _mm_load_si128((__m128i*)(source3 + 4 * x));
+								__m128i c0 = _mm_loadu_si128((__m128i*)(source0 + 4 * x));
+								__m128i c1 = _mm_loadu_si128((__m128i*)(source1 + 4 * x));
+								__m128i c2 = _mm_loadu_si128((__m128i*)(source2 + 4 * x));
+								__m128i c3 = _mm_loadu_si128((__m128i*)(source3 + 4 * x));
 
 								c0 = _mm_avg_epu8(c0, c1);
 								c2 = _mm_avg_epu8(c2, c3);
 								c0 = _mm_avg_epu8(c0, c2);
 
-								_mm_store_si128((__m128i*)(source0 + 4 * x), c0);
+								_mm_storeu_si128((__m128i*)(source0 + 4 * x), c0);
 							}
 
 							source0 += pitch;
@@ -4104,14 +4429,14 @@ namespace sw
 						{
 							for(int x = 0; x < width; x += 4)
 							{
-								__m128i c0 = _mm_load_si128((__m128i*)(source0 + 4 * x));
-								__m128i c1 = _mm_load_si128((__m128i*)(source1 + 4 * x));
-								__m128i c2 = _mm_load_si128((__m128i*)(source2 + 4 * x));
-								__m128i c3 = _mm_load_si128((__m128i*)(source3 + 4 * x));
-								__m128i c4 = _mm_load_si128((__m128i*)(source4 + 4 * x));
-								__m128i c5 = _mm_load_si128((__m128i*)(source5 + 4 * x));
-								__m128i c6 = _mm_load_si128((__m128i*)(source6 + 4 * x));
-								__m128i c7 = _mm_load_si128((__m128i*)(source7 + 4 * x));
+								__m128i c0 = _mm_loadu_si128((__m128i*)(source0 + 4 * x));
+								__m128i c1 = _mm_loadu_si128((__m128i*)(source1 + 4 * x));
+								__m128i c2 = _mm_loadu_si128((__m128i*)(source2 + 4 * x));
+								__m128i c3 = _mm_loadu_si128((__m128i*)(source3 + 4 * x));
+								__m128i c4 = _mm_loadu_si128((__m128i*)(source4 + 4 * x));
+								__m128i c5 = _mm_loadu_si128((__m128i*)(source5 + 4 * x));
+								__m128i c6 = _mm_loadu_si128((__m128i*)(source6 + 4 * x));
+								__m128i c7 = _mm_loadu_si128((__m128i*)(source7 + 4 * x));
 
 								c0 = _mm_avg_epu8(c0, c1);
 								c2 = _mm_avg_epu8(c2, c3);
@@ -4121,7 +4446,7 @@ namespace sw
 								c4 = _mm_avg_epu8(c4, c6);
 								c0 = _mm_avg_epu8(c0, c4);
 
-								_mm_store_si128((__m128i*)(source0 + 4 * x), c0);
+								_mm_storeu_si128((__m128i*)(source0 + 4 * x), c0);
 							}
 
 							source0 += pitch;
@@ -4140,22 +4465,22 @@ namespace sw
 						{
 							for(int x = 0; x < width; x += 4)
 							{
-								__m128i c0 = _mm_load_si128((__m128i*)(source0 + 4 * x));
-								__m128i c1 = _mm_load_si128((__m128i*)(source1 + 4 * x));
-								__m128i c2 = _mm_load_si128((__m128i*)(source2 + 4 * x));
-								__m128i c3 = _mm_load_si128((__m128i*)(source3 + 4 * x));
-								__m128i c4 = _mm_load_si128((__m128i*)(source4 + 4 * x));
-								__m128i c5 = _mm_load_si128((__m128i*)(source5 + 4 * x));
-								__m128i c6 = _mm_load_si128((__m128i*)(source6 + 4 * x));
-								__m128i c7 = _mm_load_si128((__m128i*)(source7 + 4 * x));
-								__m128i c8 = _mm_load_si128((__m128i*)(source8 + 4 * x));
-								__m128i c9 = _mm_load_si128((__m128i*)(source9 + 4 * x));
-								__m128i cA = _mm_load_si128((__m128i*)(sourceA + 4 * x));
-								__m128i cB = _mm_load_si128((__m128i*)(sourceB + 4 * x));
-								__m128i cC = _mm_load_si128((__m128i*)(sourceC + 4 * x));
-								__m128i cD = _mm_load_si128((__m128i*)(sourceD + 4 * x));
-								__m128i cE = _mm_load_si128((__m128i*)(sourceE + 4 * x));
-								__m128i cF = _mm_load_si128((__m128i*)(sourceF + 4 * x));
+								__m128i c0 = _mm_loadu_si128((__m128i*)(source0 + 4 * x));
+								__m128i c1 = _mm_loadu_si128((__m128i*)(source1 + 4 * x));
+								__m128i c2 = _mm_loadu_si128((__m128i*)(source2 + 4 * x));
+								__m128i c3 = _mm_loadu_si128((__m128i*)(source3 + 4 * x));
+								__m128i c4 = _mm_loadu_si128((__m128i*)(source4 + 4 * x));
+								__m128i c5 = _mm_loadu_si128((__m128i*)(source5 + 4 * x));
+								__m128i c6 = _mm_loadu_si128((__m128i*)(source6 + 4 * x));
+								__m128i c7 = _mm_loadu_si128((__m128i*)(source7 + 4 * x));
+								__m128i c8 = _mm_loadu_si128((__m128i*)(source8 + 4 * x));
+								__m128i c9 = _mm_loadu_si128((__m128i*)(source9 + 4 * x));
+								__m128i cA = _mm_loadu_si128((__m128i*)(sourceA + 4 * x));
+								__m128i cB = _mm_loadu_si128((__m128i*)(sourceB + 4 * x));
+								__m128i cC = _mm_loadu_si128((__m128i*)(sourceC + 4 * x));
+								__m128i cD = _mm_loadu_si128((__m128i*)(sourceD + 4 * x));
+								__m128i cE = _mm_loadu_si128((__m128i*)(sourceE + 4 * x));
+								__m128i cF = _mm_loadu_si128((__m128i*)(sourceF + 4 * x));
 
 								c0 = _mm_avg_epu8(c0, c1);
 								c2 = _mm_avg_epu8(c2, c3);
@@ -4173,7 +4498,7 @@ namespace sw
 								c8 = _mm_avg_epu8(c8, cC);
 								c0 = _mm_avg_epu8(c0, c8);
 
-								_mm_store_si128((__m128i*)(source0 + 4 * x), c0);
+								_mm_storeu_si128((__m128i*)(source0 + 4 * x), c0);
 							}
 
 							source0 += pitch;
@@ -4356,12 +4681,12 @@ namespace sw
 						{
 							for(int x = 0; x < width; x += 4)
 							{
-								__m128i c0 = _mm_load_si128((__m128i*)(source0 + 4 * x));
-								__m128i c1 = _mm_load_si128((__m128i*)(source1 + 4 * x));
+								__m128i c0 = _mm_loadu_si128((__m128i*)(source0 + 4 * x));
+								__m128i c1 = _mm_loadu_si128((__m128i*)(source1 + 4 * x));
 
 								c0 = _mm_avg_epu16(c0, c1);
 
-								_mm_store_si128((__m128i*)(source0 + 4 * x), c0);
+								_mm_storeu_si128((__m128i*)(source0 + 4 * x), c0);
 							}
 
 							source0 += pitch;
@@ -4374,16 +4699,16 @@ namespace sw
 						{
 							for(int x = 0; x < width; x += 4)
 							{
-								__m128i c0 = _mm_load_si128((__m128i*)(source0 + 4 * x));
-								__m128i c1 = _mm_load_si128((__m128i*)(source1 + 4 * x));
-								__m128i c2 = _mm_load_si128((__m128i*)(source2 + 4 * x));
-								__m128i c3 = _mm_load_si128((__m128i*)(source3 + 4 * x));
+								__m128i c0 = _mm_loadu_si128((__m128i*)(source0 + 4 * x));
+								__m128i c1 = _mm_loadu_si128((__m128i*)(source1 + 4 * x));
+								__m128i c2 = _mm_loadu_si128((__m128i*)(source2 + 4 * x));
+								__m128i c3 = _mm_loadu_si128((__m128i*)(source3 + 4 * x));
 
 								c0 = _mm_avg_epu16(c0, c1);
 								c2 = _mm_avg_epu16(c2, c3);
 								c0 = _mm_avg_epu16(c0, c2);
 
-								_mm_store_si128((__m128i*)(source0 + 4 * x), c0);
+								_mm_storeu_si128((__m128i*)(source0 + 4 * x), c0);
 							}
 
 							source0 += pitch;
@@ -4398,14 +4723,14 @@ namespace sw
 						{
 							for(int x = 0; x < width; x += 4)
 							{
-								__m128i c0 = _mm_load_si128((__m128i*)(source0 + 4 * x));
-								__m128i c1 = _mm_load_si128((__m128i*)(source1 + 4 * x));
-								__m128i c2 = _mm_load_si128((__m128i*)(source2 + 4 * x));
-								__m128i c3 = _mm_load_si128((__m128i*)(source3 + 4 * x));
-								__m128i c4 = _mm_load_si128((__m128i*)(source4 + 4 * x));
-								__m128i c5 = _mm_load_si128((__m128i*)(source5 + 4 * x));
-								__m128i c6 = _mm_load_si128((__m128i*)(source6 + 4 * x));
-								__m128i c7 = _mm_load_si128((__m128i*)(source7 + 4 * x));
+								__m128i c0 = _mm_loadu_si128((__m128i*)(source0 + 4 * x));
+								__m128i c1 = _mm_loadu_si128((__m128i*)(source1 + 4 * x));
+								__m128i c2 = _mm_loadu_si128((__m128i*)(source2 + 4 * x));
+								__m128i c3 = _mm_loadu_si128((__m128i*)(source3 + 4 * x));
+								__m128i c4 = _mm_loadu_si128((__m128i*)(source4 + 4 * x));
+								__m128i c5 = _mm_loadu_si128((__m128i*)(source5 + 4 * x));
+								__m128i c6 = _mm_loadu_si128((__m128i*)(source6 + 4 * x));
+								__m128i c7 = _mm_loadu_si128((__m128i*)(source7 + 4 * x));
 
 								c0 = _mm_avg_epu16(c0, c1);
 								c2 = _mm_avg_epu16(c2, c3);
@@ -4415,7 +4740,7 @@ namespace sw
 								c4 = _mm_avg_epu16(c4, c6);
 								c0 = _mm_avg_epu16(c0, c4);
 
-								_mm_store_si128((__m128i*)(source0 + 4 * x), c0);
+								_mm_storeu_si128((__m128i*)(source0 + 4 * x), c0);
 							}
 
 							source0 += pitch;
@@ -4434,22 +4759,22 @@ namespace sw
 						{
 							for(int x = 0; x < width; x += 4)
 							{
-								__m128i c0 = _mm_load_si128((__m128i*)(source0 + 4 * x));
-								__m128i c1 = _mm_load_si128((__m128i*)(source1 + 4 * x));
-								__m128i c2 = _mm_load_si128((__m128i*)(source2 + 4 * x));
-								__m128i c3 = _mm_load_si128((__m128i*)(source3 + 4 * x));
-								__m128i c4 = _mm_load_si128((__m128i*)(source4 + 4 * x));
-								__m128i c5 = _mm_load_si128((__m128i*)(source5 + 4 * x));
-								__m128i c6 = _mm_load_si128((__m128i*)(source6 + 4 * x));
-								__m128i c7 = _mm_load_si128((__m128i*)(source7 + 4 * x));
-								__m128i c8 = _mm_load_si128((__m128i*)(source8 + 4 * x));
-								__m128i c9 = _mm_load_si128((__m128i*)(source9 + 4 * x));
-								__m128i cA = _mm_load_si128((__m128i*)(sourceA + 4 * x));
-								__m128i cB = _mm_load_si128((__m128i*)(sourceB + 4 * x));
-								__m128i cC = _mm_load_si128((__m128i*)(sourceC + 4 * x));
-								__m128i cD = _mm_load_si128((__m128i*)(sourceD + 4 * x));
-								__m128i cE = _mm_load_si128((__m128i*)(sourceE + 4 * x));
-								__m128i cF = _mm_load_si128((__m128i*)(sourceF + 4 * x));
+								__m128i c0 = _mm_loadu_si128((__m128i*)(source0 + 4 * x));
+								__m128i c1 = _mm_loadu_si128((__m128i*)(source1 + 4 * x));
+								__m128i c2 = _mm_loadu_si128((__m128i*)(source2 + 4 * x));
+								__m128i c3 = _mm_loadu_si128((__m128i*)(source3 + 4 * x));
+								__m128i c4 = _mm_loadu_si128((__m128i*)(source4 + 4 * x));
+								__m128i c5 = _mm_loadu_si128((__m128i*)(source5 + 4 * x));
+								__m128i c6 = _mm_loadu_si128((__m128i*)(source6 + 4 * x));
+								__m128i c7 = _mm_loadu_si128((__m128i*)(source7 + 4 * x));
+								__m128i c8 = _mm_loadu_si128((__m128i*)(source8 + 4 * x));
+								__m128i c9 = _mm_loadu_si128((__m128i*)(source9 + 4 * x));
+								__m128i cA = _mm_loadu_si128((__m128i*)(sourceA + 4 * x));
+								__m128i cB = _mm_loadu_si128((__m128i*)(sourceB + 4 * x));
+								__m128i cC = _mm_loadu_si128((__m128i*)(sourceC + 4 * x));
+								__m128i cD = _mm_loadu_si128((__m128i*)(sourceD + 4 * x));
+								__m128i cE = _mm_loadu_si128((__m128i*)(sourceE + 4 * x));
+								__m128i cF = _mm_loadu_si128((__m128i*)(sourceF + 4 * x));
 
 								c0 = _mm_avg_epu16(c0, c1);
 								c2 = _mm_avg_epu16(c2, c3);
@@ -4467,7 +4792,7 @@ namespace sw
 								c8 = _mm_avg_epu16(c8, cC);
 								c0 = _mm_avg_epu16(c0, c8);
 
-								_mm_store_si128((__m128i*)(source0 + 4 * x), c0);
+								_mm_storeu_si128((__m128i*)(source0 + 4 * x), c0);
 							}
 
 							source0 += pitch;
@@ -4649,12 +4974,12 @@ namespace sw
 						{
 							for(int x = 0; x < width; x += 2)
 							{
-								__m128i c0 = _mm_load_si128((__m128i*)(source0 + 8 * x));
-								__m128i c1 = _mm_load_si128((__m128i*)(source1 + 8 * x));
+								__m128i c0 = _mm_loadu_si128((__m128i*)(source0 + 8 * x));
+								__m128i c1 = _mm_loadu_si128((__m128i*)(source1 + 8 * x));
 
 								c0 = _mm_avg_epu16(c0, c1);
 
-								_mm_store_si128((__m128i*)(source0 + 8 * x), c0);
+								_mm_storeu_si128((__m128i*)(source0 + 8 * x), c0);
 							}
 
 							source0 += pitch;
@@ -4667,16 +4992,16 @@ namespace sw
 						{
 							for(int x = 0; x < width; x += 2)
 							{
-								__m128i c0 = _mm_load_si128((__m128i*)(source0 + 8 * x));
-								__m128i c1 = _mm_load_si128((__m128i*)(source1 + 8 * x));
-								__m128i c2 = _mm_load_si128((__m128i*)(source2 + 8 * x));
-								__m128i c3 = _mm_load_si128((__m128i*)(source3 + 8 * x));
+								__m128i c0 = _mm_loadu_si128((__m128i*)(source0 + 8 * x));
+								__m128i c1 = _mm_loadu_si128((__m128i*)(source1 + 8 * x));
+								__m128i c2 = _mm_loadu_si128((__m128i*)(source2 + 8 * x));
+								__m128i c3 = _mm_loadu_si128((__m128i*)(source3 + 8 * x));
 
 								c0 = _mm_avg_epu16(c0, c1);
 								c2 = _mm_avg_epu16(c2, c3);
 								c0 = _mm_avg_epu16(c0, c2);
 
-								_mm_store_si128((__m128i*)(source0 + 8 * x), c0);
+								_mm_storeu_si128((__m128i*)(source0 + 8 * x), c0);
 							}
 
 							source0 += pitch;
@@ -4691,14 +5016,14 @@ namespace sw
 						{
 							for(int x = 0; x < width; x += 2)
 							{
-								__m128i c0 = _mm_load_si128((__m128i*)(source0 + 8 * x));
-								__m128i c1 = _mm_load_si128((__m128i*)(source1 + 8 * x));
-								__m128i c2 = _mm_load_si128((__m128i*)(source2 + 8 * x));
-								__m128i c3 = _mm_load_si128((__m128i*)(source3 + 8 * x));
-								__m128i c4 = _mm_load_si128((__m128i*)(source4 + 8 * x));
-								__m128i c5 = _mm_load_si128((__m128i*)(source5 + 8 * x));
-								__m128i c6 = _mm_load_si128((__m128i*)(source6 + 8 * x));
-								__m128i c7 = _mm_load_si128((__m128i*)(source7 + 8 * x));
+								__m128i c0 = _mm_loadu_si128((__m128i*)(source0 + 8 * x));
+								__m128i c1 = _mm_loadu_si128((__m128i*)(source1 + 8 * x));
+								__m128i c2 = _mm_loadu_si128((__m128i*)(source2 + 8 * x));
+								__m128i c3 = _mm_loadu_si128((__m128i*)(source3 + 8 * x));
+								__m128i c4 = _mm_loadu_si128((__m128i*)(source4 + 8 * x));
+								__m128i c5 = _mm_loadu_si128((__m128i*)(source5 + 8 * x));
+								__m128i c6 = _mm_loadu_si128((__m128i*)(source6 + 8 * x));
+								__m128i c7 = _mm_loadu_si128((__m128i*)(source7 + 8 * x));
 
 								c0 = _mm_avg_epu16(c0, c1);
 								c2 = _mm_avg_epu16(c2, c3);
@@ -4708,7 +5033,7 @@ namespace sw
 								c4 = _mm_avg_epu16(c4, c6);
 								c0 = _mm_avg_epu16(c0, c4);
 
-								_mm_store_si128((__m128i*)(source0 + 8 * x), c0);
+								_mm_storeu_si128((__m128i*)(source0 + 8 * x), c0);
 							}
 
 							source0 += pitch;
@@ -4727,22 +5052,22 @@ namespace sw
 						{
 							for(int x = 0; x < width; x += 2)
 							{
-								__m128i c0 = _mm_load_si128((__m128i*)(source0 + 8 * x));
-								__m128i c1 = _mm_load_si128((__m128i*)(source1 + 8 * x));
-								__m128i c2 = _mm_load_si128((__m128i*)(source2 + 8 * x));
-								__m128i c3 = _mm_load_si128((__m128i*)(source3 + 8 * x));
-								__m128i c4 = _mm_load_si128((__m128i*)(source4 + 8 * x));
-								__m128i c5 = _mm_load_si128((__m128i*)(source5 + 8 * x));
-								__m128i c6 = _mm_load_si128((__m128i*)(source6 + 8 * x));
-								__m128i c7 = _mm_load_si128((__m128i*)(source7 + 8 * x));
-								__m128i c8 = _mm_load_si128((__m128i*)(source8 + 8 * x));
-								__m128i c9 = _mm_load_si128((__m128i*)(source9 + 8 * x));
-								__m128i cA = _mm_load_si128((__m128i*)(sourceA + 8 * x));
-								__m128i cB = _mm_load_si128((__m128i*)(sourceB + 8 * x));
-								__m128i cC = _mm_load_si128((__m128i*)(sourceC + 8 * x));
-								__m128i cD = _mm_load_si128((__m128i*)(sourceD + 8 * x));
-								__m128i cE = _mm_load_si128((__m128i*)(sourceE + 8 * x));
-								__m128i cF = _mm_load_si128((__m128i*)(sourceF + 8 * x));
+								__m128i c0 = _mm_loadu_si128((__m128i*)(source0 + 8 * x));
+								__m128i c1 = _mm_loadu_si128((__m128i*)(source1 + 8 * x));
+								__m128i c2 = _mm_loadu_si128((__m128i*)(source2 + 8 * x));
+								__m128i c3 = _mm_loadu_si128((__m128i*)(source3 + 8 * x));
+								__m128i c4 = _mm_loadu_si128((__m128i*)(source4 + 8 * x));
+								__m128i c5 = _mm_loadu_si128((__m128i*)(source5 + 8 * x));
+								__m128i c6 = _mm_loadu_si128((__m128i*)(source6 + 8 * x));
+								__m128i c7 = _mm_loadu_si128((__m128i*)(source7 + 8 * x));
+								__m128i c8 = _mm_loadu_si128((__m128i*)(source8 + 8 * x));
+								__m128i c9 = _mm_loadu_si128((__m128i*)(source9 + 8 * x));
+								__m128i cA = _mm_loadu_si128((__m128i*)(sourceA + 8 * x));
+								__m128i cB = _mm_loadu_si128((__m128i*)(sourceB + 8 * x));
+								__m128i cC = _mm_loadu_si128((__m128i*)(sourceC + 8 * x));
+								__m128i cD = _mm_loadu_si128((__m128i*)(sourceD + 8 * x));
+								__m128i cE = _mm_loadu_si128((__m128i*)(sourceE + 8 * x));
+								__m128i cF = _mm_loadu_si128((__m128i*)(sourceF + 8 * x));
 
 								c0 = _mm_avg_epu16(c0, c1);
 								c2 = _mm_avg_epu16(c2, c3);
@@ -4760,7 +5085,7 @@ namespace sw
 								c8 = _mm_avg_epu16(c8, cC);
 								c0 = _mm_avg_epu16(c0, c8);
 
-								_mm_store_si128((__m128i*)(source0 + 8 * x), c0);
+								_mm_storeu_si128((__m128i*)(source0 + 8 * x), c0);
 							}
 
 							source0 += pitch;
@@ -4942,13 +5267,13 @@ namespace sw
 						{
 							for(int x = 0; x < width; x += 4)
 							{
-								__m128 c0 = _mm_load_ps((float*)(source0 + 4 * x));
-								__m128 c1 = _mm_load_ps((float*)(source1 + 4 * x));
+								__m128 c0 = _mm_loadu_ps((float*)(source0 + 4 * x));
+								__m128 c1 = _mm_loadu_ps((float*)(source1 + 4 * x));
 
 								c0 = _mm_add_ps(c0, c1);
 								c0 = _mm_mul_ps(c0, _mm_set1_ps(1.0f / 2.0f));
 
-								_mm_store_ps((float*)(source0 + 4 * x), c0);
+								_mm_storeu_ps((float*)(source0 + 4 * x), c0);
 							}
 
 							source0 += pitch;
@@ -4961,17 +5286,17 @@ namespace sw
 						{
 							for(int x = 0; x < width; x += 4)
 							{
-								__m128 c0 = _mm_load_ps((float*)(source0 + 4 * x));
-								__m128 c1 = _mm_load_ps((float*)(source1 + 4 * x));
-								__m128 c2 = _mm_load_ps((float*)(source2 + 4 * x));
-								__m128 c3 = _mm_load_ps((float*)(source3 + 4 * x));
+								__m128 c0 = _mm_loadu_ps((float*)(source0 + 4 * x));
+								__m128 c1 = _mm_loadu_ps((float*)(source1 + 4 * x));
+								__m128 c2 = _mm_loadu_ps((float*)(source2 + 4 * x));
+								__m128 c3 = _mm_loadu_ps((float*)(source3 + 4 * x));
 
 								c0 = _mm_add_ps(c0, c1);
 								c2 = _mm_add_ps(c2, c3);
 								c0 = _mm_add_ps(c0, c2);
 								c0 = _mm_mul_ps(c0, _mm_set1_ps(1.0f / 4.0f));
 
-								_mm_store_ps((float*)(source0 + 4 * x), c0);
+								_mm_storeu_ps((float*)(source0 + 4 * x), c0);
 							}
 
 							source0 += pitch;
@@ -4986,14 +5311,14 @@ namespace sw
 						{
 							for(int x = 0; x < width; x += 4)
 							{
-								__m128 c0 = _mm_load_ps((float*)(source0 + 4 * x));
-								__m128 c1 = _mm_load_ps((float*)(source1 + 4 * x));
-								__m128 c2 = _mm_load_ps((float*)(source2 + 4 * x));
-								__m128 c3 = _mm_load_ps((float*)(source3 + 4 * x));
-								__m128 c4 = _mm_load_ps((float*)(source4 + 4 * x));
-								__m128 c5 = _mm_load_ps((float*)(source5 + 4 * x));
-								__m128 c6 = _mm_load_ps((float*)(source6 + 4 * x));
-								__m128 c7 = _mm_load_ps((float*)(source7 + 4 * x));
+								__m128 c0 = _mm_loadu_ps((float*)(source0 + 4 * x));
+								__m128 c1 = _mm_loadu_ps((float*)(source1 + 4 * x));
+								__m128 c2 = _mm_loadu_ps((float*)(source2 + 4 * x));
+								__m128 c3 = _mm_loadu_ps((float*)(source3 + 4 * x));
+								__m128 c4 = _mm_loadu_ps((float*)(source4 + 4 * x));
+								__m128 c5 = _mm_loadu_ps((float*)(source5 + 4 * x));
+								__m128 c6 = _mm_loadu_ps((float*)(source6 + 4 * x));
+								__m128 c7 = _mm_loadu_ps((float*)(source7 + 4 * x));
 
 								c0 = _mm_add_ps(c0, c1);
 								c2 = _mm_add_ps(c2, c3);
@@ -5004,7 +5329,7 @@ namespace sw
 								c0 = _mm_add_ps(c0, c4);
 								c0 = _mm_mul_ps(c0, _mm_set1_ps(1.0f / 8.0f));
 
-								_mm_store_ps((float*)(source0 + 4 * x), c0);
+								_mm_storeu_ps((float*)(source0 + 4 * x), c0);
 							}
 
 							source0 += pitch;
@@ -5023,22 +5348,22 @@ namespace sw
 						{
 							for(int x = 0; x < width; x += 4)
 							{
-								__m128 c0 = _mm_load_ps((float*)(source0 + 4 * x));
-								__m128 c1 = _mm_load_ps((float*)(source1 + 4 * x));
-								__m128 c2 = _mm_load_ps((float*)(source2 + 4 * x));
-								__m128 c3 = _mm_load_ps((float*)(source3 + 4 * x));
-								__m128 c4 = _mm_load_ps((float*)(source4 + 4 * x));
-								__m128 c5 = _mm_load_ps((float*)(source5 + 4 * x));
-								__m128 c6 = _mm_load_ps((float*)(source6 + 4 * x));
-								__m128 c7 = _mm_load_ps((float*)(source7 + 4 * x));
-								__m128 c8 = _mm_load_ps((float*)(source8 + 4 * x));
-								__m128 c9 = _mm_load_ps((float*)(source9 + 4 * x));
-								__m128 cA = _mm_load_ps((float*)(sourceA + 4 * x));
-								__m128 cB = _mm_load_ps((float*)(sourceB + 4 * x));
-								__m128 cC = _mm_load_ps((float*)(sourceC + 4 * x));
-								__m128 cD = _mm_load_ps((float*)(sourceD + 4 * x));
-								__m128 cE = _mm_load_ps((float*)(sourceE + 4 * x));
-								__m128 cF = _mm_load_ps((float*)(sourceF + 4 * x));
+								__m128 c0 = _mm_loadu_ps((float*)(source0 + 4 * x));
+								__m128 c1 = _mm_loadu_ps((float*)(source1 + 4 * x));
+								__m128 c2 = _mm_loadu_ps((float*)(source2 + 4 * x));
+								__m128 c3 = _mm_loadu_ps((float*)(source3 + 4 * x));
+								__m128 c4 = _mm_loadu_ps((float*)(source4 + 4 * x));
+								__m128 c5 = _mm_loadu_ps((float*)(source5 + 4 * x));
+								__m128 c6 = _mm_loadu_ps((float*)(source6 + 4 * x));
+								__m128 c7 = _mm_loadu_ps((float*)(source7 + 4 * x));
+								__m128 c8 = _mm_loadu_ps((float*)(source8 + 4 * x));
+								__m128 c9 = _mm_loadu_ps((float*)(source9 + 4 * x));
+								__m128 cA = _mm_loadu_ps((float*)(sourceA + 4 * x));
+								__m128 cB = _mm_loadu_ps((float*)(sourceB + 4 * x));
+								__m128 cC = _mm_loadu_ps((float*)(sourceC + 4 * x));
+								__m128 cD = _mm_loadu_ps((float*)(sourceD + 4 * x));
+								__m128 cE = _mm_loadu_ps((float*)(sourceE + 4 * x));
+								__m128 cF = _mm_loadu_ps((float*)(sourceF + 4 * x));
 
 								c0 = _mm_add_ps(c0, c1);
 								c2 = _mm_add_ps(c2, c3);
@@ -5057,7 +5382,7 @@ namespace sw
 								c0 = _mm_add_ps(c0, c8);
 								c0 = _mm_mul_ps(c0, _mm_set1_ps(1.0f / 16.0f));
 
-								_mm_store_ps((float*)(source0 + 4 * x), c0);
+								_mm_storeu_ps((float*)(source0 + 4 * x), c0);
 							}
 
 							source0 += pitch;
@@ -5239,13 +5564,13 @@ namespace sw
 						{
 							for(int x = 0; x < width; x += 2)
 							{
-								__m128 c0 = _mm_load_ps((float*)(source0 + 8 * x));
-								__m128 c1 = _mm_load_ps((float*)(source1 + 8 * x));
+								__m128 c0 = _mm_loadu_ps((float*)(source0 + 8 * x));
+								__m128 c1 = _mm_loadu_ps((float*)(source1 + 8 * x));
 
 								c0 = _mm_add_ps(c0, c1);
 								c0 = _mm_mul_ps(c0, _mm_set1_ps(1.0f / 2.0f));
 
-								_mm_store_ps((float*)(source0 + 8 * x), c0);
+								_mm_storeu_ps((float*)(source0 + 8 * x), c0);
 							}
 
 							source0 += pitch;
@@ -5258,17 +5583,17 @@ namespace sw
 						{
 							for(int x = 0; x < width; x += 2)
 							{
-								__m128 c0 = _mm_load_ps((float*)(source0 + 8 * x));
-								__m128 c1 = _mm_load_ps((float*)(source1 + 8 * x));
-								__m128 c2 = _mm_load_ps((float*)(source2 + 8 * x));
-								__m128 c3 = _mm_load_ps((float*)(source3 + 8 * x));
+								__m128 c0 = _mm_loadu_ps((float*)(source0 + 8 * x));
+								__m128 c1 = _mm_loadu_ps((float*)(source1 + 8 * x));
+								__m128 c2 = _mm_loadu_ps((float*)(source2 + 8 * x));
+								__m128 c3 = _mm_loadu_ps((float*)(source3 + 8 * x));
 
 								c0 = _mm_add_ps(c0, c1);
 								c2 = _mm_add_ps(c2, c3);
 								c0 = _mm_add_ps(c0, c2);
 								c0 = _mm_mul_ps(c0, _mm_set1_ps(1.0f / 4.0f));
 
-								_mm_store_ps((float*)(source0 + 8 * x), c0);
+								_mm_storeu_ps((float*)(source0 + 8 * x), c0);
 							}
 
 							source0 += pitch;
@@ -5283,14 +5608,14 @@ namespace sw
 						{
 							for(int x = 0; x < width; x += 2)
 							{
-								__m128 c0 = _mm_load_ps((float*)(source0 + 8 * x));
-								__m128 c1 = _mm_load_ps((float*)(source1 + 8 * x));
-								__m128 c2 = _mm_load_ps((float*)(source2 + 8 * x));
-								__m128 c3 = _mm_load_ps((float*)(source3 + 8 * x));
-								__m128 c4 = _mm_load_ps((float*)(source4 + 8 * x));
-								__m128 c5 = _mm_load_ps((float*)(source5 + 8 * x));
-								__m128 c6 = _mm_load_ps((float*)(source6 + 8 * x));
-								__m128 c7 = _mm_load_ps((float*)(source7 + 8 * x));
+								__m128 c0 = _mm_loadu_ps((float*)(source0 + 8 * x));
+								__m128 c1 = _mm_loadu_ps((float*)(source1 + 8 * x));
+								__m128 c2 = _mm_loadu_ps((float*)(source2 + 8 * x));
+								__m128 c3 = _mm_loadu_ps((float*)(source3 + 8 * x));
+								__m128 c4 = _mm_loadu_ps((float*)(source4 + 8 * x));
+								__m128 c5 = _mm_loadu_ps((float*)(source5 + 8 * x));
+								__m128 c6 = _mm_loadu_ps((float*)(source6 + 8 * x));
+								__m128 c7 = _mm_loadu_ps((float*)(source7 + 8 * x));
 
 								c0 = _mm_add_ps(c0, c1);
 								c2 = _mm_add_ps(c2, c3);
@@ -5301,7 +5626,7 @@ namespace sw
 								c0 = _mm_add_ps(c0, c4);
 								c0 = _mm_mul_ps(c0, _mm_set1_ps(1.0f / 8.0f));
 
-								_mm_store_ps((float*)(source0 + 8 * x), c0);
+								_mm_storeu_ps((float*)(source0 + 8 * x), c0);
 							}
 
 							source0 += pitch;
@@ -5320,22 +5645,22 @@ namespace sw
 						{
 							for(int x = 0; x < width; x += 2)
 							{
-								__m128 c0 = _mm_load_ps((float*)(source0 + 8 * x));
-								__m128 c1 = _mm_load_ps((float*)(source1 + 8 * x));
-								__m128 c2 = _mm_load_ps((float*)(source2 + 8 * x));
-								__m128 c3 = _mm_load_ps((float*)(source3 + 8 * x));
-								__m128 c4 = _mm_load_ps((float*)(source4 + 8 * x));
-								__m128 c5 = _mm_load_ps((float*)(source5 + 8 * x));
-								__m128 c6 = _mm_load_ps((float*)(source6 + 8 * x));
-								__m128 c7 = _mm_load_ps((float*)(source7 + 8 * x));
-								__m128 c8 = _mm_load_ps((float*)(source8 + 8 * x));
-								__m128 c9 = _mm_load_ps((float*)(source9 + 8 * x));
-								__m128 cA = _mm_load_ps((float*)(sourceA + 8 * x));
-								__m128 cB = _mm_load_ps((float*)(sourceB + 8 * x));
-								__m128 cC = _mm_load_ps((float*)(sourceC + 8 * x));
-								__m128 cD = _mm_load_ps((float*)(sourceD + 8 * x));
-								__m128 cE = _mm_load_ps((float*)(sourceE + 8 * x));
-								__m128 cF = _mm_load_ps((float*)(sourceF + 8 * x));
+								__m128 c0 = _mm_loadu_ps((float*)(source0 + 8 * x));
+								__m128 c1 = _mm_loadu_ps((float*)(source1 + 8 * x));
+								__m128 c2 = _mm_loadu_ps((float*)(source2 + 8 * x));
+								__m128 c3 = _mm_loadu_ps((float*)(source3 + 8 * x));
+								__m128 c4 = _mm_loadu_ps((float*)(source4 + 8 * x));
+								__m128 c5 = _mm_loadu_ps((float*)(source5 + 8 * x));
+								__m128 c6 = _mm_loadu_ps((float*)(source6 + 8 * x));
+								__m128 c7 = _mm_loadu_ps((float*)(source7 + 8 * x));
+								__m128 c8 = _mm_loadu_ps((float*)(source8 + 8 * x));
+								__m128 c9 = _mm_loadu_ps((float*)(source9 + 8 * x));
+								__m128 cA = _mm_loadu_ps((float*)(sourceA + 8 * x));
+								__m128 cB = _mm_loadu_ps((float*)(sourceB + 8 * x));
+								__m128 cC = _mm_loadu_ps((float*)(sourceC + 8 * x));
+								__m128 cD = _mm_loadu_ps((float*)(sourceD + 8 * x));
+								__m128 cE = _mm_loadu_ps((float*)(sourceE + 8 * x));
+								__m128 cF = _mm_loadu_ps((float*)(sourceF + 8 * x));
 
 								c0 = _mm_add_ps(c0, c1);
 								c2 = _mm_add_ps(c2, c3);
@@ -5354,7 +5679,7 @@ namespace sw
 								c0 = _mm_add_ps(c0, c8);
 								c0 = _mm_mul_ps(c0, _mm_set1_ps(1.0f / 16.0f));
 
-								_mm_store_ps((float*)(source0 + 8 * x), c0);
+								_mm_storeu_ps((float*)(source0 + 8 * x), c0);
 							}
 
 							source0 += pitch;
@@ -5538,13 +5863,13 @@ namespace sw
 						{
 							for(int x = 0; x < width; x++)
 							{
-								__m128 c0 = _mm_load_ps((float*)(source0 + 16 * x));
-								__m128 c1 = _mm_load_ps((float*)(source1 + 16 * x));
+								__m128 c0 = _mm_loadu_ps((float*)(source0 + 16 * x));
+								__m128 c1 = _mm_loadu_ps((float*)(source1 + 16 * x));
 
 								c0 = _mm_add_ps(c0, c1);
 								c0 = _mm_mul_ps(c0, _mm_set1_ps(1.0f / 2.0f));
 
-								_mm_store_ps((float*)(source0 + 16 * x), c0);
+								_mm_storeu_ps((float*)(source0 + 16 * x), c0);
 							}
 
 							source0 += pitch;
@@ -5557,17 +5882,17 @@ namespace sw
 						{
 							for(int x = 0; x < width; x++)
 							{
-								__m128 c0 = _mm_load_ps((float*)(source0 + 16 * x));
-								__m128 c1 = _mm_load_ps((float*)(source1 + 16 * x));
-								__m128 c2 = _mm_load_ps((float*)(source2 + 16 * x));
-								__m128 c3 = _mm_load_ps((float*)(source3 + 16 * x));
+								__m128 c0 = _mm_loadu_ps((float*)(source0 + 16 * x));
+								__m128 c1 = _mm_loadu_ps((float*)(source1 + 16 * x));
+								__m128 c2 = _mm_loadu_ps((float*)(source2 + 16 * x));
+								__m128 c3 = _mm_loadu_ps((float*)(source3 + 16 * x));
 
 								c0 = _mm_add_ps(c0, c1);
 								c2 = _mm_add_ps(c2, c3);
 								c0 = _mm_add_ps(c0, c2);
 								c0 = _mm_mul_ps(c0, _mm_set1_ps(1.0f / 4.0f));
 
-								_mm_store_ps((float*)(source0 + 16 * x), c0);
+								_mm_storeu_ps((float*)(source0 + 16 * x), c0);
 							}
 
 							source0 += pitch;
@@ -5582,14 +5907,14 @@ namespace sw
 						{
 							for(int x = 0; x < width; x++)
 							{
-								__m128 c0 = _mm_load_ps((float*)(source0 + 16 * x));
-								__m128 c1 = _mm_load_ps((float*)(source1 + 16 * x));
-								__m128 c2 = _mm_load_ps((float*)(source2 + 16 * x));
-								__m128 c3 = _mm_load_ps((float*)(source3 + 16 * x));
-								__m128 c4 = _mm_load_ps((float*)(source4 + 16 * x));
-								__m128 c5 = _mm_load_ps((float*)(source5 + 16 * x));
-								__m128 c6 = _mm_load_ps((float*)(source6 + 16 * x));
-								__m128 c7 = _mm_load_ps((float*)(source7 + 16 * x));
+								__m128 c0 = _mm_loadu_ps((float*)(source0 + 16 * x));
+								__m128 c1 = _mm_loadu_ps((float*)(source1 + 16 * x));
+								__m128 c2 = _mm_loadu_ps((float*)(source2 + 16 * x));
+								__m128 c3 = _mm_loadu_ps((float*)(source3 + 16 * x));
+								__m128 c4 = _mm_loadu_ps((float*)(source4 + 16 * x));
+								__m128 c5 = _mm_loadu_ps((float*)(source5 + 16 * x));
+								__m128 c6 = _mm_loadu_ps((float*)(source6 + 16 * x));
+								__m128 c7 = _mm_loadu_ps((float*)(source7 + 16 * x));
 
 								c0 = _mm_add_ps(c0, c1);
 								c2 = _mm_add_ps(c2, c3);
@@ -5600,7 +5925,7 @@ namespace sw
 								c0 = _mm_add_ps(c0, c4);
 								c0 = _mm_mul_ps(c0, _mm_set1_ps(1.0f / 8.0f));
 
-								_mm_store_ps((float*)(source0 + 16 * x), c0);
+								_mm_storeu_ps((float*)(source0 + 16 * x), c0);
 							}
 
 							source0 += pitch;
@@ -5619,22 +5944,22 @@ namespace sw
 						{
 							for(int x = 0; x < width; x++)
 							{
-								__m128 c0 = _mm_load_ps((float*)(source0 + 16 * x));
-								__m128 c1 = _mm_load_ps((float*)(source1 + 16 * x));
-								__m128 c2 = _mm_load_ps((float*)(source2 + 16 * x));
-								__m128 c3 = _mm_load_ps((float*)(source3 + 16 * x));
-								__m128 c4 = _mm_load_ps((float*)(source4 + 16 * x));
-								__m128 c5 = _mm_load_ps((float*)(source5 + 16 * x));
-								__m128 c6 = _mm_load_ps((float*)(source6 + 16 * x));
-								__m128 c7 = _mm_load_ps((float*)(source7 + 16 * x));
-								__m128 c8 = _mm_load_ps((float*)(source8 + 16 * x));
-								__m128 c9 = _mm_load_ps((float*)(source9 + 16 * x));
-								__m128 cA = _mm_load_ps((float*)(sourceA + 16 * x));
-								__m128 cB = _mm_load_ps((float*)(sourceB + 16 * x));
-								__m128 cC = _mm_load_ps((float*)(sourceC + 16 * x));
-								__m128 cD = _mm_load_ps((float*)(sourceD + 16 * x));
-								__m128 cE = _mm_load_ps((float*)(sourceE + 16 * x));
-								__m128 cF = _mm_load_ps((float*)(sourceF + 16 * x));
+								__m128 c0 = _mm_loadu_ps((float*)(source0 + 16 * x));
+								__m128 c1 = _mm_loadu_ps((float*)(source1 + 16 * x));
+								__m128 c2 = _mm_loadu_ps((float*)(source2 + 16 * x));
+								__m128 c3 = _mm_loadu_ps((float*)(source3 + 16 * x));
+								__m128 c4 = _mm_loadu_ps((float*)(source4 + 16 * x));
+								__m128 c5 = _mm_loadu_ps((float*)(source5 + 16 * x));
+								__m128 c6 = _mm_loadu_ps((float*)(source6 + 16 * x));
+								__m128 c7 = _mm_loadu_ps((float*)(source7 + 16 * x));
+								__m128 c8 = _mm_loadu_ps((float*)(source8 + 16 * x));
+								__m128 c9 = _mm_loadu_ps((float*)(source9 + 16 * x));
+								__m128 cA = _mm_loadu_ps((float*)(sourceA + 16 * x));
+								__m128 cB = _mm_loadu_ps((float*)(sourceB + 16 * x));
+								__m128 cC = _mm_loadu_ps((float*)(sourceC + 16 * x));
+								__m128 cD = _mm_loadu_ps((float*)(sourceD + 16 * x));
+								__m128 cE = _mm_loadu_ps((float*)(sourceE + 16 * x));
+								__m128 cF = _mm_loadu_ps((float*)(sourceF + 16 * x));
 
 								c0 = _mm_add_ps(c0, c1);
 								c2 = _mm_add_ps(c2, c3);
@@ -5653,7 +5978,7 @@ namespace sw
 								c0 = _mm_add_ps(c0, c8);
 								c0 = _mm_mul_ps(c0, _mm_set1_ps(1.0f / 16.0f));
 
-								_mm_store_ps((float*)(source0 + 16 * x), c0);
+								_mm_storeu_ps((float*)(source0 + 16 * x), c0);
 							}
 
 							source0 += pitch;
@@ -5835,8 +6160,8 @@ namespace sw
 						{
 							for(int x = 0; x < width; x += 8)
 							{
-								__m128i c0 = _mm_load_si128((__m128i*)(source0 + 2 * x));
-								__m128i c1 = _mm_load_si128((__m128i*)(source1 + 2 * x));
+								__m128i c0 = _mm_loadu_si128((__m128i*)(source0 + 2 * x));
+								__m128i c1 = _mm_loadu_si128((__m128i*)(source1 + 2 * x));
 
 								static const ushort8 r_b = {0xF81F, 0xF81F, 0xF81F, 0xF81F, 0xF81F, 0xF81F, 0xF81F, 0xF81F};
 								static const ushort8 _g_ = {0x07E0, 0x07E0, 0x07E0, 0x07E0, 0x07E0, 0x07E0, 0x07E0, 0x07E0};
@@ -5851,7 +6176,7 @@ namespace sw
 								c1 = _mm_and_si128(c1, reinterpret_cast<const __m128i&>(_g_));
 								c0 = _mm_or_si128(c0, c1);
 
-								_mm_store_si128((__m128i*)(source0 + 2 * x), c0);
+								_mm_storeu_si128((__m128i*)(source0 + 2 * x), c0);
 							}
 
 							source0 += pitch;
@@ -5864,10 +6189,10 @@ namespace sw
 						{
 							for(int x = 0; x < width; x += 8)
 							{
-								__m128i c0 = _mm_load_si128((__m128i*)(source0 + 2 * x));
-								__m128i c1 = _mm_load_si128((__m128i*)(source1 + 2 * x));
-								__m128i c2 = _mm_load_si128((__m128i*)(source2 + 2 * x));
-								__m128i c3 = _mm_load_si128((__m128i*)(source3 + 2 * x));
+								__m128i c0 = _mm_loadu_si128((__m128i*)(source0 + 2 * x));
+								__m128i c1 = _mm_loadu_si128((__m128i*)(source1 + 2 * x));
+								__m128i c2 = _mm_loadu_si128((__m128i*)(source2 + 2 * x));
+								__m128i c3 = _mm_loadu_si128((__m128i*)(source3 + 2 * x));
 
 								static const ushort8 r_b = {0xF81F, 0xF81F, 0xF81F, 0xF81F, 0xF81F, 0xF81F, 0xF81F, 0xF81F};
 								static const ushort8 _g_ = {0x07E0, 0x07E0, 0x07E0, 0x07E0, 0x07E0, 0x07E0, 0x07E0, 0x07E0};
@@ -5890,7 +6215,7 @@ namespace sw
 								c1 = _mm_and_si128(c1, reinterpret_cast<const __m128i&>(_g_));
 								c0 = _mm_or_si128(c0, c1);
 
-								_mm_store_si128((__m128i*)(source0 + 2 * x), c0);
+								_mm_storeu_si128((__m128i*)(source0 + 2 * x), c0);
 							}
 
 							source0 += pitch;
@@ -5905,14 +6230,14 @@ namespace sw
 						{
 							for(int x = 0; x < width; x += 8)
 							{
-								__m128i c0 = _mm_load_si128((__m128i*)(source0 + 2 * x));
-								__m128i c1 = _mm_load_si128((__m128i*)(source1 + 2 * x));
-								__m128i c2 = _mm_load_si128((__m128i*)(source2 + 2 * x));
-								__m128i c3 = _mm_load_si128((__m128i*)(source3 + 2 * x));
-								__m128i c4 = _mm_load_si128((__m128i*)(source4 + 2 * x));
-								__m128i c5 = _mm_load_si128((__m128i*)(source5 + 2 * x));
-								__m128i c6 = _mm_load_si128((__m128i*)(source6 + 2 * x));
-								__m128i c7 = _mm_load_si128((__m128i*)(source7 + 2 * x));
+								__m128i c0 = _mm_loadu_si128((__m128i*)(source0 + 2 * x));
+								__m128i c1 = _mm_loadu_si128((__m128i*)(source1 + 2 * x));
+								__m128i c2 = _mm_loadu_si128((__m128i*)(source2 + 2 * x));
+								__m128i c3 = _mm_loadu_si128((__m128i*)(source3 + 2 * x));
+								__m128i c4 = _mm_loadu_si128((__m128i*)(source4 + 2 * x));
+								__m128i c5 = _mm_loadu_si128((__m128i*)(source5 + 2 * x));
+								__m128i c6 = _mm_loadu_si128((__m128i*)(source6 + 2 * x));
+								__m128i c7 = _mm_loadu_si128((__m128i*)(source7 + 2 * x));
 
 								static const ushort8 r_b = {0xF81F, 0xF81F, 0xF81F, 0xF81F, 0xF81F, 0xF81F, 0xF81F, 0xF81F};
 								static const ushort8 _g_ = {0x07E0, 0x07E0, 0x07E0, 0x07E0, 0x07E0, 0x07E0, 0x07E0, 0x07E0};
@@ -5951,7 +6276,7 @@ namespace sw
 								c1 = _mm_and_si128(c1, reinterpret_cast<const __m128i&>(_g_));
 								c0 = _mm_or_si128(c0, c1);
 
-								_mm_store_si128((__m128i*)(source0 + 2 * x), c0);
+								_mm_storeu_si128((__m128i*)(source0 + 2 * x), c0);
 							}
 
 							source0 += pitch;
@@ -5970,22 +6295,22 @@ namespace sw
 						{
 							for(int x = 0; x < width; x += 8)
 							{
-								__m128i c0 = _mm_load_si128((__m128i*)(source0 + 2 * x));
-								__m128i c1 = _mm_load_si128((__m128i*)(source1 + 2 * x));
-								__m128i c2 = _mm_load_si128((__m128i*)(source2 + 2 * x));
-								__m128i c3 = _mm_load_si128((__m128i*)(source3 + 2 * x));
-								__m128i c4 = _mm_load_si128((__m128i*)(source4 + 2 * x));
-								__m128i c5 = _mm_load_si128((__m128i*)(source5 + 2 * x));
-								__m128i c6 = _mm_load_si128((__m128i*)(source6 + 2 * x));
-								__m128i c7 = _mm_load_si128((__m128i*)(source7 + 2 * x));
-								__m128i c8 = _mm_load_si128((__m128i*)(source8 + 2 * x));
-								__m128i c9 = _mm_load_si128((__m128i*)(source9 + 2 * x));
-								__m128i cA = _mm_load_si128((__m128i*)(sourceA + 2 * x));
-								__m128i cB = _mm_load_si128((__m128i*)(sourceB + 2 * x));
-								__m128i cC = _mm_load_si128((__m128i*)(sourceC + 2 * x));
-								__m128i cD = _mm_load_si128((__m128i*)(sourceD + 2 * x));
-								__m128i cE = _mm_load_si128((__m128i*)(sourceE + 2 * x));
-								__m128i cF = _mm_load_si128((__m128i*)(sourceF + 2 * x));
+								__m128i c0 = _mm_loadu_si128((__m128i*)(source0 + 2 * x));
+								__m128i c1 = _mm_loadu_si128((__m128i*)(source1 + 2 * x));
+								__m128i c2 = _mm_loadu_si128((__m128i*)(source2 + 2 * x));
+								__m128i c3 = _mm_loadu_si128((__m128i*)(source3 + 2 * x));
+								__m128i c4 = _mm_loadu_si128((__m128i*)(source4 + 2 * x));
+								__m128i c5 = _mm_loadu_si128((__m128i*)(source5 + 2 * x));
+								__m128i c6 = _mm_loadu_si128((__m128i*)(source6 + 2 * x));
+								__m128i c7 = _mm_loadu_si128((__m128i*)(source7 + 2 * x));
+								__m128i c8 = _mm_loadu_si128((__m128i*)(source8 + 2 * x));
+								__m128i c9 = _mm_loadu_si128((__m128i*)(source9 + 2 * x));
+								__m128i cA = _mm_loadu_si128((__m128i*)(sourceA + 2 * x));
+								__m128i cB = _mm_loadu_si128((__m128i*)(sourceB + 2 * x));
+								__m128i cC = _mm_loadu_si128((__m128i*)(sourceC + 2 * x));
+								__m128i cD = _mm_loadu_si128((__m128i*)(sourceD + 2 * x));
+								__m128i cE = _mm_loadu_si128((__m128i*)(sourceE + 2 * x));
+								__m128i cF = _mm_loadu_si128((__m128i*)(sourceF + 2 * x));
 
 								static const ushort8 r_b = {0xF81F, 0xF81F, 0xF81F, 0xF81F, 0xF81F, 0xF81F, 0xF81F, 0xF81F};
 								static const ushort8 _g_ = {0x07E0, 0x07E0, 0x07E0, 0x07E0, 0x07E0, 0x07E0, 0x07E0, 0x07E0};
@@ -6056,7 +6381,7 @@ namespace sw
 								c1 = _mm_and_si128(c1, reinterpret_cast<const __m128i&>(_g_));
 								c0 = _mm_or_si128(c0, c1);
 
-								_mm_store_si128((__m128i*)(source0 + 2 * x), c0);
+								_mm_storeu_si128((__m128i*)(source0 + 2 * x), c0);
 							}
 
 							source0 += pitch;
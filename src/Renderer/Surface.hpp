@@ -353,6 +353,9 @@ namespace sw
 
 		bool hasDirtyContents() const;
 		void markContentsClean();
+		void invalidate();
+		inline bool hasUndefinedContents() const;
+		unsigned int getRevision() const;
 		inline bool isExternalDirty() const;
 		Resource *getResource();
 
@@ -382,6 +385,12 @@ namespace sw
 
 		static void setTexturePalette(unsigned int *palette);
 
+		// Helper threads for resolving large multisampled surfaces. Renderers own them, so they
+		// get shut down along with the rendering threads instead of at process exit.
+		class ResolvePool;
+		static ResolvePool *createResolvePool();
+		static void destroyResolvePool(ResolvePool *pool);
+
 	private:
 		sw::Resource *resource;
 
@@ -482,12 +491,25 @@ namespace sw
 		static void update(Buffer &destination, Buffer &source);
 		static void genericUpdate(Buffer &destination, Buffer &source);
 		static void *allocateBuffer(int width, int height, int depth, int border, int samples, Format format);
+		static size_t bufferSize(int width, int height, int depth, int border, int samples, Format format);
 		static void memfill4(void *buffer, int pattern, int bytes);
 
 		bool identicalFormats() const;
 		Format selectInternalFormat(Format format) const;
 
 		void resolve();
+		void resolve(int x0, int y0, int x1, int y1);
+		void resolveRows(int y0, int y1);
+
+		enum
+		{
+			MAX_RESOLVE_BANDS = 16,
+			RESOLVE_BAND_PIXELS = 64 * 1024,   // Minimum band size worth a thread
+		};
+
+		bool canRename(Lock lock, Accessor client);
+		void renameStorage(Lock lock);
+		void releaseRetired();
 
 		Buffer external;
 		Buffer internal;
@@ -497,13 +519,24 @@ namespace sw
 		const bool renderTarget;
 
 		bool dirtyContents;   // Sibling surfaces need updating (mipmaps / cube borders).
+		bool undefinedContents;   // Invalidated, and not written since
 		unsigned int paletteUsed;
+		unsigned int revision;   // Unique across surfaces, reissued on each application write
+
+		static AtomicInt revisionCounter;
 
 		static unsigned int *palette;   // FIXME: Not multi-device safe
 		static unsigned int paletteID;
 
 		bool hasParent;
 		bool ownExternal;
+
+		// Storage replaced while the renderer was still sampling from it,
+		// released once the renderer no longer holds the resource.
+		enum {MAX_RETIRED_BUFFERS = 3};
+		void *retired[MAX_RETIRED_BUFFERS];
+		int retiredCount;
+		bool renamedLock;   // External lock taken without locking the resource
 	};
 }
 
@@ -658,6 +691,11 @@ namespace sw
 	{
 		return external.buffer && external.buffer != internal.buffer && external.dirty;
 	}
+
+	bool Surface::hasUndefinedContents() const
+	{
+		return undefinedContents;
+	}
 }
 
 #endif   // sw_Surface_hpp
@@ -0,0 +1,146 @@
+// Copyright 2017 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "TieredRoutine.hpp"
+
+namespace sw
+{
+	bool tieredCompilation = true;
+
+	// Number of draw calls after which a routine gets recompiled with full optimization. Routines
+	// used by fewer draws are typically part of a loading screen or a one-time effect.
+	const int hotInvocations = 16;
+
+	TieredRoutine::TieredRoutine(Routine *routine, OptimizationLevel level) : baseline(routine)
+	{
+		baseline->bind();
+
+		optimized = nullptr;
+		entry = baseline->getEntry();
+
+		invocations = (level == FullOptimization) ? hotInvocations : 0;
+	}
+
+	TieredRoutine::~TieredRoutine()
+	{
+		baseline->unbind();
+
+		if(optimized)
+		{
+			optimized.load()->unbind();
+		}
+	}
+
+	const void *TieredRoutine::getEntry()
+	{
+		return entry;
+	}
+
+	bool TieredRoutine::invoke()
+	{
+		if(invocations == hotInvocations)
+		{
+			return false;
+		}
+
+		return ++invocations == hotInvocations;
+	}
+
+	void TieredRoutine::optimize(Routine *routine)
+	{
+		if(!routine)
+		{
+			return;
+		}
+
+		routine->bind();
+
+		const void *optimizedEntry = routine->getEntry();
+
+		if(!optimizedEntry)   // Out of memory for code, keep using the quickly compiled routine
+		{
+			routine->unbind();
+			return;
+		}
+
+		optimized = routine;
+		entry = optimizedEntry;
+	}
+
+	RoutineOptimizer::RoutineOptimizer()
+	{
+		terminate = false;
+		thread = new Thread(threadFunction, this);
+	}
+
+	RoutineOptimizer::~RoutineOptimizer()
+	{
+		terminate = true;
+		taskEvent.signal();
+		thread->join();
+		delete thread;
+
+		for(Task &task : tasks)   // Routines which didn't get optimized yet keep their quickly compiled code
+		{
+			task.routine->unbind();
+			delete task.generator;
+		}
+	}
+
+	void RoutineOptimizer::schedule(TieredRoutine *routine, RoutineGenerator *generator)
+	{
+		routine->bind();
+
+		taskMutex.lock();
+		tasks.push_back({routine, generator});
+		taskMutex.unlock();
+
+		taskEvent.signal();
+	}
+
+	void RoutineOptimizer::threadFunction(void *parameters)
+	{
+		RoutineOptimizer *optimizer = static_cast<RoutineOptimizer*>(parameters);
+
+		optimizer->optimizeRoutines();
+	}
+
+	void RoutineOptimizer::optimizeRoutines()
+	{
+		while(!terminate)
+		{
+			taskEvent.wait();
+
+			while(!terminate)
+			{
+				taskMutex.lock();
+
+				if(tasks.empty())
+				{
+					taskMutex.unlock();
+					break;
+				}
+
+				Task task = tasks.front();
+				tasks.pop_front();
+
+				taskMutex.unlock();
+
+				task.routine->optimize(task.generator->generate(FullOptimization));
+				task.routine->unbind();
+				delete task.generator;
+			}
+		}
+	}
+}
@@ -0,0 +1,89 @@
+// Copyright 2017 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef sw_TieredRoutine_hpp
+#define sw_TieredRoutine_hpp
+
+#include "Reactor/Reactor.hpp"
+#include "Common/MutexLock.hpp"
+#include "Common/Thread.hpp"
+
+#include <atomic>
+#include <deque>
+
+namespace sw
+{
+	extern bool tieredCompilation;   // Compile new routines quickly, and optimize the hot ones in the background
+
+	class RoutineGenerator
+	{
+	public:
+		virtual ~RoutineGenerator() {}
+
+		virtual Routine *generate(OptimizationLevel level) = 0;
+	};
+
+	// Routine which starts out as quickly compiled code, and gets replaced by a fully optimized
+	// version once enough draw calls have used it. Draw calls fetch the entry when they get
+	// queued, so the replaced code stays alive for as long as this routine does.
+	class TieredRoutine : public Routine
+	{
+	public:
+		TieredRoutine(Routine *routine, OptimizationLevel level);
+
+		~TieredRoutine() override;
+
+		const void *getEntry() override;
+
+		bool invoke();   // Counts a draw call, returns true when the routine just became hot
+		void optimize(Routine *routine);   // Releases the routine instead when it has no entry
+
+	private:
+		Routine *const baseline;
+		std::atomic<Routine*> optimized;
+		std::atomic<const void*> entry;
+
+		int invocations;
+	};
+
+	// Recompiles hot routines with full optimization on a background thread
+	class RoutineOptimizer
+	{
+	public:
+		RoutineOptimizer();
+
+		~RoutineOptimizer();
+
+		void schedule(TieredRoutine *routine, RoutineGenerator *generator);   // Takes ownership of the generator
+
+	private:
+		static void threadFunction(void *parameters);
+		void optimizeRoutines();
+
+		struct Task
+		{
+			TieredRoutine *routine;
+			RoutineGenerator *generator;
+		};
+
+		std::deque<Task> tasks;
+		MutexLock taskMutex;
+		Event taskEvent;
+
+		Thread *thread;
+		volatile bool terminate;
+	};
+}
+
+#endif   // sw_TieredRoutine_hpp
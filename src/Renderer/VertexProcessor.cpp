@@ -21,6 +21,7 @@
 #include "Shader/Constants.hpp"
 #include "Common/Math.hpp"
 #include "Common/Debug.hpp"
+#include "Main/Config.hpp"
 
 #include <string.h>
 
@@ -118,18 +119,31 @@ namespace sw
 			updateModelMatrix[i] = true;
 		}
 
+		floatConstants = new Resource(sizeof(float4) * (VERTEX_UNIFORM_VECTORS + 1));
+		floatConstantsShared = false;
+		c = static_cast<float4*>(const_cast<void*>(floatConstants->data()));
+
 		routineCache = 0;
 		setRoutineCacheSize(1024);
 	}
 
 	VertexProcessor::~VertexProcessor()
 	{
+		floatConstants->destruct();
+
 		delete routineCache;
 		routineCache = 0;
 	}
 
 	void VertexProcessor::setInputStream(int index, const Stream &stream)
 	{
+		const Stream &input = context->input[index];
+
+		if(input.type != stream.type || input.count != stream.count || input.normalized != stream.normalized)
+		{
+			context->dirtyState |= Context::DIRTY_INPUTS;
+		}
+
 		context->input[index] = stream;
 	}
 
@@ -137,16 +151,21 @@ namespace sw
 	{
 		for(int i = 0; i < MAX_VERTEX_INPUTS; i++)
 		{
-			context->input[i].defaults();
+			setInputStream(i, Stream().defaults());
 		}
 
-		context->preTransformed = preTransformed;
+		context->setRenderState(context->preTransformed, preTransformed);
 	}
 
 	void VertexProcessor::setFloatConstant(unsigned int index, const float value[4])
 	{
 		if(index < VERTEX_UNIFORM_VECTORS)
 		{
+			if(floatConstantsShared)
+			{
+				renameFloatConstants();
+			}
+
 			c[index][0] = value[0];
 			c[index][1] = value[1];
 			c[index][2] = value[2];
@@ -155,6 +174,32 @@ namespace sw
 		else ASSERT(false);
 	}
 
+	// Constants still read by a draw call in flight are left intact, and get replaced by a copy
+	void VertexProcessor::renameFloatConstants()
+	{
+		floatConstantsShared = false;
+
+		if(!floatConstants->isBusy())
+		{
+			return;
+		}
+
+		Resource *constants = new Resource(floatConstants->size, true, true);
+		memcpy(const_cast<void*>(constants->data()), c, floatConstants->size);
+
+		floatConstants->destruct();   // Deleted by the last draw call which reads it
+		floatConstants = constants;
+		c = static_cast<float4*>(const_cast<void*>(constants->data()));
+	}
+
+	float4 *VertexProcessor::lockFloatConstants(sw::Resource **constants)
+	{
+		floatConstantsShared = true;
+		*constants = floatConstants;
+
+		return static_cast<float4*>(floatConstants->lock(PUBLIC, PRIVATE));
+	}
+
 	void VertexProcessor::setIntegerConstant(unsigned int index, const int integer[4])
 	{
 		if(index < 16)
@@ -246,7 +291,7 @@ namespace sw
 	void VertexProcessor::setProjectionMatrix(const Matrix &P)
 	{
 		this->P = P;
-		context->wBasedFog = (P[3][0] != 0.0f) || (P[3][1] != 0.0f) || (P[3][2] != 0.0f) || (P[3][3] != 1.0f);
+		context->setRenderState(context->wBasedFog, (P[3][0] != 0.0f) || (P[3][1] != 0.0f) || (P[3][2] != 0.0f) || (P[3][3] != 1.0f));
 
 		updateMatrix = true;
 		updateProjectionMatrix = true;
@@ -346,12 +391,12 @@ namespace sw
 
 	void VertexProcessor::setFogEnable(bool fogEnable)
 	{
-		context->fogEnable = fogEnable;
+		context->setRenderState(context->fogEnable, fogEnable);
 	}
 
 	void VertexProcessor::setVertexFogMode(FogMode fogMode)
 	{
-		context->vertexFogMode = fogMode;
+		context->setRenderState(context->vertexFogMode, fogMode);
 	}
 
 	void VertexProcessor::setInstanceID(int instanceID)
@@ -443,19 +488,19 @@ namespace sw
 
 	void VertexProcessor::setRangeFogEnable(bool enable)
 	{
-		context->rangeFogEnable = enable;
+		context->setRenderState(context->rangeFogEnable, enable);
 	}
 
 	void VertexProcessor::setIndexedVertexBlendEnable(bool indexedVertexBlendEnable)
 	{
-		context->indexedVertexBlendEnable = indexedVertexBlendEnable;
+		context->setRenderState(context->indexedVertexBlendEnable, indexedVertexBlendEnable);
 	}
 
 	void VertexProcessor::setVertexBlendMatrixCount(unsigned int vertexBlendMatrixCount)
 	{
 		if(vertexBlendMatrixCount <= 4)
 		{
-			context->vertexBlendMatrixCount = vertexBlendMatrixCount;
+			context->setRenderState(context->vertexBlendMatrixCount, (int)vertexBlendMatrixCount);
 		}
 		else ASSERT(false);
 	}
@@ -464,7 +509,7 @@ namespace sw
 	{
 		if(stage < TEXTURE_IMAGE_UNITS)
 		{
-			context->textureWrap[stage] = mask;
+			context->setRenderState(context->textureWrap[stage], (unsigned char)mask);
 		}
 		else ASSERT(false);
 
@@ -480,19 +525,19 @@ namespace sw
 	{
 		if(stage < 8)
 		{
-			context->texGen[stage] = texGen;
+			context->setRenderState(context->texGen[stage], texGen);
 		}
 		else ASSERT(false);
 	}
 
 	void VertexProcessor::setLocalViewer(bool localViewer)
 	{
-		context->localViewer = localViewer;
+		context->setRenderState(context->localViewer, localViewer);
 	}
 
 	void VertexProcessor::setNormalizeNormals(bool normalizeNormals)
 	{
-		context->normalizeNormals = normalizeNormals;
+		context->setRenderState(context->normalizeNormals, normalizeNormals);
 	}
 
 	void VertexProcessor::setTextureMatrix(int stage, const Matrix &T)
@@ -508,8 +553,8 @@ namespace sw
 
 	void VertexProcessor::setTextureTransform(int stage, int count, bool project)
 	{
-		context->textureTransformCount[stage] = count;
-		context->textureTransformProject[stage] = project;
+		context->setRenderState(context->textureTransformCount[stage], count);
+		context->setRenderState(context->textureTransformProject[stage], project);
 	}
 
 	void VertexProcessor::setTextureFilter(unsigned int sampler, FilterType textureFilter)
@@ -517,6 +562,7 @@ namespace sw
 		if(sampler < VERTEX_TEXTURE_IMAGE_UNITS)
 		{
 			context->sampler[TEXTURE_IMAGE_UNITS + sampler].setTextureFilter(textureFilter);
+			context->dirtySamplers |= 1u << (TEXTURE_IMAGE_UNITS + sampler);
 		}
 		else ASSERT(false);
 	}
@@ -526,6 +572,7 @@ namespace sw
 		if(sampler < VERTEX_TEXTURE_IMAGE_UNITS)
 		{
 			context->sampler[TEXTURE_IMAGE_UNITS + sampler].setMipmapFilter(mipmapFilter);
+			context->dirtySamplers |= 1u << (TEXTURE_IMAGE_UNITS + sampler);
 		}
 		else ASSERT(false);
 	}
@@ -535,6 +582,7 @@ namespace sw
 		if(sampler < VERTEX_TEXTURE_IMAGE_UNITS)
 		{
 			context->sampler[TEXTURE_IMAGE_UNITS + sampler].setGatherEnable(enable);
+			context->dirtySamplers |= 1u << (TEXTURE_IMAGE_UNITS + sampler);
 		}
 		else ASSERT(false);
 	}
@@ -544,6 +592,7 @@ namespace sw
 		if(sampler < VERTEX_TEXTURE_IMAGE_UNITS)
 		{
 			context->sampler[TEXTURE_IMAGE_UNITS + sampler].setAddressingModeU(addressMode);
+			context->dirtySamplers |= 1u << (TEXTURE_IMAGE_UNITS + sampler);
 		}
 		else ASSERT(false);
 	}
@@ -553,6 +602,7 @@ namespace sw
 		if(sampler < VERTEX_TEXTURE_IMAGE_UNITS)
 		{
 			context->sampler[TEXTURE_IMAGE_UNITS + sampler].setAddressingModeV(addressMode);
+			context->dirtySamplers |= 1u << (TEXTURE_IMAGE_UNITS + sampler);
 		}
 		else ASSERT(false);
 	}
@@ -562,6 +612,7 @@ namespace sw
 		if(sampler < VERTEX_TEXTURE_IMAGE_UNITS)
 		{
 			context->sampler[TEXTURE_IMAGE_UNITS + sampler].setAddressingModeW(addressMode);
+			context->dirtySamplers |= 1u << (TEXTURE_IMAGE_UNITS + sampler);
 		}
 		else ASSERT(false);
 	}
@@ -571,6 +622,7 @@ namespace sw
 		if(sampler < VERTEX_TEXTURE_IMAGE_UNITS)
 		{
 			context->sampler[TEXTURE_IMAGE_UNITS + sampler].setReadSRGB(sRGB);
+			context->dirtySamplers |= 1u << (TEXTURE_IMAGE_UNITS + sampler);
 		}
 		else ASSERT(false);
 	}
@@ -580,6 +632,7 @@ namespace sw
 		if(sampler < VERTEX_TEXTURE_IMAGE_UNITS)
 		{
 			context->sampler[TEXTURE_IMAGE_UNITS + sampler].setMipmapLOD(bias);
+			context->dirtySamplers |= 1u << (TEXTURE_IMAGE_UNITS + sampler);
 		}
 		else ASSERT(false);
 	}
@@ -589,6 +642,7 @@ namespace sw
 		if(sampler < VERTEX_TEXTURE_IMAGE_UNITS)
 		{
 			context->sampler[TEXTURE_IMAGE_UNITS + sampler].setBorderColor(borderColor);
+			context->dirtySamplers |= 1u << (TEXTURE_IMAGE_UNITS + sampler);
 		}
 		else ASSERT(false);
 	}
@@ -598,6 +652,7 @@ namespace sw
 		if(sampler < VERTEX_TEXTURE_IMAGE_UNITS)
 		{
 			context->sampler[TEXTURE_IMAGE_UNITS + sampler].setMaxAnisotropy(maxAnisotropy);
+			context->dirtySamplers |= 1u << (TEXTURE_IMAGE_UNITS + sampler);
 		}
 		else ASSERT(false);
 	}
@@ -606,7 +661,8 @@ namespace sw
 	{
 		if(sampler < TEXTURE_IMAGE_UNITS)
 		{
-			context->sampler[sampler].setHighPrecisionFiltering(highPrecisionFiltering);
+			context->sampler[TEXTURE_IMAGE_UNITS + sampler].setHighPrecisionFiltering(highPrecisionFiltering);
+			context->dirtySamplers |= 1u << (TEXTURE_IMAGE_UNITS + sampler);
 		}
 		else ASSERT(false);
 	}
@@ -616,6 +672,7 @@ namespace sw
 		if(sampler < VERTEX_TEXTURE_IMAGE_UNITS)
 		{
 			context->sampler[TEXTURE_IMAGE_UNITS + sampler].setSwizzleR(swizzleR);
+			context->dirtySamplers |= 1u << (TEXTURE_IMAGE_UNITS + sampler);
 		}
 		else ASSERT(false);
 	}
@@ -625,6 +682,7 @@ namespace sw
 		if(sampler < VERTEX_TEXTURE_IMAGE_UNITS)
 		{
 			context->sampler[TEXTURE_IMAGE_UNITS + sampler].setSwizzleG(swizzleG);
+			context->dirtySamplers |= 1u << (TEXTURE_IMAGE_UNITS + sampler);
 		}
 		else ASSERT(false);
 	}
@@ -634,6 +692,7 @@ namespace sw
 		if(sampler < VERTEX_TEXTURE_IMAGE_UNITS)
 		{
 			context->sampler[TEXTURE_IMAGE_UNITS + sampler].setSwizzleB(swizzleB);
+			context->dirtySamplers |= 1u << (TEXTURE_IMAGE_UNITS + sampler);
 		}
 		else ASSERT(false);
 	}
@@ -643,6 +702,7 @@ namespace sw
 		if(sampler < VERTEX_TEXTURE_IMAGE_UNITS)
 		{
 			context->sampler[TEXTURE_IMAGE_UNITS + sampler].setSwizzleA(swizzleA);
+			context->dirtySamplers |= 1u << (TEXTURE_IMAGE_UNITS + sampler);
 		}
 		else ASSERT(false);
 	}
@@ -652,6 +712,7 @@ namespace sw
 		if(sampler < VERTEX_TEXTURE_IMAGE_UNITS)
 		{
 			context->sampler[TEXTURE_IMAGE_UNITS + sampler].setCompareFunc(compFunc);
+			context->dirtySamplers |= 1u << (TEXTURE_IMAGE_UNITS + sampler);
 		}
 		else ASSERT(false);
 	}
@@ -661,6 +722,7 @@ namespace sw
 		if(sampler < VERTEX_TEXTURE_IMAGE_UNITS)
 		{
 			context->sampler[TEXTURE_IMAGE_UNITS + sampler].setBaseLevel(baseLevel);
+			context->dirtySamplers |= 1u << (TEXTURE_IMAGE_UNITS + sampler);
 		}
 		else ASSERT(false);
 	}
@@ -670,6 +732,7 @@ namespace sw
 		if(sampler < VERTEX_TEXTURE_IMAGE_UNITS)
 		{
 			context->sampler[TEXTURE_IMAGE_UNITS + sampler].setMaxLevel(maxLevel);
+			context->dirtySamplers |= 1u << (TEXTURE_IMAGE_UNITS + sampler);
 		}
 		else ASSERT(false);
 	}
@@ -679,6 +742,7 @@ namespace sw
 		if(sampler < VERTEX_TEXTURE_IMAGE_UNITS)
 		{
 			context->sampler[TEXTURE_IMAGE_UNITS + sampler].setMinLod(minLod);
+			context->dirtySamplers |= 1u << (TEXTURE_IMAGE_UNITS + sampler);
 		}
 		else ASSERT(false);
 	}
@@ -688,6 +752,7 @@ namespace sw
 		if(sampler < VERTEX_TEXTURE_IMAGE_UNITS)
 		{
 			context->sampler[TEXTURE_IMAGE_UNITS + sampler].setMaxLod(maxLod);
+			context->dirtySamplers |= 1u << (TEXTURE_IMAGE_UNITS + sampler);
 		}
 		else ASSERT(false);
 	}
@@ -724,12 +789,12 @@ namespace sw
 
 	void VertexProcessor::setTransformFeedbackQueryEnabled(bool enable)
 	{
-		context->transformFeedbackQueryEnabled = enable;
+		context->setRenderState(context->transformFeedbackQueryEnabled, enable);
 	}
 
 	void VertexProcessor::enableTransformFeedback(uint64_t enable)
 	{
-		context->transformFeedbackEnabled = enable;
+		context->setRenderState(context->transformFeedbackEnabled, enable);
 	}
 
 	const Matrix &VertexProcessor::getModelTransform(int i)
@@ -890,7 +955,7 @@ namespace sw
 	void VertexProcessor::setRoutineCacheSize(int cacheSize)
 	{
 		delete routineCache;
-		routineCache = new RoutineCache<State>(clamp(cacheSize, 1, 65536), precacheVertex ? "sw-vertex" : 0);
+		routineCache = new RoutineCache<State, TieredRoutine>(clamp(cacheSize, 1, 65536), precacheVertex ? "sw-vertex" : 0);
 	}
 
 	const VertexProcessor::State VertexProcessor::update(DrawType drawType)
@@ -1080,11 +1145,55 @@ namespace sw
 		return state;
 	}
 
-	Routine *VertexProcessor::routine(const State &state)
+	// Updates a state derived for the current shaders and render states with the modified samplers
+	bool VertexProcessor::update(State &state, unsigned int dirtySamplers) const
 	{
-		Routine *routine = routineCache->query(state);
+		ASSERT(context->vertexShader);
 
-		if(!routine)   // Create one
+		bool modified = false;
+
+		for(unsigned int i = 0; i < VERTEX_TEXTURE_IMAGE_UNITS; i++)
+		{
+			if((dirtySamplers & (1u << (TEXTURE_IMAGE_UNITS + i))) && context->vertexShader->usesSampler(i))
+			{
+				const Sampler::State sampler = context->sampler[TEXTURE_IMAGE_UNITS + i].samplerState();
+
+				if(memcmp(&state.sampler[i], &sampler, sizeof(Sampler::State)) != 0)
+				{
+					state.sampler[i] = sampler;
+					modified = true;
+				}
+			}
+		}
+
+		if(modified)
+		{
+			state.hash = state.computeHash();
+		}
+
+		return modified;
+	}
+
+	// Keeps its own copy of the shader, since the application may delete it before the routine gets regenerated
+	class VertexRoutineGenerator : public RoutineGenerator
+	{
+	public:
+		VertexRoutineGenerator(const VertexProcessor::State &state, const VertexShader *shader)
+			: state(state), shader(shader ? new VertexShader(shader) : nullptr)
+		{
+		}
+
+		~VertexRoutineGenerator() override
+		{
+			delete shader;
+		}
+
+		Routine *generate(OptimizationLevel level) override
+		{
+			return generate(state, shader, level);
+		}
+
+		static Routine *generate(const VertexProcessor::State &state, const VertexShader *shader, OptimizationLevel level)
 		{
 			VertexRoutine *generator = nullptr;
 
@@ -1094,16 +1203,40 @@ namespace sw
 			}
 			else
 			{
-				generator = new VertexProgram(state, context->vertexShader);
+				generator = new VertexProgram(state, shader);
 			}
 
 			generator->generate();
-			routine = (*generator)(L"VertexRoutine_%0.8X", state.shaderID);
+			Routine *routine = (*generator)(level, L"VertexRoutine_%0.8X", state.shaderID);
 			delete generator;
 
+			return routine;
+		}
+
+	private:
+		const VertexProcessor::State state;
+		const VertexShader *const shader;
+	};
+
+	TieredRoutine *VertexProcessor::routine(const State &state)
+	{
+		TieredRoutine *routine = routineCache->query(state);
+
+		if(!routine)   // Create one
+		{
+			OptimizationLevel level = tieredCompilation ? QuickCompilation : FullOptimization;
+
+			routine = new TieredRoutine(VertexRoutineGenerator::generate(state, context->vertexShader, level), level);
+
 			routineCache->add(state, routine);
+			profiler.vertexRoutines++;
 		}
 
 		return routine;
 	}
+
+	RoutineGenerator *VertexProcessor::generator(const State &state) const
+	{
+		return new VertexRoutineGenerator(state, state.fixedFunction ? nullptr : context->vertexShader);
+	}
 }
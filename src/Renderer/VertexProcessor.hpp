@@ -18,6 +18,7 @@
 #include "Matrix.hpp"
 #include "Context.hpp"
 #include "RoutineCache.hpp"
+#include "TieredRoutine.hpp"
 #include "Shader/VertexShader.hpp"
 
 namespace sw
@@ -193,6 +194,7 @@ namespace sw
 		void setFloatConstant(unsigned int index, const float value[4]);
 		void setIntegerConstant(unsigned int index, const int integer[4]);
 		void setBooleanConstant(unsigned int index, int boolean);
+		float4 *lockFloatConstants(sw::Resource **constants);
 
 		void setUniformBuffer(int index, sw::Resource* uniformBuffer, int offset);
 		void lockUniformBuffers(byte** u, sw::Resource* uniformBuffers[]);
@@ -284,13 +286,15 @@ namespace sw
 		const Matrix &getViewTransform();
 
 		const State update(DrawType drawType);
-		Routine *routine(const State &state);
+		bool update(State &state, unsigned int dirtySamplers) const;   // Returns true when modified
+		TieredRoutine *routine(const State &state);
+		RoutineGenerator *generator(const State &state) const;   // Regenerates the routine after the shader is gone
 
 		bool isFixedFunction();
 		void setRoutineCacheSize(int cacheSize);
 
 		// Shader constants
-		float4 c[VERTEX_UNIFORM_VECTORS + 1];   // One extra for indices out of range, c[VERTEX_UNIFORM_VECTORS] = {0, 0, 0, 0}
+		float4 *c;   // One extra for indices out of range, c[VERTEX_UNIFORM_VECTORS] = {0, 0, 0, 0}
 		int4 i[16];
 		bool b[16];
 
@@ -298,6 +302,11 @@ namespace sw
 		FixedFunction ff;
 
 	private:
+		void renameFloatConstants();
+
+		Resource *floatConstants;   // Current version of the storage c points into
+		bool floatConstantsShared;   // Referenced by a draw call since it was last renamed
+
 		struct UniformBufferInfo
 		{
 			UniformBufferInfo();
@@ -327,7 +336,7 @@ namespace sw
 
 		Context *const context;
 
-		RoutineCache<State> *routineCache;
+		RoutineCache<State, TieredRoutine> *routineCache;
 
 	protected:
 		Matrix M[12];      // Model/Geometry/World matrix
@@ -107,6 +107,44 @@ namespace sw
 				continue;
 			}
 
+			if(instruction->isBranch() || instruction->isCall() || instruction->isBreak() || instruction->isLoop() || instruction->isEndLoop() ||
+			   opcode == Shader::OPCODE_ELSE || opcode == Shader::OPCODE_ENDIF || opcode == Shader::OPCODE_LABEL || opcode == Shader::OPCODE_RET ||
+			   opcode == Shader::OPCODE_LEAVE || opcode == Shader::OPCODE_CONTINUE || opcode == Shader::OPCODE_TEST ||
+			   opcode == Shader::OPCODE_SWITCH || opcode == Shader::OPCODE_ENDSWITCH)
+			{
+				// Levels of detail computed before a control flow change don't necessarily reach the code after it
+				invalidateSharedLod();
+			}
+
+			if(opcode == Shader::OPCODE_LOOP || opcode == Shader::OPCODE_REP)
+			{
+				unrollStart[unrollDepth] = i;
+				unrollIterations[unrollDepth] = unrolledIterations(i);
+				unrollIfDepth[unrollDepth] = ifDepth;
+				unrollEndBlock[unrollDepth] = (unrollIterations[unrollDepth] > 0 && shader->containsBreakInstruction()) ? Nucleus::createBasicBlock() : nullptr;
+			}
+			else if((opcode == Shader::OPCODE_ENDLOOP || opcode == Shader::OPCODE_ENDREP) && unrollIterations[unrollDepth - 1] > 1)
+			{
+				// Emit the next iteration of an unrolled loop
+				unrollIterations[unrollDepth - 1]--;
+
+				if(opcode == Shader::OPCODE_ENDLOOP)
+				{
+					aL[loopDepth] = aL[loopDepth] + increment[loopDepth];
+				}
+
+				if(unrollEndBlock[unrollDepth - 1])
+				{
+					BasicBlock *nextBlock = Nucleus::createBasicBlock();
+
+					branch(anyNotBroken(0), nextBlock, unrollEndBlock[unrollDepth - 1]);
+					Nucleus::setInsertBlock(nextBlock);
+				}
+
+				i = unrollStart[unrollDepth - 1];
+				continue;
+			}
+
 			const Dst &dst = instruction->dst;
 			const Src &src0 = instruction->src[0];
 			const Src &src1 = instruction->src[1];
@@ -142,6 +180,16 @@ namespace sw
 				}
 			}
 
+			lodCoordinates = nullptr;
+
+			if((opcode == Shader::OPCODE_TEX && !project && !bias) || opcode == Shader::OPCODE_TEXOFFSET)
+			{
+				if(src0.rel.type == Shader::PARAMETER_VOID)
+				{
+					lodCoordinates = &src0;
+				}
+			}
+
 			if(src0.type != Shader::PARAMETER_VOID) s0 = fetchRegister(src0);
 			if(src1.type != Shader::PARAMETER_VOID) s1 = fetchRegister(src1);
 			if(src2.type != Shader::PARAMETER_VOID) s2 = fetchRegister(src2);
@@ -340,6 +388,8 @@ namespace sw
 
 			if(dst.type != Shader::PARAMETER_VOID && dst.type != Shader::PARAMETER_LABEL && opcode != Shader::OPCODE_TEXKILL && opcode != Shader::OPCODE_NOP)
 			{
+				invalidateSharedLod(dst);
+
 				if(dst.saturate)
 				{
 					if(dst.x) d.x = Max(d.x, Float4(0.0f));
@@ -686,6 +736,7 @@ namespace sw
 		else
 		{
 			Int index = As<Int>(Float(fetchRegister(sampler).x.x));
+			lodCoordinates = nullptr;   // Each sample is conditional
 
 			for(int i = 0; i < TEXTURE_IMAGE_UNITS; i++)
 			{
@@ -716,7 +767,7 @@ namespace sw
 		#endif
 
 		Pointer<Byte> texture = data + OFFSET(DrawData, mipmap) + samplerIndex * sizeof(Texture);
-		Vector4f c = SamplerCore(constants, state.sampler[samplerIndex]).sampleTexture(texture, uvwq.x, uvwq.y, uvwq.z, uvwq.w, bias, dsx, dsy, offset, function);
+		Vector4f c = SamplerCore(constants, state.sampler[samplerIndex], findSharedLod(samplerIndex)).sampleTexture(texture, uvwq.x, uvwq.y, uvwq.z, uvwq.w, bias, dsx, dsy, offset, function);
 
 		#if PERF_PROFILE
 			cycles[PERF_TEX] += Ticks() - texTime;
@@ -725,6 +776,74 @@ namespace sw
 		return c;
 	}
 
+	LodCache *PixelProgram::findSharedLod(int samplerIndex)
+	{
+		const Sampler::State &samplerState = state.sampler[samplerIndex];
+
+		if(!lodCoordinates || samplerState.textureType == TEXTURE_NULL || samplerState.textureType == TEXTURE_CUBE || samplerState.textureType == TEXTURE_3D)
+		{
+			return nullptr;
+		}
+
+		const Src &coordinates = *lodCoordinates;
+		SharedLod *unused = nullptr;
+
+		for(int i = 0; i < 4; i++)
+		{
+			SharedLod &entry = sharedLod[i];
+
+			if(!entry.cache.valid)
+			{
+				if(!unused)
+				{
+					unused = &entry;
+				}
+			}
+			else if(entry.coordinates.type == coordinates.type && entry.coordinates.index == coordinates.index &&
+			        entry.coordinates.swizzle == coordinates.swizzle && entry.coordinates.modifier == coordinates.modifier &&
+			        entry.filter == samplerState.textureFilter)
+			{
+				entry.cache.sameTexture = (entry.sampler == samplerIndex);
+				entry.sampler = samplerIndex;
+
+				return &entry.cache;
+			}
+		}
+
+		if(!unused)
+		{
+			return nullptr;
+		}
+
+		unused->coordinates = coordinates;
+		unused->sampler = samplerIndex;
+		unused->filter = samplerState.textureFilter;
+		unused->cache.sameTexture = false;
+
+		return &unused->cache;
+	}
+
+	void PixelProgram::invalidateSharedLod(const Dst &dst)
+	{
+		for(int i = 0; i < 4; i++)
+		{
+			const Src &coordinates = sharedLod[i].coordinates;
+
+			if(coordinates.type == dst.type && (coordinates.index == dst.index || dst.rel.type != Shader::PARAMETER_VOID))
+			{
+				sharedLod[i].cache.valid = false;
+			}
+		}
+	}
+
+	void PixelProgram::invalidateSharedLod()
+	{
+		for(int i = 0; i < 4; i++)
+		{
+			sharedLod[i].cache.valid = false;
+		}
+	}
+
 	void PixelProgram::clampColor(Vector4f oC[RENDERTARGETS])
 	{
 		for(int index = 0; index < RENDERTARGETS; index++)
@@ -815,6 +934,76 @@ namespace sw
 		return enable;
 	}
 
+	// True while some lane enabled at the level of the innermost loop hasn't broken out of it yet
+	RValue<Bool> PixelProgram::anyNotBroken(int nesting)
+	{
+		return SignMask(enableBreak & enableStack[enableIndex - nesting]) != 0;
+	}
+
+	// Lanes which already left the loop iteration take neither side of a branch, so that nested breaks
+	// and continues only affect running lanes, and blocks are skipped once none of them are left
+	void PixelProgram::excludeExitedLanes(Int4 &condition)
+	{
+		if(!whileTest)
+		{
+			if(shader->containsBreakInstruction()) condition &= enableBreak;
+			if(shader->containsContinueInstruction()) condition &= enableContinue;
+		}
+	}
+
+	// When a break leaves no lanes running, jump straight to the loop test, or past the end of an
+	// unrolled loop, instead of executing the rest of the body with a zero mask.
+	void PixelProgram::skipBrokenIteration()
+	{
+		BasicBlock *exitBlock = nullptr;
+		int loopIfDepth = 0;
+
+		if(unrollDepth > 0 && unrollIterations[unrollDepth - 1] > 0)   // Unrolled loops don't contain other loops
+		{
+			exitBlock = unrollEndBlock[unrollDepth - 1];
+			loopIfDepth = unrollIfDepth[unrollDepth - 1];
+		}
+		else if(loopRepDepth > 0)
+		{
+			exitBlock = loopRepTestBlock[loopRepDepth - 1];   // Null for switch statements
+			loopIfDepth = loopRepIfDepth[loopRepDepth - 1];
+		}
+
+		if(!exitBlock)
+		{
+			return;
+		}
+
+		// Conditionals between the loop and the break which have to be popped when leaving early
+		int nesting = 0;
+
+		for(int i = loopIfDepth; i < ifDepth; i++)
+		{
+			if(isConditionalIf[i])
+			{
+				nesting++;
+			}
+		}
+
+		BasicBlock *continueBlock = Nucleus::createBasicBlock();
+
+		if(nesting == 0)
+		{
+			branch(anyNotBroken(0), continueBlock, exitBlock);
+		}
+		else
+		{
+			BasicBlock *leaveBlock = Nucleus::createBasicBlock();
+
+			branch(anyNotBroken(nesting), continueBlock, leaveBlock);
+			Nucleus::setInsertBlock(leaveBlock);
+			enableIndex = enableIndex - nesting;
+			Nucleus::createBr(exitBlock);
+		}
+
+		Nucleus::setInsertBlock(continueBlock);
+	}
+
 	Vector4f PixelProgram::fetchRegister(const Src &src, unsigned int offset)
 	{
 		Vector4f reg;
@@ -948,7 +1137,7 @@ namespace sw
 	{
 		if(bufferIndex == -1)
 		{
-			return data + OFFSET(DrawData, ps.c[index]);
+			return *Pointer<Pointer<Byte>>(data + OFFSET(DrawData, ps.c)) + index * sizeof(float4);
 		}
 		else
 		{
@@ -995,6 +1184,22 @@ namespace sw
 					}
 				}
 			}
+
+			if(src.bufferIndex == -1)
+			{
+				for(int k = 0; k < state.specialization.floatCount; k++)   // Folded control constant
+				{
+					if(state.specialization.floatIndex[k] == i)
+					{
+						c.x = Float4(state.specialization.floatValue[k][0]);
+						c.y = Float4(state.specialization.floatValue[k][1]);
+						c.z = Float4(state.specialization.floatValue[k][2]);
+						c.w = Float4(state.specialization.floatValue[k][3]);
+
+						break;
+					}
+				}
+			}
 		}
 		else if(src.rel.type == Shader::PARAMETER_LOOP)
 		{
@@ -1258,6 +1463,8 @@ namespace sw
 	void PixelProgram::BREAK()
 	{
 		enableBreak = enableBreak & ~enableStack[enableIndex];
+
+		skipBrokenIteration();
 	}
 
 	void PixelProgram::BREAKC(Vector4f &src0, Vector4f &src1, Control control)
@@ -1296,6 +1503,8 @@ namespace sw
 		condition &= enableStack[enableIndex];
 
 		enableBreak = enableBreak & ~condition;
+
+		skipBrokenIteration();
 	}
 
 	void PixelProgram::CONTINUE()
@@ -1343,7 +1552,7 @@ namespace sw
 
 	void PixelProgram::CALLNZb(int labelIndex, int callSiteIndex, const Src &boolRegister)
 	{
-		Bool condition = (*Pointer<Byte>(data + OFFSET(DrawData, ps.b[boolRegister.index])) != Byte(0));   // FIXME
+		Bool condition = booleanConstant(boolRegister);
 
 		if(boolRegister.modifier == Shader::MODIFIER_NOT)
 		{
@@ -1411,11 +1620,15 @@ namespace sw
 		if(isConditionalIf[ifDepth])
 		{
 			Int4 condition = ~enableStack[enableIndex] & enableStack[enableIndex - 1];
+			excludeExitedLanes(condition);
 			Bool notAllFalse = SignMask(condition) != 0;
 
 			branch(notAllFalse, falseBlock, endBlock);
 
-			enableStack[enableIndex] = ~enableStack[enableIndex] & enableStack[enableIndex - 1];
+			// The false block is also entered directly when no lanes took the if
+			condition = ~enableStack[enableIndex] & enableStack[enableIndex - 1];
+			excludeExitedLanes(condition);
+			enableStack[enableIndex] = condition;
 		}
 		else
 		{
@@ -1445,15 +1658,23 @@ namespace sw
 
 	void PixelProgram::ENDLOOP()
 	{
-		loopRepDepth--;
+		if(unrollIterations[--unrollDepth] <= 0)
+		{
+			loopRepDepth--;
 
-		aL[loopDepth] = aL[loopDepth] + increment[loopDepth];   // FIXME: +=
+			aL[loopDepth] = aL[loopDepth] + increment[loopDepth];   // FIXME: +=
 
-		BasicBlock *testBlock = loopRepTestBlock[loopRepDepth];
-		BasicBlock *endBlock = loopRepEndBlock[loopRepDepth];
+			BasicBlock *testBlock = loopRepTestBlock[loopRepDepth];
+			BasicBlock *endBlock = loopRepEndBlock[loopRepDepth];
 
-		Nucleus::createBr(testBlock);
-		Nucleus::setInsertBlock(endBlock);
+			Nucleus::createBr(testBlock);
+			Nucleus::setInsertBlock(endBlock);
+		}
+		else if(unrollEndBlock[unrollDepth])
+		{
+			Nucleus::createBr(unrollEndBlock[unrollDepth]);
+			Nucleus::setInsertBlock(unrollEndBlock[unrollDepth]);
+		}
 
 		loopDepth--;
 		enableBreak = Int4(0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF);
@@ -1461,13 +1682,21 @@ namespace sw
 
 	void PixelProgram::ENDREP()
 	{
-		loopRepDepth--;
+		if(unrollIterations[--unrollDepth] <= 0)
+		{
+			loopRepDepth--;
 
-		BasicBlock *testBlock = loopRepTestBlock[loopRepDepth];
-		BasicBlock *endBlock = loopRepEndBlock[loopRepDepth];
+			BasicBlock *testBlock = loopRepTestBlock[loopRepDepth];
+			BasicBlock *endBlock = loopRepEndBlock[loopRepDepth];
 
-		Nucleus::createBr(testBlock);
-		Nucleus::setInsertBlock(endBlock);
+			Nucleus::createBr(testBlock);
+			Nucleus::setInsertBlock(endBlock);
+		}
+		else if(unrollEndBlock[unrollDepth])
+		{
+			Nucleus::createBr(unrollEndBlock[unrollDepth]);
+			Nucleus::setInsertBlock(unrollEndBlock[unrollDepth]);
+		}
 
 		loopDepth--;
 		enableBreak = Int4(0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF);
@@ -1518,7 +1747,7 @@ namespace sw
 	{
 		ASSERT(ifDepth < 24 + 4);
 
-		Bool condition = (*Pointer<Byte>(data + OFFSET(DrawData, ps.b[boolRegister.index])) != Byte(0));   // FIXME
+		Bool condition = booleanConstant(boolRegister);
 
 		if(boolRegister.modifier == Shader::MODIFIER_NOT)
 		{
@@ -1570,6 +1799,7 @@ namespace sw
 	void PixelProgram::IF(Int4 &condition)
 	{
 		condition &= enableStack[enableIndex];
+		excludeExitedLanes(condition);
 
 		enableIndex++;
 		enableStack[enableIndex] = condition;
@@ -1587,6 +1817,62 @@ namespace sw
 		ifDepth++;
 	}
 
+	RValue<Bool> PixelProgram::booleanConstant(const Src &boolRegister)
+	{
+		if(state.specialization.booleanMask & (1 << boolRegister.index))
+		{
+			return Bool((state.specialization.boolean & (1 << boolRegister.index)) != 0);
+		}
+
+		return *Pointer<Byte>(data + OFFSET(DrawData, ps.b[boolRegister.index])) != Byte(0);   // FIXME
+	}
+
+	RValue<Int> PixelProgram::integerConstant(const Src &integerRegister, int component)
+	{
+		if(state.specialization.integerMask & (1 << integerRegister.index))
+		{
+			return Int(state.specialization.integer[integerRegister.index][component]);
+		}
+
+		return *Pointer<Int>(data + OFFSET(DrawData, ps.i[integerRegister.index][component]));
+	}
+
+	// Number of times the body of a LOOP or REP is emitted, when its iteration count is a
+	// specialized constant and it's small enough. Returns -1 for loops which aren't unrolled.
+	int PixelProgram::unrolledIterations(size_t loop) const
+	{
+		const Shader::Instruction *instruction = shader->getInstruction(loop);
+		const Src &integerRegister = (instruction->opcode == Shader::OPCODE_LOOP) ? instruction->src[1] : instruction->src[0];
+
+		if(!(state.specialization.integerMask & (1 << integerRegister.index)))
+		{
+			return -1;
+		}
+
+		int count = state.specialization.integer[integerRegister.index][0];
+
+		for(size_t i = loop + 1; i < shader->getLength(); i++)
+		{
+			switch(shader->getInstruction(i)->opcode)
+			{
+			case Shader::OPCODE_ENDLOOP:
+			case Shader::OPCODE_ENDREP:
+				return (count > 0 && count * (i - loop) <= 256) ? count : -1;
+			case Shader::OPCODE_LOOP:      // Only innermost loops are unrolled
+			case Shader::OPCODE_REP:
+			case Shader::OPCODE_WHILE:
+			case Shader::OPCODE_SWITCH:
+			case Shader::OPCODE_CALL:      // Call sites have a single return block
+			case Shader::OPCODE_CALLNZ:
+				return -1;
+			default:
+				break;
+			}
+		}
+
+		return -1;
+	}
+
 	void PixelProgram::LABEL(int labelIndex)
 	{
 		if(!labelBlock[labelIndex])
@@ -1602,15 +1888,20 @@ namespace sw
 	{
 		loopDepth++;
 
-		iteration[loopDepth] = *Pointer<Int>(data + OFFSET(DrawData, ps.i[integerRegister.index][0]));
-		aL[loopDepth] = *Pointer<Int>(data + OFFSET(DrawData, ps.i[integerRegister.index][1]));
-		increment[loopDepth] = *Pointer<Int>(data + OFFSET(DrawData, ps.i[integerRegister.index][2]));
+		iteration[loopDepth] = integerConstant(integerRegister, 0);
+		aL[loopDepth] = integerConstant(integerRegister, 1);
+		increment[loopDepth] = integerConstant(integerRegister, 2);
 
 		//	If(increment[loopDepth] == 0)
 		//	{
 		//		increment[loopDepth] = 1;
 		//	}
 
+		if(unrollIterations[unrollDepth++] > 0)
+		{
+			return;   // The body gets emitted once per iteration
+		}
+
 		BasicBlock *loopBlock = Nucleus::createBasicBlock();
 		BasicBlock *testBlock = Nucleus::createBasicBlock();
 		BasicBlock *endBlock = Nucleus::createBasicBlock();
@@ -1622,11 +1913,20 @@ namespace sw
 		Nucleus::createBr(testBlock);
 		Nucleus::setInsertBlock(testBlock);
 
-		branch(iteration[loopDepth] > 0, loopBlock, endBlock);
+		if(shader->containsBreakInstruction())
+		{
+			branch(iteration[loopDepth] > 0 && anyNotBroken(0), loopBlock, endBlock);
+		}
+		else
+		{
+			branch(iteration[loopDepth] > 0, loopBlock, endBlock);
+		}
+
 		Nucleus::setInsertBlock(loopBlock);
 
 		iteration[loopDepth] = iteration[loopDepth] - 1;   // FIXME: --
 
+		loopRepIfDepth[loopRepDepth] = ifDepth;
 		loopRepDepth++;
 	}
 
@@ -1634,9 +1934,14 @@ namespace sw
 	{
 		loopDepth++;
 
-		iteration[loopDepth] = *Pointer<Int>(data + OFFSET(DrawData, ps.i[integerRegister.index][0]));
+		iteration[loopDepth] = integerConstant(integerRegister, 0);
 		aL[loopDepth] = aL[loopDepth - 1];
 
+		if(unrollIterations[unrollDepth++] > 0)
+		{
+			return;   // The body gets emitted once per iteration
+		}
+
 		BasicBlock *loopBlock = Nucleus::createBasicBlock();
 		BasicBlock *testBlock = Nucleus::createBasicBlock();
 		BasicBlock *endBlock = Nucleus::createBasicBlock();
@@ -1648,11 +1953,20 @@ namespace sw
 		Nucleus::createBr(testBlock);
 		Nucleus::setInsertBlock(testBlock);
 
-		branch(iteration[loopDepth] > 0, loopBlock, endBlock);
+		if(shader->containsBreakInstruction())
+		{
+			branch(iteration[loopDepth] > 0 && anyNotBroken(0), loopBlock, endBlock);
+		}
+		else
+		{
+			branch(iteration[loopDepth] > 0, loopBlock, endBlock);
+		}
+
 		Nucleus::setInsertBlock(loopBlock);
 
 		iteration[loopDepth] = iteration[loopDepth] - 1;   // FIXME: --
 
+		loopRepIfDepth[loopRepDepth] = ifDepth;
 		loopRepDepth++;
 	}
 
@@ -1690,6 +2004,7 @@ namespace sw
 
 		Nucleus::setInsertBlock(loopBlock);
 
+		loopRepIfDepth[loopRepDepth] = ifDepth;
 		loopRepDepth++;
 	}
 
@@ -1699,6 +2014,7 @@ namespace sw
 
 		loopRepTestBlock[loopRepDepth] = nullptr;
 		loopRepEndBlock[loopRepDepth] = endBlock;
+		loopRepIfDepth[loopRepDepth] = ifDepth;
 
 		Int4 restoreBreak = enableBreak;
 
@@ -25,7 +25,7 @@ namespace sw
 	public:
 		PixelProgram(const PixelProcessor::State &state, const PixelShader *shader) :
 			PixelRoutine(state, shader), r(shader->dynamicallyIndexedTemporaries),
-			loopDepth(-1), ifDepth(0), loopRepDepth(0), currentLabel(-1), whileTest(false)
+			loopDepth(-1), ifDepth(0), loopRepDepth(0), currentLabel(-1), whileTest(false), unrollDepth(0), lodCoordinates(nullptr)
 		{
 			for(int i = 0; i < 2048; ++i)
 			{
@@ -89,12 +89,18 @@ namespace sw
 		void clampColor(Vector4f oC[RENDERTARGETS]);
 
 		Int4 enableMask(const Shader::Instruction *instruction);
+		RValue<Bool> anyNotBroken(int nesting);
+		void excludeExitedLanes(Int4 &condition);
+		void skipBrokenIteration();
 
 		Vector4f fetchRegister(const Src &src, unsigned int offset = 0);
 		Vector4f readConstant(const Src &src, unsigned int offset = 0);
 		RValue<Pointer<Byte>> uniformAddress(int bufferIndex, unsigned int index);
 		RValue<Pointer<Byte>> uniformAddress(int bufferIndex, unsigned int index, Int& offset);
 		Int relativeAddress(const Shader::Parameter &var, int bufferIndex = -1);
+		RValue<Bool> booleanConstant(const Src &boolRegister);
+		RValue<Int> integerConstant(const Src &integerRegister, int component);
+		int unrolledIterations(size_t loop) const;
 
 		Float4 linearToSRGB(const Float4 &x);
 
@@ -160,10 +166,34 @@ namespace sw
 		BasicBlock *ifFalseBlock[24 + 24];
 		BasicBlock *loopRepTestBlock[4];
 		BasicBlock *loopRepEndBlock[4];
+		int loopRepIfDepth[4];
 		BasicBlock *labelBlock[2048];
 		std::vector<BasicBlock*> callRetBlock[2048];
 		BasicBlock *returnBlock;
 		bool isConditionalIf[24 + 24];
+
+		// Loops with specialized iteration counts
+		int unrollDepth;
+		size_t unrollStart[4];
+		int unrollIterations[4];   // Iterations left to emit, or -1 for regular loops
+		int unrollIfDepth[4];
+		BasicBlock *unrollEndBlock[4];
+
+		// Level of detail shared by implicit samples at the same coordinates
+		struct SharedLod
+		{
+			Src coordinates;
+			int sampler;   // Last sampler it was computed for
+			FilterType filter;
+			LodCache cache;
+		};
+
+		SharedLod sharedLod[4];
+		const Src *lodCoordinates;   // Coordinates of the sample being emitted, if its LOD can be shared
+
+		LodCache *findSharedLod(int samplerIndex);
+		void invalidateSharedLod(const Dst &dst);
+		void invalidateSharedLod();
 	};
 }
 
@@ -29,6 +29,8 @@ namespace sw
 
 		if(ps)   // Make a copy
 		{
+			shaderModel = ps->shaderModel;
+
 			for(size_t i = 0; i < ps->getLength(); i++)
 			{
 				append(new sw::Shader::Instruction(*ps->getInstruction(i)));
@@ -157,6 +159,7 @@ namespace sw
 		analyzeKill();
 		analyzeInterpolants();
 		analyzeDirtyConstants();
+		analyzeControlConstants();
 		analyzeDynamicBranching();
 		analyzeSamplers();
 		analyzeCallSites();
@@ -52,7 +52,7 @@ namespace sw
 {
 	extern bool colorsDefaultToZero;
 
-	SamplerCore::SamplerCore(Pointer<Byte> &constants, const Sampler::State &state) : constants(constants), state(state)
+	SamplerCore::SamplerCore(Pointer<Byte> &constants, const Sampler::State &state, LodCache *lodCache) : constants(constants), state(state), lodCache(lodCache)
 	{
 	}
 
@@ -106,7 +106,7 @@ namespace sw
 			{
 				if(state.textureType != TEXTURE_CUBE)
 				{
-					computeLod(texture, lod, anisotropy, uDelta, vDelta, uuuu, vvvv, bias.x, dsx, dsy, function);
+					computeSharedLod(texture, lod, anisotropy, uDelta, vDelta, uuuu, vvvv, bias.x, dsx, dsy, function);
 				}
 				else
 				{
@@ -315,7 +315,7 @@ namespace sw
 				{
 					if(state.textureType != TEXTURE_CUBE)
 					{
-						computeLod(texture, lod, anisotropy, uDelta, vDelta, uuuu, vvvv, bias.x, dsx, dsy, function);
+						computeSharedLod(texture, lod, anisotropy, uDelta, vDelta, uuuu, vvvv, bias.x, dsx, dsy, function);
 					}
 					else
 					{
@@ -1451,6 +1451,78 @@ namespace sw
 		lod = Min(lod, *Pointer<Float>(texture + OFFSET(Texture, maxLod)));
 	}
 
+	// Takes the level of detail from an earlier sample at the same coordinates when its texture has the
+	// same dimensions and LOD clamping, as is common for material textures sharing one set of UVs
+	void SamplerCore::computeSharedLod(Pointer<Byte> &texture, Float &lod, Float &anisotropy, Float4 &uDelta, Float4 &vDelta, Float4 &uuuu, Float4 &vvvv, const Float &lodBias, Vector4f &dsx, Vector4f &dsy, SamplerFunction function)
+	{
+		if(!lodCache || function.method != Implicit)
+		{
+			computeLod(texture, lod, anisotropy, uDelta, vDelta, uuuu, vvvv, lodBias, dsx, dsy, function);
+			return;
+		}
+
+		bool anisotropic = (state.textureFilter == FILTER_ANISOTROPIC);
+
+		if(lodCache->valid && lodCache->sameTexture)
+		{
+			lod = lodCache->lod;
+
+			if(anisotropic)
+			{
+				anisotropy = lodCache->anisotropy;
+				uDelta = lodCache->uDelta;
+				vDelta = lodCache->vDelta;
+			}
+
+			return;
+		}
+
+		Float4 widthHeightLOD = *Pointer<Float4>(texture + OFFSET(Texture,widthHeightLOD));
+		Float minLod = *Pointer<Float>(texture + OFFSET(Texture,minLod));
+		Float maxLod = *Pointer<Float>(texture + OFFSET(Texture,maxLod));
+		Float maxAnisotropy = *Pointer<Float>(texture + OFFSET(Texture,maxAnisotropy));
+
+		if(lodCache->valid)
+		{
+			Bool differs = SignMask(CmpNEQ(widthHeightLOD, lodCache->widthHeightLOD)) != 0 ||
+			               minLod != lodCache->minLod || maxLod != lodCache->maxLod;
+
+			if(anisotropic)
+			{
+				differs = differs || maxAnisotropy != lodCache->maxAnisotropy;
+			}
+
+			lod = lodCache->lod;
+			anisotropy = lodCache->anisotropy;
+			uDelta = lodCache->uDelta;
+			vDelta = lodCache->vDelta;
+
+			If(differs)
+			{
+				computeLod(texture, lod, anisotropy, uDelta, vDelta, uuuu, vvvv, lodBias, dsx, dsy, function);
+			}
+		}
+		else
+		{
+			computeLod(texture, lod, anisotropy, uDelta, vDelta, uuuu, vvvv, lodBias, dsx, dsy, function);
+		}
+
+		lodCache->lod = lod;
+		lodCache->widthHeightLOD = widthHeightLOD;
+		lodCache->minLod = minLod;
+		lodCache->maxLod = maxLod;
+		lodCache->maxAnisotropy = maxAnisotropy;
+
+		if(anisotropic)
+		{
+			lodCache->anisotropy = anisotropy;
+			lodCache->uDelta = uDelta;
+			lodCache->vDelta = vDelta;
+		}
+
+		lodCache->valid = true;
+	}
+
 	void SamplerCore::computeLodCube(Pointer<Byte> &texture, Float &lod, Float4 &u, Float4 &v, Float4 &w, const Float &lodBias, Vector4f &dsx, Vector4f &dsy, Float4 &M, SamplerFunction function)
 	{
 		if(function != Lod && function != Fetch)
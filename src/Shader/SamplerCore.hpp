@@ -46,10 +46,30 @@ namespace sw
 		const SamplerOption option;
  	};
 
+	// Level of detail computed by an earlier implicit sample at the same coordinates
+	struct LodCache
+	{
+		LodCache() : valid(false), sameTexture(false) {}
+
+		bool valid;         // Computed on the code path being generated
+		bool sameTexture;   // Computed for the texture being sampled
+
+		Float lod;
+		Float anisotropy;
+		Float4 uDelta;
+		Float4 vDelta;
+
+		// Parameters of the texture it was computed for
+		Float4 widthHeightLOD;
+		Float minLod;
+		Float maxLod;
+		Float maxAnisotropy;
+	};
+
 	class SamplerCore
 	{
 	public:
-		SamplerCore(Pointer<Byte> &constants, const Sampler::State &state);
+		SamplerCore(Pointer<Byte> &constants, const Sampler::State &state, LodCache *lodCache = nullptr);
 
 		Vector4s sampleTexture(Pointer<Byte> &texture, Float4 &u, Float4 &v, Float4 &w, Float4 &q, Float4 &bias, Vector4f &dsx, Vector4f &dsy);
 		Vector4f sampleTexture(Pointer<Byte> &texture, Float4 &u, Float4 &v, Float4 &w, Float4 &q, Float4 &bias, Vector4f &dsx, Vector4f &dsy, Vector4f &offset, SamplerFunction function);
@@ -74,6 +94,7 @@ namespace sw
 		Float log2sqrt(Float lod);
 		Float log2(Float lod);
 		void computeLod(Pointer<Byte> &texture, Float &lod, Float &anisotropy, Float4 &uDelta, Float4 &vDelta, Float4 &u, Float4 &v, const Float &lodBias, Vector4f &dsx, Vector4f &dsy, SamplerFunction function);
+		void computeSharedLod(Pointer<Byte> &texture, Float &lod, Float &anisotropy, Float4 &uDelta, Float4 &vDelta, Float4 &u, Float4 &v, const Float &lodBias, Vector4f &dsx, Vector4f &dsy, SamplerFunction function);
 		void computeLodCube(Pointer<Byte> &texture, Float &lod, Float4 &u, Float4 &v, Float4 &w, const Float &lodBias, Vector4f &dsx, Vector4f &dsy, Float4 &M, SamplerFunction function);
 		void computeLod3D(Pointer<Byte> &texture, Float &lod, Float4 &u, Float4 &v, Float4 &w, const Float &lodBias, Vector4f &dsx, Vector4f &dsy, SamplerFunction function);
 		void cubeFace(Int face[4], Float4 &U, Float4 &V, Float4 &x, Float4 &y, Float4 &z, Float4 &M);
@@ -111,6 +132,7 @@ namespace sw
 
 		Pointer<Byte> &constants;
 		const Sampler::State &state;
+		LodCache *lodCache;
 	};
 }
 
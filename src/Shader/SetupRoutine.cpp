@@ -35,168 +35,280 @@ namespace sw
 	{
 	}
 
-	void SetupRoutine::generate()
+	void SetupRoutine::generate(OptimizationLevel level)
 	{
-		Function<Bool(Pointer<Byte>, Pointer<Byte>, Pointer<Byte>, Pointer<Byte>)> function;
+		Function<Int(Pointer<Byte>, Pointer<Byte>, Pointer<Byte>, Pointer<Byte>, Int)> function;
 		{
 			Pointer<Byte> primitive(function.Arg<0>());
 			Pointer<Byte> tri(function.Arg<1>());
 			Pointer<Byte> polygon(function.Arg<2>());
 			Pointer<Byte> data(function.Arg<3>());
+			Int count(function.Arg<4>());
 
-			Pointer<Byte> constants = *Pointer<Pointer<Byte> >(data + OFFSET(DrawData,constants));
+			NoAlias(data);
 
-			const bool point = state.isDrawPoint;
-			const bool sprite = state.pointSprite;
-			const bool line = state.isDrawLine;
-			const bool triangle = state.isDrawSolidTriangle || sprite;
-			const bool solidTriangle = state.isDrawSolidTriangle;
+			Int visible = 0;
 
-			const int V0 = OFFSET(Triangle,v0);
-			const int V1 = (triangle || line) ? OFFSET(Triangle,v1) : OFFSET(Triangle,v0);
-			const int V2 = triangle ? OFFSET(Triangle,v2) : (line ? OFFSET(Triangle,v1) : OFFSET(Triangle,v0));
+			Do
+			{
+				// Reject four triangles at a time, then set up the survivors one by one
+				Int survivors = cull(tri, polygon, data, count);
+				Pointer<Byte> triangle = tri;
 
-			int pos = state.positionRegister;
+				While(survivors != 0)
+				{
+					If((survivors & 1) != 0)
+					{
+						Bool rasterized = false;
 
-			Pointer<Byte> v0 = tri + V0;
-			Pointer<Byte> v1 = tri + V1;
-			Pointer<Byte> v2 = tri + V2;
+						setupPrimitive(primitive, triangle, polygon, data, rasterized);
 
-			Array<Int> X(16);
-			Array<Int> Y(16);
+						If(rasterized)
+						{
+							primitive += state.multiSample * sizeof(Primitive);
+							visible++;
+						}
+					}
 
-			X[0] = *Pointer<Int>(v0 + OFFSET(Vertex,X));
-			X[1] = *Pointer<Int>(v1 + OFFSET(Vertex,X));
-			X[2] = *Pointer<Int>(v2 + OFFSET(Vertex,X));
+					survivors = survivors >> 1;
+					triangle += sizeof(Triangle);
+				}
 
-			Y[0] = *Pointer<Int>(v0 + OFFSET(Vertex,Y));
-			Y[1] = *Pointer<Int>(v1 + OFFSET(Vertex,Y));
-			Y[2] = *Pointer<Int>(v2 + OFFSET(Vertex,Y));
+				tri += 4 * sizeof(Triangle);
+				count -= 4;
+			}
+			Until(count <= 0)
 
-			Int d = 1;     // Winding direction
+			Return(visible);
+		}
 
-			// Culling
-			if(solidTriangle)
-			{
-				Float x0 = Float(X[0]);
-				Float x1 = Float(X[1]);
-				Float x2 = Float(X[2]);
+		routine = function(level, L"SetupRoutine");
+	}
 
-				Float y0 = Float(Y[0]);
-				Float y1 = Float(Y[1]);
-				Float y2 = Float(Y[2]);
+	Int SetupRoutine::cull(Pointer<Byte> &tri, Pointer<Byte> &polygon, Pointer<Byte> &data, Int &count)
+	{
+		Int survivors = SignMask(CmpLT(Int4(0, 1, 2, 3), Int4(count)));
 
-				Float A = (y2 - y0) * x1 + (y1 - y2) * x0 + (y0 - y1) * x2;   // Area
+		if(!state.isDrawSolidTriangle)
+		{
+			return survivors;
+		}
 
-				If(A == 0.0f)
-				{
-					Return(false);
-				}
+		const int pos = state.positionRegister;
 
-				Int w0w1w2 = *Pointer<Int>(v0 + pos * 16 + 12) ^
-							 *Pointer<Int>(v1 + pos * 16 + 12) ^
-							 *Pointer<Int>(v2 + pos * 16 + 12);
+		Int4 X0, X1, X2;
+		Int4 Y0, Y1, Y2;
+		Int4 w0w1w2;
 
-				A = IfThenElse(w0w1w2 < 0, -A, A);
+		for(int i = 0; i < 4; i++)
+		{
+			// Lanes past the end of the batch repeat the first triangle
+			Pointer<Byte> triangle = IfThenElse(Int(i) < count, tri + i * sizeof(Triangle), tri);
+			Pointer<Byte> v0 = triangle + OFFSET(Triangle,v0);
+			Pointer<Byte> v1 = triangle + OFFSET(Triangle,v1);
+			Pointer<Byte> v2 = triangle + OFFSET(Triangle,v2);
+
+			X0 = Insert(X0, *Pointer<Int>(v0 + OFFSET(Vertex,X)), i);
+			X1 = Insert(X1, *Pointer<Int>(v1 + OFFSET(Vertex,X)), i);
+			X2 = Insert(X2, *Pointer<Int>(v2 + OFFSET(Vertex,X)), i);
+
+			Y0 = Insert(Y0, *Pointer<Int>(v0 + OFFSET(Vertex,Y)), i);
+			Y1 = Insert(Y1, *Pointer<Int>(v1 + OFFSET(Vertex,Y)), i);
+			Y2 = Insert(Y2, *Pointer<Int>(v2 + OFFSET(Vertex,Y)), i);
+
+			w0w1w2 = Insert(w0w1w2, *Pointer<Int>(v0 + pos * 16 + 12) ^
+			                        *Pointer<Int>(v1 + pos * 16 + 12) ^
+			                        *Pointer<Int>(v2 + pos * 16 + 12), i);
+		}
 
-				if(state.cullMode == CULL_CLOCKWISE)
-				{
-					If(A >= 0.0f) Return(false);
-				}
-				else if(state.cullMode == CULL_COUNTERCLOCKWISE)
-				{
-					If(A <= 0.0f) Return(false);
-				}
+		Float4 x0 = Float4(X0);
+		Float4 x1 = Float4(X1);
+		Float4 x2 = Float4(X2);
 
-				d = IfThenElse(A < 0.0f, d, Int(0));
+		Float4 y0 = Float4(Y0);
+		Float4 y1 = Float4(Y1);
+		Float4 y2 = Float4(Y2);
 
-				if(state.twoSidedStencil)
-				{
-					If(A > 0.0f)
-					{
-						*Pointer<Byte8>(primitive + OFFSET(Primitive,clockwiseMask)) = Byte8(0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF);
-						*Pointer<Byte8>(primitive + OFFSET(Primitive,invClockwiseMask)) = Byte8(0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00);
-					}
-					Else
-					{
-						*Pointer<Byte8>(primitive + OFFSET(Primitive,clockwiseMask)) = Byte8(0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00);
-						*Pointer<Byte8>(primitive + OFFSET(Primitive,invClockwiseMask)) = Byte8(0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF);
-					}
-				}
+		Float4 A = (y2 - y0) * x1 + (y1 - y2) * x0 + (y0 - y1) * x2;   // Area
 
-				if(state.vFace)
-				{
-					*Pointer<Float>(primitive + OFFSET(Primitive,area)) = 0.5f * A;
-				}
+		Int4 visible = ~CmpEQ(A, Float4(0.0f));
+
+		A = As<Float4>(As<Int4>(A) ^ (w0w1w2 & Int4(0x80000000)));
+
+		if(state.cullMode == CULL_CLOCKWISE)
+		{
+			visible &= CmpNLE(Float4(0.0f), A);
+		}
+		else if(state.cullMode == CULL_COUNTERCLOCKWISE)
+		{
+			visible &= CmpNLE(A, Float4(0.0f));
+		}
+
+		// Vertical range, which clipped polygons recompute after reprojection
+		If(*Pointer<Int>(polygon + OFFSET(Polygon,i)) == 0)
+		{
+			Int4 yMin = Min(Min(Y0, Y1), Y2);
+			Int4 yMax = Max(Max(Y0, Y1), Y2);
+
+			if(state.multiSample > 1)
+			{
+				yMin = (yMin + Int4(0x0A)) >> 4;
+				yMax = (yMax + Int4(0x14)) >> 4;
 			}
 			else
 			{
-				if(state.twoSidedStencil)
-				{
-					*Pointer<Byte8>(primitive + OFFSET(Primitive,clockwiseMask)) = Byte8(0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF);
-					*Pointer<Byte8>(primitive + OFFSET(Primitive,invClockwiseMask)) = Byte8(0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00);
-				}
+				yMin = (yMin + Int4(0x0F)) >> 4;
+				yMax = (yMax + Int4(0x0F)) >> 4;
 			}
 
-			Int n = *Pointer<Int>(polygon + OFFSET(Polygon,n));
-			Int m = *Pointer<Int>(polygon + OFFSET(Polygon,i));
+			yMin = Max(yMin, Int4(*Pointer<Int>(data + OFFSET(DrawData,scissorY0))));
+			yMax = Min(yMax, Int4(*Pointer<Int>(data + OFFSET(DrawData,scissorY1))));
 
-			If(m != 0 || Bool(!solidTriangle))   // Clipped triangle; reproject
-			{
-				Pointer<Byte> V = polygon + OFFSET(Polygon,P) + m * sizeof(void*) * 16;
+			visible &= CmpLT(yMin, yMax);
+		}
 
-				Int i = 0;
+		return survivors & SignMask(visible);
+	}
 
-				Do
-				{
-					Pointer<Float4> p = *Pointer<Pointer<Float4> >(V + i * sizeof(void*));
-					Float4 v = *Pointer<Float4>(p, 16);
+	void SetupRoutine::setupPrimitive(Pointer<Byte> &primitive, Pointer<Byte> &tri, Pointer<Byte> &polygon, Pointer<Byte> &data, Bool &visible)
+	{
+		Pointer<Byte> constants = *Pointer<Pointer<Byte> >(data + OFFSET(DrawData,constants));
+		NoAlias(constants);
 
-					Float w = v.w;
-					Float rhw = IfThenElse(w != 0.0f, 1.0f / w, Float(1.0f));
+		const bool point = state.isDrawPoint;
+		const bool sprite = state.pointSprite;
+		const bool line = state.isDrawLine;
+		const bool triangle = state.isDrawSolidTriangle || sprite;
+		const bool solidTriangle = state.isDrawSolidTriangle;
 
-					X[i] = RoundInt(*Pointer<Float>(data + OFFSET(DrawData,X0x16)) + v.x * rhw * *Pointer<Float>(data + OFFSET(DrawData,Wx16)));
-					Y[i] = RoundInt(*Pointer<Float>(data + OFFSET(DrawData,Y0x16)) + v.y * rhw * *Pointer<Float>(data + OFFSET(DrawData,Hx16)));
+		const int V0 = OFFSET(Triangle,v0);
+		const int V1 = (triangle || line) ? OFFSET(Triangle,v1) : OFFSET(Triangle,v0);
+		const int V2 = triangle ? OFFSET(Triangle,v2) : (line ? OFFSET(Triangle,v1) : OFFSET(Triangle,v0));
 
-					i++;
-				}
-				Until(i >= n)
-			}
+		int pos = state.positionRegister;
 
-			// Vertical range
-			Int yMin = Y[0];
-			Int yMax = Y[0];
+		Pointer<Byte> v0 = tri + V0;
+		Pointer<Byte> v1 = tri + V1;
+		Pointer<Byte> v2 = tri + V2;
 
-			Int i = 1;
+		Array<Int> X(16);
+		Array<Int> Y(16);
 
-			Do
-			{
-				yMin = Min(Y[i], yMin);
-				yMax = Max(Y[i], yMax);
+		X[0] = *Pointer<Int>(v0 + OFFSET(Vertex,X));
+		X[1] = *Pointer<Int>(v1 + OFFSET(Vertex,X));
+		X[2] = *Pointer<Int>(v2 + OFFSET(Vertex,X));
 
-				i++;
+		Y[0] = *Pointer<Int>(v0 + OFFSET(Vertex,Y));
+		Y[1] = *Pointer<Int>(v1 + OFFSET(Vertex,Y));
+		Y[2] = *Pointer<Int>(v2 + OFFSET(Vertex,Y));
+
+		Int d = 1;     // Winding direction
+
+		// Culling (rejection happens in cull())
+		if(solidTriangle)
+		{
+			Float x0 = Float(X[0]);
+			Float x1 = Float(X[1]);
+			Float x2 = Float(X[2]);
+
+			Float y0 = Float(Y[0]);
+			Float y1 = Float(Y[1]);
+			Float y2 = Float(Y[2]);
+
+			Float A = (y2 - y0) * x1 + (y1 - y2) * x0 + (y0 - y1) * x2;   // Area
+
+			Int w0w1w2 = *Pointer<Int>(v0 + pos * 16 + 12) ^
+						 *Pointer<Int>(v1 + pos * 16 + 12) ^
+						 *Pointer<Int>(v2 + pos * 16 + 12);
+
+			A = IfThenElse(w0w1w2 < 0, -A, A);
+
+			d = IfThenElse(A < 0.0f, d, Int(0));
+
+			if(state.twoSidedStencil)
+			{
+				If(A > 0.0f)
+				{
+					*Pointer<Byte8>(primitive + OFFSET(Primitive,clockwiseMask)) = Byte8(0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF);
+					*Pointer<Byte8>(primitive + OFFSET(Primitive,invClockwiseMask)) = Byte8(0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00);
+				}
+				Else
+				{
+					*Pointer<Byte8>(primitive + OFFSET(Primitive,clockwiseMask)) = Byte8(0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00);
+					*Pointer<Byte8>(primitive + OFFSET(Primitive,invClockwiseMask)) = Byte8(0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF);
+				}
 			}
-			Until(i >= n)
 
-			if(state.multiSample > 1)
+			if(state.vFace)
 			{
-				yMin = (yMin + 0x0A) >> 4;
-				yMax = (yMax + 0x14) >> 4;
+				*Pointer<Float>(primitive + OFFSET(Primitive,area)) = 0.5f * A;
 			}
-			else
+		}
+		else
+		{
+			if(state.twoSidedStencil)
 			{
-				yMin = (yMin + 0x0F) >> 4;
-				yMax = (yMax + 0x0F) >> 4;
+				*Pointer<Byte8>(primitive + OFFSET(Primitive,clockwiseMask)) = Byte8(0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF);
+				*Pointer<Byte8>(primitive + OFFSET(Primitive,invClockwiseMask)) = Byte8(0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00);
 			}
+		}
+
+		Int n = *Pointer<Int>(polygon + OFFSET(Polygon,n));
+		Int m = *Pointer<Int>(polygon + OFFSET(Polygon,i));
+
+		If(m != 0 || Bool(!solidTriangle))   // Clipped triangle; reproject
+		{
+			Pointer<Byte> V = polygon + OFFSET(Polygon,P) + m * sizeof(void*) * 16;
 
-			If(yMin == yMax)
+			Int i = 0;
+
+			Do
 			{
-				Return(false);
+				Pointer<Float4> p = *Pointer<Pointer<Float4> >(V + i * sizeof(void*));
+				Float4 v = *Pointer<Float4>(p, 16);
+
+				Float w = v.w;
+				Float rhw = IfThenElse(w != 0.0f, 1.0f / w, Float(1.0f));
+
+				X[i] = RoundInt(*Pointer<Float>(data + OFFSET(DrawData,X0x16)) + v.x * rhw * *Pointer<Float>(data + OFFSET(DrawData,Wx16)));
+				Y[i] = RoundInt(*Pointer<Float>(data + OFFSET(DrawData,Y0x16)) + v.y * rhw * *Pointer<Float>(data + OFFSET(DrawData,Hx16)));
+
+				i++;
 			}
+			Until(i >= n)
+		}
+
+		// Vertical range
+		Int yMin = Y[0];
+		Int yMax = Y[0];
+
+		Int i = 1;
+
+		Do
+		{
+			yMin = Min(Y[i], yMin);
+			yMax = Max(Y[i], yMax);
+
+			i++;
+		}
+		Until(i >= n)
+
+		if(state.multiSample > 1)
+		{
+			yMin = (yMin + 0x0A) >> 4;
+			yMax = (yMax + 0x14) >> 4;
+		}
+		else
+		{
+			yMin = (yMin + 0x0F) >> 4;
+			yMax = (yMax + 0x0F) >> 4;
+		}
 
-			yMin = Max(yMin, *Pointer<Int>(data + OFFSET(DrawData,scissorY0)));
-			yMax = Min(yMax, *Pointer<Int>(data + OFFSET(DrawData,scissorY1)));
+		yMin = Max(yMin, *Pointer<Int>(data + OFFSET(DrawData,scissorY0)));
+		yMax = Min(yMax, *Pointer<Int>(data + OFFSET(DrawData,scissorY1)));
 
+		If(yMin < yMax)   // Not outside of the scissor rectangle, e.g. within the guard band
+		{
 			For(Int q = 0, q < state.multiSample, q++)
 			{
 				Array<Int> Xq(16);
@@ -263,220 +375,219 @@ namespace sw
 						// Decrements yMax
 					}
 
-					If(yMin == yMax)
+					If(yMin < yMax)
 					{
-						Return(false);
+						*Pointer<Short>(leftEdge + (yMin - 1) * sizeof(Primitive::Span)) = *Pointer<Short>(leftEdge + yMin * sizeof(Primitive::Span));
+						*Pointer<Short>(rightEdge + (yMin - 1) * sizeof(Primitive::Span)) = *Pointer<Short>(leftEdge + yMin * sizeof(Primitive::Span));
+						*Pointer<Short>(leftEdge + yMax * sizeof(Primitive::Span)) = *Pointer<Short>(leftEdge + (yMax - 1) * sizeof(Primitive::Span));
+						*Pointer<Short>(rightEdge + yMax * sizeof(Primitive::Span)) = *Pointer<Short>(leftEdge + (yMax - 1) * sizeof(Primitive::Span));
 					}
-
-					*Pointer<Short>(leftEdge + (yMin - 1) * sizeof(Primitive::Span)) = *Pointer<Short>(leftEdge + yMin * sizeof(Primitive::Span));
-					*Pointer<Short>(rightEdge + (yMin - 1) * sizeof(Primitive::Span)) = *Pointer<Short>(leftEdge + yMin * sizeof(Primitive::Span));
-					*Pointer<Short>(leftEdge + yMax * sizeof(Primitive::Span)) = *Pointer<Short>(leftEdge + (yMax - 1) * sizeof(Primitive::Span));
-					*Pointer<Short>(rightEdge + yMax * sizeof(Primitive::Span)) = *Pointer<Short>(leftEdge + (yMax - 1) * sizeof(Primitive::Span));
 				}
 			}
 
-			*Pointer<Int>(primitive + OFFSET(Primitive,yMin)) = yMin;
-			*Pointer<Int>(primitive + OFFSET(Primitive,yMax)) = yMax;
-
-			// Sort by minimum y
-			if(solidTriangle && logPrecision >= WHQL)
+			If(yMin < yMax)
 			{
-				Float y0 = *Pointer<Float>(v0 + pos * 16 + 4);
-				Float y1 = *Pointer<Float>(v1 + pos * 16 + 4);
-				Float y2 = *Pointer<Float>(v2 + pos * 16 + 4);
+				*Pointer<Int>(primitive + OFFSET(Primitive,yMin)) = yMin;
+				*Pointer<Int>(primitive + OFFSET(Primitive,yMax)) = yMax;
 
-				Float yMin = Min(Min(y0, y1), y2);
+				// Sort by minimum y
+				if(solidTriangle && logPrecision >= WHQL)
+				{
+					Float y0 = *Pointer<Float>(v0 + pos * 16 + 4);
+					Float y1 = *Pointer<Float>(v1 + pos * 16 + 4);
+					Float y2 = *Pointer<Float>(v2 + pos * 16 + 4);
 
-				conditionalRotate1(yMin == y1, v0, v1, v2);
-				conditionalRotate2(yMin == y2, v0, v1, v2);
-			}
+					Float yMin = Min(Min(y0, y1), y2);
 
-			// Sort by maximum w
-			if(solidTriangle)
-			{
-				Float w0 = *Pointer<Float>(v0 + pos * 16 + 12);
-				Float w1 = *Pointer<Float>(v1 + pos * 16 + 12);
-				Float w2 = *Pointer<Float>(v2 + pos * 16 + 12);
+					conditionalRotate1(yMin == y1, v0, v1, v2);
+					conditionalRotate2(yMin == y2, v0, v1, v2);
+				}
 
-				Float wMax = Max(Max(w0, w1), w2);
+				// Sort by maximum w
+				if(solidTriangle)
+				{
+					Float w0 = *Pointer<Float>(v0 + pos * 16 + 12);
+					Float w1 = *Pointer<Float>(v1 + pos * 16 + 12);
+					Float w2 = *Pointer<Float>(v2 + pos * 16 + 12);
 
-				conditionalRotate1(wMax == w1, v0, v1, v2);
-				conditionalRotate2(wMax == w2, v0, v1, v2);
-			}
+					Float wMax = Max(Max(w0, w1), w2);
 
-			Float w0 = *Pointer<Float>(v0 + pos * 16 + 12);
-			Float w1 = *Pointer<Float>(v1 + pos * 16 + 12);
-			Float w2 = *Pointer<Float>(v2 + pos * 16 + 12);
+					conditionalRotate1(wMax == w1, v0, v1, v2);
+					conditionalRotate2(wMax == w2, v0, v1, v2);
+				}
 
-			Float4 w012;
+				Float w0 = *Pointer<Float>(v0 + pos * 16 + 12);
+				Float w1 = *Pointer<Float>(v1 + pos * 16 + 12);
+				Float w2 = *Pointer<Float>(v2 + pos * 16 + 12);
 
-			w012.x = w0;
-			w012.y = w1;
-			w012.z = w2;
-			w012.w = 1;
+				Float4 w012;
 
-			Float rhw0 = *Pointer<Float>(v0 + OFFSET(Vertex,W));
+				w012.x = w0;
+				w012.y = w1;
+				w012.z = w2;
+				w012.w = 1;
 
-			Int X0 = *Pointer<Int>(v0 + OFFSET(Vertex,X));
-			Int X1 = *Pointer<Int>(v1 + OFFSET(Vertex,X));
-			Int X2 = *Pointer<Int>(v2 + OFFSET(Vertex,X));
+				Float rhw0 = *Pointer<Float>(v0 + OFFSET(Vertex,W));
 
-			Int Y0 = *Pointer<Int>(v0 + OFFSET(Vertex,Y));
-			Int Y1 = *Pointer<Int>(v1 + OFFSET(Vertex,Y));
-			Int Y2 = *Pointer<Int>(v2 + OFFSET(Vertex,Y));
+				Int X0 = *Pointer<Int>(v0 + OFFSET(Vertex,X));
+				Int X1 = *Pointer<Int>(v1 + OFFSET(Vertex,X));
+				Int X2 = *Pointer<Int>(v2 + OFFSET(Vertex,X));
 
-			if(line)
-			{
-				X2 = X1 + Y1 - Y0;
-				Y2 = Y1 + X0 - X1;
-			}
+				Int Y0 = *Pointer<Int>(v0 + OFFSET(Vertex,Y));
+				Int Y1 = *Pointer<Int>(v1 + OFFSET(Vertex,Y));
+				Int Y2 = *Pointer<Int>(v2 + OFFSET(Vertex,Y));
 
-			Float dx = Float(X0) * (1.0f / 16.0f);
-			Float dy = Float(Y0) * (1.0f / 16.0f);
+				if(line)
+				{
+					X2 = X1 + Y1 - Y0;
+					Y2 = Y1 + X0 - X1;
+				}
 
-			X1 -= X0;
-			Y1 -= Y0;
+				Float dx = Float(X0) * (1.0f / 16.0f);
+				Float dy = Float(Y0) * (1.0f / 16.0f);
 
-			X2 -= X0;
-			Y2 -= Y0;
+				X1 -= X0;
+				Y1 -= Y0;
 
-			Float x1 = w1 * (1.0f / 16.0f) * Float(X1);
-			Float y1 = w1 * (1.0f / 16.0f) * Float(Y1);
+				X2 -= X0;
+				Y2 -= Y0;
 
-			Float x2 = w2 * (1.0f / 16.0f) * Float(X2);
-			Float y2 = w2 * (1.0f / 16.0f) * Float(Y2);
+				Float x1 = w1 * (1.0f / 16.0f) * Float(X1);
+				Float y1 = w1 * (1.0f / 16.0f) * Float(Y1);
 
-			Float a = x1 * y2 - x2 * y1;
+				Float x2 = w2 * (1.0f / 16.0f) * Float(X2);
+				Float y2 = w2 * (1.0f / 16.0f) * Float(Y2);
 
-			Float4 xQuad = Float4(0, 1, 0, 1) - Float4(dx);
-			Float4 yQuad = Float4(0, 0, 1, 1) - Float4(dy);
+				Float a = x1 * y2 - x2 * y1;
 
-			*Pointer<Float4>(primitive + OFFSET(Primitive,xQuad), 16) = xQuad;
-			*Pointer<Float4>(primitive + OFFSET(Primitive,yQuad), 16) = yQuad;
+				Float4 xQuad = Float4(0, 1, 0, 1) - Float4(dx);
+				Float4 yQuad = Float4(0, 0, 1, 1) - Float4(dy);
 
-			Float4 M[3];
+				*Pointer<Float4>(primitive + OFFSET(Primitive,xQuad), 16) = xQuad;
+				*Pointer<Float4>(primitive + OFFSET(Primitive,yQuad), 16) = yQuad;
 
-			M[0] = Float4(0, 0, 0, 0);
-			M[1] = Float4(0, 0, 0, 0);
-			M[2] = Float4(0, 0, 0, 0);
+				Float4 M[3];
 
-			M[0].z = rhw0;
+				M[0] = Float4(0, 0, 0, 0);
+				M[1] = Float4(0, 0, 0, 0);
+				M[2] = Float4(0, 0, 0, 0);
 
-			If(a != 0.0f)
-			{
-				Float A = 1.0f / a;
-				Float D = A * rhw0;
-
-				M[0].x = (y1 * w2 - y2 * w1) * D;
-				M[0].y = (x2 * w1 - x1 * w2) * D;
-			//	M[0].z = rhw0;
-			//	M[0].w = 0;
-
-				M[1].x = y2 * A;
-				M[1].y = -x2 * A;
-			//	M[1].z = 0;
-			//	M[1].w = 0;
-
-				M[2].x = -y1 * A;
-				M[2].y = x1 * A;
-			//	M[2].z = 0;
-			//	M[2].w = 0;
-			}
+				M[0].z = rhw0;
 
-			if(state.interpolateW)
-			{
-				Float4 ABC = M[0] + M[1] + M[2];
+				If(a != 0.0f)
+				{
+					Float A = 1.0f / a;
+					Float D = A * rhw0;
+
+					M[0].x = (y1 * w2 - y2 * w1) * D;
+					M[0].y = (x2 * w1 - x1 * w2) * D;
+				//	M[0].z = rhw0;
+				//	M[0].w = 0;
+
+					M[1].x = y2 * A;
+					M[1].y = -x2 * A;
+				//	M[1].z = 0;
+				//	M[1].w = 0;
+
+					M[2].x = -y1 * A;
+					M[2].y = x1 * A;
+				//	M[2].z = 0;
+				//	M[2].w = 0;
+				}
 
-				Float4 A = ABC.x;
-				Float4 B = ABC.y;
-				Float4 C = ABC.z;
+				if(state.interpolateW)
+				{
+					Float4 ABC = M[0] + M[1] + M[2];
 
-				*Pointer<Float4>(primitive + OFFSET(Primitive,w.A), 16) = A;
-				*Pointer<Float4>(primitive + OFFSET(Primitive,w.B), 16) = B;
-				*Pointer<Float4>(primitive + OFFSET(Primitive,w.C), 16) = C;
-			}
+					Float4 A = ABC.x;
+					Float4 B = ABC.y;
+					Float4 C = ABC.z;
 
-			if(state.interpolateZ)
-			{
-				Float z0 = *Pointer<Float>(v0 + OFFSET(Vertex,Z));
-				Float z1 = *Pointer<Float>(v1 + OFFSET(Vertex,Z));
-				Float z2 = *Pointer<Float>(v2 + OFFSET(Vertex,Z));
+					*Pointer<Float4>(primitive + OFFSET(Primitive,w.A), 16) = A;
+					*Pointer<Float4>(primitive + OFFSET(Primitive,w.B), 16) = B;
+					*Pointer<Float4>(primitive + OFFSET(Primitive,w.C), 16) = C;
+				}
 
-				z1 -= z0;
-				z2 -= z0;
+				if(state.interpolateZ)
+				{
+					Float z0 = *Pointer<Float>(v0 + OFFSET(Vertex,Z));
+					Float z1 = *Pointer<Float>(v1 + OFFSET(Vertex,Z));
+					Float z2 = *Pointer<Float>(v2 + OFFSET(Vertex,Z));
 
-				Float4 A;
-				Float4 B;
-				Float4 C;
+					z1 -= z0;
+					z2 -= z0;
 
-				if(!point)
-				{
-					Float x1 = Float(X1) * (1.0f / 16.0f);
-					Float y1 = Float(Y1) * (1.0f / 16.0f);
-					Float x2 = Float(X2) * (1.0f / 16.0f);
-					Float y2 = Float(Y2) * (1.0f / 16.0f);
+					Float4 A;
+					Float4 B;
+					Float4 C;
 
-					Float D = *Pointer<Float>(data + OFFSET(DrawData,depthRange)) / (x1 * y2 - x2 * y1);
+					if(!point)
+					{
+						Float x1 = Float(X1) * (1.0f / 16.0f);
+						Float y1 = Float(Y1) * (1.0f / 16.0f);
+						Float x2 = Float(X2) * (1.0f / 16.0f);
+						Float y2 = Float(Y2) * (1.0f / 16.0f);
 
-					Float a = (y2 * z1 - y1 * z2) * D;
-					Float b = (x1 * z2 - x2 * z1) * D;
+						Float D = *Pointer<Float>(data + OFFSET(DrawData,depthRange)) / (x1 * y2 - x2 * y1);
 
-					A = Float4(a);
-					B = Float4(b);
-				}
-				else
-				{
-					A = Float4(0, 0, 0, 0);
-					B = Float4(0, 0, 0, 0);
-				}
+						Float a = (y2 * z1 - y1 * z2) * D;
+						Float b = (x1 * z2 - x2 * z1) * D;
 
-				*Pointer<Float4>(primitive + OFFSET(Primitive,z.A), 16) = A;
-				*Pointer<Float4>(primitive + OFFSET(Primitive,z.B), 16) = B;
+						A = Float4(a);
+						B = Float4(b);
+					}
+					else
+					{
+						A = Float4(0, 0, 0, 0);
+						B = Float4(0, 0, 0, 0);
+					}
 
-				Float c = z0;
+					*Pointer<Float4>(primitive + OFFSET(Primitive,z.A), 16) = A;
+					*Pointer<Float4>(primitive + OFFSET(Primitive,z.B), 16) = B;
 
-				if(state.isDrawTriangle && state.slopeDepthBias)
-				{
-					Float bias = Max(Abs(Float(A.x)), Abs(Float(B.x)));
-					bias *= *Pointer<Float>(data + OFFSET(DrawData,slopeDepthBias));
+					Float c = z0;
 
-					if(complementaryDepthBuffer)
+					if(state.isDrawTriangle && state.slopeDepthBias)
 					{
-						bias = -bias;
-					}
+						Float bias = Max(Abs(Float(A.x)), Abs(Float(B.x)));
+						bias *= *Pointer<Float>(data + OFFSET(DrawData,slopeDepthBias));
 
-					c += bias;
-				}
+						if(complementaryDepthBuffer)
+						{
+							bias = -bias;
+						}
 
-				C = Float4(c * *Pointer<Float>(data + OFFSET(DrawData,depthRange)) + *Pointer<Float>(data + OFFSET(DrawData,depthNear)));
+						c += bias;
+					}
 
-				*Pointer<Float4>(primitive + OFFSET(Primitive,z.C), 16) = C;
-			}
+					C = Float4(c * *Pointer<Float>(data + OFFSET(DrawData,depthRange)) + *Pointer<Float>(data + OFFSET(DrawData,depthNear)));
 
-			for(int interpolant = 0; interpolant < MAX_FRAGMENT_INPUTS; interpolant++)
-			{
-				for(int component = 0; component < 4; component++)
-				{
-					int attribute = state.gradient[interpolant][component].attribute;
-					bool flat = state.gradient[interpolant][component].flat;
-					bool wrap = state.gradient[interpolant][component].wrap;
+					*Pointer<Float4>(primitive + OFFSET(Primitive,z.C), 16) = C;
+				}
 
-					if(attribute != Unused)
+				for(int interpolant = 0; interpolant < MAX_FRAGMENT_INPUTS; interpolant++)
+				{
+					for(int component = 0; component < 4; component++)
 					{
-						setupGradient(primitive, tri, w012, M, v0, v1, v2, OFFSET(Vertex,v[attribute][component]), OFFSET(Primitive,V[interpolant][component]), flat, sprite, state.perspective, wrap, component);
+						int attribute = state.gradient[interpolant][component].attribute;
+						bool flat = state.gradient[interpolant][component].flat;
+						bool wrap = state.gradient[interpolant][component].wrap;
+
+						if(attribute != Unused)
+						{
+							setupGradient(primitive, tri, w012, M, v0, v1, v2, OFFSET(Vertex,v[attribute][component]), OFFSET(Primitive,V[interpolant][component]), flat, sprite, state.perspective, wrap, component);
+						}
 					}
 				}
-			}
 
-			if(state.fog.attribute == Fog)
-			{
-				setupGradient(primitive, tri, w012, M, v0, v1, v2, OFFSET(Vertex,f), OFFSET(Primitive,f), state.fog.flat, false, state.perspective, false, 0);
-			}
+				if(state.fog.attribute == Fog)
+				{
+					setupGradient(primitive, tri, w012, M, v0, v1, v2, OFFSET(Vertex,f), OFFSET(Primitive,f), state.fog.flat, false, state.perspective, false, 0);
+				}
 
-			Return(true);
+				visible = Bool(true);
+			}
 		}
-
-		routine = function(L"SetupRoutine");
 	}
 
 	void SetupRoutine::setupGradient(Pointer<Byte> &primitive, Pointer<Byte> &triangle, Float4 &w012, Float4 (&m)[3], Pointer<Byte> &v0, Pointer<Byte> &v1, Pointer<Byte> &v2, int attribute, int planeEquation, bool flat, bool sprite, bool perspective, bool wrap, int component)
@@ -29,10 +29,12 @@ namespace sw
 
 		virtual ~SetupRoutine();
 
-		void generate();
+		void generate(OptimizationLevel level);
 		Routine *getRoutine();
 
 	private:
+		Int cull(Pointer<Byte> &tri, Pointer<Byte> &polygon, Pointer<Byte> &data, Int &count);
+		void setupPrimitive(Pointer<Byte> &primitive, Pointer<Byte> &tri, Pointer<Byte> &polygon, Pointer<Byte> &data, Bool &visible);
 		void setupGradient(Pointer<Byte> &primitive, Pointer<Byte> &triangle, Float4 &w012, Float4 (&m)[3], Pointer<Byte> &v0, Pointer<Byte> &v1, Pointer<Byte> &v2, int attribute, int planeEquation, bool flatShading, bool sprite, bool perspective, bool wrap, int component);
 		void edge(Pointer<Byte> &primitive, Pointer<Byte> &data, const Int &Xa, const Int &Ya, const Int &Xb, const Int &Yb, Int &q);
 		void conditionalRotate1(Bool condition, Pointer<Byte> &v0, Pointer<Byte> &v1, Pointer<Byte> &v2);
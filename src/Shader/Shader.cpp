@@ -19,10 +19,12 @@
 #include "Common/Math.hpp"
 #include "Common/Debug.hpp"
 
+#include <map>
 #include <set>
 #include <fstream>
 #include <sstream>
 #include <stdarg.h>
+#include <string.h>
 
 namespace sw
 {
@@ -1130,6 +1132,211 @@ namespace sw
 		       analysisLeave;
 	}
 
+	bool Shader::Instruction::isComponentwise() const
+	{
+		// Each destination component only depends on the same component of the operands
+		switch(opcode)
+		{
+		case OPCODE_MOV:
+		case OPCODE_ADD:
+		case OPCODE_IADD:
+		case OPCODE_SUB:
+		case OPCODE_ISUB:
+		case OPCODE_MUL:
+		case OPCODE_IMUL:
+		case OPCODE_MAD:
+		case OPCODE_IMAD:
+		case OPCODE_DIV:
+		case OPCODE_IDIV:
+		case OPCODE_UDIV:
+		case OPCODE_MOD:
+		case OPCODE_IMOD:
+		case OPCODE_UMOD:
+		case OPCODE_MIN:
+		case OPCODE_IMIN:
+		case OPCODE_UMIN:
+		case OPCODE_MAX:
+		case OPCODE_IMAX:
+		case OPCODE_UMAX:
+		case OPCODE_ABS:
+		case OPCODE_IABS:
+		case OPCODE_NEG:
+		case OPCODE_INEG:
+		case OPCODE_SGN:
+		case OPCODE_ISGN:
+		case OPCODE_FRC:
+		case OPCODE_TRUNC:
+		case OPCODE_FLOOR:
+		case OPCODE_ROUND:
+		case OPCODE_ROUNDEVEN:
+		case OPCODE_CEIL:
+		case OPCODE_SQRT:
+		case OPCODE_RSQ:
+		case OPCODE_EXP2:
+		case OPCODE_LOG2:
+		case OPCODE_EXP:
+		case OPCODE_LOG:
+		case OPCODE_POW:
+		case OPCODE_SIN:
+		case OPCODE_COS:
+		case OPCODE_TAN:
+		case OPCODE_ASIN:
+		case OPCODE_ACOS:
+		case OPCODE_ATAN:
+		case OPCODE_ATAN2:
+		case OPCODE_SINH:
+		case OPCODE_COSH:
+		case OPCODE_TANH:
+		case OPCODE_ASINH:
+		case OPCODE_ACOSH:
+		case OPCODE_ATANH:
+		case OPCODE_LRP:
+		case OPCODE_STEP:
+		case OPCODE_SMOOTH:
+		case OPCODE_SLT:
+		case OPCODE_SGE:
+		case OPCODE_CMP:
+		case OPCODE_ICMP:
+		case OPCODE_UCMP:
+		case OPCODE_CMP0:
+		case OPCODE_SELECT:
+		case OPCODE_ISNAN:
+		case OPCODE_ISINF:
+		case OPCODE_F2B:
+		case OPCODE_B2F:
+		case OPCODE_F2I:
+		case OPCODE_I2F:
+		case OPCODE_F2U:
+		case OPCODE_U2F:
+		case OPCODE_I2B:
+		case OPCODE_B2I:
+		case OPCODE_FLOATBITSTOINT:
+		case OPCODE_FLOATBITSTOUINT:
+		case OPCODE_INTBITSTOFLOAT:
+		case OPCODE_UINTBITSTOFLOAT:
+		case OPCODE_NOT:
+		case OPCODE_AND:
+		case OPCODE_OR:
+		case OPCODE_XOR:
+		case OPCODE_SHL:
+		case OPCODE_ISHR:
+		case OPCODE_USHR:
+		case OPCODE_DFDX:
+		case OPCODE_DFDY:
+		case OPCODE_FWIDTH:
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	bool Shader::Instruction::isPure() const
+	{
+		if(isComponentwise())
+		{
+			return true;
+		}
+
+		// Only writes the destination register, so it can be removed when the result is unused
+		switch(opcode)
+		{
+		case OPCODE_DP1:
+		case OPCODE_DP2:
+		case OPCODE_DP3:
+		case OPCODE_DP4:
+		case OPCODE_DP2ADD:
+		case OPCODE_CRS:
+		case OPCODE_DET2:
+		case OPCODE_DET3:
+		case OPCODE_DET4:
+		case OPCODE_LEN2:
+		case OPCODE_LEN3:
+		case OPCODE_LEN4:
+		case OPCODE_DIST1:
+		case OPCODE_DIST2:
+		case OPCODE_DIST3:
+		case OPCODE_DIST4:
+		case OPCODE_NRM2:
+		case OPCODE_NRM3:
+		case OPCODE_NRM4:
+		case OPCODE_FORWARD1:
+		case OPCODE_FORWARD2:
+		case OPCODE_FORWARD3:
+		case OPCODE_FORWARD4:
+		case OPCODE_REFLECT1:
+		case OPCODE_REFLECT2:
+		case OPCODE_REFLECT3:
+		case OPCODE_REFLECT4:
+		case OPCODE_REFRACT1:
+		case OPCODE_REFRACT2:
+		case OPCODE_REFRACT3:
+		case OPCODE_REFRACT4:
+		case OPCODE_RCPX:
+		case OPCODE_RSQX:
+		case OPCODE_EXP2X:
+		case OPCODE_LOG2X:
+		case OPCODE_POWX:
+		case OPCODE_EXPP:
+		case OPCODE_LOGP:
+		case OPCODE_LIT:
+		case OPCODE_ATT:
+		case OPCODE_SINCOS:
+		case OPCODE_EQ:
+		case OPCODE_NE:
+		case OPCODE_ALL:
+		case OPCODE_ANY:
+		case OPCODE_EXTRACT:
+		case OPCODE_INSERT:
+		case OPCODE_M3X2:
+		case OPCODE_M3X3:
+		case OPCODE_M3X4:
+		case OPCODE_M4X3:
+		case OPCODE_M4X4:
+		case OPCODE_PACKSNORM2x16:
+		case OPCODE_PACKUNORM2x16:
+		case OPCODE_PACKHALF2x16:
+		case OPCODE_UNPACKSNORM2x16:
+		case OPCODE_UNPACKUNORM2x16:
+		case OPCODE_UNPACKHALF2x16:
+		case OPCODE_TEX:
+		case OPCODE_TEXLDD:
+		case OPCODE_TEXLDL:
+		case OPCODE_TEXLOD:
+		case OPCODE_TEXBIAS:
+		case OPCODE_TEXOFFSET:
+		case OPCODE_TEXOFFSETBIAS:
+		case OPCODE_TEXLODOFFSET:
+		case OPCODE_TEXELFETCH:
+		case OPCODE_TEXELFETCHOFFSET:
+		case OPCODE_TEXGRAD:
+		case OPCODE_TEXGRADOFFSET:
+		case OPCODE_TEXRECT:
+		case OPCODE_TEXSIZE:
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	bool Shader::Instruction::usesDerivatives() const
+	{
+		// Reads operands of neighboring pixels in the quad
+		switch(opcode)
+		{
+		case OPCODE_DFDX:
+		case OPCODE_DFDY:
+		case OPCODE_FWIDTH:
+		case OPCODE_TEX:
+		case OPCODE_TEXBIAS:
+		case OPCODE_TEXOFFSET:
+		case OPCODE_TEXOFFSETBIAS:
+		case OPCODE_TEXRECT:
+			return true;
+		default:
+			return false;
+		}
+	}
+
 	Shader::Shader() : serialID(serialCounter++)
 	{
 		usedSamplers = 0;
@@ -1490,9 +1697,653 @@ namespace sw
 
 	void Shader::optimize()
 	{
+		size_t length = instruction.size();
 		optimizeLeave();
 		optimizeCall();
 		removeNull();
+
+		// Register level passes, for shader models without implicit register semantics
+		if(shaderModel >= 0x0300 && !indexesTemporaries())
+		{
+			for(int pass = 0; pass < 8; pass++)
+			{
+				bool progress = foldConstants();
+				progress = propagateCopies() || progress;
+				progress = eliminateCommonSubexpressions() || progress;
+				progress = eliminateDeadCode() || progress;
+
+				removeNull();
+
+				if(!progress)
+				{
+					break;
+				}
+			}
+		}
+
+		TRACE("%d -> %d instructions", (int)length, (int)instruction.size());
+		(void)length;   // Unused when tracing is disabled
+	}
+
+	// Instructions which start or end a basic block, or have effects besides writing their destination
+	static bool isBlockBoundary(const Shader::Instruction *inst)
+	{
+		switch(inst->opcode)
+		{
+		case Shader::OPCODE_DCL:
+		case Shader::OPCODE_NOP:
+		case Shader::OPCODE_NULL:
+			return false;
+		default:
+			return !inst->isPure();
+		}
+	}
+
+	// Number of consecutive registers read by the second operand
+	static int matrixRows(Shader::Opcode opcode)
+	{
+		switch(opcode)
+		{
+		case Shader::OPCODE_M3X2: return 2;
+		case Shader::OPCODE_M3X3: return 3;
+		case Shader::OPCODE_M3X4: return 4;
+		case Shader::OPCODE_M4X3: return 3;
+		case Shader::OPCODE_M4X4: return 4;
+		default:                  return 1;
+		}
+	}
+
+	static bool isRegister(const Shader::Parameter &parameter)
+	{
+		switch(parameter.type)
+		{
+		case Shader::PARAMETER_VOID:
+		case Shader::PARAMETER_LABEL:
+		case Shader::PARAMETER_FLOAT4LITERAL:
+		case Shader::PARAMETER_BOOL1LITERAL:
+		case Shader::PARAMETER_INT4LITERAL:
+			return false;
+		default:
+			return true;
+		}
+	}
+
+	// Operands which can replace a temporary register without changing the instruction's semantics
+	static bool isPlainOperand(const Shader::SourceParameter &src)
+	{
+		switch(src.type)
+		{
+		case Shader::PARAMETER_TEMP:
+		case Shader::PARAMETER_INPUT:
+		case Shader::PARAMETER_CONST:
+			return src.rel.type == Shader::PARAMETER_VOID;
+		case Shader::PARAMETER_FLOAT4LITERAL:
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	static bool isSameOperand(const Shader::SourceParameter &a, const Shader::SourceParameter &b)
+	{
+		if(a.type != b.type)
+		{
+			return false;
+		}
+
+		if(a.type == Shader::PARAMETER_VOID)
+		{
+			return true;
+		}
+
+		if(a.swizzle != b.swizzle || a.modifier != b.modifier)
+		{
+			return false;
+		}
+
+		if(a.type == Shader::PARAMETER_FLOAT4LITERAL)
+		{
+			return memcmp(a.value, b.value, sizeof(a.value)) == 0;
+		}
+
+		return a.index == b.index && a.bufferIndex == b.bufferIndex &&
+		       a.rel.type == Shader::PARAMETER_VOID && b.rel.type == Shader::PARAMETER_VOID;
+	}
+
+	// Register components selected by the swizzle for the given destination components
+	static int swizzleMask(int swizzle, int mask)
+	{
+		int components = 0;
+
+		for(int i = 0; i < 4; i++)
+		{
+			if(mask & (1 << i))
+			{
+				components |= 1 << ((swizzle >> (2 * i)) & 0x3);
+			}
+		}
+
+		return components;
+	}
+
+	// Accumulates the components of temporary registers read by the instruction
+	static void readTemporaries(const Shader::Instruction *inst, std::map<unsigned int, int> &reads)
+	{
+		int mask = inst->isComponentwise() ? inst->dst.mask : 0xF;
+
+		for(int i = 0; i < 5; i++)
+		{
+			const Shader::SourceParameter &src = inst->src[i];
+
+			if(src.type == Shader::PARAMETER_TEMP)
+			{
+				int rows = (i == 1) ? matrixRows(inst->opcode) : 1;
+
+				for(int row = 0; row < rows; row++)
+				{
+					reads[src.index + row] |= (rows == 1) ? swizzleMask(src.swizzle, mask) : 0xF;
+				}
+			}
+
+			if(isRegister(src) && src.rel.type == Shader::PARAMETER_TEMP)
+			{
+				reads[src.rel.index] |= 0xF;
+			}
+		}
+
+		if(isRegister(inst->dst) && inst->dst.rel.type == Shader::PARAMETER_TEMP)
+		{
+			reads[inst->dst.rel.index] |= 0xF;
+		}
+
+		if(inst->opcode == Shader::OPCODE_TEXKILL && inst->dst.type == Shader::PARAMETER_TEMP)   // Takes destination as input
+		{
+			reads[inst->dst.index] |= 0xF;
+		}
+	}
+
+	bool Shader::indexesTemporaries() const
+	{
+		for(const auto &inst : instruction)
+		{
+			if(inst->dst.type == PARAMETER_TEMP && inst->dst.rel.type != PARAMETER_VOID)
+			{
+				return true;
+			}
+
+			for(int i = 0; i < 5; i++)
+			{
+				if(inst->src[i].type == PARAMETER_TEMP && inst->src[i].rel.type != PARAMETER_VOID)
+				{
+					return true;
+				}
+			}
+		}
+
+		return false;
+	}
+
+	bool Shader::foldConstants()
+	{
+		// Evaluates instructions on literal operands, replacing them with a literal move
+		bool progress = false;
+
+		for(auto &inst : instruction)
+		{
+			if(inst->predicate || inst->dst.saturate || inst->dst.shift != 0)
+			{
+				continue;
+			}
+
+			if(inst->dst.type != PARAMETER_TEMP && inst->dst.type != PARAMETER_OUTPUT && inst->dst.type != PARAMETER_COLOROUT)
+			{
+				continue;
+			}
+
+			int operands = 0;
+
+			switch(inst->opcode)
+			{
+			case OPCODE_MOV:
+			case OPCODE_NEG:
+			case OPCODE_INEG:
+			case OPCODE_NOT:
+			case OPCODE_I2F:
+			case OPCODE_B2F:
+				operands = 1;
+				break;
+			case OPCODE_ADD:
+			case OPCODE_IADD:
+			case OPCODE_SUB:
+			case OPCODE_ISUB:
+			case OPCODE_MUL:
+			case OPCODE_IMUL:
+			case OPCODE_AND:
+			case OPCODE_OR:
+			case OPCODE_XOR:
+				operands = 2;
+				break;
+			case OPCODE_MAD:
+			case OPCODE_IMAD:
+				operands = 3;
+				break;
+			default:
+				continue;
+			}
+
+			if(inst->opcode == OPCODE_MOV && inst->src[0].modifier == MODIFIER_NONE && inst->src[0].swizzle == 0xE4)
+			{
+				continue;   // Already folded
+			}
+
+			union Component
+			{
+				float f;
+				int i;
+				unsigned int u;
+			};
+
+			Component s[3][4];
+			bool literal = true;
+
+			for(int j = 0; j < 5; j++)
+			{
+				const SourceParameter &src = inst->src[j];
+
+				if(j >= operands)
+				{
+					literal = literal && (src.type == PARAMETER_VOID);
+					continue;
+				}
+
+				if(src.type != PARAMETER_FLOAT4LITERAL)
+				{
+					literal = false;
+					break;
+				}
+
+				for(int k = 0; k < 4; k++)
+				{
+					Component &c = s[j][k];
+					c.f = src.value[(src.swizzle >> (2 * k)) & 0x3];
+
+					switch(src.modifier)
+					{
+					case MODIFIER_NONE:                                    break;
+					case MODIFIER_NEGATE:     c.u ^= 0x80000000;           break;
+					case MODIFIER_ABS:        c.u &= 0x7FFFFFFF;           break;
+					case MODIFIER_ABS_NEGATE: c.u |= 0x80000000;           break;
+					case MODIFIER_NOT:        c.u ^= 0xFFFFFFFF;           break;
+					default:                  literal = false;             break;
+					}
+				}
+			}
+
+			if(!literal)
+			{
+				continue;
+			}
+
+			Component d[4];
+
+			for(int k = 0; k < 4; k++)
+			{
+				const Component &a = s[0][k];
+				const Component &b = s[1][k];
+				const Component &c = s[2][k];
+
+				switch(inst->opcode)
+				{
+				case OPCODE_MOV:  d[k].u = a.u;                    break;
+				case OPCODE_NEG:  d[k].u = a.u ^ 0x80000000;       break;
+				case OPCODE_INEG: d[k].u = 0u - a.u;               break;
+				case OPCODE_NOT:  d[k].u = ~a.u;                   break;
+				case OPCODE_I2F:  d[k].f = (float)a.i;             break;
+				case OPCODE_B2F:  d[k].u = a.u & 0x3F800000;       break;
+				case OPCODE_ADD:  d[k].f = a.f + b.f;              break;
+				case OPCODE_IADD: d[k].u = a.u + b.u;              break;
+				case OPCODE_SUB:  d[k].f = a.f - b.f;              break;
+				case OPCODE_ISUB: d[k].u = a.u - b.u;              break;
+				case OPCODE_MUL:  d[k].f = a.f * b.f;              break;
+				case OPCODE_IMUL: d[k].u = a.u * b.u;              break;
+				case OPCODE_AND:  d[k].u = a.u & b.u;              break;
+				case OPCODE_OR:   d[k].u = a.u | b.u;              break;
+				case OPCODE_XOR:  d[k].u = a.u ^ b.u;              break;
+				case OPCODE_MAD:  d[k].f = a.f * b.f + c.f;        break;
+				case OPCODE_IMAD: d[k].u = a.u * b.u + c.u;        break;
+				default:          ASSERT(false);
+				}
+			}
+
+			inst->opcode = OPCODE_MOV;
+			inst->control = CONTROL_RESERVED0;
+
+			for(int j = 1; j < 5; j++)
+			{
+				inst->src[j] = SourceParameter();
+			}
+
+			inst->src[0] = SourceParameter();
+			inst->src[0].type = PARAMETER_FLOAT4LITERAL;
+
+			for(int k = 0; k < 4; k++)
+			{
+				inst->src[0].value[k] = d[k].f;
+			}
+
+			progress = true;
+		}
+
+		return progress;
+	}
+
+	bool Shader::propagateCopies()
+	{
+		// Replaces reads of temporaries defined by a move with the move's operand, within basic blocks
+		bool progress = false;
+
+		std::map<unsigned int, const Instruction*> copy;   // Move which defined each register component in the block
+		int depth = 0;
+		bool divergent = false;   // Past code which can disable pixels of a quad
+
+		for(auto &inst : instruction)
+		{
+			if(isBlockBoundary(inst))
+			{
+				copy.clear();
+
+				if(inst->isBranch() || inst->isLoop() || inst->opcode == OPCODE_SWITCH)
+				{
+					depth++;
+				}
+				else if(inst->opcode == OPCODE_ENDIF || inst->isEndLoop() || inst->opcode == OPCODE_ENDSWITCH)
+				{
+					depth--;
+				}
+				else if(inst->opcode == OPCODE_LABEL || inst->opcode == OPCODE_RET || inst->isBreak() ||
+				        inst->opcode == OPCODE_CONTINUE || inst->opcode == OPCODE_LEAVE)
+				{
+					divergent = true;
+				}
+
+				continue;
+			}
+
+			bool uniform = (depth == 0) && !divergent;
+
+			for(int j = 0; j < 5 && inst->isPure(); j++)
+			{
+				SourceParameter &src = inst->src[j];
+
+				if(src.type != PARAMETER_TEMP || src.rel.type != PARAMETER_VOID)
+				{
+					continue;
+				}
+
+				if((j == 1 && matrixRows(inst->opcode) > 1) || (inst->usesDerivatives() && !uniform))
+				{
+					continue;
+				}
+
+				int mask = inst->isComponentwise() ? inst->dst.mask : 0xF;
+				const Instruction *move = nullptr;
+				int first = -1;
+
+				for(int k = 0; k < 4; k++)
+				{
+					if(mask & (1 << k))
+					{
+						auto c = copy.find(src.index * 4 + ((src.swizzle >> (2 * k)) & 0x3));
+
+						if(c == copy.end() || (move && c->second != move))
+						{
+							move = nullptr;
+							break;
+						}
+
+						move = c->second;
+						first = (first < 0) ? k : first;
+					}
+				}
+
+				if(!move)
+				{
+					continue;
+				}
+
+				unsigned int swizzle = 0;
+
+				for(int k = 0; k < 4; k++)
+				{
+					int component = (src.swizzle >> (2 * ((mask & (1 << k)) ? k : first))) & 0x3;
+
+					swizzle |= ((move->src[0].swizzle >> (2 * component)) & 0x3) << (2 * k);
+				}
+
+				Modifier modifier = src.modifier;
+
+				src = move->src[0];
+				src.swizzle = swizzle;
+				src.modifier = modifier;
+
+				progress = true;
+			}
+
+			if(inst->dst.type == PARAMETER_TEMP)
+			{
+				unsigned int index = inst->dst.index;
+
+				for(auto c = copy.begin(); c != copy.end(); )
+				{
+					const SourceParameter &operand = c->second->src[0];
+
+					if((c->first / 4 == index && (inst->dst.mask & (1 << (c->first % 4)))) ||
+					   (operand.type == PARAMETER_TEMP && operand.index == index))
+					{
+						c = copy.erase(c);
+					}
+					else
+					{
+						c++;
+					}
+				}
+
+				const SourceParameter &operand = inst->src[0];
+
+				if(inst->opcode == OPCODE_MOV && !inst->predicate && !inst->dst.saturate && inst->dst.shift == 0 &&
+				   isPlainOperand(operand) && operand.modifier == MODIFIER_NONE &&
+				   !(operand.type == PARAMETER_TEMP && operand.index == index))
+				{
+					for(int k = 0; k < 4; k++)
+					{
+						if(inst->dst.mask & (1 << k))
+						{
+							copy[index * 4 + k] = inst;
+						}
+					}
+				}
+			}
+		}
+
+		return progress;
+	}
+
+	bool Shader::eliminateCommonSubexpressions()
+	{
+		// Replaces recomputations of a value still held in a temporary with a move, within basic blocks
+		bool progress = false;
+
+		std::vector<Instruction*> available;
+
+		for(auto &inst : instruction)
+		{
+			if(isBlockBoundary(inst))
+			{
+				available.clear();
+				continue;
+			}
+
+			bool candidate = inst->isPure() && inst->opcode != OPCODE_MOV && matrixRows(inst->opcode) == 1 &&
+			                 !inst->predicate && inst->dst.type == PARAMETER_TEMP;
+
+			for(int j = 0; j < 5 && candidate; j++)
+			{
+				const SourceParameter &src = inst->src[j];
+
+				candidate = src.type == PARAMETER_VOID || isPlainOperand(src) ||
+				            (src.type == PARAMETER_SAMPLER && src.rel.type == PARAMETER_VOID);
+			}
+
+			if(candidate)
+			{
+				for(const auto &previous : available)
+				{
+					bool same = previous->opcode == inst->opcode &&
+					            previous->control == inst->control &&
+					            previous->dst.saturate == inst->dst.saturate &&
+					            previous->dst.shift == inst->dst.shift &&
+					            previous->dst.partialPrecision == inst->dst.partialPrecision &&
+					            (inst->dst.mask & ~previous->dst.mask) == 0;
+
+					for(int j = 0; j < 5 && same; j++)
+					{
+						same = isSameOperand(previous->src[j], inst->src[j]);
+					}
+
+					if(same && previous->dst.index == inst->dst.index)
+					{
+						inst->opcode = OPCODE_NULL;   // Still holds the value
+
+						progress = true;
+						break;
+					}
+
+					if(same)
+					{
+						inst->opcode = OPCODE_MOV;
+						inst->control = CONTROL_RESERVED0;
+						inst->dst.saturate = false;
+						inst->dst.shift = 0;   // Already applied to the previous result
+
+						for(int j = 1; j < 5; j++)
+						{
+							inst->src[j] = SourceParameter();
+						}
+
+						inst->src[0] = SourceParameter();
+						inst->src[0].type = PARAMETER_TEMP;
+						inst->src[0].index = previous->dst.index;
+
+						candidate = false;
+						progress = true;
+						break;
+					}
+				}
+			}
+
+			if(inst->dst.type == PARAMETER_TEMP && inst->opcode != OPCODE_NULL)
+			{
+				unsigned int index = inst->dst.index;
+
+				for(auto previous = available.begin(); previous != available.end(); )
+				{
+					bool overwritten = (*previous)->dst.index == index;
+
+					for(int j = 0; j < 5; j++)
+					{
+						overwritten = overwritten || ((*previous)->src[j].type == PARAMETER_TEMP && (*previous)->src[j].index == index);
+					}
+
+					if(overwritten)
+					{
+						previous = available.erase(previous);
+					}
+					else
+					{
+						previous++;
+					}
+				}
+
+				for(int j = 0; j < 5 && candidate; j++)
+				{
+					candidate = !(inst->src[j].type == PARAMETER_TEMP && inst->src[j].index == index);
+				}
+
+				if(candidate)
+				{
+					available.push_back(inst);
+				}
+			}
+		}
+
+		return progress;
+	}
+
+	bool Shader::eliminateDeadCode()
+	{
+		// Removes instructions, or destination components, whose result is never read
+		bool progress = false;
+
+		std::map<unsigned int, int> reads;   // Components read anywhere in the shader
+
+		for(const auto &inst : instruction)
+		{
+			if(inst->opcode != OPCODE_NULL)
+			{
+				readTemporaries(inst, reads);
+			}
+		}
+
+		std::map<unsigned int, int> overwritten;   // Components written later in the block before being read
+
+		for(auto i = instruction.rbegin(); i != instruction.rend(); i++)
+		{
+			Instruction *inst = *i;
+
+			if(inst->opcode == OPCODE_NULL)
+			{
+				continue;
+			}
+
+			if(isBlockBoundary(inst))
+			{
+				overwritten.clear();
+			}
+			else if(inst->dst.type == PARAMETER_TEMP && inst->isPure())
+			{
+				unsigned int index = inst->dst.index;
+				int live = reads[index] & ~overwritten[index];
+
+				if((inst->dst.mask & live) == 0)
+				{
+					inst->opcode = OPCODE_NULL;
+					progress = true;
+
+					continue;
+				}
+
+				if(inst->isComponentwise() && (inst->dst.mask & ~live) != 0)
+				{
+					inst->dst.mask &= live;
+					progress = true;
+				}
+
+				if(!inst->predicate)
+				{
+					overwritten[index] |= inst->dst.mask;
+				}
+			}
+
+			std::map<unsigned int, int> used;
+			readTemporaries(inst, used);
+
+			for(const auto &use : used)
+			{
+				overwritten[use.first] &= ~use.second;
+			}
+		}
+
+		return progress;
 	}
 
 	void Shader::optimizeLeave()
@@ -1626,6 +2477,108 @@ namespace sw
 		}
 	}
 
+	void Shader::analyzeControlConstants()
+	{
+		controlConstantsI = 0;
+		controlConstantsB = 0;
+
+		for(const auto &inst : instruction)
+		{
+			for(int j = 0; j < 5; j++)
+			{
+				const SourceParameter &src = inst->src[j];
+
+				if(src.type == PARAMETER_CONSTINT && src.index < 16)
+				{
+					controlConstantsI |= 1 << src.index;
+				}
+				else if(src.type == PARAMETER_CONSTBOOL && src.index < 16)
+				{
+					controlConstantsB |= 1 << src.index;
+				}
+			}
+		}
+
+		// Float constants which branch and loop conditions are computed from. This is flow-insensitive,
+		// since it only selects the registers worth specializing, and their values become part of the state.
+		controlConstantsFCount = 0;
+
+		std::set<std::pair<int, unsigned int>> control;   // Registers read by the conditions, directly or indirectly
+		std::vector<bool> controlling(instruction.size(), false);
+		std::set<unsigned int> defined;   // Known at compile time
+
+		for(const auto &inst : instruction)
+		{
+			if(inst->opcode == OPCODE_DEF)
+			{
+				defined.insert(inst->dst.index);
+			}
+		}
+
+		for(bool changed = true; changed;)
+		{
+			changed = false;
+
+			for(size_t i = 0; i < instruction.size(); i++)
+			{
+				const Instruction *inst = instruction[i];
+
+				if(controlling[i])
+				{
+					continue;
+				}
+
+				switch(inst->opcode)
+				{
+				case OPCODE_IF:
+				case OPCODE_IFC:
+				case OPCODE_BREAKC:
+				case OPCODE_BREAKP:
+				case OPCODE_CALLNZ:
+				case OPCODE_WHILE:
+					break;
+				default:
+					if(inst->dst.type == PARAMETER_VOID || !control.count(std::make_pair((int)inst->dst.type, inst->dst.index)))
+					{
+						continue;
+					}
+				}
+
+				controlling[i] = true;
+				changed = true;
+
+				for(int j = 0; j < 5; j++)
+				{
+					const SourceParameter &src = inst->src[j];
+
+					if(src.type == PARAMETER_CONST)
+					{
+						if(src.rel.type != PARAMETER_VOID || src.bufferIndex != -1 || defined.count(src.index))
+						{
+							continue;
+						}
+
+						bool listed = false;
+
+						for(int k = 0; k < controlConstantsFCount; k++)
+						{
+							listed = listed || (controlConstantsF[k] == src.index);
+						}
+
+						if(!listed && controlConstantsFCount < 8)
+						{
+							controlConstantsF[controlConstantsFCount++] = src.index;
+						}
+					}
+					else if(src.type != PARAMETER_VOID)
+					{
+						control.insert(std::make_pair((int)src.type, src.index));
+					}
+				}
+			}
+		}
+	}
+
 	void Shader::analyzeDynamicBranching()
 	{
 		dynamicBranching = false;
@@ -513,6 +513,9 @@ namespace sw
 			bool isEndLoop() const;
 
 			bool isPredicated() const;
+			bool isComponentwise() const;
+			bool isPure() const;
+			bool usesDerivatives() const;
 
 			Opcode opcode;
 
@@ -613,6 +616,11 @@ namespace sw
 		unsigned int dirtyConstantsI;
 		unsigned int dirtyConstantsB;
 
+		unsigned short controlConstantsI;   // Integer registers read by loops, bit flags
+		unsigned short controlConstantsB;   // Boolean registers read by branches and calls, bit flags
+		unsigned short controlConstantsF[8];   // Float registers which branch and loop conditions are computed from
+		int controlConstantsFCount;
+
 		bool dynamicallyIndexedTemporaries;
 		bool dynamicallyIndexedInput;
 		bool dynamicallyIndexedOutput;
@@ -623,8 +631,14 @@ namespace sw
 		void optimizeLeave();
 		void optimizeCall();
 		void removeNull();
+		bool foldConstants();
+		bool propagateCopies();
+		bool eliminateCommonSubexpressions();
+		bool eliminateDeadCode();
+		bool indexesTemporaries() const;
 
 		void analyzeDirtyConstants();
+		void analyzeControlConstants();
 		void analyzeDynamicBranching();
 		void analyzeSamplers();
 		void analyzeCallSites();
@@ -779,7 +779,7 @@ namespace sw
 	{
 		if(bufferIndex == -1)
 		{
-			return data + OFFSET(DrawData, vs.c[index]);
+			return *Pointer<Pointer<Byte>>(data + OFFSET(DrawData, vs.c)) + index * sizeof(float4);
 		}
 		else
 		{
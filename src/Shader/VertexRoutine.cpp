@@ -50,6 +50,8 @@ namespace sw
 		UInt indexInPrimitive = 0;
 
 		constants = *Pointer<Pointer<Byte>>(data + OFFSET(DrawData,constants));
+		NoAlias(data);
+		NoAlias(constants);
 
 		Do
 		{
@@ -110,11 +112,13 @@ namespace sw
 	{
 		int pos = state.positionRegister;
 
-		Int4 maxX = CmpLT(o[pos].w, o[pos].x);
-		Int4 maxY = CmpLT(o[pos].w, o[pos].y);
+		Float4 guardBand = o[pos].w * *Pointer<Float4>(data + OFFSET(DrawData,guardBand));
+
+		Int4 maxX = CmpLT(guardBand, o[pos].x);
+		Int4 maxY = CmpLT(guardBand, o[pos].y);
 		Int4 maxZ = CmpLT(o[pos].w, o[pos].z);
-		Int4 minX = CmpNLE(-o[pos].w, o[pos].x);
-		Int4 minY = CmpNLE(-o[pos].w, o[pos].y);
+		Int4 minX = CmpNLE(-guardBand, o[pos].x);
+		Int4 minY = CmpNLE(-guardBand, o[pos].y);
 		Int4 minZ = symmetricNormalizedDepth ? CmpNLE(-o[pos].w, o[pos].z) : CmpNLE(Float4(0.0f), o[pos].z);
 
 		clipFlags = *Pointer<Int>(constants + OFFSET(Constants,maxX) + SignMask(maxX) * 4);   // FIXME: Array indexing
@@ -38,6 +38,8 @@ namespace sw
 
 		if(vs)   // Make a copy
 		{
+			shaderModel = vs->shaderModel;
+
 			for(size_t i = 0; i < vs->getLength(); i++)
 			{
 				append(new sw::Shader::Instruction(*vs->getInstruction(i)));
@@ -183,6 +185,74 @@ namespace sw
 		pointSizeRegister = ptSizeReg;
 	}
 
+	// Strips writes to output components which have no semantic (i.e. are not consumed by the
+	// pixel shader or transform feedback), letting optimization remove the code which feeds them
+	void VertexShader::removeUnusedOutputs()
+	{
+		if(shaderModel < 0x0300 || dynamicallyIndexedOutput)
+		{
+			return;
+		}
+
+		bool readBack[MAX_VERTEX_OUTPUTS] = {false};
+
+		for(const auto &inst : instruction)
+		{
+			for(int j = 0; j < 5; j++)
+			{
+				if(inst->src[j].type == PARAMETER_OUTPUT && inst->src[j].index < MAX_VERTEX_OUTPUTS)
+				{
+					readBack[inst->src[j].index] = true;
+				}
+			}
+		}
+
+		bool modified = false;
+
+		for(auto &inst : instruction)
+		{
+			DestinationParameter &dst = inst->dst;
+
+			if(inst->opcode == OPCODE_DCL || dst.type != PARAMETER_OUTPUT ||
+			   dst.index >= MAX_VERTEX_OUTPUTS || readBack[dst.index])
+			{
+				continue;
+			}
+
+			int live = 0;
+
+			for(int c = 0; c < 4; c++)
+			{
+				if(output[dst.index][c].active())
+				{
+					live |= 1 << c;
+				}
+			}
+
+			if((dst.mask & live) == dst.mask)
+			{
+				continue;
+			}
+
+			if((dst.mask & live) == 0 && inst->isPure())
+			{
+				inst->opcode = OPCODE_NULL;
+				modified = true;
+			}
+			else if(inst->isComponentwise() && (dst.mask & live) != 0)
+			{
+				dst.mask &= live;
+				modified = true;
+			}
+		}
+
+		if(modified)
+		{
+			optimize();
+			analyze();
+		}
+	}
+
 	const sw::Shader::Semantic& VertexShader::getInput(int inputIdx) const
 	{
 		return input[inputIdx];
@@ -203,6 +273,7 @@ namespace sw
 		analyzeInput();
 		analyzeOutput();
 		analyzeDirtyConstants();
+		analyzeControlConstants();
 		analyzeTextureSampling();
 		analyzeDynamicBranching();
 		analyzeSamplers();
@@ -46,6 +46,7 @@ namespace sw
 		void setPointSizeRegister(int ptSizeReg);
 		void declareInstanceId() { instanceIdDeclared = true; }
 		void declareVertexId() { vertexIdDeclared = true; }
+		void removeUnusedOutputs();
 
 		const Semantic& getInput(int inputIdx) const;
 		const Semantic& getOutput(int outputIdx, int component) const;
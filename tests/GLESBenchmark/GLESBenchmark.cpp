@@ -0,0 +1,781 @@
+// Copyright 2017 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// GLESBenchmark.cpp: Synthetic OpenGL ES workloads rendered to an offscreen
+// pbuffer, for measuring the cost of specific driver paths.
+//
+// Usage: GLESBenchmark <scenario> [frames]
+//
+// Scenarios:
+//   readback   Renders frames and reads each one back, synchronously into
+//              client memory and through pixel pack buffers with 0 to 3
+//              frames in flight before the application consumes them.
+//   texupload  Updates a streaming texture with glTexSubImage2D every frame
+//              while the previous frames that sample it are still rendering.
+//   drawcalls  Issues 1000 small textured draws per frame with constant state,
+//              and again with one uniform modified between draws, to measure
+//              the per-draw driver overhead. Also submits the constant state
+//              draws as a single glMultiDrawArraysEXT call per frame.
+//   compile    Compiles a corpus of large generated shaders, modeled on
+//              engine uber-shaders with thousands of lines, many locals and
+//              uniforms, and reports the compile time per shader. The frame
+//              count is the number of times each shader gets compiled.
+
+#include <EGL/egl.h>
+#include <GLES3/gl3.h>
+#include <GLES2/gl2ext.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+class Benchmark
+{
+public:
+	virtual ~Benchmark();
+
+	bool initialize(EGLint width, EGLint height);
+	virtual bool run(int frames) = 0;
+
+protected:
+	GLuint compileProgram(const char *vertexSource, const char *fragmentSource);
+
+	static double now()
+	{
+		return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	EGLDisplay display = EGL_NO_DISPLAY;
+	EGLContext context = EGL_NO_CONTEXT;
+	EGLSurface surface = EGL_NO_SURFACE;
+	EGLint width = 0;
+	EGLint height = 0;
+};
+
+Benchmark::~Benchmark()
+{
+	if(display != EGL_NO_DISPLAY)
+	{
+		eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+		eglDestroyContext(display, context);
+		eglDestroySurface(display, surface);
+		eglTerminate(display);
+	}
+}
+
+bool Benchmark::initialize(EGLint width, EGLint height)
+{
+	display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+	if(!eglInitialize(display, nullptr, nullptr))
+	{
+		fprintf(stderr, "eglInitialize failed\n");
+		return false;
+	}
+
+	const EGLint configAttributes[] =
+	{
+		EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_ES2_BIT,
+		EGL_RED_SIZE, 8,
+		EGL_GREEN_SIZE, 8,
+		EGL_BLUE_SIZE, 8,
+		EGL_ALPHA_SIZE, 8,
+		EGL_DEPTH_SIZE, 24,
+		EGL_NONE
+	};
+
+	EGLConfig config;
+	EGLint configCount = 0;
+
+	if(!eglChooseConfig(display, configAttributes, &config, 1, &configCount) || configCount == 0)
+	{
+		fprintf(stderr, "eglChooseConfig failed\n");
+		return false;
+	}
+
+	const EGLint surfaceAttributes[] = {EGL_WIDTH, width, EGL_HEIGHT, height, EGL_NONE};
+	surface = eglCreatePbufferSurface(display, config, surfaceAttributes);
+
+	const EGLint contextAttributes[] = {EGL_CONTEXT_CLIENT_VERSION, 3, EGL_NONE};
+	context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttributes);
+
+	if(surface == EGL_NO_SURFACE || context == EGL_NO_CONTEXT || !eglMakeCurrent(display, surface, surface, context))
+	{
+		fprintf(stderr, "Failed to create an OpenGL ES 3.0 pbuffer context\n");
+		return false;
+	}
+
+	this->width = width;
+	this->height = height;
+
+	return true;
+}
+
+GLuint Benchmark::compileProgram(const char *vertexSource, const char *fragmentSource)
+{
+	GLuint program = glCreateProgram();
+	const char *sources[2] = {vertexSource, fragmentSource};
+	const GLenum types[2] = {GL_VERTEX_SHADER, GL_FRAGMENT_SHADER};
+
+	for(int i = 0; i < 2; i++)
+	{
+		GLuint shader = glCreateShader(types[i]);
+		glShaderSource(shader, 1, &sources[i], nullptr);
+		glCompileShader(shader);
+		glAttachShader(program, shader);
+		glDeleteShader(shader);
+	}
+
+	glBindAttribLocation(program, 0, "position");
+	glLinkProgram(program);
+
+	GLint linked = GL_FALSE;
+	glGetProgramiv(program, GL_LINK_STATUS, &linked);
+
+	if(!linked)
+	{
+		fprintf(stderr, "Failed to link program\n");
+		glDeleteProgram(program);
+		return 0;
+	}
+
+	return program;
+}
+
+// Renders a fullscreen triangle with an arithmetic-heavy fragment shader and
+// reads every frame back. The application consumes each frame by checksumming
+// it, which overlaps with rendering when the readback doesn't block.
+class ReadbackBenchmark : public Benchmark
+{
+public:
+	bool run(int frames) override;
+
+private:
+	void drawFrame(int frame);
+	double measure(int frames, int framesInFlight);
+	void consume(const unsigned char *pixels);
+
+	GLuint program = 0;
+	GLint frameLocation = -1;
+	unsigned int checksum = 0;
+};
+
+bool ReadbackBenchmark::run(int frames)
+{
+	const char *vertexSource =
+		"attribute vec4 position;\n"
+		"void main() { gl_Position = position; }\n";
+
+	const char *fragmentSource =
+		"precision highp float;\n"
+		"uniform float frame;\n"
+		"void main()\n"
+		"{\n"
+		"	vec2 p = gl_FragCoord.xy * 0.01 + frame;\n"
+		"	float a = 0.0;\n"
+		"	for(int i = 0; i < 16; i++) { a += sin(p.x * float(i)) * cos(p.y + float(i)); }\n"
+		"	gl_FragColor = vec4(fract(a), fract(p), 1.0);\n"
+		"}\n";
+
+	program = compileProgram(vertexSource, fragmentSource);
+
+	if(!program)
+	{
+		return false;
+	}
+
+	glUseProgram(program);
+	frameLocation = glGetUniformLocation(program, "frame");
+
+	static const GLfloat triangle[] = {-1, -1, 3, -1, -1, 3};
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, triangle);
+
+	printf("%dx%d, %d frames\n", width, height, frames);
+	printf("%-24s %10s %10s\n", "readback", "ms/frame", "frames/s");
+
+	for(int framesInFlight = -1; framesInFlight <= 3; framesInFlight++)
+	{
+		double time = measure(frames, framesInFlight);
+
+		char label[32];
+		if(framesInFlight < 0)
+		{
+			snprintf(label, sizeof(label), "client memory");
+		}
+		else
+		{
+			snprintf(label, sizeof(label), "PBO, %d in flight", framesInFlight);
+		}
+
+		printf("%-24s %10.3f %10.1f\n", label, 1000.0 * time / frames, frames / time);
+	}
+
+	printf("checksum %08X\n", checksum);
+
+	glDeleteProgram(program);
+
+	return glGetError() == GL_NO_ERROR;
+}
+
+void ReadbackBenchmark::drawFrame(int frame)
+{
+	glUniform1f(frameLocation, (float)frame);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+}
+
+void ReadbackBenchmark::consume(const unsigned char *pixels)
+{
+	const unsigned int *words = reinterpret_cast<const unsigned int*>(pixels);
+
+	for(int i = 0; i < width * height; i++)
+	{
+		checksum = (checksum ^ words[i]) * 16777619u;
+	}
+}
+
+// A negative number of frames in flight reads into client memory
+double ReadbackBenchmark::measure(int frames, int framesInFlight)
+{
+	size_t frameSize = width * height * 4;
+	glFinish();
+
+	if(framesInFlight < 0)
+	{
+		std::vector<unsigned char> pixels(frameSize);
+		double start = now();
+
+		for(int frame = 0; frame < frames; frame++)
+		{
+			drawFrame(frame);
+			glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+			consume(pixels.data());
+		}
+
+		return now() - start;
+	}
+
+	int ringSize = framesInFlight + 1;
+	std::vector<GLuint> buffers(ringSize);
+	std::vector<GLsync> fences(ringSize);
+
+	glGenBuffers(ringSize, buffers.data());
+
+	for(GLuint buffer : buffers)
+	{
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer);
+		glBufferData(GL_PIXEL_PACK_BUFFER, frameSize, nullptr, GL_STREAM_READ);
+	}
+
+	double start = now();
+
+	for(int frame = 0; frame < frames + framesInFlight; frame++)
+	{
+		if(frame < frames)
+		{
+			int slot = frame % ringSize;
+
+			drawFrame(frame);
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, buffers[slot]);
+			glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+			fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		}
+
+		int consumed = frame - framesInFlight;
+
+		if(consumed >= 0)
+		{
+			int slot = consumed % ringSize;
+
+			glClientWaitSync(fences[slot], 0, GL_TIMEOUT_IGNORED);
+			glDeleteSync(fences[slot]);
+
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, buffers[slot]);
+			const void *pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, frameSize, GL_MAP_READ_BIT);
+			consume(static_cast<const unsigned char*>(pixels));
+			glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+		}
+	}
+
+	double time = now() - start;
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	glDeleteBuffers(ringSize, buffers.data());
+
+	return time;
+}
+
+// Uploads a new 1024x1024 image into a texture every frame, like a video
+// player, and draws it fullscreen with a fragment shader that takes longer
+// than the upload. Without renaming, each upload waits for the previous
+// frame's draw to finish sampling the texture.
+class TextureUploadBenchmark : public Benchmark
+{
+public:
+	bool run(int frames) override;
+
+private:
+	enum { TEXTURE_SIZE = 1024 };
+
+	double measure(int frames, GLenum format);
+};
+
+bool TextureUploadBenchmark::run(int frames)
+{
+	const char *vertexSource =
+		"attribute vec4 position;\n"
+		"varying vec2 texCoord;\n"
+		"void main() { gl_Position = position; texCoord = position.xy * 0.5 + 0.5; }\n";
+
+	const char *fragmentSource =
+		"precision highp float;\n"
+		"uniform sampler2D image;\n"
+		"varying vec2 texCoord;\n"
+		"void main()\n"
+		"{\n"
+		"	vec4 color = vec4(0.0);\n"
+		"	for(int i = 0; i < 8; i++) { color += texture2D(image, texCoord + float(i) / 1024.0); }\n"
+		"	gl_FragColor = color / 8.0;\n"
+		"}\n";
+
+	GLuint program = compileProgram(vertexSource, fragmentSource);
+
+	if(!program)
+	{
+		return false;
+	}
+
+	glUseProgram(program);
+
+	static const GLfloat triangle[] = {-1, -1, 3, -1, -1, 3};
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, triangle);
+
+	printf("%dx%d, %dx%d texture, %d frames\n", width, height, TEXTURE_SIZE, TEXTURE_SIZE, frames);
+	printf("%-24s %10s %10s\n", "texupload", "ms/frame", "frames/s");
+
+	const GLenum formats[] = {GL_RGBA, GL_RGB, GL_LUMINANCE};
+	const char *labels[] = {"RGBA", "RGB", "LUMINANCE"};
+
+	for(int i = 0; i < 3; i++)
+	{
+		double time = measure(frames, formats[i]);
+		printf("%-24s %10.3f %10.1f\n", labels[i], 1000.0 * time / frames, frames / time);
+	}
+
+	glDeleteProgram(program);
+
+	return glGetError() == GL_NO_ERROR;
+}
+
+double TextureUploadBenchmark::measure(int frames, GLenum format)
+{
+	int bytes = (format == GL_RGBA) ? 4 : (format == GL_RGB) ? 3 : 1;
+	std::vector<unsigned char> image(TEXTURE_SIZE * TEXTURE_SIZE * bytes);
+
+	GLuint texture;
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexImage2D(GL_TEXTURE_2D, 0, format, TEXTURE_SIZE, TEXTURE_SIZE, 0, format, GL_UNSIGNED_BYTE, image.data());
+	glFinish();
+
+	double start = now();
+
+	for(int frame = 0; frame < frames; frame++)
+	{
+		memset(image.data(), frame, image.size());
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, TEXTURE_SIZE, TEXTURE_SIZE, format, GL_UNSIGNED_BYTE, image.data());
+		glDrawArrays(GL_TRIANGLES, 0, 3);
+		glFlush();
+	}
+
+	glFinish();
+	double time = now() - start;
+
+	glDeleteTextures(1, &texture);
+
+	return time;
+}
+
+// Renders many tiny blended and depth tested quads, which costs little to
+// rasterize, so the time is dominated by validating and applying state.
+class DrawCallBenchmark : public Benchmark
+{
+public:
+	bool run(int frames) override;
+
+private:
+	enum { DRAWS_PER_FRAME = 1000 };
+
+	double measure(int frames, bool uniformUpdates);
+	double measureMultiDraw(int frames);
+
+	GLint offsetLocation = -1;
+	PFNGLMULTIDRAWARRAYSEXTPROC multiDrawArrays = nullptr;
+};
+
+bool DrawCallBenchmark::run(int frames)
+{
+	const char *vertexSource =
+		"attribute vec4 position;\n"
+		"uniform vec2 offset;\n"
+		"varying vec2 texCoord;\n"
+		"void main() { gl_Position = vec4(position.xy * 0.01 + offset, 0.0, 1.0); texCoord = position.xy; }\n";
+
+	const char *fragmentSource =
+		"precision mediump float;\n"
+		"uniform sampler2D image;\n"
+		"varying vec2 texCoord;\n"
+		"void main() { gl_FragColor = texture2D(image, texCoord); }\n";
+
+	GLuint program = compileProgram(vertexSource, fragmentSource);
+
+	if(!program)
+	{
+		return false;
+	}
+
+	glUseProgram(program);
+	offsetLocation = glGetUniformLocation(program, "offset");
+
+	static const GLfloat quad[] = {0, 0, 1, 0, 0, 1, 1, 1};
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, quad);
+
+	static const GLubyte texels[] = {255, 0, 0, 128, 0, 255, 0, 128, 0, 0, 255, 128, 255, 255, 255, 128};
+	GLuint texture;
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 2, 2, 0, GL_RGBA, GL_UNSIGNED_BYTE, texels);
+
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glEnable(GL_DEPTH_TEST);
+
+	printf("%dx%d, %d draws per frame, %d frames\n", width, height, DRAWS_PER_FRAME, frames);
+	printf("%-24s %10s %10s\n", "drawcalls", "us/draw", "draws/s");
+
+	const char *labels[] = {"constant state", "uniform per draw"};
+
+	for(int i = 0; i < 2; i++)
+	{
+		double time = measure(frames, i == 1);
+		int draws = frames * DRAWS_PER_FRAME;
+		printf("%-24s %10.3f %10.0f\n", labels[i], 1000000.0 * time / draws, draws / time);
+	}
+
+	multiDrawArrays = (PFNGLMULTIDRAWARRAYSEXTPROC)eglGetProcAddress("glMultiDrawArraysEXT");
+
+	if(multiDrawArrays)
+	{
+		double time = measureMultiDraw(frames);
+		int draws = frames * DRAWS_PER_FRAME;
+		printf("%-24s %10.3f %10.0f\n", "multi-draw", 1000000.0 * time / draws, draws / time);
+	}
+
+	glDeleteTextures(1, &texture);
+	glDeleteProgram(program);
+
+	return glGetError() == GL_NO_ERROR;
+}
+
+double DrawCallBenchmark::measure(int frames, bool uniformUpdates)
+{
+	glUniform2f(offsetLocation, 0.0f, 0.0f);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	glFinish();
+
+	double start = now();
+
+	for(int frame = 0; frame < frames; frame++)
+	{
+		for(int draw = 0; draw < DRAWS_PER_FRAME; draw++)
+		{
+			if(uniformUpdates)
+			{
+				glUniform2f(offsetLocation, (draw % 40) * 0.05f - 1.0f, (draw / 40) * 0.08f - 1.0f);
+			}
+
+			glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+		}
+
+		glFlush();
+	}
+
+	glFinish();
+
+	return now() - start;
+}
+
+double DrawCallBenchmark::measureMultiDraw(int frames)
+{
+	std::vector<GLint> first(DRAWS_PER_FRAME, 0);
+	std::vector<GLsizei> count(DRAWS_PER_FRAME, 4);
+
+	glUniform2f(offsetLocation, 0.0f, 0.0f);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	glFinish();
+
+	double start = now();
+
+	for(int frame = 0; frame < frames; frame++)
+	{
+		multiDrawArrays(GL_TRIANGLE_STRIP, first.data(), count.data(), DRAWS_PER_FRAME);
+
+		glFlush();
+	}
+
+	glFinish();
+
+	return now() - start;
+}
+
+// Compiles each shader of a generated corpus repeatedly. Most of the time goes
+// to the GLSL front end and its register assignment, not to the JIT.
+class ShaderCompileBenchmark : public Benchmark
+{
+public:
+	bool run(int frames) override;
+
+private:
+	static std::string generateFragmentShader(int functions, int statements);
+	static std::string generateVertexShader(int statements);
+	static std::string generateBlockShader(int blocks, int statements);
+
+	bool measure(const char *label, GLenum type, const std::string &source, int frames);
+};
+
+static void append(std::string &source, const char *format, ...)
+{
+	char line[256];
+
+	va_list arguments;
+	va_start(arguments, format);
+	vsnprintf(line, sizeof(line), format, arguments);
+	va_end(arguments);
+
+	source += line;
+}
+
+// Helper functions with long chains of local temporaries and uniform reads
+std::string ShaderCompileBenchmark::generateFragmentShader(int functions, int statements)
+{
+	std::string source = "precision highp float;\n";
+
+	for(int i = 0; i < 128; i++) append(source, "uniform vec4 u%d;\n", i);
+	for(int i = 0; i < 8; i++) append(source, "uniform sampler2D s%d;\n", i);
+	for(int i = 0; i < 8; i++) append(source, "varying vec4 v%d;\n", i);
+
+	for(int f = 0; f < functions; f++)
+	{
+		append(source, "vec4 f%d(vec4 a, vec4 b)\n{\n", f);
+		append(source, "\tvec4 t0 = a * u%d + b;\n", f % 128);
+
+		for(int i = 1; i < statements; i++)
+		{
+			if(i % 10 == 0)
+			{
+				append(source, "\tif(t%d.x > u%d.y)\n\t{\n\t\tt%d = t%d.yzwx * 0.5;\n\t}\n", i / 2, (f + i) % 128, i - 1, i - 1);
+			}
+
+			append(source, "\tvec4 t%d = t%d * u%d + t%d;\n", i, i - 1, (f * 7 + i) % 128, i / 2);
+		}
+
+		append(source, "\treturn t%d;\n}\n", statements - 1);
+	}
+
+	source += "void main()\n{\n\tvec4 c = v0;\n";
+
+	for(int f = 0; f < functions; f++)
+	{
+		append(source, "\tc = f%d(c, v%d) + texture2D(s%d, c.xy);\n", f, f % 8, f % 8);
+	}
+
+	source += "\tgl_FragColor = c;\n}\n";
+
+	return source;
+}
+
+// Skinning and lighting with many attributes, varyings and uniform arrays
+std::string ShaderCompileBenchmark::generateVertexShader(int statements)
+{
+	std::string source = "attribute vec4 position;\nattribute vec4 weights;\nattribute vec4 indices;\n";
+
+	for(int i = 0; i < 8; i++) append(source, "attribute vec4 a%d;\n", i);
+	for(int i = 0; i < 12; i++) append(source, "varying vec4 v%d;\n", i);
+
+	source += "uniform mat4 bones[32];\nuniform vec4 lights[16];\nuniform mat4 viewProjection;\n";
+	source += "void main()\n{\n";
+	source += "\tmat4 skin = bones[int(indices.x)] * weights.x + bones[int(indices.y)] * weights.y;\n";
+	source += "\tvec4 p = skin * position;\n";
+
+	for(int i = 0; i < statements; i++)
+	{
+		append(source, "\tvec4 l%d = normalize(lights[%d] - p) * a%d + p * %d.0;\n", i, i % 16, i % 8, i % 5);
+		append(source, "\tv%d += l%d * dot(l%d, a%d);\n", i % 12, i, i, (i + 3) % 8);
+	}
+
+	source += "\tgl_Position = viewProjection * p;\n}\n";
+
+	return source;
+}
+
+// GLSL ES 3.00 with uniform blocks, nested scopes and loops
+std::string ShaderCompileBenchmark::generateBlockShader(int blocks, int statements)
+{
+	std::string source = "#version 300 es\nprecision highp float;\n";
+
+	for(int b = 0; b < blocks; b++)
+	{
+		append(source, "layout(std140) uniform Block%d\n{\n", b);
+
+		for(int m = 0; m < 12; m++)
+		{
+			append(source, "\tvec4 m%d_%d;\n", b, m);
+		}
+
+		source += "};\n";
+	}
+
+	source += "in vec4 color;\nout vec4 fragColor;\nvoid main()\n{\n\tvec4 c = color;\n";
+
+	for(int i = 0; i < statements; i++)
+	{
+		int b = i % blocks;
+
+		append(source, "\t{\n\t\tvec4 x%d = m%d_%d * c;\n", i, b, i % 12);
+		append(source, "\t\tfor(int j = 0; j < 4; j++)\n\t\t{\n\t\t\tx%d += m%d_%d * float(j);\n\t\t}\n", i, b, (i + 5) % 12);
+		append(source, "\t\tc = mix(c, x%d, m%d_%d.w);\n\t}\n", i, b, (i + 7) % 12);
+	}
+
+	source += "\tfragColor = c;\n}\n";
+
+	return source;
+}
+
+bool ShaderCompileBenchmark::run(int frames)
+{
+	printf("%d compiles per shader\n", frames);
+	printf("%-24s %10s %10s %10s\n", "compile", "lines", "ms/shader", "lines/ms");
+
+	bool success = true;
+
+	success = success && measure("fragment, 40 functions", GL_FRAGMENT_SHADER, generateFragmentShader(40, 60), frames);
+	success = success && measure("fragment, 8 functions", GL_FRAGMENT_SHADER, generateFragmentShader(8, 300), frames);
+	success = success && measure("vertex, skinning", GL_VERTEX_SHADER, generateVertexShader(1000), frames);
+	success = success && measure("fragment, uniform blocks", GL_FRAGMENT_SHADER, generateBlockShader(8, 400), frames);
+
+	return success && glGetError() == GL_NO_ERROR;
+}
+
+bool ShaderCompileBenchmark::measure(const char *label, GLenum type, const std::string &source, int frames)
+{
+	GLuint shader = glCreateShader(type);
+	const char *text = source.c_str();
+	glShaderSource(shader, 1, &text, nullptr);
+
+	glCompileShader(shader);   // Warm-up
+
+	GLint compiled = GL_FALSE;
+	glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+
+	if(!compiled)
+	{
+		char log[1024] = "";
+		glGetShaderInfoLog(shader, sizeof(log), nullptr, log);
+		fprintf(stderr, "Failed to compile %s shader: %s\n", label, log);
+		glDeleteShader(shader);
+		return false;
+	}
+
+	double start = now();
+
+	for(int frame = 0; frame < frames; frame++)
+	{
+		glCompileShader(shader);
+	}
+
+	double time = now() - start;
+
+	glDeleteShader(shader);
+
+	int lines = 0;
+	for(char c : source)
+	{
+		lines += (c == '\n');
+	}
+
+	double milliseconds = 1000.0 * time / frames;
+	printf("%-24s %10d %10.3f %10.1f\n", label, lines, milliseconds, lines / milliseconds);
+
+	return true;
+}
+
+int main(int argc, char *argv[])
+{
+	if(argc < 2 || argc > 3)
+	{
+		fprintf(stderr, "Usage: %s <scenario> [frames]\n", argv[0]);
+		fprintf(stderr, "Scenarios: readback, texupload, drawcalls, compile\n");
+		return 1;
+	}
+
+	int frames = (argc == 3) ? atoi(argv[2]) : 100;
+
+	if(frames <= 0)
+	{
+		fprintf(stderr, "Invalid frame count %s\n", argv[2]);
+		return 1;
+	}
+
+	Benchmark *benchmark = nullptr;
+
+	if(strcmp(argv[1], "readback") == 0)
+	{
+		benchmark = new ReadbackBenchmark();
+	}
+	else if(strcmp(argv[1], "texupload") == 0)
+	{
+		benchmark = new TextureUploadBenchmark();
+	}
+	else if(strcmp(argv[1], "drawcalls") == 0)
+	{
+		benchmark = new DrawCallBenchmark();
+	}
+	else if(strcmp(argv[1], "compile") == 0)
+	{
+		benchmark = new ShaderCompileBenchmark();
+	}
+	else
+	{
+		fprintf(stderr, "Unknown scenario %s\n", argv[1]);
+		return 1;
+	}
+
+	bool success = benchmark->initialize(1280, 720) && benchmark->run(frames);
+	delete benchmark;
+
+	return success ? 0 : 1;
+}
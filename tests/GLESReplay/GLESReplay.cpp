@@ -0,0 +1,1102 @@
+// Copyright 2017 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// GLESReplay.cpp: Replays an OpenGL ES call-stream trace recorded by
+// libGLESv2's capture layer (see src/OpenGL/libGLESv2/Capture.h) against an
+// offscreen pbuffer, and reports the CPU time, draw rate and number of
+// routines compiled for each frame, and how often buffer and texture updates
+// renamed storage in use by the renderer rather than waiting for it.
+//
+// Usage: GLESReplay <trace file>
+//
+// Traces are recorded by setting File in the [Capture] section of the
+// application's SwiftShader.ini. Replay from a directory without such a
+// SwiftShader.ini, or the replay itself gets captured.
+
+#include <EGL/egl.h>
+#include <GLES2/gl2.h>
+#include <GLES2/gl2ext.h>
+
+#include "OpenGL/libGLESv2/Capture.h"
+#include "OpenGL/libGLESv2/libGLESv2.hpp"
+
+#include <chrono>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <stdio.h>
+#include <string.h>
+
+extern "C" LibGLESv2exports *libGLESv2_swiftshader();
+
+class Trace
+{
+public:
+	bool load(const char *path)
+	{
+		FILE *file = fopen(path, "rb");
+
+		if(!file)
+		{
+			return false;
+		}
+
+		fseek(file, 0, SEEK_END);
+		long size = ftell(file);
+		fseek(file, 0, SEEK_SET);
+
+		bytes.resize(size);
+		bool success = (size == 0) || (fread(&bytes[0], 1, size, file) == (size_t)size);
+		fclose(file);
+
+		return success;
+	}
+
+	bool end() const
+	{
+		return position >= bytes.size();
+	}
+
+	unsigned short call()
+	{
+		if(position + 2 > bytes.size())
+		{
+			position = bytes.size();
+			return es2::CAPTURE_END;
+		}
+
+		unsigned short value = bytes[position] | (bytes[position + 1] << 8);
+		position += 2;
+
+		return value;
+	}
+
+	GLuint u()
+	{
+		if(position + 4 > bytes.size())
+		{
+			position = bytes.size();
+			return 0;
+		}
+
+		GLuint value = bytes[position] | (bytes[position + 1] << 8) | (bytes[position + 2] << 16) | ((GLuint)bytes[position + 3] << 24);
+		position += 4;
+
+		return value;
+	}
+
+	GLint i() { return (GLint)u(); }
+	GLboolean b() { return (GLboolean)u(); }
+
+	GLfloat f()
+	{
+		GLuint bits = u();
+		GLfloat value;
+		memcpy(&value, &bits, sizeof(value));
+
+		return value;
+	}
+
+	// Returns a pointer into the trace, which stays valid for the whole replay
+	const void *data(GLsizei *size = nullptr)
+	{
+		GLuint length = u();
+
+		if(position + length > bytes.size())
+		{
+			position = bytes.size();
+			length = 0;
+		}
+
+		const void *pointer = length ? &bytes[position] : nullptr;
+		position += length;
+
+		if(size)
+		{
+			*size = length;
+		}
+
+		return pointer;
+	}
+
+private:
+	std::vector<unsigned char> bytes;
+	size_t position = 0;
+};
+
+class Replayer
+{
+public:
+	Replayer(Trace &trace) : trace(trace)
+	{
+	}
+
+	~Replayer()
+	{
+		if(display != EGL_NO_DISPLAY)
+		{
+			eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+			eglTerminate(display);
+		}
+	}
+
+	bool run();
+
+private:
+	bool makeCurrent(EGLint width, EGLint height, EGLint clientVersion);
+	bool execute(unsigned short call);
+	void beginFrame();
+	void endFrame();
+
+	GLuint name(std::map<GLuint, GLuint> &names, GLuint captured)
+	{
+		return captured ? names[captured] : 0;
+	}
+
+	GLint location(GLint captured)
+	{
+		auto mapping = uniformLocations.find(std::make_pair(currentProgram, captured));
+
+		return (mapping != uniformLocations.end()) ? mapping->second : -1;
+	}
+
+	void genNames(std::map<GLuint, GLuint> &names, void (GL_APIENTRY *gen)(GLsizei, GLuint*));
+	void deleteNames(std::map<GLuint, GLuint> &names, void (GL_APIENTRY *del)(GLsizei, const GLuint*));
+
+	Trace &trace;
+
+	EGLDisplay display = EGL_NO_DISPLAY;
+	EGLConfig config = nullptr;
+	EGLContext context = EGL_NO_CONTEXT;
+	EGLSurface surface = EGL_NO_SURFACE;
+	EGLint surfaceWidth = 0;
+	EGLint surfaceHeight = 0;
+
+	// Captured object names to replayed ones. Shaders and programs share a namespace.
+	std::map<GLuint, GLuint> buffers;
+	std::map<GLuint, GLuint> textures;
+	std::map<GLuint, GLuint> framebuffers;
+	std::map<GLuint, GLuint> renderbuffers;
+	std::map<GLuint, GLuint> programs;
+	std::map<std::pair<GLuint, GLint>, GLint> uniformLocations;
+
+	// Extension entry points
+	PFNGLDRAWARRAYSINSTANCEDEXTPROC drawArraysInstanced = nullptr;
+	PFNGLDRAWELEMENTSINSTANCEDEXTPROC drawElementsInstanced = nullptr;
+	PFNGLVERTEXATTRIBDIVISOREXTPROC vertexAttribDivisor = nullptr;
+	PFNGLRENDERBUFFERSTORAGEMULTISAMPLEANGLEPROC renderbufferStorageMultisample = nullptr;
+
+	GLuint currentProgram = 0;   // Captured name
+	GLuint arrayBuffer = 0;      // Replayed name
+	std::vector<unsigned char> readback;
+
+	// Per-frame statistics
+	std::chrono::steady_clock::time_point frameStart;
+	int frameDraws = 0;
+	int frameRoutines = 0;
+
+	int frames = 0;
+	int draws = 0;
+	double totalTime = 0.0;
+	double minTime = 0.0;
+	double maxTime = 0.0;
+};
+
+static int routineCount()
+{
+	int vertexRoutines, setupRoutines, pixelRoutines;
+	libGLESv2_swiftshader()->getRoutineCounts(&vertexRoutines, &setupRoutines, &pixelRoutines);
+
+	return vertexRoutines + setupRoutines + pixelRoutines;
+}
+
+bool Replayer::makeCurrent(EGLint width, EGLint height, EGLint clientVersion)
+{
+	if(display == EGL_NO_DISPLAY)
+	{
+		display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+		if(!eglInitialize(display, nullptr, nullptr))
+		{
+			fprintf(stderr, "eglInitialize failed\n");
+			return false;
+		}
+
+		const EGLint configAttributes[] =
+		{
+			EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+			EGL_RENDERABLE_TYPE, EGL_OPENGL_ES2_BIT,
+			EGL_RED_SIZE, 8,
+			EGL_GREEN_SIZE, 8,
+			EGL_BLUE_SIZE, 8,
+			EGL_ALPHA_SIZE, 8,
+			EGL_DEPTH_SIZE, 24,
+			EGL_STENCIL_SIZE, 8,
+			EGL_NONE
+		};
+
+		EGLint numConfigs = 0;
+
+		if(!eglChooseConfig(display, configAttributes, &config, 1, &numConfigs) || numConfigs < 1)
+		{
+			fprintf(stderr, "eglChooseConfig failed\n");
+			return false;
+		}
+
+		const EGLint contextAttributes[] =
+		{
+			EGL_CONTEXT_CLIENT_VERSION, clientVersion,
+			EGL_NONE
+		};
+
+		context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttributes);
+
+		if(context == EGL_NO_CONTEXT)
+		{
+			fprintf(stderr, "eglCreateContext failed\n");
+			return false;
+		}
+
+		drawArraysInstanced = (PFNGLDRAWARRAYSINSTANCEDEXTPROC)eglGetProcAddress("glDrawArraysInstancedEXT");
+		drawElementsInstanced = (PFNGLDRAWELEMENTSINSTANCEDEXTPROC)eglGetProcAddress("glDrawElementsInstancedEXT");
+		vertexAttribDivisor = (PFNGLVERTEXATTRIBDIVISOREXTPROC)eglGetProcAddress("glVertexAttribDivisorEXT");
+		renderbufferStorageMultisample = (PFNGLRENDERBUFFERSTORAGEMULTISAMPLEANGLEPROC)eglGetProcAddress("glRenderbufferStorageMultisampleANGLE");
+	}
+
+	if(surface == EGL_NO_SURFACE || width != surfaceWidth || height != surfaceHeight)
+	{
+		const EGLint surfaceAttributes[] =
+		{
+			EGL_WIDTH, width,
+			EGL_HEIGHT, height,
+			EGL_NONE
+		};
+
+		EGLSurface pbuffer = eglCreatePbufferSurface(display, config, surfaceAttributes);
+
+		if(pbuffer == EGL_NO_SURFACE)
+		{
+			fprintf(stderr, "eglCreatePbufferSurface(%d, %d) failed\n", width, height);
+			return false;
+		}
+
+		eglMakeCurrent(display, pbuffer, pbuffer, context);
+
+		if(surface != EGL_NO_SURFACE)
+		{
+			eglDestroySurface(display, surface);
+		}
+
+		surface = pbuffer;
+		surfaceWidth = width;
+		surfaceHeight = height;
+	}
+
+	return true;
+}
+
+void Replayer::genNames(std::map<GLuint, GLuint> &names, void (GL_APIENTRY *gen)(GLsizei, GLuint*))
+{
+	GLsizei size = 0;
+	const GLuint *captured = static_cast<const GLuint*>(trace.data(&size));
+	GLsizei n = size / sizeof(GLuint);
+
+	std::vector<GLuint> replayed(n);
+	gen(n, replayed.data());
+
+	for(GLsizei i = 0; i < n; i++)
+	{
+		GLuint value;
+		memcpy(&value, &captured[i], sizeof(value));   // Trace data is not aligned
+		names[value] = replayed[i];
+	}
+}
+
+void Replayer::deleteNames(std::map<GLuint, GLuint> &names, void (GL_APIENTRY *del)(GLsizei, const GLuint*))
+{
+	GLsizei size = 0;
+	const GLuint *captured = static_cast<const GLuint*>(trace.data(&size));
+	GLsizei n = size / sizeof(GLuint);
+
+	std::vector<GLuint> replayed;
+
+	for(GLsizei i = 0; i < n; i++)
+	{
+		GLuint value;
+		memcpy(&value, &captured[i], sizeof(value));
+
+		auto mapping = names.find(value);
+
+		if(mapping != names.end())
+		{
+			replayed.push_back(mapping->second);
+			names.erase(mapping);
+		}
+	}
+
+	del((GLsizei)replayed.size(), replayed.data());
+}
+
+void Replayer::beginFrame()
+{
+	frameStart = std::chrono::steady_clock::now();
+	frameDraws = 0;
+	frameRoutines = routineCount();
+}
+
+void Replayer::endFrame()
+{
+	glFinish();
+
+	double time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frameStart).count();
+	int routines = routineCount() - frameRoutines;
+
+	printf("frame %5d: %8.3f ms, %6d draws, %10.0f draws/s, %4d routines compiled\n",
+	       frames, time, frameDraws, time > 0.0 ? frameDraws * 1000.0 / time : 0.0, routines);
+
+	minTime = (frames == 0 || time < minTime) ? time : minTime;
+	maxTime = (frames == 0 || time > maxTime) ? time : maxTime;
+	totalTime += time;
+	draws += frameDraws;
+	frames++;
+
+	beginFrame();
+}
+
+bool Replayer::run()
+{
+	GLuint magic = trace.u();
+	GLuint version = trace.u();
+
+	if(magic != es2::CAPTURE_MAGIC || version < 1 || version > es2::CAPTURE_VERSION)
+	{
+		fprintf(stderr, "Not a capture trace, or unsupported version\n");
+		return false;
+	}
+
+	beginFrame();
+
+	while(!trace.end())
+	{
+		unsigned short call = trace.call();
+
+		if(call == es2::CAPTURE_END)
+		{
+			break;
+		}
+
+		if(call != es2::CAPTURE_MakeCurrent && context == EGL_NO_CONTEXT)
+		{
+			fprintf(stderr, "Trace does not start with a MakeCurrent record\n");
+			return false;
+		}
+
+		if(!execute(call))
+		{
+			return false;
+		}
+	}
+
+	if(frameDraws > 0)   // Trailing partial frame
+	{
+		endFrame();
+	}
+
+	if(frames > 0)
+	{
+		printf("\n%d frames, %d draws, %d routines compiled\n", frames, draws, routineCount());
+		printf("frame time: %.3f ms average, %.3f ms min, %.3f ms max\n", totalTime / frames, minTime, maxTime);
+		printf("draw rate: %.0f draws/s\n", totalTime > 0.0 ? draws * 1000.0 / totalTime : 0.0);
+
+		int bufferRenames, bufferWaits, textureRenames, textureWaits;
+		libGLESv2_swiftshader()->getRenameCounts(&bufferRenames, &bufferWaits, &textureRenames, &textureWaits);
+		printf("updates of storage in use: buffers %d renamed, %d waited; textures %d renamed, %d waited\n",
+		       bufferRenames, bufferWaits, textureRenames, textureWaits);
+	}
+
+	return true;
+}
+
+bool Replayer::execute(unsigned short call)
+{
+	switch(call)
+	{
+	case es2::CAPTURE_MakeCurrent:
+		{
+			EGLint width = trace.i();
+			EGLint height = trace.i();
+			EGLint clientVersion = trace.i();
+
+			return makeCurrent(width, height, clientVersion);
+		}
+	case es2::CAPTURE_SwapBuffers:
+		endFrame();
+		break;
+	case es2::CAPTURE_ClientArray:
+		{
+			GLuint index = trace.u();
+			GLint size = trace.i();
+			GLenum type = trace.u();
+			GLboolean normalized = trace.b();
+			GLsizei stride = trace.i();
+			const void *data = trace.data();
+
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+			glVertexAttribPointer(index, size, type, normalized, stride, data);
+			glBindBuffer(GL_ARRAY_BUFFER, arrayBuffer);
+		}
+		break;
+	case es2::CAPTURE_ActiveTexture:
+		glActiveTexture(trace.u());
+		break;
+	case es2::CAPTURE_AttachShader:
+		{
+			GLuint program = name(programs, trace.u());
+			glAttachShader(program, name(programs, trace.u()));
+		}
+		break;
+	case es2::CAPTURE_BindAttribLocation:
+		{
+			GLuint program = name(programs, trace.u());
+			GLuint index = trace.u();
+			GLsizei size = 0;
+			const char *attribute = static_cast<const char*>(trace.data(&size));
+			glBindAttribLocation(program, index, std::string(attribute, size).c_str());
+		}
+		break;
+	case es2::CAPTURE_BindBuffer:
+		{
+			GLenum target = trace.u();
+			GLuint buffer = name(buffers, trace.u());
+
+			if(target == GL_ARRAY_BUFFER)
+			{
+				arrayBuffer = buffer;
+			}
+
+			glBindBuffer(target, buffer);
+		}
+		break;
+	case es2::CAPTURE_BindFramebuffer:
+		{
+			GLenum target = trace.u();
+			glBindFramebuffer(target, name(framebuffers, trace.u()));
+		}
+		break;
+	case es2::CAPTURE_BindRenderbuffer:
+		{
+			GLenum target = trace.u();
+			glBindRenderbuffer(target, name(renderbuffers, trace.u()));
+		}
+		break;
+	case es2::CAPTURE_BindTexture:
+		{
+			GLenum target = trace.u();
+			glBindTexture(target, name(textures, trace.u()));
+		}
+		break;
+	case es2::CAPTURE_BlendColor:
+		{
+			GLfloat red = trace.f();
+			GLfloat green = trace.f();
+			GLfloat blue = trace.f();
+			glBlendColor(red, green, blue, trace.f());
+		}
+		break;
+	case es2::CAPTURE_BlendEquationSeparate:
+		{
+			GLenum modeRGB = trace.u();
+			glBlendEquationSeparate(modeRGB, trace.u());
+		}
+		break;
+	case es2::CAPTURE_BlendFuncSeparate:
+		{
+			GLenum srcRGB = trace.u();
+			GLenum dstRGB = trace.u();
+			GLenum srcAlpha = trace.u();
+			glBlendFuncSeparate(srcRGB, dstRGB, srcAlpha, trace.u());
+		}
+		break;
+	case es2::CAPTURE_BufferData:
+		{
+			GLenum target = trace.u();
+			GLsizeiptr size = trace.u();
+			GLenum usage = trace.u();
+			glBufferData(target, size, trace.data(), usage);
+		}
+		break;
+	case es2::CAPTURE_BufferSubData:
+		{
+			GLenum target = trace.u();
+			GLintptr offset = trace.u();
+			GLsizei size = 0;
+			const void *data = trace.data(&size);
+			glBufferSubData(target, offset, size, data);
+		}
+		break;
+	case es2::CAPTURE_Clear:
+		glClear(trace.u());
+		break;
+	case es2::CAPTURE_ClearColor:
+		{
+			GLfloat red = trace.f();
+			GLfloat green = trace.f();
+			GLfloat blue = trace.f();
+			glClearColor(red, green, blue, trace.f());
+		}
+		break;
+	case es2::CAPTURE_ClearDepthf:
+		glClearDepthf(trace.f());
+		break;
+	case es2::CAPTURE_ClearStencil:
+		glClearStencil(trace.i());
+		break;
+	case es2::CAPTURE_ColorMask:
+		{
+			GLboolean red = trace.b();
+			GLboolean green = trace.b();
+			GLboolean blue = trace.b();
+			glColorMask(red, green, blue, trace.b());
+		}
+		break;
+	case es2::CAPTURE_CompileShader:
+		glCompileShader(name(programs, trace.u()));
+		break;
+	case es2::CAPTURE_CompressedTexImage2D:
+		{
+			GLenum target = trace.u();
+			GLint level = trace.i();
+			GLenum internalformat = trace.u();
+			GLsizei width = trace.i();
+			GLsizei height = trace.i();
+			GLint border = trace.i();
+			GLsizei size = 0;
+			const void *data = trace.data(&size);
+			glCompressedTexImage2D(target, level, internalformat, width, height, border, size, data);
+		}
+		break;
+	case es2::CAPTURE_CompressedTexSubImage2D:
+		{
+			GLenum target = trace.u();
+			GLint level = trace.i();
+			GLint xoffset = trace.i();
+			GLint yoffset = trace.i();
+			GLsizei width = trace.i();
+			GLsizei height = trace.i();
+			GLenum format = trace.u();
+			GLsizei size = 0;
+			const void *data = trace.data(&size);
+			glCompressedTexSubImage2D(target, level, xoffset, yoffset, width, height, format, size, data);
+		}
+		break;
+	case es2::CAPTURE_CopyTexImage2D:
+		{
+			GLenum target = trace.u();
+			GLint level = trace.i();
+			GLenum internalformat = trace.u();
+			GLint x = trace.i();
+			GLint y = trace.i();
+			GLsizei width = trace.i();
+			GLsizei height = trace.i();
+			glCopyTexImage2D(target, level, internalformat, x, y, width, height, trace.i());
+		}
+		break;
+	case es2::CAPTURE_CopyTexSubImage2D:
+		{
+			GLenum target = trace.u();
+			GLint level = trace.i();
+			GLint xoffset = trace.i();
+			GLint yoffset = trace.i();
+			GLint x = trace.i();
+			GLint y = trace.i();
+			GLsizei width = trace.i();
+			glCopyTexSubImage2D(target, level, xoffset, yoffset, x, y, width, trace.i());
+		}
+		break;
+	case es2::CAPTURE_CreateProgram:
+		programs[trace.u()] = glCreateProgram();
+		break;
+	case es2::CAPTURE_CreateShader:
+		{
+			GLenum type = trace.u();
+			programs[trace.u()] = glCreateShader(type);
+		}
+		break;
+	case es2::CAPTURE_CullFace:
+		glCullFace(trace.u());
+		break;
+	case es2::CAPTURE_DeleteBuffers:
+		deleteNames(buffers, glDeleteBuffers);
+		break;
+	case es2::CAPTURE_DeleteFramebuffers:
+		deleteNames(framebuffers, glDeleteFramebuffers);
+		break;
+	case es2::CAPTURE_DeleteProgram:
+	case es2::CAPTURE_DeleteShader:
+		{
+			GLuint captured = trace.u();
+			GLuint replayed = name(programs, captured);
+
+			if(call == es2::CAPTURE_DeleteProgram)
+			{
+				glDeleteProgram(replayed);
+			}
+			else
+			{
+				glDeleteShader(replayed);
+			}
+
+			programs.erase(captured);
+		}
+		break;
+	case es2::CAPTURE_DeleteRenderbuffers:
+		deleteNames(renderbuffers, glDeleteRenderbuffers);
+		break;
+	case es2::CAPTURE_DeleteTextures:
+		deleteNames(textures, glDeleteTextures);
+		break;
+	case es2::CAPTURE_DepthFunc:
+		glDepthFunc(trace.u());
+		break;
+	case es2::CAPTURE_DepthMask:
+		glDepthMask(trace.b());
+		break;
+	case es2::CAPTURE_DepthRangef:
+		{
+			GLfloat zNear = trace.f();
+			glDepthRangef(zNear, trace.f());
+		}
+		break;
+	case es2::CAPTURE_DetachShader:
+		{
+			GLuint program = name(programs, trace.u());
+			glDetachShader(program, name(programs, trace.u()));
+		}
+		break;
+	case es2::CAPTURE_Disable:
+		glDisable(trace.u());
+		break;
+	case es2::CAPTURE_DisableVertexAttribArray:
+		glDisableVertexAttribArray(trace.u());
+		break;
+	case es2::CAPTURE_DrawArrays:
+	case es2::CAPTURE_DrawArraysInstanced:
+		{
+			GLenum mode = trace.u();
+			GLint first = trace.i();
+			GLsizei count = trace.i();
+
+			if(call == es2::CAPTURE_DrawArraysInstanced)
+			{
+				drawArraysInstanced(mode, first, count, trace.i());
+			}
+			else
+			{
+				glDrawArrays(mode, first, count);
+			}
+
+			frameDraws++;
+		}
+		break;
+	case es2::CAPTURE_DrawElements:
+	case es2::CAPTURE_DrawElementsInstanced:
+		{
+			GLenum mode = trace.u();
+			GLsizei count = trace.i();
+			GLenum type = trace.u();
+			GLsizei instanceCount = (call == es2::CAPTURE_DrawElementsInstanced) ? trace.i() : 1;
+			GLuint offset = trace.u();
+			const void *indices = trace.data();
+
+			if(!indices)
+			{
+				indices = reinterpret_cast<const void*>((size_t)offset);
+			}
+
+			if(call == es2::CAPTURE_DrawElementsInstanced)
+			{
+				drawElementsInstanced(mode, count, type, indices, instanceCount);
+			}
+			else
+			{
+				glDrawElements(mode, count, type, indices);
+			}
+
+			frameDraws++;
+		}
+		break;
+	case es2::CAPTURE_Enable:
+		glEnable(trace.u());
+		break;
+	case es2::CAPTURE_EnableVertexAttribArray:
+		glEnableVertexAttribArray(trace.u());
+		break;
+	case es2::CAPTURE_Finish:
+		glFinish();
+		break;
+	case es2::CAPTURE_Flush:
+		glFlush();
+		break;
+	case es2::CAPTURE_FramebufferRenderbuffer:
+		{
+			GLenum target = trace.u();
+			GLenum attachment = trace.u();
+			GLenum renderbuffertarget = trace.u();
+			glFramebufferRenderbuffer(target, attachment, renderbuffertarget, name(renderbuffers, trace.u()));
+		}
+		break;
+	case es2::CAPTURE_FramebufferTexture2D:
+		{
+			GLenum target = trace.u();
+			GLenum attachment = trace.u();
+			GLenum textarget = trace.u();
+			GLuint texture = name(textures, trace.u());
+			glFramebufferTexture2D(target, attachment, textarget, texture, trace.i());
+		}
+		break;
+	case es2::CAPTURE_FrontFace:
+		glFrontFace(trace.u());
+		break;
+	case es2::CAPTURE_GenBuffers:
+		genNames(buffers, glGenBuffers);
+		break;
+	case es2::CAPTURE_GenerateMipmap:
+		glGenerateMipmap(trace.u());
+		break;
+	case es2::CAPTURE_GenFramebuffers:
+		genNames(framebuffers, glGenFramebuffers);
+		break;
+	case es2::CAPTURE_GenRenderbuffers:
+		genNames(renderbuffers, glGenRenderbuffers);
+		break;
+	case es2::CAPTURE_GenTextures:
+		genNames(textures, glGenTextures);
+		break;
+	case es2::CAPTURE_GetAttribLocation:
+		// Attribute locations are assigned deterministically at link time, so the
+		// captured indices are used as-is.
+		trace.u();
+		trace.i();
+		trace.data();
+		break;
+	case es2::CAPTURE_GetUniformLocation:
+		{
+			GLuint program = trace.u();
+			GLint captured = trace.i();
+			GLsizei size = 0;
+			const char *uniform = static_cast<const char*>(trace.data(&size));
+
+			uniformLocations[std::make_pair(program, captured)] = glGetUniformLocation(name(programs, program), std::string(uniform, size).c_str());
+		}
+		break;
+	case es2::CAPTURE_Hint:
+		{
+			GLenum target = trace.u();
+			glHint(target, trace.u());
+		}
+		break;
+	case es2::CAPTURE_LineWidth:
+		glLineWidth(trace.f());
+		break;
+	case es2::CAPTURE_LinkProgram:
+		glLinkProgram(name(programs, trace.u()));
+		break;
+	case es2::CAPTURE_PixelStorei:
+		{
+			GLenum pname = trace.u();
+			glPixelStorei(pname, trace.i());
+		}
+		break;
+	case es2::CAPTURE_PolygonOffset:
+		{
+			GLfloat factor = trace.f();
+			glPolygonOffset(factor, trace.f());
+		}
+		break;
+	case es2::CAPTURE_ReadPixels:
+		{
+			GLint x = trace.i();
+			GLint y = trace.i();
+			GLsizei width = trace.i();
+			GLsizei height = trace.i();
+			GLenum format = trace.u();
+			GLenum type = trace.u();
+
+			// Large enough for any format and type combination
+			readback.resize((size_t)width * height * 16);
+			glReadPixels(x, y, width, height, format, type, readback.data());
+		}
+		break;
+	case es2::CAPTURE_RenderbufferStorage:
+		{
+			GLenum target = trace.u();
+			GLenum internalformat = trace.u();
+			GLsizei width = trace.i();
+			glRenderbufferStorage(target, internalformat, width, trace.i());
+		}
+		break;
+	case es2::CAPTURE_RenderbufferStorageMultisample:
+		{
+			GLenum target = trace.u();
+			GLsizei samples = trace.i();
+			GLenum internalformat = trace.u();
+			GLsizei width = trace.i();
+			renderbufferStorageMultisample(target, samples, internalformat, width, trace.i());
+		}
+		break;
+	case es2::CAPTURE_SampleCoverage:
+		{
+			GLfloat value = trace.f();
+			glSampleCoverage(value, trace.b());
+		}
+		break;
+	case es2::CAPTURE_Scissor:
+		{
+			GLint x = trace.i();
+			GLint y = trace.i();
+			GLsizei width = trace.i();
+			glScissor(x, y, width, trace.i());
+		}
+		break;
+	case es2::CAPTURE_ShaderSource:
+		{
+			GLuint shader = name(programs, trace.u());
+			GLsizei size = 0;
+			const GLchar *source = static_cast<const GLchar*>(trace.data(&size));
+			GLint length = size;
+			glShaderSource(shader, 1, &source, &length);
+		}
+		break;
+	case es2::CAPTURE_StencilFuncSeparate:
+		{
+			GLenum face = trace.u();
+			GLenum func = trace.u();
+			GLint ref = trace.i();
+			glStencilFuncSeparate(face, func, ref, trace.u());
+		}
+		break;
+	case es2::CAPTURE_StencilMaskSeparate:
+		{
+			GLenum face = trace.u();
+			glStencilMaskSeparate(face, trace.u());
+		}
+		break;
+	case es2::CAPTURE_StencilOpSeparate:
+		{
+			GLenum face = trace.u();
+			GLenum fail = trace.u();
+			GLenum zfail = trace.u();
+			glStencilOpSeparate(face, fail, zfail, trace.u());
+		}
+		break;
+	case es2::CAPTURE_TexImage2D:
+		{
+			GLenum target = trace.u();
+			GLint level = trace.i();
+			GLint internalformat = trace.i();
+			GLsizei width = trace.i();
+			GLsizei height = trace.i();
+			GLint border = trace.i();
+			GLenum format = trace.u();
+			GLenum type = trace.u();
+			GLuint offset = trace.u();
+			const void *pixels = trace.data();
+
+			if(!pixels)
+			{
+				pixels = reinterpret_cast<const void*>((size_t)offset);
+			}
+
+			glTexImage2D(target, level, internalformat, width, height, border, format, type, pixels);
+		}
+		break;
+	case es2::CAPTURE_TexParameterf:
+		{
+			GLenum target = trace.u();
+			GLenum pname = trace.u();
+			glTexParameterf(target, pname, trace.f());
+		}
+		break;
+	case es2::CAPTURE_TexParameteri:
+		{
+			GLenum target = trace.u();
+			GLenum pname = trace.u();
+			glTexParameteri(target, pname, trace.i());
+		}
+		break;
+	case es2::CAPTURE_TexParameterfv:
+	case es2::CAPTURE_TexParameteriv:
+		{
+			GLenum target = trace.u();
+			GLenum pname = trace.u();
+			GLsizei size = 0;
+			const void *data = trace.data(&size);
+
+			std::vector<GLuint> values(size / sizeof(GLuint));   // Aligned copy
+			memcpy(values.data(), data, values.size() * sizeof(GLuint));
+
+			if(call == es2::CAPTURE_TexParameterfv)
+			{
+				glTexParameterfv(target, pname, reinterpret_cast<const GLfloat*>(values.data()));
+			}
+			else
+			{
+				glTexParameteriv(target, pname, reinterpret_cast<const GLint*>(values.data()));
+			}
+		}
+		break;
+	case es2::CAPTURE_TexSubImage2D:
+		{
+			GLenum target = trace.u();
+			GLint level = trace.i();
+			GLint xoffset = trace.i();
+			GLint yoffset = trace.i();
+			GLsizei width = trace.i();
+			GLsizei height = trace.i();
+			GLenum format = trace.u();
+			GLenum type = trace.u();
+			GLuint offset = trace.u();
+			const void *pixels = trace.data();
+
+			if(!pixels)
+			{
+				pixels = reinterpret_cast<const void*>((size_t)offset);
+			}
+
+			glTexSubImage2D(target, level, xoffset, yoffset, width, height, format, type, pixels);
+		}
+		break;
+	case es2::CAPTURE_Uniformfv:
+	case es2::CAPTURE_Uniformiv:
+		{
+			GLint components = trace.i();
+			GLint uniform = location(trace.i());
+			GLsizei count = trace.i();
+			GLsizei size = 0;
+			const void *data = trace.data(&size);
+
+			std::vector<GLuint> values(size / sizeof(GLuint));   // Aligned copy
+			memcpy(values.data(), data, values.size() * sizeof(GLuint));
+
+			const GLfloat *f = reinterpret_cast<const GLfloat*>(values.data());
+			const GLint *i = reinterpret_cast<const GLint*>(values.data());
+
+			switch(components + (call == es2::CAPTURE_Uniformiv ? 4 : 0))
+			{
+			case 1: glUniform1fv(uniform, count, f); break;
+			case 2: glUniform2fv(uniform, count, f); break;
+			case 3: glUniform3fv(uniform, count, f); break;
+			case 4: glUniform4fv(uniform, count, f); break;
+			case 5: glUniform1iv(uniform, count, i); break;
+			case 6: glUniform2iv(uniform, count, i); break;
+			case 7: glUniform3iv(uniform, count, i); break;
+			case 8: glUniform4iv(uniform, count, i); break;
+			default: break;
+			}
+		}
+		break;
+	case es2::CAPTURE_UniformMatrixfv:
+		{
+			GLint columns = trace.i();
+			GLint uniform = location(trace.i());
+			GLsizei count = trace.i();
+			GLboolean transpose = trace.b();
+			GLsizei size = 0;
+			const void *data = trace.data(&size);
+
+			std::vector<GLfloat> values(size / sizeof(GLfloat));
+			memcpy(values.data(), data, values.size() * sizeof(GLfloat));
+
+			switch(columns)
+			{
+			case 2: glUniformMatrix2fv(uniform, count, transpose, values.data()); break;
+			case 3: glUniformMatrix3fv(uniform, count, transpose, values.data()); break;
+			case 4: glUniformMatrix4fv(uniform, count, transpose, values.data()); break;
+			default: break;
+			}
+		}
+		break;
+	case es2::CAPTURE_UseProgram:
+		currentProgram = trace.u();
+		glUseProgram(name(programs, currentProgram));
+		break;
+	case es2::CAPTURE_VertexAttrib4f:
+		{
+			GLuint index = trace.u();
+			GLfloat x = trace.f();
+			GLfloat y = trace.f();
+			GLfloat z = trace.f();
+			glVertexAttrib4f(index, x, y, z, trace.f());
+		}
+		break;
+	case es2::CAPTURE_VertexAttribDivisor:
+		{
+			GLuint index = trace.u();
+			vertexAttribDivisor(index, trace.u());
+		}
+		break;
+	case es2::CAPTURE_VertexAttribPointer:
+		{
+			GLuint index = trace.u();
+			GLint size = trace.i();
+			GLenum type = trace.u();
+			GLboolean normalized = trace.b();
+			GLsizei stride = trace.i();
+			GLuint buffer = trace.u();
+			GLuint offset = trace.u();
+
+			if(buffer)   // Client-side arrays are specified by ClientArray records at draw time
+			{
+				glVertexAttribPointer(index, size, type, normalized, stride, reinterpret_cast<const void*>((size_t)offset));
+			}
+		}
+		break;
+	case es2::CAPTURE_Viewport:
+		{
+			GLint x = trace.i();
+			GLint y = trace.i();
+			GLsizei width = trace.i();
+			glViewport(x, y, width, trace.i());
+		}
+		break;
+	default:
+		fprintf(stderr, "Unknown capture record %d\n", call);
+		return false;
+	}
+
+	return true;
+}
+
+int main(int argc, char *argv[])
+{
+	if(argc != 2)
+	{
+		fprintf(stderr, "Usage: %s <trace file>\n", argv[0]);
+		return 1;
+	}
+
+	Trace trace;
+
+	if(!trace.load(argv[1]))
+	{
+		fprintf(stderr, "Failed to read %s\n", argv[1]);
+		return 1;
+	}
+
+	Replayer replayer(trace);
+
+	return replayer.run() ? 0 : 1;
+}
@@ -18,6 +18,11 @@
 #include <EGL/egl.h>
 #include <GLES2/gl2.h>
 
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
 #if defined(_WIN32)
 #include <Windows.h>
 #endif
@@ -185,3 +190,751 @@ TEST_F(SwiftShaderTest, Initalization)
 	EXPECT_EQ(EGL_SUCCESS, eglGetError());
 	EXPECT_EQ((EGLBoolean)EGL_TRUE, success);
 }
+
+// Renders a quad with a given fragment shader, to check the results of the shader optimizations
+class ShaderOptimizationTest : public SwiftShaderTest
+{
+protected:
+	void SetUp() override
+	{
+		SwiftShaderTest::SetUp();
+
+		display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+		eglInitialize(display, nullptr, nullptr);
+
+		const EGLint configAttributes[] =
+		{
+			EGL_SURFACE_TYPE,		EGL_PBUFFER_BIT,
+			EGL_RENDERABLE_TYPE,	EGL_OPENGL_ES2_BIT,
+			EGL_RED_SIZE,			8,
+			EGL_GREEN_SIZE,			8,
+			EGL_BLUE_SIZE,			8,
+			EGL_ALPHA_SIZE,			8,
+			EGL_NONE
+		};
+
+		EGLConfig config;
+		EGLint num_config = -1;
+		eglChooseConfig(display, configAttributes, &config, 1, &num_config);
+		ASSERT_EQ(num_config, 1);
+
+		const EGLint surfaceAttributes[] =
+		{
+			EGL_WIDTH, width,
+			EGL_HEIGHT, height,
+			EGL_NONE
+		};
+
+		surface = eglCreatePbufferSurface(display, config, surfaceAttributes);
+		ASSERT_NE(EGL_NO_SURFACE, surface);
+
+		const EGLint contextAttributes[] =
+		{
+			EGL_CONTEXT_CLIENT_VERSION, 3,
+			EGL_NONE
+		};
+
+		context = eglCreateContext(display, config, NULL, contextAttributes);
+		ASSERT_NE(EGL_NO_CONTEXT, context);
+
+		EXPECT_EQ((EGLBoolean)EGL_TRUE, eglMakeCurrent(display, surface, surface, context));
+	}
+
+	void TearDown() override
+	{
+		eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+		eglDestroyContext(display, context);
+		eglDestroySurface(display, surface);
+		eglTerminate(display);
+	}
+
+	// Uniforms 'u' and 'v' are set to (0.1, 0.2, 0.3, 0.4) and (0.5, 0.6, 0.7, 0.8). The
+	// input 'coord' goes from -1.0 to 1.0 across the surface.
+	void draw(const char *fragmentSource)
+	{
+		const char *vertexSource =
+			"#version 300 es\n"
+			"in vec4 position;\n"
+			"out vec2 coord;\n"
+			"void main()\n"
+			"{\n"
+			"	coord = position.xy;\n"
+			"	gl_Position = position;\n"
+			"}\n";
+
+		GLuint vertexShader = compile(GL_VERTEX_SHADER, vertexSource);
+		GLuint fragmentShader = compile(GL_FRAGMENT_SHADER, fragmentSource);
+
+		GLuint program = glCreateProgram();
+		glAttachShader(program, vertexShader);
+		glAttachShader(program, fragmentShader);
+		glBindAttribLocation(program, 0, "position");
+		glLinkProgram(program);
+
+		GLint linked = GL_FALSE;
+		glGetProgramiv(program, GL_LINK_STATUS, &linked);
+		EXPECT_EQ(GL_TRUE, linked);
+
+		glUseProgram(program);
+
+		const GLfloat u[4] = {0.1f, 0.2f, 0.3f, 0.4f};
+		const GLfloat v[4] = {0.5f, 0.6f, 0.7f, 0.8f};
+		glUniform4fv(glGetUniformLocation(program, "u"), 1, u);
+		glUniform4fv(glGetUniformLocation(program, "v"), 1, v);
+
+		const GLfloat quad[] =
+		{
+			-1.0f, -1.0f, 0.0f, 1.0f,
+			 1.0f, -1.0f, 0.0f, 1.0f,
+			-1.0f,  1.0f, 0.0f, 1.0f,
+			 1.0f,  1.0f, 0.0f, 1.0f,
+		};
+
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0, quad);
+		glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+		EXPECT_EQ((GLenum)GL_NO_ERROR, glGetError());
+
+		glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+		EXPECT_EQ((GLenum)GL_NO_ERROR, glGetError());
+
+		glDeleteProgram(program);
+		glDeleteShader(vertexShader);
+		glDeleteShader(fragmentShader);
+	}
+
+	GLuint compile(GLenum type, const char *source)
+	{
+		GLuint shader = glCreateShader(type);
+		glShaderSource(shader, 1, &source, nullptr);
+		glCompileShader(shader);
+
+		GLint compiled = GL_FALSE;
+		glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+		EXPECT_EQ(GL_TRUE, compiled);
+
+		return shader;
+	}
+
+	// Compares the pixel at (x, y) against a floating-point color, allowing for rounding
+	void expectPixel(int x, int y, float r, float g, float b, float a)
+	{
+		const float expected[4] = {r, g, b, a};
+		const unsigned char *pixel = &pixels[(y * width + x) * 4];
+
+		for(int i = 0; i < 4; i++)
+		{
+			EXPECT_NEAR(expected[i] * 255.0f, pixel[i], 1.0f) << "component " << i << " of pixel (" << x << ", " << y << ")";
+		}
+	}
+
+	static const int width = 8;
+	static const int height = 8;
+
+	EGLDisplay display;
+	EGLSurface surface;
+	EGLContext context;
+
+	unsigned char pixels[width * height * 4];
+};
+
+TEST_F(ShaderOptimizationTest, FoldsLiteralArithmetic)
+{
+	draw("#version 300 es\n"
+	     "precision highp float;\n"
+	     "out vec4 color;\n"
+	     "void main()\n"
+	     "{\n"
+	     "	vec4 a = vec4(0.25, 0.5, 0.75, 1.0);\n"
+	     "	vec4 b = a * 2.0 - vec4(0.25);\n"
+	     "	float c = dot(a, vec4(1.0, 0.0, 0.0, 0.0)) + max(a.y, 0.125);\n"
+	     "	color = vec4(b.x, b.y * 0.5, c, sqrt(0.25));\n"
+	     "}\n");
+
+	for(int y = 0; y < height; y++)
+	{
+		for(int x = 0; x < width; x++)
+		{
+			expectPixel(x, y, 0.25f, 0.375f, 0.75f, 0.5f);
+		}
+	}
+}
+
+TEST_F(ShaderOptimizationTest, PropagatesPartiallyOverwrittenMoves)
+{
+	draw("#version 300 es\n"
+	     "precision highp float;\n"
+	     "uniform vec4 u;\n"
+	     "out vec4 color;\n"
+	     "void main()\n"
+	     "{\n"
+	     "	vec4 t = u;\n"
+	     "	t.yz = u.wx;\n"          // Only the x and w components still hold a copy of u
+	     "	vec4 s = t;\n"
+	     "	s.x = t.z * 2.0;\n"
+	     "	s.w = u.y;\n"
+	     "	color = s;\n"
+	     "}\n");
+
+	for(int y = 0; y < height; y++)
+	{
+		for(int x = 0; x < width; x++)
+		{
+			expectPixel(x, y, 0.2f, 0.4f, 0.1f, 0.2f);
+		}
+	}
+}
+
+TEST_F(ShaderOptimizationTest, EliminatesCommonSubexpressions)
+{
+	draw("#version 300 es\n"
+	     "precision highp float;\n"
+	     "uniform vec4 u;\n"
+	     "uniform vec4 v;\n"
+	     "out vec4 color;\n"
+	     "void main()\n"
+	     "{\n"
+	     "	vec4 x = u;\n"
+	     "	vec4 a = x * v;\n"
+	     "	vec4 b = x * v;\n"       // Same value as a
+	     "	x.y = 1.0;\n"
+	     "	vec4 c = x * v;\n"       // Operand changed, can't reuse a
+	     "	color = vec4(a.x + b.x, c.y, a.y, b.z + c.z);\n"
+	     "}\n");
+
+	for(int y = 0; y < height; y++)
+	{
+		for(int x = 0; x < width; x++)
+		{
+			expectPixel(x, y, 0.1f, 0.6f, 0.12f, 0.42f);
+		}
+	}
+}
+
+TEST_F(ShaderOptimizationTest, DerivativesInNonUniformControlFlow)
+{
+	// Values computed where only some pixels of a quad are active are undefined in the other
+	// pixels, since those keep their previous contents, and so are derivatives of them. This
+	// holds with or without the optimizations. Derivatives taken in uniform control flow, or in
+	// branches taken by whole quads, are exact and must not get moved into the other branches.
+	draw("#version 300 es\n"
+	     "precision highp float;\n"
+	     "in vec2 coord;\n"
+	     "out vec4 color;\n"
+	     "void main()\n"
+	     "{\n"
+	     "	float d = dFdx(coord.x);\n"
+	     "	vec4 c = vec4(d, 0.0, 0.0, 1.0);\n"
+	     "	if(gl_FragCoord.x < 1.0)\n"   // Part of a quad
+	     "	{\n"
+	     "		c.y = d * 2.0;\n"
+	     "	}\n"
+	     "	if(gl_FragCoord.x < 2.0)\n"   // Whole quads
+	     "	{\n"
+	     "		c.z = dFdx(coord.x * 2.0);\n"
+	     "	}\n"
+	     "	color = c;\n"
+	     "}\n");
+
+	// The input changes by 2.0 across 8 pixels
+	for(int y = 0; y < height; y++)
+	{
+		expectPixel(0, y, 0.25f, 0.5f, 0.5f, 1.0f);
+		expectPixel(1, y, 0.25f, 0.0f, 0.5f, 1.0f);
+
+		for(int x = 2; x < width; x++)
+		{
+			expectPixel(x, y, 0.25f, 0.0f, 0.0f, 1.0f);
+		}
+	}
+}
+
+TEST_F(ShaderOptimizationTest, ImplicitLodAfterNonUniformReturn)
+{
+	// Each mipmap level has a distinct color, so the result shows which level got selected
+	const GLubyte levelColor[4][4] =
+	{
+		{255, 0, 0, 255},
+		{0, 255, 0, 255},
+		{0, 0, 255, 255},
+		{255, 255, 255, 255},
+	};
+
+	GLuint texture;
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D, texture);
+
+	for(int level = 0; level < 4; level++)
+	{
+		int size = width >> level;
+		std::vector<GLubyte> texels(size * size * 4);
+
+		for(int i = 0; i < size * size; i++)
+		{
+			memcpy(&texels[i * 4], levelColor[level], 4);
+		}
+
+		glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA, size, size, 0, GL_RGBA, GL_UNSIGNED_BYTE, texels.data());
+	}
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	EXPECT_EQ((GLenum)GL_NO_ERROR, glGetError());
+
+	// After a return taken by part of a quad, the texture lookup is in non-uniform control
+	// flow and its derivatives are undefined. The level selected for the other pixel of such
+	// a quad may differ between runs and between optimization levels. Whole quads sample one
+	// texel per pixel, which is level 0.
+	draw("#version 300 es\n"
+	     "precision highp float;\n"
+	     "uniform sampler2D s;\n"
+	     "in vec2 coord;\n"
+	     "out vec4 color;\n"
+	     "vec4 shade(vec2 uv)\n"
+	     "{\n"
+	     "	if(gl_FragCoord.x < 1.0)\n"
+	     "	{\n"
+	     "		return vec4(0.0, 0.0, 0.0, 1.0);\n"
+	     "	}\n"
+	     "	return texture(s, uv);\n"
+	     "}\n"
+	     "void main()\n"
+	     "{\n"
+	     "	color = shade(coord * 0.5 + 0.5);\n"
+	     "}\n");
+
+	for(int y = 0; y < height; y++)
+	{
+		expectPixel(0, y, 0.0f, 0.0f, 0.0f, 1.0f);
+
+		const unsigned char *pixel = &pixels[(y * width + 1) * 4];
+		bool anyLevel = false;
+
+		for(int level = 0; level < 4; level++)
+		{
+			anyLevel = anyLevel || memcmp(pixel, levelColor[level], 4) == 0;
+		}
+
+		EXPECT_TRUE(anyLevel) << "pixel (1, " << y << ")";
+
+		for(int x = 2; x < width; x++)
+		{
+			expectPixel(x, y, 1.0f, 0.0f, 0.0f, 1.0f);
+		}
+	}
+
+	glDeleteTextures(1, &texture);
+}
+
+TEST_F(ShaderOptimizationTest, UnrollsConstantLoops)
+{
+	draw("#version 300 es\n"
+	     "precision highp float;\n"
+	     "uniform vec4 u;\n"
+	     "out vec4 color;\n"
+	     "void main()\n"
+	     "{\n"
+	     "	vec4 c = vec4(0.0);\n"
+	     "	for(int i = 0; i < 4; i++)\n"
+	     "	{\n"
+	     "		c[i] = u[i] * float(i + 1) * 0.5;\n"
+	     "	}\n"
+	     "	float s = 0.0;\n"
+	     "	for(float f = 1.0; f > 0.0; f -= 0.25)\n"   // Decrementing float index
+	     "	{\n"
+	     "		s += f;\n"
+	     "	}\n"
+	     "	int n = 0;\n"
+	     "	for(int i = 0; i < 3; ++i)\n"
+	     "	{\n"
+	     "		for(int j = i; j < 3; j++)\n"   // Initial value known once the outer loop is unrolled
+	     "		{\n"
+	     "			n++;\n"
+	     "		}\n"
+	     "	}\n"
+	     "	color = vec4(c.x + c.y, c.z, s * 0.1, float(n) / 8.0);\n"
+	     "}\n");
+
+	for(int y = 0; y < height; y++)
+	{
+		for(int x = 0; x < width; x++)
+		{
+			expectPixel(x, y, 0.25f, 0.45f, 0.25f, 0.75f);
+		}
+	}
+}
+
+TEST_F(ShaderOptimizationTest, KeepsLoopsWithBreakOrContinue)
+{
+	draw("#version 300 es\n"
+	     "precision highp float;\n"
+	     "in vec2 coord;\n"
+	     "out vec4 color;\n"
+	     "void main()\n"
+	     "{\n"
+	     "	float s = 0.0;\n"
+	     "	for(int i = 0; i < 8; i++)\n"
+	     "	{\n"
+	     "		if(i == 5) break;\n"
+	     "		s += 0.1;\n"
+	     "	}\n"
+	     "	float t = 0.0;\n"
+	     "	for(int i = 0; i < 8; i++)\n"
+	     "	{\n"
+	     "		if(i % 2 == 0) continue;\n"
+	     "		t += 0.125;\n"
+	     "	}\n"
+	     "	float w = 0.0;\n"
+	     "	for(int i = 0; i < 4; i++)\n"   // Can be unrolled, the break belongs to the inner loop
+	     "	{\n"
+	     "		for(int j = 0; j < 4; j++)\n"
+	     "		{\n"
+	     "			if(j > i) break;\n"
+	     "			w += 0.0625;\n"
+	     "		}\n"
+	     "	}\n"
+	     "	float x = 0.0;\n"
+	     "	for(int i = 0; i < 8; i++)\n"   // Depends on the pixel
+	     "	{\n"
+	     "		if(float(i) > coord.x * 4.0 + 4.0) break;\n"
+	     "		x += 0.125;\n"
+	     "	}\n"
+	     "	color = vec4(s, t, w, x);\n"
+	     "}\n");
+
+	// coord.x * 4.0 + 4.0 equals x + 0.5, so the last loop iterates x + 1 times
+	for(int y = 0; y < height; y++)
+	{
+		for(int x = 0; x < width; x++)
+		{
+			expectPixel(x, y, 0.5f, 0.5f, 0.625f, (x + 1) * 0.125f);
+		}
+	}
+}
+
+TEST_F(ShaderOptimizationTest, KeepsLoopsWritingTheIndex)
+{
+	draw("#version 300 es\n"
+	     "precision highp float;\n"
+	     "out vec4 color;\n"
+	     "void bump(inout int i)\n"
+	     "{\n"
+	     "	i++;\n"
+	     "}\n"
+	     "void main()\n"
+	     "{\n"
+	     "	float s = 0.0;\n"
+	     "	for(int i = 0; i < 8; i++)\n"
+	     "	{\n"
+	     "		s += 0.125;\n"
+	     "		i++;\n"
+	     "	}\n"
+	     "	float t = 0.0;\n"
+	     "	for(int i = 0; i < 8; i++)\n"
+	     "	{\n"
+	     "		t += 0.125;\n"
+	     "		bump(i);\n"   // Written through an inout parameter
+	     "	}\n"
+	     "	float w = 0.0;\n"
+	     "	for(float f = 0.0; f < 4.0; f += 1.0)\n"
+	     "	{\n"
+	     "		w += 0.125;\n"
+	     "		f = f + 1.0;\n"
+	     "	}\n"
+	     "	float x = 0.0;\n"
+	     "	for(float f = 0.0; f < 4.0; f += 1.0)\n"
+	     "	{\n"
+	     "		x += 0.125;\n"
+	     "		modf(f + 2.5, f);\n"   // Written through the built-in's out parameter
+	     "	}\n"
+	     "	color = vec4(s, t, w, x);\n"
+	     "}\n");
+
+	for(int y = 0; y < height; y++)
+	{
+		for(int x = 0; x < width; x++)
+		{
+			expectPixel(x, y, 0.5f, 0.5f, 0.25f, 0.25f);
+		}
+	}
+}
+
+TEST_F(ShaderOptimizationTest, InlinesCalls)
+{
+	draw("#version 300 es\n"
+	     "precision highp float;\n"
+	     "uniform vec4 u;\n"
+	     "in vec2 coord;\n"
+	     "out vec4 color;\n"
+	     "float counter = 0.0;\n"
+	     "float scale(float a, float b)\n"
+	     "{\n"
+	     "	return a * b + 0.125;\n"
+	     "}\n"
+	     "float first(float a, float b)\n"
+	     "{\n"
+	     "	return a;\n"
+	     "}\n"
+	     "vec2 twice(vec2 a)\n"   // Not inlined for non-trivial arguments
+	     "{\n"
+	     "	return a + a;\n"
+	     "}\n"
+	     "float next()\n"
+	     "{\n"
+	     "	counter += 0.25;\n"
+	     "	return counter;\n"
+	     "}\n"
+	     "void main()\n"
+	     "{\n"
+	     "	float a = scale(u.x, 2.0);\n"
+	     "	vec2 b = twice(vec2(coord.x, u.z) * 0.25);\n"
+	     "	float c = scale(next(), next());\n"   // Side effects must happen exactly once
+	     "	first(0.0, next());\n"                 // Even for unused arguments
+	     "	float d = scale(scale(0.5, 0.5), 1.0);\n"
+	     "	color = vec4(a, b.x + b.y + 0.35, c + counter * 0.5, d);\n"
+	     "}\n");
+
+	for(int y = 0; y < height; y++)
+	{
+		for(int x = 0; x < width; x++)
+		{
+			expectPixel(x, y, 0.325f, (x + 0.5f) / 8.0f, 0.625f, 0.5f);
+		}
+	}
+}
+
+TEST_F(ShaderOptimizationTest, FoldsBuiltIns)
+{
+	draw("#version 300 es\n"
+	     "precision highp float;\n"
+	     "out vec4 color;\n"
+	     "void main()\n"
+	     "{\n"
+	     "	float a = dot(vec3(0.5, 0.25, 1.0), vec3(0.5, 1.0, 0.25));\n"
+	     "	float b = distance(vec2(0.0, 0.0), vec2(0.3, 0.4));\n"
+	     "	float c = pow(2.0, -2.0);\n"
+	     "	float d = mod(-0.25, 1.0);\n"
+	     "	color = vec4(a, b, c, d);\n"
+	     "}\n");
+
+	expectPixel(0, 0, 0.75f, 0.5f, 0.25f, 0.75f);
+	expectPixel(width - 1, height - 1, 0.75f, 0.5f, 0.25f, 0.75f);
+
+	// Scalar arguments get applied to every component
+	draw("#version 300 es\n"
+	     "precision highp float;\n"
+	     "out vec4 color;\n"
+	     "void main()\n"
+	     "{\n"
+	     "	vec4 e = step(0.5, vec4(0.25, 0.75, 0.5, 1.0));\n"
+	     "	vec3 f = clamp(vec3(-1.0, 0.5, 2.0), 0.0, 1.0);\n"
+	     "	vec2 g = mix(vec2(0.0, 1.0), vec2(1.0, 0.0), 0.25);\n"
+	     "	color = vec4(e.x + f.x, e.y * f.y, e.z * g.x, e.w * g.y);\n"
+	     "}\n");
+
+	expectPixel(0, 0, 0.0f, 0.5f, 0.25f, 0.75f);
+	expectPixel(width - 1, height - 1, 0.0f, 0.5f, 0.25f, 0.75f);
+
+	draw("#version 300 es\n"
+	     "precision highp float;\n"
+	     "uniform vec4 u;\n"
+	     "out vec4 color;\n"
+	     "void main()\n"
+	     "{\n"
+	     "	float h = smoothstep(0.0, 1.0, 0.25);\n"
+	     "	float i = atan(1.0, 1.0);\n"
+	     "	float j = float(min(3, 5) + max(1, 2)) * 0.125;\n"   // Integer built-ins
+	     "	float k = mix(0.5, 1.0, u.x);\n"                     // Not constant
+	     "	color = vec4(h, i, j, k);\n"
+	     "}\n");
+
+	expectPixel(0, 0, 0.15625f, 0.785398f, 0.625f, 0.55f);
+	expectPixel(width - 1, height - 1, 0.15625f, 0.785398f, 0.625f, 0.55f);
+}
+
+TEST_F(ShaderOptimizationTest, RemovesDeadBranches)
+{
+	draw("#version 300 es\n"
+	     "precision highp float;\n"
+	     "uniform vec4 u;\n"
+	     "out vec4 color;\n"
+	     "void main()\n"
+	     "{\n"
+	     "	const bool enabled = false;\n"
+	     "	vec4 c = vec4(u.x);\n"
+	     "	if(enabled)\n"
+	     "	{\n"
+	     "		c = vec4(1.0);\n"
+	     "	}\n"
+	     "	else\n"
+	     "	{\n"
+	     "		c.g = 0.5;\n"
+	     "	}\n"
+	     "	if(2 > 1)\n"
+	     "	{\n"
+	     "		c.b = 0.75;\n"
+	     "	}\n"
+	     "	for(int i = 0; i < 0; i++)\n"   // Never iterates
+	     "	{\n"
+	     "		c = vec4(1.0);\n"
+	     "	}\n"
+	     "	while(false)\n"
+	     "	{\n"
+	     "		c = vec4(1.0);\n"
+	     "	}\n"
+	     "	c.a = (1.0 < 2.0) ? 1.0 : 0.0;\n"
+	     "	do\n"                           // Iterates once
+	     "	{\n"
+	     "		c.a -= 0.5;\n"
+	     "	}\n"
+	     "	while(false);\n"
+	     "	color = c;\n"
+	     "}\n");
+
+	for(int y = 0; y < height; y++)
+	{
+		for(int x = 0; x < width; x++)
+		{
+			expectPixel(x, y, 0.1f, 0.5f, 0.75f, 0.5f);
+		}
+	}
+}
+
+// Enables constant specialization through the configuration file, which is read when the context gets created
+class ConstantSpecializationTest : public ShaderOptimizationTest
+{
+protected:
+	void SetUp() override
+	{
+		FILE *existing = fopen("SwiftShader.ini", "rb");
+
+		if(existing)
+		{
+			char buffer[1024];
+			size_t size;
+
+			while((size = fread(buffer, 1, sizeof(buffer), existing)) > 0)
+			{
+				configuration.append(buffer, size);
+			}
+
+			fclose(existing);
+		}
+
+		FILE *file = fopen("SwiftShader.ini", "wb");
+		ASSERT_NE((FILE*)NULL, file);
+		fputs("[Testing]\nConstantSpecialization=1\n", file);
+		fclose(file);
+
+		ShaderOptimizationTest::SetUp();
+	}
+
+	void TearDown() override
+	{
+		ShaderOptimizationTest::TearDown();
+
+		if(configuration.empty())
+		{
+			remove("SwiftShader.ini");
+		}
+		else
+		{
+			FILE *file = fopen("SwiftShader.ini", "wb");
+			fwrite(configuration.data(), 1, configuration.size(), file);
+			fclose(file);
+		}
+	}
+
+	// Draws the quad 'count' times with uniform 'u' set to the given value, which gets folded
+	// into the routine after it remained unchanged for 256 draw calls
+	void drawRepeatedly(GLuint program, const GLfloat u[4], int count)
+	{
+		glUniform4fv(glGetUniformLocation(program, "u"), 1, u);
+
+		for(int i = 0; i < count; i++)
+		{
+			glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+		}
+
+		glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+		EXPECT_EQ((GLenum)GL_NO_ERROR, glGetError());
+	}
+
+	std::string configuration;   // Previous contents of the configuration file
+};
+
+TEST_F(ConstantSpecializationTest, FloatControlConstants)
+{
+	const char *vertexSource =
+		"#version 300 es\n"
+		"in vec4 position;\n"
+		"void main()\n"
+		"{\n"
+		"	gl_Position = position;\n"
+		"}\n";
+
+	const char *fragmentSource =
+		"#version 300 es\n"
+		"precision highp float;\n"
+		"uniform vec4 u;\n"
+		"out vec4 color;\n"
+		"void main()\n"
+		"{\n"
+		"	vec4 c = (u.x > 0.5) ? vec4(1.0, 0.0, 0.0, 1.0) : vec4(0.0, 1.0, 0.0, 1.0);\n"
+		"	if(u.z > 0.5)\n"
+		"	{\n"
+		"		c.a = 0.5;\n"
+		"	}\n"
+		"	for(float i = 0.0; i < u.y; i += 1.0)\n"
+		"	{\n"
+		"		c.b += 0.25;\n"
+		"	}\n"
+		"	color = c;\n"
+		"}\n";
+
+	GLuint vertexShader = compile(GL_VERTEX_SHADER, vertexSource);
+	GLuint fragmentShader = compile(GL_FRAGMENT_SHADER, fragmentSource);
+
+	GLuint program = glCreateProgram();
+	glAttachShader(program, vertexShader);
+	glAttachShader(program, fragmentShader);
+	glBindAttribLocation(program, 0, "position");
+	glLinkProgram(program);
+	glUseProgram(program);
+
+	const GLfloat quad[] =
+	{
+		-1.0f, -1.0f, 0.0f, 1.0f,
+		 1.0f, -1.0f, 0.0f, 1.0f,
+		-1.0f,  1.0f, 0.0f, 1.0f,
+		 1.0f,  1.0f, 0.0f, 1.0f,
+	};
+
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0, quad);
+
+	// Stable long enough to get specialized
+	const GLfloat stable[4] = {0.75f, 2.0f, 0.0f, 0.0f};
+	drawRepeatedly(program, stable, 300);
+	expectPixel(0, 0, 1.0f, 0.0f, 0.5f, 1.0f);
+	expectPixel(width - 1, height - 1, 1.0f, 0.0f, 0.5f, 1.0f);
+
+	// Changed, so the routine which reads the constants at run time must be used
+	const GLfloat changed[4] = {0.25f, 3.0f, 1.0f, 0.0f};
+	drawRepeatedly(program, changed, 1);
+	expectPixel(0, 0, 0.0f, 1.0f, 0.75f, 0.5f);
+	expectPixel(width - 1, height - 1, 0.0f, 1.0f, 0.75f, 0.5f);
+
+	// Specialized again for the new values
+	drawRepeatedly(program, changed, 300);
+	expectPixel(0, 0, 0.0f, 1.0f, 0.75f, 0.5f);
+	expectPixel(width - 1, height - 1, 0.0f, 1.0f, 0.75f, 0.5f);
+
+	// And back to the original values
+	drawRepeatedly(program, stable, 1);
+	expectPixel(0, 0, 1.0f, 0.0f, 0.5f, 1.0f);
+
+	glDeleteProgram(program);
+	glDeleteShader(vertexShader);
+	glDeleteShader(fragmentShader);
+}